@@ -22,6 +22,7 @@
 #include <linux/kdebug.h>
 #include <linux/sched/mm.h>
 #include <linux/sched/clock.h>
+#include <linux/sched/numa_balancing.h>
 #include <linux/uaccess.h>
 #include <linux/slab.h>
 #include <linux/cpu.h>
@@ -2993,6 +2994,36 @@ void perf_get_x86_pmu_capability(struct x86_pmu_capability *cap)
 }
 EXPORT_SYMBOL_GPL(perf_get_x86_pmu_capability);
 
+#ifdef CONFIG_NUMA_BALANCING
+/*
+ * NUMA balancing access sampling: use the PEBS load latency event, whose
+ * records carry the data linear address. The threshold skips cache hits,
+ * which say nothing about placement.
+ */
+bool arch_numa_sample_attr(struct perf_event_attr *attr)
+{
+	struct event_constraint *c;
+
+	if (!x86_pmu_initialized() || !x86_pmu.pebs ||
+	    !x86_pmu.pebs_constraints || x86_pmu.intel_cap.pebs_format < 1 ||
+	    is_hybrid() || (x86_pmu.flags & PMU_FL_MEM_LOADS_AUX))
+		return false;
+
+	for_each_event_constraint(c, x86_pmu.pebs_constraints) {
+		if (!(c->flags & PERF_X86_EVENT_PEBS_LDLAT))
+			continue;
+
+		attr->type = PERF_TYPE_RAW;
+		attr->config = c->code;
+		attr->config1 = 30;	/* ldlat, as perf mem defaults to */
+		attr->precise_ip = 2;
+		return true;
+	}
+
+	return false;
+}
+#endif
+
 u64 perf_get_hw_event_config(int hw_event)
 {
 	int max = x86_pmu.max_events;
@@ -56,8 +56,10 @@ DEFINE_STATIC_KEY_TRUE(virt_spin_lock_key);
 void __init native_pv_lock_init(void)
 {
 	if (IS_ENABLED(CONFIG_PARAVIRT_SPINLOCKS) &&
-	    !boot_cpu_has(X86_FEATURE_HYPERVISOR))
+	    !boot_cpu_has(X86_FEATURE_HYPERVISOR)) {
 		static_branch_disable(&virt_spin_lock_key);
+		cna_configure_spin_lock_slowpath();
+	}
 }
 
 static void native_tlb_remove_table(struct mmu_gather *tlb, void *table)
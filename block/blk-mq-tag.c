@@ -122,9 +122,19 @@ unsigned long blk_mq_get_tags(struct blk_mq_alloc_data *data, int nr_tags,
 	struct sbitmap_queue *bt = &tags->bitmap_tags;
 	unsigned long ret;
 
-	if (data->shallow_depth ||data->flags & BLK_MQ_REQ_RESERVED ||
-	    data->hctx->flags & BLK_MQ_F_TAG_QUEUE_SHARED)
+	if (data->shallow_depth || data->flags & BLK_MQ_REQ_RESERVED)
 		return 0;
+	/*
+	 * Queues sharing the tags may still take a batch, as long as it fits
+	 * into their fair share. Like for single tags, that share isn't
+	 * enforced with an I/O scheduler.
+	 */
+	if (!data->q->elevator) {
+		nr_tags = min_t(unsigned int, nr_tags,
+				hctx_tags_headroom(data->hctx, bt));
+		if (!nr_tags)
+			return 0;
+	}
 	ret = __sbitmap_queue_get_batch(bt, nr_tags, offset);
 	*offset += tags->nr_reserved_tags;
 	return ret;
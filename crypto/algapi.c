@@ -1097,6 +1097,13 @@ static void __init crypto_start_tests(void)
 
 static int __init crypto_algapi_init(void)
 {
+	/*
+	 * Algorithm lookups read lock crypto_alg_sem for every tfm
+	 * allocation, while writers only show up on (un)registration.
+	 * Without the per-CPU reader counts the rwsem simply keeps working
+	 * as before, so a failure here is not fatal.
+	 */
+	rwsem_enable_reader_bias(&crypto_alg_sem);
 	crypto_init_proc();
 	crypto_start_tests();
 	return 0;
@@ -1104,6 +1111,10 @@ static int __init crypto_algapi_init(void)
 
 static void __exit crypto_algapi_exit(void)
 {
+	/*
+	 * crypto_alg_sem outlives this module and keeps its per-CPU reader
+	 * counts, it may still be taken through them.
+	 */
 	crypto_exit_proc();
 }
 
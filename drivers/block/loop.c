@@ -81,6 +81,8 @@ struct loop_device {
 struct loop_cmd {
 	struct list_head list_entry;
 	bool use_aio; /* use AIO interface to handle I/O */
+	bool nowait; /* aio issued from ->queue_rq() with IOCB_NOWAIT */
+	bool nowait_again; /* nowait aio returned -EAGAIN, use the worker */
 	atomic_t ref; /* only for aio */
 	long ret;
 	struct kiocb iocb;
@@ -395,6 +397,12 @@ static void lo_rw_aio_do_completion(struct loop_cmd *cmd)
 		return;
 	kfree(cmd->bvec);
 	cmd->bvec = NULL;
+	if (cmd->nowait && cmd->ret == -EAGAIN) {
+		/* the backing file couldn't complete it without blocking */
+		cmd->nowait_again = true;
+		blk_mq_requeue_request(rq, true);
+		return;
+	}
 	if (likely(!blk_should_fake_timeout(rq->q)))
 		blk_mq_complete_request(rq);
 }
@@ -462,6 +470,8 @@ static int lo_rw_aio(struct loop_device *lo, struct loop_cmd *cmd,
 	cmd->iocb.ki_filp = file;
 	cmd->iocb.ki_complete = lo_rw_aio_complete;
 	cmd->iocb.ki_flags = IOCB_DIRECT;
+	if (cmd->nowait)
+		cmd->iocb.ki_flags |= IOCB_NOWAIT;
 	cmd->iocb.ki_ioprio = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_NONE, 0);
 
 	if (rw == ITER_SOURCE)
@@ -469,6 +479,10 @@ static int lo_rw_aio(struct loop_device *lo, struct loop_cmd *cmd,
 	else
 		ret = file->f_op->read_iter(&cmd->iocb, &iter);
 
+	/* let the caller hand it to the worker, nothing was submitted */
+	if (ret == -EAGAIN && cmd->nowait)
+		return -EAGAIN;
+
 	lo_rw_aio_do_completion(cmd);
 
 	if (ret != -EIOCBQUEUED)
@@ -1836,6 +1850,41 @@ MODULE_DESCRIPTION("Loopback device support");
 MODULE_LICENSE("GPL");
 MODULE_ALIAS_BLOCKDEV_MAJOR(LOOP_MAJOR);
 
+/*
+ * Try to issue direct I/O to the backing file from the submitting context,
+ * which saves the worker round trip and lets several CPUs submit to the same
+ * backing file. This is only done if it can't block and if the I/O doesn't
+ * have to be charged to a cgroup, which the workers take care of.
+ */
+static bool loop_queue_nowait(struct loop_device *lo, struct loop_cmd *cmd)
+{
+	struct request *rq = blk_mq_rq_from_pdu(cmd);
+	const bool write = op_is_write(req_op(rq));
+	bool again = cmd->nowait_again;
+	unsigned int noio_flags;
+	loff_t pos;
+	int ret;
+
+	cmd->nowait_again = false;
+	if (!cmd->use_aio || again || rq->bio != rq->biotail ||
+	    !queue_on_root_worker(cmd->blkcg_css) ||
+	    !(lo->lo_backing_file->f_mode & FMODE_NOWAIT) ||
+	    (write && (lo->lo_flags & LO_FLAGS_READ_ONLY)))
+		return false;
+
+	pos = ((loff_t) blk_rq_pos(rq) << 9) + lo->lo_offset;
+	cmd->nowait = true;
+	/* Like the workers, don't recurse into reclaim waiting on this device */
+	noio_flags = memalloc_noio_save();
+	ret = lo_rw_aio(lo, cmd, pos, write ? ITER_SOURCE : ITER_DEST);
+	memalloc_noio_restore(noio_flags);
+	if (ret) {
+		cmd->nowait = false;
+		return false;
+	}
+	return true;
+}
+
 static blk_status_t loop_queue_rq(struct blk_mq_hw_ctx *hctx,
 		const struct blk_mq_queue_data *bd)
 {
@@ -1859,19 +1908,22 @@ static blk_status_t loop_queue_rq(struct blk_mq_hw_ctx *hctx,
 		break;
 	}
 
+	cmd->nowait = false;
+
 	/* always use the first bio's css */
 	cmd->blkcg_css = NULL;
 	cmd->memcg_css = NULL;
 #ifdef CONFIG_BLK_CGROUP
-	if (rq->bio) {
+	if (rq->bio)
 		cmd->blkcg_css = bio_blkcg_css(rq->bio);
-#ifdef CONFIG_MEMCG
-		if (cmd->blkcg_css) {
-			cmd->memcg_css =
-				cgroup_get_e_css(cmd->blkcg_css->cgroup,
-						&memory_cgrp_subsys);
-		}
 #endif
+	if (loop_queue_nowait(lo, cmd))
+		return BLK_STS_OK;
+#if defined(CONFIG_BLK_CGROUP) && defined(CONFIG_MEMCG)
+	if (cmd->blkcg_css) {
+		cmd->memcg_css =
+			cgroup_get_e_css(cmd->blkcg_css->cgroup,
+					&memory_cgrp_subsys);
 	}
 #endif
 	loop_queue_work(lo, cmd);
@@ -2024,8 +2076,12 @@ static int loop_add(int i)
 	lo->tag_set.queue_depth = hw_queue_depth;
 	lo->tag_set.numa_node = NUMA_NO_NODE;
 	lo->tag_set.cmd_size = sizeof(struct loop_cmd);
+	/*
+	 * ->queue_rq() may issue I/O to the backing file, which can sleep
+	 * even with IOCB_NOWAIT, e.g. to allocate memory.
+	 */
 	lo->tag_set.flags = BLK_MQ_F_SHOULD_MERGE | BLK_MQ_F_STACKING |
-		BLK_MQ_F_NO_SCHED_BY_DEFAULT;
+		BLK_MQ_F_NO_SCHED_BY_DEFAULT | BLK_MQ_F_BLOCKING;
 	lo->tag_set.driver_data = lo;
 
 	err = blk_mq_alloc_tag_set(&lo->tag_set);
@@ -1214,11 +1214,35 @@ static enum blk_eh_timer_return ublk_timeout(struct request *rq)
 	return BLK_EH_RESET_TIMER;
 }
 
-static blk_status_t ublk_queue_rq(struct blk_mq_hw_ctx *hctx,
-		const struct blk_mq_queue_data *bd)
+static void ublk_queue_cmd_list(struct ublk_queue *ubq, struct request **rqlist)
+{
+	struct llist_node *first = NULL, *last = NULL;
+	struct request *rq = NULL;
+
+	/*
+	 * ublk_forward_io_cmds() reverses the list, so chain the batch
+	 * newest first like individual llist_add() calls would.
+	 */
+	while (!rq_list_empty(*rqlist)) {
+		struct ublk_rq_data *data;
+
+		rq = rq_list_pop(rqlist);
+		data = blk_mq_rq_to_pdu(rq);
+		data->node.next = first;
+		first = &data->node;
+		if (!last)
+			last = first;
+	}
+
+	if (first && llist_add_batch(first, last, &ubq->io_cmds)) {
+		struct ublk_io *io = &ubq->ios[rq->tag];
+
+		io_uring_cmd_complete_in_task(io->cmd, ublk_rq_task_work_cb);
+	}
+}
+
+static blk_status_t ublk_prep_req(struct ublk_queue *ubq, struct request *rq)
 {
-	struct ublk_queue *ubq = hctx->driver_data;
-	struct request *rq = bd->rq;
 	blk_status_t res;
 
 	/* fill iod to slot in io cmd buffer */
@@ -1238,6 +1262,20 @@ static blk_status_t ublk_queue_rq(struct blk_mq_hw_ctx *hctx,
 	if (ublk_queue_can_use_recovery(ubq) && unlikely(ubq->force_abort))
 		return BLK_STS_IOERR;
 
+	return BLK_STS_OK;
+}
+
+static blk_status_t ublk_queue_rq(struct blk_mq_hw_ctx *hctx,
+		const struct blk_mq_queue_data *bd)
+{
+	struct ublk_queue *ubq = hctx->driver_data;
+	struct request *rq = bd->rq;
+	blk_status_t res;
+
+	res = ublk_prep_req(ubq, rq);
+	if (res != BLK_STS_OK)
+		return res;
+
 	if (unlikely(ubq->canceling)) {
 		__ublk_abort_rq(ubq, rq);
 		return BLK_STS_OK;
@@ -1249,6 +1287,41 @@ static blk_status_t ublk_queue_rq(struct blk_mq_hw_ctx *hctx,
 	return BLK_STS_OK;
 }
 
+/*
+ * Hand a plug's worth of requests to the daemon with a single task work
+ * per queue. Requests that can't be queued right away are left to
+ * ->queue_rq(), which fails or aborts them.
+ */
+static void ublk_queue_rqs(struct request **rqlist)
+{
+	struct request *req, *next, *prev = NULL;
+	struct request *requeue_list = NULL;
+
+	rq_list_for_each_safe(rqlist, req, next) {
+		struct ublk_queue *ubq = req->mq_hctx->driver_data;
+
+		if (unlikely(ubq->canceling) ||
+		    ublk_prep_req(ubq, req) != BLK_STS_OK) {
+			rq_list_move(rqlist, &requeue_list, req, prev);
+			req = prev;
+			if (!req)
+				continue;
+		} else {
+			blk_mq_start_request(req);
+		}
+
+		if (!next || req->mq_hctx != next->mq_hctx) {
+			req->rq_next = NULL;
+			ublk_queue_cmd_list(req->mq_hctx->driver_data, rqlist);
+			*rqlist = next;
+			prev = NULL;
+		} else
+			prev = req;
+	}
+
+	*rqlist = requeue_list;
+}
+
 static int ublk_init_hctx(struct blk_mq_hw_ctx *hctx, void *driver_data,
 		unsigned int hctx_idx)
 {
@@ -1261,6 +1334,7 @@ static int ublk_init_hctx(struct blk_mq_hw_ctx *hctx, void *driver_data,
 
 static const struct blk_mq_ops ublk_mq_ops = {
 	.queue_rq       = ublk_queue_rq,
+	.queue_rqs	= ublk_queue_rqs,
 	.init_hctx	= ublk_init_hctx,
 	.timeout	= ublk_timeout,
 };
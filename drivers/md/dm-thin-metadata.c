@@ -1698,6 +1698,28 @@ int dm_thin_insert_block(struct dm_thin_device *td, dm_block_t block,
 	return r;
 }
 
+int dm_pool_insert_blocks(struct dm_pool_metadata *pmd,
+			  struct dm_thin_new_block *blocks, unsigned int nr,
+			  unsigned int *nr_inserted)
+{
+	unsigned int i = 0;
+	int r = -EINVAL;
+
+	pmd_write_lock(pmd);
+	if (!pmd->fail_io) {
+		for (r = 0; i < nr; i++) {
+			r = __insert(blocks[i].td, blocks[i].block,
+				     blocks[i].data_block);
+			if (r)
+				break;
+		}
+	}
+	pmd_write_unlock(pmd);
+
+	*nr_inserted = i;
+	return r;
+}
+
 static int __remove_range(struct dm_thin_device *td, dm_block_t begin, dm_block_t end)
 {
 	int r;
@@ -167,6 +167,21 @@ int dm_pool_alloc_data_block(struct dm_pool_metadata *pmd, dm_block_t *result);
 int dm_thin_insert_block(struct dm_thin_device *td, dm_block_t block,
 			 dm_block_t data_block);
 
+struct dm_thin_new_block {
+	struct dm_thin_device *td;
+	dm_block_t block;
+	dm_block_t data_block;
+};
+
+/*
+ * Inserts several blocks, possibly of different thin devices, while
+ * holding the metadata lock once.  Stops at the first error; *nr_inserted
+ * is set to the number of blocks that made it in.
+ */
+int dm_pool_insert_blocks(struct dm_pool_metadata *pmd,
+			  struct dm_thin_new_block *blocks, unsigned int nr,
+			  unsigned int *nr_inserted);
+
 int dm_thin_remove_range(struct dm_thin_device *td,
 			 dm_block_t begin, dm_block_t end);
 
@@ -989,11 +989,37 @@ static void complete_overwrite_bio(struct thin_c *tc, struct bio *bio)
 	spin_unlock_irq(&pool->lock);
 }
 
+/*
+ * Release any bios held while the block was being provisioned, once it
+ * has been inserted into the mapping btree.
+ */
+static void complete_prepared_mapping(struct dm_thin_new_mapping *m)
+{
+	struct thin_c *tc = m->tc;
+	struct bio *bio = m->bio;
+
+	/*
+	 * If we are processing a write bio that completely covers the block,
+	 * we already processed it so can ignore it now when processing
+	 * the bios in the cell.
+	 */
+	if (bio) {
+		inc_remap_and_issue_cell(tc, m->cell, m->data_block);
+		complete_overwrite_bio(tc, bio);
+	} else {
+		inc_all_io_entry(tc->pool, m->cell->holder);
+		remap_and_issue(tc, m->cell->holder, m->data_block);
+		inc_remap_and_issue_cell(tc, m->cell, m->data_block);
+	}
+
+	list_del(&m->list);
+	mempool_free(m, &tc->pool->mapping_pool);
+}
+
 static void process_prepared_mapping(struct dm_thin_new_mapping *m)
 {
 	struct thin_c *tc = m->tc;
 	struct pool *pool = tc->pool;
-	struct bio *bio = m->bio;
 	int r;
 
 	if (m->status) {
@@ -1013,20 +1039,8 @@ static void process_prepared_mapping(struct dm_thin_new_mapping *m)
 		goto out;
 	}
 
-	/*
-	 * Release any bios held while the block was being provisioned.
-	 * If we are processing a write bio that completely covers the block,
-	 * we already processed it so can ignore it now when processing
-	 * the bios in the cell.
-	 */
-	if (bio) {
-		inc_remap_and_issue_cell(tc, m->cell, m->data_block);
-		complete_overwrite_bio(tc, bio);
-	} else {
-		inc_all_io_entry(tc->pool, m->cell->holder);
-		remap_and_issue(tc, m->cell->holder, m->data_block);
-		inc_remap_and_issue_cell(tc, m->cell, m->data_block);
-	}
+	complete_prepared_mapping(m);
+	return;
 
 out:
 	list_del(&m->list);
@@ -1230,6 +1244,65 @@ static void process_prepared(struct pool *pool, struct list_head *head,
 		(*fn)(m);
 }
 
+#define INSERT_BATCH_SIZE 16
+
+/*
+ * Like process_prepared() for the prepared mappings, but inserts runs of
+ * successful ones into the btree together, so the metadata lock is taken
+ * once per run rather than once per block.
+ */
+static void process_prepared_mappings(struct pool *pool)
+{
+	struct dm_thin_new_block blocks[INSERT_BATCH_SIZE];
+	struct dm_thin_new_mapping *m, *tmp;
+	unsigned int i, nr, nr_inserted;
+	struct list_head maps;
+	int r;
+
+	INIT_LIST_HEAD(&maps);
+	spin_lock_irq(&pool->lock);
+	list_splice_init(&pool->prepared_mappings, &maps);
+	spin_unlock_irq(&pool->lock);
+
+	while (!list_empty(&maps)) {
+		/* the pool may have changed mode on a metadata error */
+		if (pool->process_prepared_mapping != process_prepared_mapping) {
+			list_for_each_entry_safe(m, tmp, &maps, list)
+				pool->process_prepared_mapping(m);
+			return;
+		}
+
+		nr = 0;
+		list_for_each_entry(m, &maps, list) {
+			if (m->status)
+				break;
+			blocks[nr].td = m->tc->td;
+			blocks[nr].block = m->virt_begin;
+			blocks[nr].data_block = m->data_block;
+			if (++nr == INSERT_BATCH_SIZE)
+				break;
+		}
+
+		if (!nr) {
+			process_prepared_mapping(list_first_entry(&maps,
+					struct dm_thin_new_mapping, list));
+			continue;
+		}
+
+		r = dm_pool_insert_blocks(pool->pmd, blocks, nr, &nr_inserted);
+		for (i = 0; i < nr_inserted; i++)
+			complete_prepared_mapping(list_first_entry(&maps,
+					struct dm_thin_new_mapping, list));
+		if (r) {
+			m = list_first_entry(&maps, struct dm_thin_new_mapping, list);
+			metadata_operation_failed(pool, "dm_pool_insert_blocks", r);
+			cell_error(pool, m->cell);
+			list_del(&m->list);
+			mempool_free(m, &pool->mapping_pool);
+		}
+	}
+}
+
 /*
  * Deferred bio jobs.
  */
@@ -2421,7 +2494,7 @@ static void do_worker(struct work_struct *ws)
 	throttle_work_start(&pool->throttle);
 	dm_pool_issue_prefetches(pool->pmd);
 	throttle_work_update(&pool->throttle);
-	process_prepared(pool, &pool->prepared_mappings, &pool->process_prepared_mapping);
+	process_prepared_mappings(pool);
 	throttle_work_update(&pool->throttle);
 	process_prepared(pool, &pool->prepared_discards, &pool->process_prepared_discard);
 	throttle_work_update(&pool->throttle);
@@ -1461,8 +1461,13 @@ __acquires(bitmap->lock)
 			&(bitmap->bp[page].map[pageoff]);
 }
 
+/* Chunks updated under one hold of counts.lock before giving IRQs a chance */
+#define BITMAP_COUNTS_BATCH	64
+
 int md_bitmap_startwrite(struct bitmap *bitmap, sector_t offset, unsigned long sectors, int behind)
 {
+	unsigned int batch = 0;
+
 	if (!bitmap)
 		return 0;
 
@@ -1477,16 +1482,19 @@ int md_bitmap_startwrite(struct bitmap *bitmap, sector_t offset, unsigned long s
 			 bw, bitmap->mddev->bitmap_info.max_write_behind);
 	}
 
+	/*
+	 * Keep the counter lock across chunks, a large write would otherwise
+	 * bounce it once per chunk it covers. It is still dropped every
+	 * BITMAP_COUNTS_BATCH chunks to bound the IRQs off section.
+	 */
+	spin_lock_irq(&bitmap->counts.lock);
 	while (sectors) {
 		sector_t blocks;
 		bitmap_counter_t *bmc;
 
-		spin_lock_irq(&bitmap->counts.lock);
 		bmc = md_bitmap_get_counter(&bitmap->counts, offset, &blocks, 1);
-		if (!bmc) {
-			spin_unlock_irq(&bitmap->counts.lock);
-			return 0;
-		}
+		if (!bmc)
+			break;
 
 		if (unlikely(COUNTER(*bmc) == COUNTER_MAX)) {
 			DEFINE_WAIT(__wait);
@@ -1499,6 +1507,7 @@ int md_bitmap_startwrite(struct bitmap *bitmap, sector_t offset, unsigned long s
 			spin_unlock_irq(&bitmap->counts.lock);
 			schedule();
 			finish_wait(&bitmap->overflow_wait, &__wait);
+			spin_lock_irq(&bitmap->counts.lock);
 			continue;
 		}
 
@@ -1513,14 +1522,20 @@ int md_bitmap_startwrite(struct bitmap *bitmap, sector_t offset, unsigned long s
 
 		(*bmc)++;
 
-		spin_unlock_irq(&bitmap->counts.lock);
-
 		offset += blocks;
 		if (sectors > blocks)
 			sectors -= blocks;
 		else
 			sectors = 0;
+
+		if (sectors && ++batch == BITMAP_COUNTS_BATCH) {
+			batch = 0;
+			spin_unlock_irq(&bitmap->counts.lock);
+			cond_resched();
+			spin_lock_irq(&bitmap->counts.lock);
+		}
 	}
+	spin_unlock_irq(&bitmap->counts.lock);
 	return 0;
 }
 EXPORT_SYMBOL(md_bitmap_startwrite);
@@ -1528,6 +1543,9 @@ EXPORT_SYMBOL(md_bitmap_startwrite);
 void md_bitmap_endwrite(struct bitmap *bitmap, sector_t offset,
 			unsigned long sectors, int success, int behind)
 {
+	unsigned int batch = 0;
+	unsigned long flags;
+
 	if (!bitmap)
 		return;
 	if (behind) {
@@ -1538,17 +1556,14 @@ void md_bitmap_endwrite(struct bitmap *bitmap, sector_t offset,
 			 bitmap->mddev->bitmap_info.max_write_behind);
 	}
 
+	spin_lock_irqsave(&bitmap->counts.lock, flags);
 	while (sectors) {
 		sector_t blocks;
-		unsigned long flags;
 		bitmap_counter_t *bmc;
 
-		spin_lock_irqsave(&bitmap->counts.lock, flags);
 		bmc = md_bitmap_get_counter(&bitmap->counts, offset, &blocks, 0);
-		if (!bmc) {
-			spin_unlock_irqrestore(&bitmap->counts.lock, flags);
-			return;
-		}
+		if (!bmc)
+			break;
 
 		if (success && !bitmap->mddev->degraded &&
 		    bitmap->events_cleared < bitmap->mddev->events) {
@@ -1568,13 +1583,19 @@ void md_bitmap_endwrite(struct bitmap *bitmap, sector_t offset,
 			md_bitmap_set_pending(&bitmap->counts, offset);
 			bitmap->allclean = 0;
 		}
-		spin_unlock_irqrestore(&bitmap->counts.lock, flags);
 		offset += blocks;
 		if (sectors > blocks)
 			sectors -= blocks;
 		else
 			sectors = 0;
+
+		if (sectors && ++batch == BITMAP_COUNTS_BATCH) {
+			batch = 0;
+			spin_unlock_irqrestore(&bitmap->counts.lock, flags);
+			spin_lock_irqsave(&bitmap->counts.lock, flags);
+		}
 	}
+	spin_unlock_irqrestore(&bitmap->counts.lock, flags);
 }
 EXPORT_SYMBOL(md_bitmap_endwrite);
 
@@ -63,10 +63,17 @@
 
 #define RAID5_MAX_REQ_STRIPES 256
 
+/* Upper bound of group_thread_cnt, 8192 should be big enough */
+#define RAID5_MAX_GROUP_THREADS 8192
+
 static bool devices_handle_discard_safely = false;
 module_param(devices_handle_discard_safely, bool, 0644);
 MODULE_PARM_DESC(devices_handle_discard_safely,
 		 "Set to Y if all devices in each array reliably return zeroes on reads from discarded regions");
+static int default_group_thread_cnt;
+module_param(default_group_thread_cnt, int, 0644);
+MODULE_PARM_DESC(default_group_thread_cnt,
+		 "Initial group_thread_cnt of new arrays, -1 to size it by the CPUs of each NUMA node (default: 0, handle stripes in raid5d only)");
 static struct workqueue_struct *raid5_wq;
 
 static void raid5_quiesce(struct mddev *mddev, int quiesce);
@@ -7164,8 +7171,7 @@ raid5_store_group_thread_cnt(struct mddev *mddev, const char *page, size_t len)
 		return -EINVAL;
 	if (kstrtouint(page, 10, &new))
 		return -EINVAL;
-	/* 8192 should be big enough */
-	if (new > 8192)
+	if (new > RAID5_MAX_GROUP_THREADS)
 		return -EINVAL;
 
 	err = mddev_suspend_and_lock(mddev);
@@ -7219,6 +7225,23 @@ static const struct attribute_group raid5_attrs_group = {
 	.attrs = raid5_attrs,
 };
 
+/*
+ * Worker groups are per NUMA node already, so automatic sizing only has to
+ * pick the number of workers per node. One per CPU of a node quickly turns
+ * device_lock into the bottleneck, so stop at RAID5_AUTO_WORKERS_MAX.
+ */
+#define RAID5_AUTO_WORKERS_MAX 8
+
+static int raid5_default_worker_cnt(void)
+{
+	int cnt = READ_ONCE(default_group_thread_cnt);
+
+	if (cnt >= 0)
+		return min(cnt, RAID5_MAX_GROUP_THREADS);
+	cnt = DIV_ROUND_UP(num_online_cpus(), num_online_nodes());
+	return min(cnt, RAID5_AUTO_WORKERS_MAX);
+}
+
 static int alloc_thread_groups(struct r5conf *conf, int cnt, int *group_cnt,
 			       struct r5worker_group **worker_groups)
 {
@@ -7427,7 +7450,7 @@ static struct r5conf *setup_conf(struct mddev *mddev)
 	struct md_rdev *rdev;
 	struct disk_info *disk;
 	char pers_name[6];
-	int i;
+	int i, cnt;
 	int group_cnt;
 	struct r5worker_group *new_group;
 	int ret = -ENOMEM;
@@ -7479,10 +7502,11 @@ static struct r5conf *setup_conf(struct mddev *mddev)
 		goto abort;
 	for (i = 0; i < PENDING_IO_MAX; i++)
 		list_add(&conf->pending_data[i].sibling, &conf->free_list);
-	/* Don't enable multi-threading by default*/
-	if (!alloc_thread_groups(conf, 0, &group_cnt, &new_group)) {
+	/* Only enable multi-threading if asked to */
+	cnt = raid5_default_worker_cnt();
+	if (!alloc_thread_groups(conf, cnt, &group_cnt, &new_group)) {
 		conf->group_cnt = group_cnt;
-		conf->worker_cnt_per_group = 0;
+		conf->worker_cnt_per_group = cnt;
 		conf->worker_groups = new_group;
 	} else
 		goto abort;
@@ -328,6 +328,13 @@ static bool bond_xdp_check(struct bonding *bond)
 	case BOND_MODE_ROUNDROBIN:
 	case BOND_MODE_ACTIVEBACKUP:
 		return true;
+	case BOND_MODE_TLB:
+		/* only static tlb spreads flows by xmit hash like xor does,
+		 * dynamic tlb rebalances through the skb based tx hash table
+		 */
+		if (bond->params.tlb_dynamic_lb)
+			return false;
+		fallthrough;
 	case BOND_MODE_8023AD:
 	case BOND_MODE_XOR:
 		/* vlan+srcmac is not supported with XDP as in most cases the 802.1q
@@ -4211,13 +4218,39 @@ static u32 __bond_xmit_hash(struct bonding *bond, struct sk_buff *skb, const voi
  */
 u32 bond_xmit_hash(struct bonding *bond, struct sk_buff *skb)
 {
-	if (bond->params.xmit_policy == BOND_XMIT_POLICY_ENCAP34 &&
-	    skb->l4_hash)
+	int xmit_policy = bond->params.xmit_policy;
+	struct bond_hash_cache_entry *ent = NULL;
+	u32 hash;
+
+	if (xmit_policy == BOND_XMIT_POLICY_ENCAP34 && skb->l4_hash)
 		return skb->hash;
 
-	return __bond_xmit_hash(bond, skb, skb->data, skb->protocol,
+	/* Packets of a flow carry the same L4 flow hash, so remember the
+	 * xmit hash of recent flows instead of dissecting every packet.
+	 * The cache is only used with BHs disabled, as on the xmit path.
+	 */
+	if (skb->l4_hash && bond->hash_cache && in_softirq() &&
+	    (xmit_policy == BOND_XMIT_POLICY_LAYER34 ||
+	     xmit_policy == BOND_XMIT_POLICY_LAYER23 ||
+	     xmit_policy == BOND_XMIT_POLICY_ENCAP23)) {
+		ent = &this_cpu_ptr(bond->hash_cache)->ent[skb->hash %
+							  BOND_HASH_CACHE_SIZE];
+		if (ent->valid && ent->skb_hash == skb->hash &&
+		    ent->xmit_policy == xmit_policy)
+			return ent->hash;
+	}
+
+	hash = __bond_xmit_hash(bond, skb, skb->data, skb->protocol,
 				0, skb_network_offset(skb),
 				skb_headlen(skb));
+	if (ent) {
+		ent->skb_hash = skb->hash;
+		ent->hash = hash;
+		ent->xmit_policy = xmit_policy;
+		ent->valid = true;
+	}
+
+	return hash;
 }
 
 /**
@@ -4275,6 +4308,12 @@ static int bond_open(struct net_device *bond_dev)
 			return -ENOMEM;
 	}
 
+	if (bond_mode_can_use_xmit_hash(bond) && !bond->hash_cache) {
+		bond->hash_cache = alloc_percpu(struct bond_hash_cache);
+		if (!bond->hash_cache)
+			return -ENOMEM;
+	}
+
 	/* reset slave->backup and slave->inactive */
 	if (bond_has_slaves(bond)) {
 		bond_for_each_slave(bond, slave, iter) {
@@ -5493,6 +5532,7 @@ bond_xdp_get_xmit_slave(struct net_device *bond_dev, struct xdp_buff *xdp)
 
 	case BOND_MODE_8023AD:
 	case BOND_MODE_XOR:
+	case BOND_MODE_TLB:
 		slave = bond_xdp_xmit_3ad_xor_slave_get(bond, xdp);
 		break;
 
@@ -5853,6 +5893,7 @@ static void bond_destructor(struct net_device *bond_dev)
 		destroy_workqueue(bond->wq);
 
 	free_percpu(bond->rr_tx_counter);
+	free_percpu(bond->hash_cache);
 }
 
 void bond_setup(struct net_device *bond_dev)
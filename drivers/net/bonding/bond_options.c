@@ -1655,6 +1655,7 @@ static int bond_option_tlb_dynamic_lb_set(struct bonding *bond,
 	netdev_dbg(bond->dev, "Setting dynamic-lb to %s (%llu)\n",
 		   newval->string, newval->value);
 	bond->params.tlb_dynamic_lb = newval->value;
+	bond_xdp_set_features(bond->dev);
 
 	return 0;
 }
@@ -1350,6 +1350,48 @@ static void z_erofs_decompress_queue(const struct z_erofs_decompressqueue *io,
 	}
 }
 
+/* don't split chains which would leave either half shorter than this */
+#define Z_EROFS_SPLIT_MIN_PCLUSTERS	4
+
+static void z_erofs_decompressqueue_work(struct work_struct *work);
+
+/*
+ * Hand the second half of a long pcluster chain over to another worker,
+ * which may split it again, so that large readahead is decompressed on
+ * several CPUs rather than on the one which happened to complete the I/O.
+ */
+static void z_erofs_decompressqueue_split(struct z_erofs_decompressqueue *bgq)
+{
+	z_erofs_next_pcluster_t owned = bgq->head, *mid = &bgq->head;
+	struct z_erofs_decompressqueue *q;
+	struct z_erofs_pcluster *pcl;
+	unsigned int nr = 0;
+
+	if (num_online_cpus() < 2)
+		return;
+
+	while (owned != Z_EROFS_PCLUSTER_TAIL) {
+		pcl = container_of(owned, struct z_erofs_pcluster, next);
+		owned = READ_ONCE(pcl->next);
+		/* advance @mid every other pcluster */
+		if (++nr & 1)
+			mid = &container_of(*mid, struct z_erofs_pcluster,
+					    next)->next;
+	}
+	if (nr < 2 * Z_EROFS_SPLIT_MIN_PCLUSTERS)
+		return;
+
+	q = kvzalloc(sizeof(*q), GFP_NOIO | __GFP_NOWARN);
+	if (!q)
+		return;
+	q->sb = bgq->sb;
+	q->eio = bgq->eio;
+	q->head = *mid;
+	WRITE_ONCE(*mid, Z_EROFS_PCLUSTER_TAIL);
+	INIT_WORK(&q->u.work, z_erofs_decompressqueue_work);
+	queue_work(z_erofs_workqueue, &q->u.work);
+}
+
 static void z_erofs_decompressqueue_work(struct work_struct *work)
 {
 	struct z_erofs_decompressqueue *bgq =
@@ -1357,6 +1399,7 @@ static void z_erofs_decompressqueue_work(struct work_struct *work)
 	struct page *pagepool = NULL;
 
 	DBG_BUGON(bgq->head == Z_EROFS_PCLUSTER_TAIL);
+	z_erofs_decompressqueue_split(bgq);
 	z_erofs_decompress_queue(bgq, &pagepool);
 	erofs_release_pages(&pagepool);
 	kvfree(bgq);
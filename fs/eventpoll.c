@@ -2036,6 +2036,8 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 		 */
 		init_wait(&wait);
 		wait.func = ep_autoremove_wake_function;
+		/* Any waiter will do, let the waker pick a cache-local one. */
+		wait.flags |= WQ_FLAG_AFFINE;
 
 		write_lock_irq(&ep->lock);
 		/*
@@ -158,7 +158,9 @@ static int __revise_pending(struct inode *inode, ext4_lblk_t lblk,
 
 int __init ext4_init_es(void)
 {
-	ext4_es_cachep = KMEM_CACHE(extent_status, SLAB_RECLAIM_ACCOUNT);
+	/* see ext4_es_lookup_cached() */
+	ext4_es_cachep = KMEM_CACHE(extent_status,
+				    SLAB_RECLAIM_ACCOUNT | SLAB_TYPESAFE_BY_RCU);
 	if (ext4_es_cachep == NULL)
 		return -ENOMEM;
 	return 0;
@@ -895,6 +897,7 @@ void ext4_es_insert_extent(struct inode *inode, ext4_lblk_t lblk,
 	if ((err1 || err2 || err3) && revise_pending && !pr)
 		pr = __alloc_pending(true);
 	write_lock(&EXT4_I(inode)->i_es_lock);
+	write_seqcount_begin(&EXT4_I(inode)->i_es_seq);
 
 	err1 = __es_remove_extent(inode, lblk, end, NULL, es1);
 	if (err1 != 0)
@@ -928,6 +931,7 @@ void ext4_es_insert_extent(struct inode *inode, ext4_lblk_t lblk,
 		}
 	}
 error:
+	write_seqcount_end(&EXT4_I(inode)->i_es_seq);
 	write_unlock(&EXT4_I(inode)->i_es_lock);
 	if (err1 || err2 || err3)
 		goto retry;
@@ -963,13 +967,47 @@ void ext4_es_cache_extent(struct inode *inode, ext4_lblk_t lblk,
 	BUG_ON(end < lblk);
 
 	write_lock(&EXT4_I(inode)->i_es_lock);
+	write_seqcount_begin(&EXT4_I(inode)->i_es_seq);
 
 	es = __es_tree_search(&EXT4_I(inode)->i_es_tree.root, lblk);
 	if (!es || es->es_lblk > end)
 		__es_insert_extent(inode, &newes, NULL);
+	write_seqcount_end(&EXT4_I(inode)->i_es_seq);
 	write_unlock(&EXT4_I(inode)->i_es_lock);
 }
 
+/*
+ * Look up @lblk in the most recently used extent without i_es_lock.
+ *
+ * Every change to the tree and to cache_es happens inside an i_es_seq
+ * write section, and extent_status objects are SLAB_TYPESAFE_BY_RCU, so
+ * the copied fields can be trusted if the sequence did not change. Only
+ * extents which are already referenced qualify, since setting the flag
+ * writes to the extent.
+ */
+static bool ext4_es_lookup_cached(struct inode *inode, ext4_lblk_t lblk,
+				  struct extent_status *es)
+{
+	struct ext4_inode_info *ei = EXT4_I(inode);
+	struct extent_status *es1;
+	unsigned int seq;
+	bool found = false;
+
+	rcu_read_lock();
+	seq = read_seqcount_begin(&ei->i_es_seq);
+	es1 = READ_ONCE(ei->i_es_tree.cache_es);
+	if (es1) {
+		es->es_lblk = READ_ONCE(es1->es_lblk);
+		es->es_len = READ_ONCE(es1->es_len);
+		es->es_pblk = READ_ONCE(es1->es_pblk);
+		found = in_range(lblk, es->es_lblk, es->es_len) &&
+			ext4_es_is_referenced(es) &&
+			!read_seqcount_retry(&ei->i_es_seq, seq);
+	}
+	rcu_read_unlock();
+	return found;
+}
+
 /*
  * ext4_es_lookup_extent() looks up an extent in extent status tree.
  *
@@ -993,6 +1031,13 @@ int ext4_es_lookup_extent(struct inode *inode, ext4_lblk_t lblk,
 	trace_ext4_es_lookup_extent_enter(inode, lblk);
 	es_debug("lookup extent in block %u\n", lblk);
 
+	stats = &EXT4_SB(inode->i_sb)->s_es_stats;
+	if (!next_lblk && ext4_es_lookup_cached(inode, lblk, es)) {
+		percpu_counter_inc(&stats->es_stats_cache_hits);
+		trace_ext4_es_lookup_extent_exit(inode, es, 1);
+		return 1;
+	}
+
 	tree = &EXT4_I(inode)->i_es_tree;
 	read_lock(&EXT4_I(inode)->i_es_lock);
 
@@ -1020,7 +1065,6 @@ int ext4_es_lookup_extent(struct inode *inode, ext4_lblk_t lblk,
 	}
 
 out:
-	stats = &EXT4_SB(inode->i_sb)->s_es_stats;
 	if (found) {
 		BUG_ON(!es1);
 		es->es_lblk = es1->es_lblk;
@@ -1522,6 +1566,7 @@ void ext4_es_remove_extent(struct inode *inode, ext4_lblk_t lblk,
 	 * is reclaimed.
 	 */
 	write_lock(&EXT4_I(inode)->i_es_lock);
+	write_seqcount_begin(&EXT4_I(inode)->i_es_seq);
 	err = __es_remove_extent(inode, lblk, end, &reserved, es);
 	/* Free preallocated extent if it didn't get used. */
 	if (es) {
@@ -1529,6 +1574,7 @@ void ext4_es_remove_extent(struct inode *inode, ext4_lblk_t lblk,
 			__es_free_extent(es);
 		es = NULL;
 	}
+	write_seqcount_end(&EXT4_I(inode)->i_es_seq);
 	write_unlock(&EXT4_I(inode)->i_es_lock);
 	if (err)
 		goto retry;
@@ -1585,7 +1631,9 @@ static int __es_shrink(struct ext4_sb_info *sbi, int nr_to_scan,
 		 */
 		spin_unlock(&sbi->s_es_lock);
 
+		write_seqcount_begin(&ei->i_es_seq);
 		nr_shrunk += es_reclaim_extents(ei, &nr_to_scan);
+		write_seqcount_end(&ei->i_es_seq);
 		write_unlock(&ei->i_es_lock);
 
 		if (nr_to_scan <= 0)
@@ -1845,6 +1893,7 @@ void ext4_clear_inode_es(struct inode *inode)
 	struct rb_node *node;
 
 	write_lock(&ei->i_es_lock);
+	write_seqcount_begin(&ei->i_es_seq);
 	tree = &EXT4_I(inode)->i_es_tree;
 	tree->cache_es = NULL;
 	node = rb_first(&tree->root);
@@ -1857,6 +1906,7 @@ void ext4_clear_inode_es(struct inode *inode)
 		}
 	}
 	ext4_clear_inode_state(inode, EXT4_STATE_EXT_PRECACHED);
+	write_seqcount_end(&ei->i_es_seq);
 	write_unlock(&ei->i_es_lock);
 }
 
@@ -2091,6 +2141,7 @@ void ext4_es_insert_delayed_block(struct inode *inode, ext4_lblk_t lblk,
 	if ((err1 || err2 || err3) && allocated && !pr)
 		pr = __alloc_pending(true);
 	write_lock(&EXT4_I(inode)->i_es_lock);
+	write_seqcount_begin(&EXT4_I(inode)->i_es_seq);
 
 	err1 = __es_remove_extent(inode, lblk, lblk, NULL, es1);
 	if (err1 != 0)
@@ -2122,6 +2173,7 @@ void ext4_es_insert_delayed_block(struct inode *inode, ext4_lblk_t lblk,
 		}
 	}
 error:
+	write_seqcount_end(&EXT4_I(inode)->i_es_seq);
 	write_unlock(&EXT4_I(inode)->i_es_lock);
 	if (err1 || err2 || err3)
 		goto retry;
@@ -246,29 +246,55 @@ static int expand_files(struct files_struct *files, unsigned int nr)
 	return expanded;
 }
 
+/*
+ * The fd bitmaps are modified without files->file_lock by alloc_fd(), so
+ * all updates to them have to be atomic.
+ */
 static inline void __set_close_on_exec(unsigned int fd, struct fdtable *fdt)
 {
-	__set_bit(fd, fdt->close_on_exec);
+	set_bit(fd, fdt->close_on_exec);
 }
 
 static inline void __clear_close_on_exec(unsigned int fd, struct fdtable *fdt)
 {
 	if (test_bit(fd, fdt->close_on_exec))
-		__clear_bit(fd, fdt->close_on_exec);
+		clear_bit(fd, fdt->close_on_exec);
 }
 
-static inline void __set_open_fd(unsigned int fd, struct fdtable *fdt)
+/*
+ * Claim @fd in the open_fds bitmap. Returns true if somebody else had
+ * already claimed it.
+ */
+static inline bool __test_and_set_open_fd(unsigned int fd, struct fdtable *fdt)
 {
-	__set_bit(fd, fdt->open_fds);
+	if (test_and_set_bit(fd, fdt->open_fds))
+		return true;
 	fd /= BITS_PER_LONG;
-	if (!~fdt->open_fds[fd])
-		__set_bit(fd, fdt->full_fds_bits);
+	if (!~READ_ONCE(fdt->open_fds[fd])) {
+		set_bit(fd, fdt->full_fds_bits);
+		/*
+		 * A concurrent __clear_open_fd() may have cleared the
+		 * full bit before we set it; never leave it set on a
+		 * word with free slots, find_next_fd() would skip it.
+		 */
+		smp_mb__after_atomic();
+		if (~READ_ONCE(fdt->open_fds[fd]))
+			clear_bit(fd, fdt->full_fds_bits);
+	}
+	return false;
+}
+
+static inline void __set_open_fd(unsigned int fd, struct fdtable *fdt)
+{
+	__test_and_set_open_fd(fd, fdt);
 }
 
 static inline void __clear_open_fd(unsigned int fd, struct fdtable *fdt)
 {
-	__clear_bit(fd, fdt->open_fds);
-	__clear_bit(fd / BITS_PER_LONG, fdt->full_fds_bits);
+	clear_bit(fd, fdt->open_fds);
+	/* pairs with smp_mb__after_atomic() in __test_and_set_open_fd() */
+	smp_mb__after_atomic();
+	clear_bit(fd / BITS_PER_LONG, fdt->full_fds_bits);
 }
 
 static inline bool fd_is_open(unsigned int fd, const struct fdtable *fdt)
@@ -385,9 +411,23 @@ struct files_struct *dup_fd(struct files_struct *oldf, unsigned int max_fds, int
 	new_fds = new_fdt->fd;
 
 	for (i = open_files; i != 0; i--) {
-		struct file *f = *old_fds++;
+		/* pairs with rcu_assign_pointer() in fd_install() */
+		struct file *f = smp_load_acquire(old_fds);
+
+		old_fds++;
 		if (f) {
+			unsigned int fd = open_files - i;
+
 			get_file(f);
+			/*
+			 * alloc_fd() claims descriptors without the file_lock,
+			 * so the bitmaps copied above may predate the claim.
+			 */
+			__set_open_fd(fd, new_fdt);
+			if (test_bit(fd, old_fdt->close_on_exec))
+				__set_close_on_exec(fd, new_fdt);
+			else
+				__clear_close_on_exec(fd, new_fdt);
 		} else {
 			/*
 			 * The fd may be claimed in the fd bitmap but not yet
@@ -498,8 +538,80 @@ static unsigned int find_next_fd(struct fdtable *fdt, unsigned int start)
 	return find_next_zero_bit(fdt->open_fds, maxfd, start);
 }
 
+/*
+ * All fds below files->next_fd are in use. Lower it to a freed @fd; this
+ * races with claim_next_fd() advancing it without the file_lock.
+ */
+static void fd_lower_next_fd(struct files_struct *files, unsigned int fd)
+{
+	unsigned int old = READ_ONCE(files->next_fd);
+
+	while (fd < old && !try_cmpxchg(&files->next_fd, &old, fd))
+		;
+}
+
+/*
+ * Claim the lowest free fd at or above @start and files->next_fd.
+ *
+ * Both the lockless fast path and the locked slow path of alloc_fd() use
+ * this, so the slot is taken with an atomic test-and-set and next_fd is
+ * only advanced with cmpxchg. Returns the claimed fd, or a value of at
+ * least min(@end, fdt->max_fds) if no slot below that is free.
+ */
+static unsigned int claim_next_fd(struct files_struct *files,
+				  struct fdtable *fdt,
+				  unsigned int start, unsigned int end)
+{
+	unsigned int next = READ_ONCE(files->next_fd);
+	unsigned int fd = max(start, next);
+	unsigned int free;
+
+	for (;;) {
+		fd = find_next_fd(fdt, fd);
+		if (fd >= end || fd >= fdt->max_fds)
+			return fd;
+		if (!__test_and_set_open_fd(fd, fdt))
+			break;
+		fd++;
+	}
+
+	if (start > next || cmpxchg(&files->next_fd, next, fd + 1) != next)
+		return fd;
+
+	/*
+	 * An fd between next and ours may have been closed after we passed
+	 * it. Its __put_unused_fd() either saw our new next_fd and lowered
+	 * it, or we see the cleared bit here; the cmpxchg above is fully
+	 * ordered and pairs with smp_mb__after_atomic() there.
+	 */
+	free = find_next_zero_bit(fdt->open_fds, fd, next);
+	if (free < fd)
+		fd_lower_next_fd(files, free);
+	return fd;
+}
+
+static void fd_claimed(struct fdtable *fdt, unsigned int fd, unsigned flags)
+{
+	if (flags & O_CLOEXEC)
+		__set_close_on_exec(fd, fdt);
+	else
+		__clear_close_on_exec(fd, fdt);
+#if 1
+	/* Sanity check */
+	if (rcu_access_pointer(fdt->fd[fd]) != NULL) {
+		printk(KERN_WARNING "alloc_fd: slot %d not NULL!\n", fd);
+		rcu_assign_pointer(fdt->fd[fd], NULL);
+	}
+#endif
+}
+
 /*
  * allocate a file descriptor, mark it busy.
+ *
+ * Descriptors are claimed locklessly under rcu_read_lock_sched(), like
+ * fd_install() stores them. Only growing the table needs the file_lock;
+ * expand_fdtable() waits for lockless claimers on the old table before
+ * copying it.
  */
 static int alloc_fd(unsigned start, unsigned end, unsigned flags)
 {
@@ -508,15 +620,28 @@ static int alloc_fd(unsigned start, unsigned end, unsigned flags)
 	int error;
 	struct fdtable *fdt;
 
+	rcu_read_lock_sched();
+	if (likely(!files->resize_in_progress)) {
+		/* coupled with smp_wmb() in expand_fdtable() */
+		smp_rmb();
+		fdt = rcu_dereference_sched(files->fdt);
+		fd = claim_next_fd(files, fdt, start, end);
+		if (fd < end && fd < fdt->max_fds) {
+			fd_claimed(fdt, fd, flags);
+			rcu_read_unlock_sched();
+			return fd;
+		}
+		if (fd >= end) {
+			rcu_read_unlock_sched();
+			return -EMFILE;
+		}
+	}
+	rcu_read_unlock_sched();
+
 	spin_lock(&files->file_lock);
 repeat:
 	fdt = files_fdtable(files);
-	fd = start;
-	if (fd < files->next_fd)
-		fd = files->next_fd;
-
-	if (fd < fdt->max_fds)
-		fd = find_next_fd(fdt, fd);
+	fd = claim_next_fd(files, fdt, start, end);
 
 	/*
 	 * N.B. For clone tasks sharing a files structure, this test
@@ -526,33 +651,19 @@ static int alloc_fd(unsigned start, unsigned end, unsigned flags)
 	if (fd >= end)
 		goto out;
 
-	error = expand_files(files, fd);
-	if (error < 0)
-		goto out;
-
-	/*
-	 * If we needed to expand the fs array we
-	 * might have blocked - try again.
-	 */
-	if (error)
+	if (fd >= fdt->max_fds) {
+		error = expand_files(files, fd);
+		if (error < 0)
+			goto out;
+		/*
+		 * We needed to expand the fs array and might have
+		 * blocked - try again.
+		 */
 		goto repeat;
+	}
 
-	if (start <= files->next_fd)
-		files->next_fd = fd + 1;
-
-	__set_open_fd(fd, fdt);
-	if (flags & O_CLOEXEC)
-		__set_close_on_exec(fd, fdt);
-	else
-		__clear_close_on_exec(fd, fdt);
+	fd_claimed(fdt, fd, flags);
 	error = fd;
-#if 1
-	/* Sanity check */
-	if (rcu_access_pointer(fdt->fd[fd]) != NULL) {
-		printk(KERN_WARNING "alloc_fd: slot %d not NULL!\n", fd);
-		rcu_assign_pointer(fdt->fd[fd], NULL);
-	}
-#endif
 
 out:
 	spin_unlock(&files->file_lock);
@@ -574,8 +685,9 @@ static void __put_unused_fd(struct files_struct *files, unsigned int fd)
 {
 	struct fdtable *fdt = files_fdtable(files);
 	__clear_open_fd(fd, fdt);
-	if (fd < files->next_fd)
-		files->next_fd = fd;
+	/* pairs with the cmpxchg in claim_next_fd() */
+	smp_mb__after_atomic();
+	fd_lower_next_fd(files, fd);
 }
 
 void put_unused_fd(unsigned int fd)
@@ -700,8 +812,13 @@ static inline void __range_cloexec(struct files_struct *cur_fds,
 	spin_lock(&cur_fds->file_lock);
 	fdt = files_fdtable(cur_fds);
 	max_fd = min(last_fd(fdt), max_fd);
-	if (fd <= max_fd)
-		bitmap_set(fdt->close_on_exec, fd, max_fd - fd + 1);
+	/* alloc_fd() may update bits in partial words concurrently */
+	for (; fd <= max_fd && fd % BITS_PER_LONG; fd++)
+		__set_close_on_exec(fd, fdt);
+	for (; fd + BITS_PER_LONG - 1 <= max_fd; fd += BITS_PER_LONG)
+		WRITE_ONCE(fdt->close_on_exec[fd / BITS_PER_LONG], ~0UL);
+	for (; fd <= max_fd; fd++)
+		__set_close_on_exec(fd, fdt);
 	spin_unlock(&cur_fds->file_lock);
 }
 
@@ -1249,11 +1366,10 @@ __releases(&files->file_lock)
 	 */
 	fdt = files_fdtable(files);
 	tofree = fdt->fd[fd];
-	if (!tofree && fd_is_open(fd, fdt))
+	if (!tofree && __test_and_set_open_fd(fd, fdt))
 		goto Ebusy;
 	get_file(file);
 	rcu_assign_pointer(fdt->fd[fd], file);
-	__set_open_fd(fd, fdt);
 	if (flags & O_CLOEXEC)
 		__set_close_on_exec(fd, fdt);
 	else
@@ -21,8 +21,22 @@ static void fuse_file_accessed(struct file *file)
 static void fuse_file_modified(struct file *file)
 {
 	struct inode *inode = file_inode(file);
-
-	fuse_invalidate_attr_mask(inode, FUSE_STATX_MODSIZE);
+	struct fuse_file *ff = file->private_data;
+	struct inode *backing_inode = file_inode(fuse_file_passthrough(ff));
+	struct fuse_conn *fc = get_fuse_conn(inode);
+	struct fuse_inode *fi = get_fuse_inode(inode);
+
+	/*
+	 * The backing file holds the data, so its size is authoritative.
+	 * Take it over rather than invalidating it, so that e.g. a following
+	 * lseek(SEEK_END) doesn't need a round trip to the server.
+	 */
+	spin_lock(&fi->lock);
+	fi->attr_version = atomic64_inc_return(&fc->attr_version);
+	i_size_write(inode, i_size_read(backing_inode));
+	spin_unlock(&fi->lock);
+
+	fuse_invalidate_attr_mask(inode, FUSE_STATX_MODIFY);
 }
 
 ssize_t fuse_passthrough_read_iter(struct kiocb *iocb, struct iov_iter *iter)
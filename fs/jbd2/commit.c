@@ -1162,5 +1162,8 @@ void jbd2_journal_commit_transaction(journal_t *journal)
 	journal->j_stats.run.rs_handle_count += stats.run.rs_handle_count;
 	journal->j_stats.run.rs_blocks += stats.run.rs_blocks;
 	journal->j_stats.run.rs_blocks_logged += stats.run.rs_blocks_logged;
+	journal->j_stats.ts_commit_hist[min_t(unsigned int,
+			ilog2(div_u64(commit_time, NSEC_PER_USEC) | 1),
+			JBD2_COMMIT_HIST_BUCKETS - 1)]++;
 	spin_unlock(&journal->j_history_lock);
 }
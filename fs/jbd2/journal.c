@@ -1158,6 +1158,7 @@ static void *jbd2_seq_info_next(struct seq_file *seq, void *v, loff_t *pos)
 static int jbd2_seq_info_show(struct seq_file *seq, void *v)
 {
 	struct jbd2_stats_proc_session *s = seq->private;
+	int i;
 
 	if (v != SEQ_START_TOKEN)
 		return 0;
@@ -1189,6 +1190,17 @@ static int jbd2_seq_info_show(struct seq_file *seq, void *v)
 	    s->stats->run.rs_blocks / s->stats->ts_tid);
 	seq_printf(seq, "  %lu logged blocks per transaction\n",
 	    s->stats->run.rs_blocks_logged / s->stats->ts_tid);
+	seq_puts(seq, "commit time:\n");
+	for (i = 0; i < JBD2_COMMIT_HIST_BUCKETS; i++) {
+		if (!s->stats->ts_commit_hist[i])
+			continue;
+		if (i == JBD2_COMMIT_HIST_BUCKETS - 1)
+			seq_printf(seq, "  >= %luus: %lu\n", 1UL << i,
+				   s->stats->ts_commit_hist[i]);
+		else
+			seq_printf(seq, "  < %luus: %lu\n", 2UL << i,
+				   s->stats->ts_commit_hist[i]);
+	}
 	return 0;
 }
 
@@ -1003,12 +1003,13 @@ nfsd_file_do_acquire(struct svc_rqst *rqstp, struct svc_fh *fhp,
 
 	if (nf) {
 		/*
-		 * If the nf is on the LRU then it holds an extra reference
-		 * that must be put if it's removed. It had better not be
-		 * the last one however, since we should hold another.
+		 * Leave the nf on the LRU, along with the reference held on
+		 * its behalf, rather than taking the LRU lock twice per RPC.
+		 * The laundrette drops entries that are in use from the LRU,
+		 * and the final nfsd_file_put() puts them back. Just mark it
+		 * referenced so that it isn't considered idle.
 		 */
-		if (nfsd_file_lru_remove(nf))
-			WARN_ON_ONCE(refcount_dec_and_test(&nf->nf_ref));
+		set_bit(NFSD_FILE_REFERENCED, &nf->nf_flags);
 		goto wait_for_construction;
 	}
 
@@ -36,6 +36,7 @@
 #include <linux/net.h>
 #include <linux/socket.h>
 #include <linux/sched/signal.h>
+#include <linux/sizes.h>
 
 #include "internal.h"
 
@@ -1014,6 +1015,36 @@ ssize_t vfs_splice_read(struct file *in, loff_t *ppos,
 }
 EXPORT_SYMBOL_GPL(vfs_splice_read);
 
+/* Capacity of the internal pipe, capped by pipe-max-size */
+#define SPLICE_DIRECT_PIPE_SIZE		SZ_256K
+
+/*
+ * Every round trip through the internal pipe costs a ->splice_read() and
+ * an actor call, so let it move more than a default pipe's worth at a time.
+ * It is charged to the user like any other pipe. As every task that ever
+ * used sendfile() keeps its internal pipe, it is only grown while that
+ * leaves the user at least half of the pipe buffer limits, so it can't
+ * push regular pipes of the user down to PIPE_MIN_DEF_BUFFERS.
+ */
+static void splice_direct_grow_pipe(struct pipe_inode_info *pipe)
+{
+	unsigned long user_bufs;
+	unsigned int nr_slots;
+
+	nr_slots = round_pipe_size(min_t(unsigned int, SPLICE_DIRECT_PIPE_SIZE,
+					 pipe_max_user_size())) >> PAGE_SHIFT;
+	if (nr_slots <= pipe->ring_size)
+		return;
+
+	user_bufs = account_pipe_buffers(pipe->user, pipe->nr_accounted,
+					 nr_slots);
+	if (too_many_pipe_buffers_soft(2 * user_bufs) ||
+	    too_many_pipe_buffers_hard(2 * user_bufs) ||
+	    pipe_resize_ring(pipe, nr_slots) < 0)
+		(void) account_pipe_buffers(pipe->user, nr_slots,
+					    pipe->nr_accounted);
+}
+
 /**
  * splice_direct_to_actor - splices data directly between two non-pipes
  * @in:		file to splice from
@@ -1060,6 +1091,8 @@ ssize_t splice_direct_to_actor(struct file *in, struct splice_desc *sd,
 		 */
 		pipe->readers = 1;
 
+		splice_direct_grow_pipe(pipe);
+
 		current->splice_pipe = pipe;
 	}
 
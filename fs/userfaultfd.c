@@ -1498,7 +1498,8 @@ static int userfaultfd_register(struct userfaultfd_ctx *ctx,
 
 		/* CONTINUE ioctl is only supported for MINOR ranges. */
 		if (!(uffdio_register.mode & UFFDIO_REGISTER_MODE_MINOR))
-			ioctls_out &= ~((__u64)1 << _UFFDIO_CONTINUE);
+			ioctls_out &= ~((__u64)1 << _UFFDIO_CONTINUE |
+					(__u64)1 << _UFFDIO_CONTINUE_VEC);
 
 		/*
 		 * Now that we scanned all vmas we can already tell
@@ -1963,6 +1964,51 @@ static inline int userfaultfd_poison(struct userfaultfd_ctx *ctx, unsigned long
 	return ret;
 }
 
+/*
+ * Resolve an array of UFFDIO_COPY or UFFDIO_CONTINUE requests in one
+ * syscall.  Each entry goes through the single range handler, which
+ * reports its own progress, and the walk stops at the first entry that
+ * is not fully resolved.
+ */
+static int userfaultfd_vec(struct userfaultfd_ctx *ctx, unsigned long arg,
+			   int (*fn)(struct userfaultfd_ctx *, unsigned long),
+			   size_t entry_size)
+{
+	struct uffdio_vec uffdio_vec;
+	struct uffdio_vec __user *user_uffdio_vec;
+	unsigned long entries;
+	__s64 done;
+	int ret = 0;
+
+	user_uffdio_vec = (struct uffdio_vec __user *)arg;
+
+	if (copy_from_user(&uffdio_vec, user_uffdio_vec,
+			   /* don't copy "done" last field */
+			   sizeof(uffdio_vec) - sizeof(__s64)))
+		return -EFAULT;
+
+	if (uffdio_vec.nr > ULONG_MAX / entry_size)
+		return -EINVAL;
+	entries = uffdio_vec.entries;
+	if (!access_ok((void __user *)entries, uffdio_vec.nr * entry_size))
+		return -EFAULT;
+
+	for (done = 0; done < uffdio_vec.nr; done++) {
+		if (fatal_signal_pending(current)) {
+			ret = -EINTR;
+			break;
+		}
+		ret = fn(ctx, entries + done * entry_size);
+		if (ret)
+			break;
+		cond_resched();
+	}
+
+	if (unlikely(put_user(done, &user_uffdio_vec->done)))
+		return -EFAULT;
+	return ret;
+}
+
 bool userfaultfd_wp_async(struct vm_area_struct *vma)
 {
 	return userfaultfd_wp_async_ctx(vma->vm_userfaultfd_ctx.ctx);
@@ -2147,6 +2193,14 @@ static long userfaultfd_ioctl(struct file *file, unsigned cmd,
 	case UFFDIO_POISON:
 		ret = userfaultfd_poison(ctx, arg);
 		break;
+	case UFFDIO_COPY_VEC:
+		ret = userfaultfd_vec(ctx, arg, userfaultfd_copy,
+				      sizeof(struct uffdio_copy));
+		break;
+	case UFFDIO_CONTINUE_VEC:
+		ret = userfaultfd_vec(ctx, arg, userfaultfd_continue,
+				      sizeof(struct uffdio_continue));
+		break;
 	}
 	return ret;
 }
@@ -75,9 +75,11 @@ xfs_buf_is_vmapped(
 	 *
 	 * b_addr is null if the buffer is not mapped, but the code is clever
 	 * enough to know it doesn't have to map a single page, so the check has
-	 * to be both for b_addr and bp->b_page_count > 1.
+	 * to be both for b_addr and bp->b_page_count > 1. Contiguous buffers
+	 * are addressed through the direct map.
 	 */
-	return bp->b_addr && bp->b_page_count > 1;
+	return bp->b_addr && bp->b_page_count > 1 &&
+		!(bp->b_flags & _XBF_CONTIG);
 }
 
 static inline int
@@ -298,7 +300,7 @@ xfs_buf_free_pages(
 	if (bp->b_pages != bp->b_page_array)
 		kfree(bp->b_pages);
 	bp->b_pages = NULL;
-	bp->b_flags &= ~_XBF_PAGES;
+	bp->b_flags &= ~(_XBF_PAGES | _XBF_CONTIG);
 }
 
 static void
@@ -387,6 +389,31 @@ xfs_buf_alloc_pages(
 	if (!(flags & XBF_READ))
 		gfp_mask |= __GFP_ZERO;
 
+	/*
+	 * Try a physically contiguous allocation first, so that the buffer can
+	 * be addressed through the direct map instead of being vmapped. The
+	 * allocation is split so that its pages are freed like bulk ones.
+	 */
+	if (bp->b_page_count > 1) {
+		unsigned int	order = get_order(BBTOB(bp->b_length));
+		struct page	*page;
+		unsigned int	i;
+
+		page = alloc_pages(gfp_mask | __GFP_NORETRY, order);
+		if (page) {
+			split_page(page, order);
+			for (i = 0; i < (1U << order); i++) {
+				if (i < bp->b_page_count)
+					bp->b_pages[i] = page + i;
+				else
+					__free_page(page + i);
+			}
+			bp->b_flags |= _XBF_CONTIG;
+			XFS_STATS_INC(bp->b_mount, xb_page_found);
+			return 0;
+		}
+	}
+
 	/*
 	 * Bulk filling of pages can take multiple calls. Not filling the entire
 	 * array is not an allocation failure, so don't back off if we get at
@@ -428,6 +455,9 @@ _xfs_buf_map_pages(
 	if (bp->b_page_count == 1) {
 		/* A single page buffer is always mappable */
 		bp->b_addr = page_address(bp->b_pages[0]);
+	} else if (bp->b_flags & _XBF_CONTIG) {
+		/* So is a physically contiguous one */
+		bp->b_addr = page_address(bp->b_pages[0]);
 	} else if (flags & XBF_UNMAPPED) {
 		bp->b_addr = NULL;
 	} else {
@@ -582,7 +612,7 @@ xfs_buf_find_lock(
 			return -ENOENT;
 		}
 		ASSERT((bp->b_flags & _XBF_DELWRI_Q) == 0);
-		bp->b_flags &= _XBF_KMEM | _XBF_PAGES;
+		bp->b_flags &= _XBF_KMEM | _XBF_PAGES | _XBF_CONTIG;
 		bp->b_ops = NULL;
 	}
 	return 0;
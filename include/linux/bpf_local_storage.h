@@ -16,7 +16,11 @@
 #include <linux/bpf_mem_alloc.h>
 #include <uapi/linux/btf.h>
 
+#ifdef CONFIG_BPF_LOCAL_STORAGE_CACHE_SIZE
+#define BPF_LOCAL_STORAGE_CACHE_SIZE	CONFIG_BPF_LOCAL_STORAGE_CACHE_SIZE
+#else
 #define BPF_LOCAL_STORAGE_CACHE_SIZE	16
+#endif
 
 #define bpf_rcu_lock_held()                                                    \
 	(rcu_read_lock_held() || rcu_read_lock_trace_held() ||                 \
@@ -109,8 +113,6 @@ struct bpf_local_storage {
 	container_of((_SDATA), struct bpf_local_storage_elem, sdata)
 #define SDATA(_SELEM) (&(_SELEM)->sdata)
 
-#define BPF_LOCAL_STORAGE_CACHE_SIZE	16
-
 struct bpf_local_storage_cache {
 	spinlock_t idx_lock;
 	u64 idx_usage_counts[BPF_LOCAL_STORAGE_CACHE_SIZE];
@@ -541,6 +541,31 @@ struct damon_callback {
 	void (*before_terminate)(struct damon_ctx *context);
 };
 
+/**
+ * struct damon_intervals_goal - Monitoring intervals auto-tuning goal.
+ *
+ * @access_bp:		Access events observation ratio to achieve in bp.
+ * @aggrs:		Number of aggregations to observe before each tuning.
+ * @min_sample_us:	Minimum resulting sampling interval in microseconds.
+ * @max_sample_us:	Maximum resulting sampling interval in microseconds,
+ *			or zero for no limit.
+ *
+ * DAMON sees at most &damon_attrs->aggr_interval /
+ * &damon_attrs->sample_interval access events per region per aggregation.
+ * If @access_bp and @aggrs are non-zero, DAMON measures the ratio of the
+ * size-weighted access events it observed during @aggrs aggregations to
+ * that maximum, and scales the sampling and aggregation intervals together
+ * (keeping their ratio) so that the ratio approaches @access_bp.  Too few
+ * observed events means the intervals are too short to see the workload's
+ * accesses; too many means they are needlessly long.
+ */
+struct damon_intervals_goal {
+	unsigned long access_bp;
+	unsigned long aggrs;
+	unsigned long min_sample_us;
+	unsigned long max_sample_us;
+};
+
 /**
  * struct damon_attrs - Monitoring attributes for accuracy/overhead control.
  *
@@ -551,6 +576,7 @@ struct damon_callback {
  *				regions.
  * @max_nr_regions:		The maximum number of adaptive monitoring
  *				regions.
+ * @intervals_goal:		Intervals auto-tuning goal.
  *
  * For each @sample_interval, DAMON checks whether each region is accessed or
  * not during the last @sample_interval.  If such access is found, DAMON
@@ -568,6 +594,7 @@ struct damon_attrs {
 	unsigned long ops_update_interval;
 	unsigned long min_nr_regions;
 	unsigned long max_nr_regions;
+	struct damon_intervals_goal intervals_goal;
 };
 
 /**
@@ -616,6 +643,10 @@ struct damon_ctx {
 	 * update
 	 */
 	unsigned long next_ops_update_sis;
+	/* aggregations observed, and their access events, for intervals_goal */
+	unsigned long nr_tune_aggrs;
+	u64 tune_access_events;
+	u64 tune_max_access_events;
 	/* for waiting until the execution of the kdamond_fn is started */
 	struct completion kdamond_started;
 
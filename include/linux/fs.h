@@ -461,10 +461,13 @@ extern const struct address_space_operations empty_aops;
  * @i_private_lock: For use by the owner of the address_space.
  * @i_private_list: For use by the owner of the address_space.
  * @i_private_data: For use by the owner of the address_space.
+ * @i_pages_delete_seqcnt: Bumped when folios are deleted from @i_pages, for
+ *   page cache readers that don't hold a folio reference.
  */
 struct address_space {
 	struct inode		*host;
 	struct xarray		i_pages;
+	seqcount_spinlock_t	i_pages_delete_seqcnt;
 	struct rw_semaphore	invalidate_lock;
 	gfp_t			gfp_mask;
 	atomic_t		i_mmap_writable;
@@ -963,6 +966,7 @@ struct fown_struct {
  *      the first of these pages is accessed.
  * @ra_pages: Maximum size of a readahead request, copied from the bdi.
  * @mmap_miss: How many mmap accesses missed in the page cache.
+ * @stride: Gap in pages between the two most recent random reads.
  * @prev_pos: The last byte in the most recent read request.
  *
  * When this structure is passed to ->readahead(), the "most recent"
@@ -974,6 +978,7 @@ struct file_ra_state {
 	unsigned int async_size;
 	unsigned int ra_pages;
 	unsigned int mmap_miss;
+	unsigned int stride;
 	loff_t prev_pos;
 };
 
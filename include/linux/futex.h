@@ -4,6 +4,7 @@
 
 #include <linux/sched.h>
 #include <linux/ktime.h>
+#include <linux/mm_types.h>
 
 #include <uapi/linux/futex.h>
 
@@ -47,10 +48,11 @@ union futex_key {
 		u64 ptr;
 		unsigned long word;
 		unsigned int offset;
+		int node;	/* FUTEX2_NUMA node, part of the match */
 	} both;
 };
 
-#define FUTEX_KEY_INIT (union futex_key) { .both = { .ptr = 0ULL } }
+#define FUTEX_KEY_INIT (union futex_key) { .both = { .ptr = 0ULL, .node = FUTEX_NO_NODE } }
 
 #ifdef CONFIG_FUTEX
 enum {
@@ -90,4 +92,26 @@ static inline long do_futex(u32 __user *uaddr, int op, u32 val,
 }
 #endif
 
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+static inline void futex_mm_init(struct mm_struct *mm)
+{
+	mm->futex_phash = NULL;
+	mm->futex_phash_slots = 0;
+}
+
+void futex_hash_allocate_default(unsigned long clone_flags);
+void futex_hash_free(struct mm_struct *mm);
+int futex_hash_prctl(unsigned long arg2, unsigned long arg3,
+		     unsigned long arg4, unsigned long arg5);
+#else
+static inline void futex_mm_init(struct mm_struct *mm) { }
+static inline void futex_hash_allocate_default(unsigned long clone_flags) { }
+static inline void futex_hash_free(struct mm_struct *mm) { }
+static inline int futex_hash_prctl(unsigned long arg2, unsigned long arg3,
+				   unsigned long arg4, unsigned long arg5)
+{
+	return -EINVAL;
+}
+#endif
+
 #endif
@@ -371,6 +371,7 @@ extern int schedule_hrtimeout(ktime_t *expires, const enum hrtimer_mode mode);
 
 /* Soft interrupt function to run the hrtimer queues: */
 extern void hrtimer_run_queues(void);
+extern void hrtimer_flush_deferred_reprogram(void);
 
 /* Bootup initialization: */
 extern void __init hrtimers_init(void);
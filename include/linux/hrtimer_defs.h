@@ -79,6 +79,8 @@ enum  hrtimer_base_type {
  * @hang_detected:	The last hrtimer interrupt detected a hang
  * @softirq_activated:	displays, if the softirq is raised - update of softirq
  *			related settings is not required then.
+ * @deferred_reprogram:	expires_next was moved earlier from softirq context
+ *			without reprogramming the clock event device yet
  * @nr_events:		Total number of hrtimer interrupt events
  * @nr_retries:		Total number of hrtimer interrupt retries
  * @nr_hangs:		Total number of hrtimer interrupt hangs
@@ -110,6 +112,7 @@ struct hrtimer_cpu_base {
 					hang_detected		: 1,
 					softirq_activated       : 1,
 					online			: 1;
+	bool				deferred_reprogram;
 #ifdef CONFIG_HIGH_RES_TIMERS
 	unsigned int			nr_events;
 	unsigned short			nr_retries;
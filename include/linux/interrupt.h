@@ -69,6 +69,9 @@
  *		   depends on IRQF_PERCPU.
  * IRQF_COND_ONESHOT - Agree to do IRQF_ONESHOT if already set for a shared
  *                 interrupt.
+ * IRQF_POLL - Threaded handler polls with a budget and the line is kept
+ *             masked until the handler reports the device idle by returning
+ *             IRQ_NONE. Implies IRQF_ONESHOT, not allowed with IRQF_SHARED.
  */
 #define IRQF_SHARED		0x00000080
 #define IRQF_PROBE_SHARED	0x00000100
@@ -85,6 +88,7 @@
 #define IRQF_NO_AUTOEN		0x00080000
 #define IRQF_NO_DEBUG		0x00100000
 #define IRQF_COND_ONESHOT	0x00200000
+#define IRQF_POLL		0x00400000
 
 #define IRQF_TIMER		(__IRQF_TIMER | IRQF_NO_SUSPEND | IRQF_NO_THREAD)
 
@@ -117,6 +121,8 @@ typedef irqreturn_t (*irq_handler_t)(int, void *);
  * @thread_flags:	flags related to @thread
  * @thread_mask:	bitmask for keeping track of @thread activity
  * @dir:	pointer to the proc/irq/NN/name entry
+ * @poll_wakeups:	IRQF_POLL: number of thread wakeups, including requeues
+ * @poll_rounds:	IRQF_POLL: number of handler invocations which found work
  */
 struct irqaction {
 	irq_handler_t		handler;
@@ -132,6 +138,8 @@ struct irqaction {
 	unsigned long		thread_mask;
 	const char		*name;
 	struct proc_dir_entry	*dir;
+	unsigned long		poll_wakeups;
+	unsigned long		poll_rounds;
 } ____cacheline_internodealigned_in_smp;
 
 extern irqreturn_t no_action(int cpl, void *dev_id);
@@ -293,6 +293,7 @@ struct io_ring_ctx {
 		struct io_alloc_cache	netmsg_cache;
 		struct io_alloc_cache	rw_cache;
 		struct io_alloc_cache	uring_cache;
+		struct io_alloc_cache	timeout_cache;
 
 		/*
 		 * Any cancelable uring_cmd is added to this list in
@@ -399,6 +400,9 @@ struct io_ring_ctx {
 	struct io_alloc_cache		msg_cache;
 	spinlock_t			msg_lock;
 
+	/* per-opcode stats, IFF IORING_SETUP_OP_STATS is set */
+	struct io_op_stats		*op_stats;
+
 #ifdef CONFIG_NET_RX_BUSY_POLL
 	struct list_head	napi_list;	/* track busy poll napi_id */
 	spinlock_t		napi_lock;	/* napi_list lock */
@@ -407,6 +411,7 @@ struct io_ring_ctx {
 	unsigned int		napi_busy_poll_to;
 	bool			napi_prefer_busy_poll;
 	bool			napi_enabled;
+	u8			napi_track_mode;
 
 	DECLARE_HASHTABLE(napi_ht, 4);
 #endif
@@ -651,6 +656,11 @@ struct io_kiocb {
 	void				*async_data;
 	/* linked requests, IFF REQ_F_HARDLINK or REQ_F_LINK are set */
 	atomic_t			poll_refs;
+	/*
+	 * submission time in usecs, truncated to fit the hole before ->link,
+	 * valid IFF IORING_SETUP_OP_STATS is set
+	 */
+	u32				submit_us;
 	struct io_kiocb			*link;
 	/* custom credentials, valid IFF REQ_F_CREDS is set */
 	const struct cred		*creds;
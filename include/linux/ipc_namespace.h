@@ -64,6 +64,7 @@ struct ipc_namespace {
 	unsigned int    mq_msgsize_max;  /* initialized to DFLT_MSGSIZEMAX */
 	unsigned int    mq_msg_default;
 	unsigned int    mq_msgsize_default;
+	unsigned int    mq_zerocopy_min; /* 0 disables zero-copy sends */
 
 	struct ctl_table_set	mq_set;
 	struct ctl_table_header	*mq_sysctls;
@@ -721,10 +721,14 @@ struct transaction_run_stats_s {
 	__u32			rs_blocks_logged;
 };
 
+/* Commit time buckets, bucket n counts commits of less than 2^(n+1) us */
+#define JBD2_COMMIT_HIST_BUCKETS	24
+
 struct transaction_stats_s {
 	unsigned long		ts_tid;
 	unsigned long		ts_requested;
 	struct transaction_run_stats_s run;
+	unsigned long		ts_commit_hist[JBD2_COMMIT_HIST_BUCKETS];
 };
 
 static inline unsigned long
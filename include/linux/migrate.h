@@ -57,6 +57,22 @@ struct movable_operations {
 	void (*putback_page)(struct page *);
 };
 
+/**
+ * struct migrate_copy_ops - Offloaded folio copy for migration
+ * @copy:
+ * Copy the contents of @src to @dst, e.g. with a DMA engine. Called in
+ * process context with both folios locked and @src unmapped; may sleep.
+ * Return 0 on success. On error the VM falls back to copying with the CPU.
+ *
+ * @min_order:
+ * Folios of a smaller order are always copied by the CPU, as the setup cost
+ * of the offload would outweigh the copy.
+ */
+struct migrate_copy_ops {
+	int (*copy)(struct folio *dst, struct folio *src);
+	unsigned int min_order;
+};
+
 /* Defined in mm/debug.c: */
 extern const char *migrate_reason_names[MR_TYPES];
 
@@ -81,6 +97,8 @@ void folio_migrate_flags(struct folio *newfolio, struct folio *folio);
 void folio_migrate_copy(struct folio *newfolio, struct folio *folio);
 int folio_migrate_mapping(struct address_space *mapping,
 		struct folio *newfolio, struct folio *folio, int extra_count);
+int migrate_register_copy_ops(const struct migrate_copy_ops *ops);
+void migrate_unregister_copy_ops(const struct migrate_copy_ops *ops);
 
 #else
 
@@ -31,6 +31,7 @@
 
 struct address_space;
 struct mem_cgroup;
+struct futex_hash_bucket;
 
 /*
  * Each physical page in the system has a struct page associated with
@@ -733,7 +734,9 @@ struct vm_area_struct {
 #ifdef CONFIG_SWAP
 	atomic_long_t swap_readahead_info;
 #endif
-#ifndef CONFIG_MMU
+#ifdef CONFIG_MMU
+	atomic_long_t fault_around_info; /* Last fault-around page and window */
+#else
 	struct vm_region *vm_region;	/* NOMMU mapping region */
 #endif
 #ifdef CONFIG_NUMA
@@ -931,6 +934,15 @@ struct mm_struct {
 #ifdef CONFIG_MMU_NOTIFIER
 		struct mmu_notifier_subscriptions *notifier_subscriptions;
 #endif
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+		/*
+		 * Hash for PTHREAD_PROCESS_PRIVATE futexes. futex_phash_slots
+		 * is 0 until the first thread is created, -1 if the global
+		 * hash is used and the table size otherwise.
+		 */
+		struct futex_hash_bucket *futex_phash;
+		int futex_phash_slots;
+#endif
 #if defined(CONFIG_TRANSPARENT_HUGEPAGE) && !USE_SPLIT_PMD_PTLOCKS
 		pgtable_t pmd_huge_pte; /* protected by page_table_lock */
 #endif
@@ -1154,6 +1166,19 @@ static inline cpumask_t *mm_cidmask(struct mm_struct *mm)
 	return (struct cpumask *)cid_bitmap;
 }
 
+/*
+ * Accessor for the cids last handed out on NUMA node @node, following the
+ * cidmask. Allocation prefers those, so per-cid data userspace placed on a
+ * node keeps being used from that node.
+ */
+static inline cpumask_t *mm_node_cidmask(struct mm_struct *mm, int node)
+{
+	unsigned long cid_bitmap = (unsigned long)mm_cidmask(mm);
+
+	cid_bitmap += cpumask_size() * (1 + node);
+	return (struct cpumask *)cid_bitmap;
+}
+
 static inline void mm_init_cid(struct mm_struct *mm)
 {
 	int i;
@@ -1165,6 +1190,8 @@ static inline void mm_init_cid(struct mm_struct *mm)
 		pcpu_cid->time = 0;
 	}
 	cpumask_clear(mm_cidmask(mm));
+	for (i = 0; i < nr_node_ids; i++)
+		cpumask_clear(mm_node_cidmask(mm, i));
 }
 
 static inline int mm_alloc_cid_noprof(struct mm_struct *mm)
@@ -1185,7 +1212,7 @@ static inline void mm_destroy_cid(struct mm_struct *mm)
 
 static inline unsigned int mm_cid_size(void)
 {
-	return cpumask_size();
+	return cpumask_size() * (1 + nr_node_ids);
 }
 #else /* CONFIG_SCHED_MM_CID */
 static inline void mm_init_cid(struct mm_struct *mm) { }
@@ -446,6 +446,8 @@ struct lru_gen_folio {
 	/* can be modified without holding the LRU lock */
 	atomic_long_t evicted[NR_HIST_GENS][ANON_AND_FILE][MAX_NR_TIERS];
 	atomic_long_t refaulted[NR_HIST_GENS][ANON_AND_FILE][MAX_NR_TIERS];
+	/* the refault count seen by the last proactive reclaim pass */
+	unsigned long proactive_refaults;
 	/* whether the multi-gen LRU is enabled */
 	bool enabled;
 	/* the memcg generation this lru_gen_folio belongs to */
@@ -656,15 +658,20 @@ enum zone_watermarks {
 /*
  * One per migratetype for each PAGE_ALLOC_COSTLY_ORDER. Two additional lists
  * are added for THP. One PCP list is used by GPF_MOVABLE, and the other PCP list
- * is used by GFP_UNMOVABLE and GFP_RECLAIMABLE.
+ * is used by GFP_UNMOVABLE and GFP_RECLAIMABLE. The same split is used for the
+ * NR_PCP_MTHP_ORDERS orders right above PAGE_ALLOC_COSTLY_ORDER, which are
+ * common mTHP sizes for anonymous memory.
  */
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
 #define NR_PCP_THP 2
+#define NR_PCP_MTHP_ORDERS 2
 #else
 #define NR_PCP_THP 0
+#define NR_PCP_MTHP_ORDERS 0
 #endif
 #define NR_LOWORDER_PCP_LISTS (MIGRATE_PCPTYPES * (PAGE_ALLOC_COSTLY_ORDER + 1))
-#define NR_PCP_LISTS (NR_LOWORDER_PCP_LISTS + NR_PCP_THP)
+#define NR_PCP_MTHP (2 * NR_PCP_MTHP_ORDERS)
+#define NR_PCP_LISTS (NR_LOWORDER_PCP_LISTS + NR_PCP_THP + NR_PCP_MTHP)
 
 #define min_wmark_pages(z) (z->_watermark[WMARK_MIN] + z->watermark_boost)
 #define low_wmark_pages(z) (z->_watermark[WMARK_LOW] + z->watermark_boost)
@@ -1340,6 +1347,9 @@ typedef struct pglist_data {
 	wait_queue_head_t kcompactd_wait;
 	struct task_struct *kcompactd;
 	bool proactive_compact_trigger;
+	/* Order proactive compaction targets, picked from recent demand */
+	unsigned int proactive_compact_order;
+	unsigned long compact_order_demand[NR_PAGE_ORDERS];
 #endif
 	/*
 	 * This is a per-node reserve of pages that are not available
@@ -1375,6 +1385,8 @@ typedef struct pglist_data {
 	unsigned int nbp_rl_start;
 	/* number of promote candidate pages at start time of current rate limit period */
 	unsigned long nbp_rl_nr_cand;
+	/* number of demoted pages at start time of current rate limit period */
+	unsigned long nbp_rl_nr_demoted;
 	/* promote threshold in ms */
 	unsigned int nbp_threshold;
 	/* start time in ms of current promote threshold adjustment period */
@@ -336,9 +336,10 @@ struct gro_list {
 
 /*
  * size of gro hash buckets, must less than bit number of
- * napi_struct::gro_bitmask
+ * napi_struct::gro_bitmask. Each bucket holds up to MAX_GRO_SKBS flows,
+ * use all the bits so that many concurrent flows can still be merged.
  */
-#define GRO_HASH_BUCKETS	8
+#define GRO_HASH_BUCKETS	BITS_PER_LONG
 
 /*
  * Structure for NAPI scheduling similar to tasklet but with weighting
@@ -1979,7 +1980,7 @@ enum netdev_reg_state {
  *			for hardware timestamping
  *	@sfp_bus:	attached &struct sfp_bus structure.
  *
- *	@qdisc_tx_busylock: lockdep class annotating Qdisc->busylock spinlock
+ *	@qdisc_tx_busylock: lockdep class annotating Qdisc->seqlock spinlock
  *
  *	@proto_down:	protocol port state information can be sent to the
  *			switch driver and used to set the phys state of the
@@ -3089,6 +3090,8 @@ u16 dev_pick_tx_cpu_id(struct net_device *dev, struct sk_buff *skb,
 
 int __dev_queue_xmit(struct sk_buff *skb, struct net_device *sb_dev);
 int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id);
+struct sk_buff *__dev_direct_xmit_list(struct sk_buff *skb, u16 queue_id,
+				       int *ret);
 
 static inline int dev_queue_xmit(struct sk_buff *skb)
 {
@@ -5,8 +5,12 @@
 #include <linux/mmzone.h>
 #include <linux/scatterlist.h>
 
-/* This value should always be a power of 2, see page_reporting_cycle() */
+/*
+ * Default number of scatterlist entries per report() call.  Any capacity
+ * must be a power of 2, see page_reporting_cycle().
+ */
 #define PAGE_REPORTING_CAPACITY		32
+#define PAGE_REPORTING_MAX_CAPACITY	512
 
 struct page_reporting_dev_info {
 	/* function that alters pages to make them "reported" */
@@ -21,6 +25,9 @@ struct page_reporting_dev_info {
 
 	/* Minimal order of page reporting */
 	unsigned int order;
+
+	/* Entries per report() call, 0 means PAGE_REPORTING_CAPACITY */
+	unsigned int capacity;
 };
 
 /* Tear-down and bring-up for page reporting devices */
@@ -10,6 +10,7 @@
 #include <linux/timerqueue.h>
 
 struct kernel_siginfo;
+struct signal_struct;
 struct task_struct;
 
 static inline clockid_t make_process_cpuclock(const unsigned int pid,
@@ -94,6 +95,7 @@ static inline void posix_cputimers_init(struct posix_cputimers *pct)
 }
 
 void posix_cputimers_group_init(struct posix_cputimers *pct, u64 cpu_limit);
+void posix_cputimers_group_free(struct signal_struct *sig);
 
 static inline void posix_cputimers_rt_watchdog(struct posix_cputimers *pct,
 					       u64 runtime)
@@ -122,6 +124,7 @@ struct cpu_timer { };
 static inline void posix_cputimers_init(struct posix_cputimers *pct) { }
 static inline void posix_cputimers_group_init(struct posix_cputimers *pct,
 					      u64 cpu_limit) { }
+static inline void posix_cputimers_group_free(struct signal_struct *sig) { }
 #endif
 
 #ifdef CONFIG_POSIX_CPU_TIMERS_TASK_WORK
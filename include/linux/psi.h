@@ -32,11 +32,23 @@ __poll_t psi_trigger_poll(void **trigger_ptr, struct file *file,
 			poll_table *wait);
 
 #ifdef CONFIG_CGROUPS
+extern unsigned int psi_cgroup_depth;
+
 static inline struct psi_group *cgroup_psi(struct cgroup *cgrp)
 {
 	return cgroup_ino(cgrp) == 1 ? &psi_system : cgrp->psi;
 }
 
+/*
+ * Cgroups deeper than psi_cgroup_depth= have no pressure state or files
+ * of their own; their tasks are accounted in the nearest ancestor within
+ * the limit.
+ */
+static inline bool cgroup_psi_shared(struct cgroup *cgrp)
+{
+	return psi_cgroup_depth && cgrp->level > psi_cgroup_depth;
+}
+
 int psi_cgroup_alloc(struct cgroup *cgrp);
 void psi_cgroup_free(struct cgroup *cgrp);
 void cgroup_move_task(struct task_struct *p, struct css_set *to);
@@ -63,6 +75,10 @@ static inline void cgroup_move_task(struct task_struct *p, struct css_set *to)
 	rcu_assign_pointer(p->cgroups, to);
 }
 static inline void psi_cgroup_restart(struct psi_group *group) {}
+static inline bool cgroup_psi_shared(struct cgroup *cgrp)
+{
+	return false;
+}
 #endif
 
 #endif /* CONFIG_PSI */
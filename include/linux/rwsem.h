@@ -27,6 +27,28 @@
 # define __RWSEM_DEP_MAP_INIT(lockname)
 #endif
 
+struct rw_semaphore;
+
+/*
+ * Per-CPU reader mode for read-mostly rw semaphores, see
+ * kernel/locking/rwsem.c.
+ */
+#ifdef CONFIG_RWSEM_READER_BIAS
+extern int rwsem_enable_reader_bias(struct rw_semaphore *sem);
+extern void rwsem_free_reader_bias(struct rw_semaphore *sem);
+extern bool rwsem_reader_bias_locked(const struct rw_semaphore *sem);
+#else
+static inline int rwsem_enable_reader_bias(struct rw_semaphore *sem)
+{
+	return 0;
+}
+static inline void rwsem_free_reader_bias(struct rw_semaphore *sem) { }
+static inline bool rwsem_reader_bias_locked(const struct rw_semaphore *sem)
+{
+	return false;
+}
+#endif
+
 #ifndef CONFIG_PREEMPT_RT
 
 #ifdef CONFIG_RWSEM_SPIN_ON_OWNER
@@ -58,6 +80,9 @@ struct rw_semaphore {
 #endif
 	raw_spinlock_t wait_lock;
 	struct list_head wait_list;
+#ifdef CONFIG_RWSEM_READER_BIAS
+	struct rwsem_reader_bias *rbias;
+#endif
 #ifdef CONFIG_DEBUG_RWSEMS
 	void *magic;
 #endif
@@ -72,12 +97,14 @@ struct rw_semaphore {
 
 static inline int rwsem_is_locked(struct rw_semaphore *sem)
 {
-	return atomic_long_read(&sem->count) != RWSEM_UNLOCKED_VALUE;
+	return atomic_long_read(&sem->count) != RWSEM_UNLOCKED_VALUE ||
+	       rwsem_reader_bias_locked(sem);
 }
 
 static inline void rwsem_assert_held_nolockdep(const struct rw_semaphore *sem)
 {
-	WARN_ON(atomic_long_read(&sem->count) == RWSEM_UNLOCKED_VALUE);
+	WARN_ON(atomic_long_read(&sem->count) == RWSEM_UNLOCKED_VALUE &&
+		!rwsem_reader_bias_locked(sem));
 }
 
 static inline void rwsem_assert_held_write_nolockdep(const struct rw_semaphore *sem)
@@ -99,12 +126,19 @@ static inline void rwsem_assert_held_write_nolockdep(const struct rw_semaphore *
 #define __RWSEM_OPT_INIT(lockname)
 #endif
 
+#ifdef CONFIG_RWSEM_READER_BIAS
+#define __RWSEM_BIAS_INIT(lockname) .rbias = NULL,
+#else
+#define __RWSEM_BIAS_INIT(lockname)
+#endif
+
 #define __RWSEM_INITIALIZER(name)				\
 	{ __RWSEM_COUNT_INIT(name),				\
 	  .owner = ATOMIC_LONG_INIT(0),				\
 	  __RWSEM_OPT_INIT(name)				\
 	  .wait_lock = __RAW_SPIN_LOCK_UNLOCKED(name.wait_lock),\
 	  .wait_list = LIST_HEAD_INIT((name).wait_list),	\
+	  __RWSEM_BIAS_INIT(name)				\
 	  __RWSEM_DEBUG_INIT(name)				\
 	  __RWSEM_DEP_MAP_INIT(name) }
 
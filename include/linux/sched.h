@@ -904,6 +904,7 @@ struct task_struct {
 	unsigned			sched_reset_on_fork:1;
 	unsigned			sched_contributes_to_load:1;
 	unsigned			sched_migrated:1;
+	unsigned			sched_latency_sensitive:1;
 
 	/* Force alignment to the next boundary: */
 	unsigned			:0;
@@ -1165,6 +1166,11 @@ struct task_struct {
 	struct mutex_waiter		*blocked_on;
 #endif
 
+#ifdef CONFIG_RWSEM_READER_BIAS
+	/* rwsem read held through its per-CPU reader counts: */
+	struct rw_semaphore		*rwsem_bias;
+#endif
+
 #ifdef CONFIG_DEBUG_ATOMIC_SLEEP
 	int				non_block_count;
 #endif
@@ -1281,6 +1287,11 @@ struct task_struct {
 	u64				last_task_numa_placement;
 	u64				last_sum_exec_runtime;
 	struct callback_head		numa_work;
+#ifdef CONFIG_PERF_EVENTS
+	/* Access sampling, see NUMA_BALANCING_SAMPLING */
+	struct perf_event		*numa_sample_event;
+	struct numa_sample_buf		*numa_samples;
+#endif
 
 	/*
 	 * This pointer is only modified for current in syscall and
@@ -98,12 +98,33 @@ struct thread_group_cputimer *get_running_cputimer(struct task_struct *tsk)
 
 	return cputimer;
 }
+
+/*
+ * get_group_cputime_pcpu - return the per-CPU group cputime sums if the
+ * thread group has them allocated. Same exit rules as for the cputimer.
+ */
+static inline
+struct task_cputime __percpu *get_group_cputime_pcpu(struct task_struct *tsk)
+{
+	struct thread_group_cputime_pcpu *pc = READ_ONCE(tsk->signal->cputime_pcpu);
+
+	if (likely(!pc) || unlikely(!tsk->sighand))
+		return NULL;
+
+	return pc->sums;
+}
 #else
 static inline
 struct thread_group_cputimer *get_running_cputimer(struct task_struct *tsk)
 {
 	return NULL;
 }
+
+static inline
+struct task_cputime __percpu *get_group_cputime_pcpu(struct task_struct *tsk)
+{
+	return NULL;
+}
 #endif
 
 /**
@@ -120,6 +141,10 @@ static inline void account_group_user_time(struct task_struct *tsk,
 					   u64 cputime)
 {
 	struct thread_group_cputimer *cputimer = get_running_cputimer(tsk);
+	struct task_cputime __percpu *sums = get_group_cputime_pcpu(tsk);
+
+	if (sums)
+		this_cpu_add(sums->utime, cputime);
 
 	if (!cputimer)
 		return;
@@ -141,6 +166,10 @@ static inline void account_group_system_time(struct task_struct *tsk,
 					     u64 cputime)
 {
 	struct thread_group_cputimer *cputimer = get_running_cputimer(tsk);
+	struct task_cputime __percpu *sums = get_group_cputime_pcpu(tsk);
+
+	if (sums)
+		this_cpu_add(sums->stime, cputime);
 
 	if (!cputimer)
 		return;
@@ -162,6 +191,10 @@ static inline void account_group_exec_runtime(struct task_struct *tsk,
 					      unsigned long long ns)
 {
 	struct thread_group_cputimer *cputimer = get_running_cputimer(tsk);
+	struct task_cputime __percpu *sums = get_group_cputime_pcpu(tsk);
+
+	if (sums)
+		this_cpu_add(sums->sum_exec_runtime, ns);
 
 	if (!cputimer)
 		return;
@@ -68,6 +68,22 @@ struct thread_group_cputimer {
 	struct task_cputime_atomic cputime_atomic;
 };
 
+/**
+ * struct thread_group_cputime_pcpu - per-CPU partial thread group cputime
+ * @base:	group cputime at the point the partial sums were started
+ * @sums:	per-CPU cputime accounted to the group since then
+ * @ready:	@base is valid, readers may use base + sum(@sums)
+ *
+ * Allocated on demand for large thread groups which sample the process
+ * wide CPU clocks while no process wide timer is armed, so a sample
+ * costs a walk over the possible CPUs instead of over all threads.
+ */
+struct thread_group_cputime_pcpu {
+	struct task_cputime		base;
+	struct task_cputime __percpu	*sums;
+	bool				ready;
+};
+
 struct multiprocess_signals {
 	sigset_t signal;
 	struct hlist_node node;
@@ -156,6 +172,9 @@ struct signal_struct {
 	 */
 	struct thread_group_cputimer cputimer;
 
+	/* Lockless per-CPU group cputime, see thread_group_cputime_pcpu */
+	struct thread_group_cputime_pcpu *cputime_pcpu;
+
 #endif
 	/* Empty if CONFIG_POSIX_TIMERS=n */
 	struct posix_cputimers posix_cputimers;
@@ -82,8 +82,27 @@ struct sched_domain_shared {
 	atomic_t	nr_busy_cpus;
 	int		has_idle_cores;
 	int		nr_idle_scan;
+
+	/*
+	 * Two masks of the LLC's CPUs, must be last:
+	 *  - sds_idle_cpus(): CPUs that went idle; set on idle entry and
+	 *    cleared lazily by the wakeup path once found busy.
+	 *  - sds_overload_cpus(): CPUs with more than one runnable task,
+	 *    for newly idle CPUs to steal from.
+	 */
+	unsigned long	cpumasks[];
 };
 
+static inline struct cpumask *sds_idle_cpus(struct sched_domain_shared *sds)
+{
+	return to_cpumask(sds->cpumasks);
+}
+
+static inline struct cpumask *sds_overload_cpus(struct sched_domain_shared *sds)
+{
+	return (struct cpumask *)((void *)sds->cpumasks + cpumask_size());
+}
+
 struct sched_domain {
 	/* These fields must be setup */
 	struct sched_domain __rcu *parent;	/* top domain must be null terminated */
@@ -112,6 +112,12 @@ struct shrinker {
 	int debugfs_id;
 	const char *name;
 	struct dentry *debugfs_entry;
+	/* reclaim cost and yield, reported in debugfs "stats" */
+	atomic_long_t nr_calls;
+	atomic_long_t nr_empty;
+	atomic_long_t nr_scanned;
+	atomic_long_t nr_freed;
+	atomic64_t scan_time_ns;
 #endif
 	/* objs pending delete, per node */
 	atomic_long_t *nr_deferred;
@@ -53,6 +53,7 @@ enum _slab_flag_bits {
 #endif
 #ifndef CONFIG_SLUB_TINY
 	_SLAB_RECLAIM_ACCOUNT,
+	_SLAB_PERCPU_SHEAVES,
 #endif
 	_SLAB_OBJECT_POISON,
 	_SLAB_CMPXCHG_DOUBLE,
@@ -205,6 +206,17 @@ enum _slab_flag_bits {
 #endif
 #define SLAB_TEMPORARY		SLAB_RECLAIM_ACCOUNT	/* Objects are short-lived */
 
+/*
+ * Front the cache with percpu arrays of free objects ("sheaves") that are
+ * refilled and flushed in bulk, so the common alloc/free is an array pop/push.
+ * Meant for a few very hot caches; ignored for debugged caches.
+ */
+#ifndef CONFIG_SLUB_TINY
+#define SLAB_PERCPU_SHEAVES	__SLAB_FLAG_BIT(_SLAB_PERCPU_SHEAVES)
+#else
+#define SLAB_PERCPU_SHEAVES	__SLAB_FLAG_UNUSED
+#endif
+
 /* Slab created using create_boot_cache */
 #ifdef CONFIG_SLAB_OBJ_EXT
 #define SLAB_NO_OBJ_EXT		__SLAB_FLAG_BIT(_SLAB_NO_OBJ_EXT)
@@ -26,6 +26,7 @@ struct srcu_data {
 	atomic_long_t srcu_lock_count[2];	/* Locks per CPU. */
 	atomic_long_t srcu_unlock_count[2];	/* Unlocks per CPU. */
 	int srcu_nmi_safety;			/* NMI-safe srcu_struct structure? */
+	bool srcu_reader_seen;			/* In ->srcu_reader_cpus? */
 
 	/* Update-side state. */
 	spinlock_t __private lock ____cacheline_internodealigned_in_smp;
@@ -88,6 +89,7 @@ struct srcu_usage {
 	unsigned long reschedule_count;
 	struct delayed_work work;
 	struct srcu_struct *srcu_ssp;
+	struct cpumask srcu_reader_cpus;	/* CPUs whose counters ever moved. */
 };
 
 /*
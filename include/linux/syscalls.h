@@ -561,6 +561,9 @@ asmlinkage long sys_futex_waitv(struct futex_waitv __user *waiters,
 
 asmlinkage long sys_futex_wake(void __user *uaddr, unsigned long mask, int nr, unsigned int flags);
 
+asmlinkage long sys_futex_wakev(struct futex_waitv __user *waiters,
+				unsigned int nr_futexes, unsigned int flags);
+
 asmlinkage long sys_futex_wait(void __user *uaddr, unsigned long val, unsigned long mask,
 			       unsigned int flags, struct __kernel_timespec __user *timespec,
 			       clockid_t clockid);
@@ -513,6 +513,7 @@ enum tsq_enum {
 				    * tcp_v{4|6}_mtu_reduced()
 				    */
 	TCP_ACK_DEFERRED,	   /* TX pure ack is deferred */
+	TCP_XMIT_DEFERRED,	   /* TX after incoming ack is deferred */
 };
 
 enum tsq_flags {
@@ -523,6 +524,7 @@ enum tsq_flags {
 	TCPF_DELACK_TIMER_DEFERRED	= BIT(TCP_DELACK_TIMER_DEFERRED),
 	TCPF_MTU_REDUCED_DEFERRED	= BIT(TCP_MTU_REDUCED_DEFERRED),
 	TCPF_ACK_DEFERRED		= BIT(TCP_ACK_DEFERRED),
+	TCPF_XMIT_DEFERRED		= BIT(TCP_XMIT_DEFERRED),
 };
 
 #define tcp_sk(ptr) container_of_const(ptr, struct tcp_sock, inet_conn.icsk_inet.sk)
@@ -44,6 +44,14 @@ enum {
 	UDP_FLAGS_UDPLITE_RECV_CC, /* set via udplite setsockopt */
 };
 
+/* Received skbs not yet moved to sk_receive_queue,
+ * see __udp_enqueue_schedule_skb()
+ */
+struct udp_prod_queue {
+	struct llist_head	ll_root ____cacheline_aligned_in_smp;
+	atomic_t		rmem_alloc;
+};
+
 struct udp_sock {
 	/* inet_sock has to be the first member */
 	struct inet_sock inet;
@@ -95,6 +103,9 @@ struct udp_sock {
 
 	/* Cache friendly copy of sk->sk_peek_off >= 0 */
 	bool		peeking_with_offset;
+
+	/* One per NUMA node, filled by softirq producers */
+	struct udp_prod_queue *udp_prod_queue;
 };
 
 #define udp_test_bit(nr, sk)			\
@@ -116,6 +116,10 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 		THP_SWPOUT,
 		THP_SWPOUT_FALLBACK,
 #endif
+#ifdef CONFIG_PAGE_REPORTING
+		PAGE_REPORTED,		/* pages reported free to the host */
+		PAGE_REPORTED_REUSED,	/* reported pages taken off free lists */
+#endif
 #ifdef CONFIG_MEMORY_BALLOON
 		BALLOON_INFLATE,
 		BALLOON_DEFLATE,
@@ -153,6 +157,8 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 		VMA_LOCK_ABORT,
 		VMA_LOCK_RETRY,
 		VMA_LOCK_MISS,
+		VMA_LOCK_MADVISE,
+		VMA_LOCK_MADVISE_FALLBACK,
 #endif
 		NR_VM_EVENT_ITEMS
 };
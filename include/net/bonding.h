@@ -199,6 +199,20 @@ struct bond_up_slave {
 	struct slave	*arr[];
 };
 
+/* Per-CPU cache of xmit hashes indexed by the flow hash of the skb */
+#define BOND_HASH_CACHE_SIZE	64
+
+struct bond_hash_cache_entry {
+	u32	skb_hash;
+	u32	hash;
+	u8	xmit_policy;
+	bool	valid;
+};
+
+struct bond_hash_cache {
+	struct bond_hash_cache_entry	ent[BOND_HASH_CACHE_SIZE];
+};
+
 /*
  * Link pseudo-state only used internally by monitors
  */
@@ -242,6 +256,7 @@ struct bonding {
 #endif /* CONFIG_PROC_FS */
 	struct   list_head bond_list;
 	u32 __percpu *rr_tx_counter;
+	struct bond_hash_cache __percpu *hash_cache;
 	struct   ad_bond_info ad_info;
 	struct   alb_bond_info alb_info;
 	struct   bond_params params;
@@ -284,6 +284,14 @@ struct fib_table *fib_trie_unmerge(struct fib_table *main_tb);
 void fib_table_flush_external(struct fib_table *table);
 void fib_free_table(struct fib_table *tb);
 
+#ifdef CONFIG_IP_FIB_LOOKUP_CACHE
+void fib_lookup_cache_invalidate(void);
+#else
+static inline void fib_lookup_cache_invalidate(void)
+{
+}
+#endif
+
 #ifndef CONFIG_IP_MULTIPLE_TABLES
 
 #define TABLE_LOCAL_INDEX	(RT_TABLE_LOCAL & (FIB_TABLE_HASHSZ - 1))
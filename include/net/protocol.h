@@ -36,6 +36,10 @@
 /* This is used to register protocols. */
 struct net_protocol {
 	int			(*handler)(struct sk_buff *skb);
+	/* Optional, takes a list of skbs which passed the raw sockets and,
+	 * unless no_policy is set, the xfrm policy check.
+	 */
+	void			(*list_handler)(struct list_head *head);
 
 	/* This returns an error if we weren't able to handle the error. */
 	int			(*err_handler)(struct sk_buff *skb, u32 info);
@@ -1409,6 +1409,21 @@ enum {
 
 /* Do not translate kernel bpf_arena pointers to user pointers */
 	BPF_F_NO_USER_CONV	= (1U << 18),
+
+/* Evict the elements of a BPF_MAP_TYPE_LRU_[PERCPU_]HASH map in CLOCK
+ * (second chance) order from per-CPU slices instead of maintaining LRU
+ * lists. Updates do not take any LRU lock, at the cost of less exact
+ * recency. As with BPF_F_NO_COMMON_LRU, the elements cannot move between
+ * CPUs, the two flags are mutually exclusive.
+ */
+	BPF_F_CLOCK_LRU		= (1U << 19),
+
+/* Allocate one BPF_MAP_TYPE_RINGBUF ring of max_entries bytes per possible
+ * CPU; records are reserved from the ring of the current CPU. The ring of
+ * CPU n is mmap()'ed at n times the mmap()'able size of a single ring, and
+ * the map fd polls readable while any of the rings has data.
+ */
+	BPF_F_RINGBUF_PERCPU	= (1U << 20),
 };
 
 /* Flags for BPF_PROG_QUERY. */
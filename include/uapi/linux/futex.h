@@ -71,6 +71,13 @@
 
 #define FUTEX2_SIZE_MASK	0x03
 
+/*
+ * With FUTEX2_NUMA the futex word is followed by a node word of the same
+ * size. Its value selects the node whose hash the futex lives in;
+ * FUTEX_NO_NODE (all ones) uses the default hash.
+ */
+#define FUTEX_NO_NODE		(-1)
+
 /* do not use */
 #define FUTEX_32		FUTEX2_SIZE_U32 /* historical accident :-( */
 
@@ -836,6 +836,8 @@ enum {
 
 	TCA_FQ_WEIGHTS,		/* Weights for each band */
 
+	TCA_FQ_WHEEL_GRANULARITY, /* timer wheel slot in ns for throttled flows, 0: no wheel */
+
 	__TCA_FQ_MAX
 };
 
@@ -13,4 +13,9 @@ struct sockaddr_un {
 
 #define SIOCUNIXFILE (SIOCPROTOPRIVATE + 0) /* open a socket file with O_PATH */
 
+#define SOL_UNIX	288
+
+/* cmsg type of MSG_ZEROCOPY completions read with MSG_ERRQUEUE */
+#define UNIX_RECVERR	1
+
 #endif /* _LINUX_UN_H */
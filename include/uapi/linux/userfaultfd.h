@@ -54,13 +54,17 @@
 	 (__u64)1 << _UFFDIO_MOVE |		\
 	 (__u64)1 << _UFFDIO_WRITEPROTECT |	\
 	 (__u64)1 << _UFFDIO_CONTINUE |		\
-	 (__u64)1 << _UFFDIO_POISON)
+	 (__u64)1 << _UFFDIO_POISON |		\
+	 (__u64)1 << _UFFDIO_COPY_VEC |		\
+	 (__u64)1 << _UFFDIO_CONTINUE_VEC)
 #define UFFD_API_RANGE_IOCTLS_BASIC		\
 	((__u64)1 << _UFFDIO_WAKE |		\
 	 (__u64)1 << _UFFDIO_COPY |		\
 	 (__u64)1 << _UFFDIO_WRITEPROTECT |	\
 	 (__u64)1 << _UFFDIO_CONTINUE |		\
-	 (__u64)1 << _UFFDIO_POISON)
+	 (__u64)1 << _UFFDIO_POISON |		\
+	 (__u64)1 << _UFFDIO_COPY_VEC |		\
+	 (__u64)1 << _UFFDIO_CONTINUE_VEC)
 
 /*
  * Valid ioctl command number range with this API is from 0x00 to
@@ -79,6 +83,8 @@
 #define _UFFDIO_WRITEPROTECT		(0x06)
 #define _UFFDIO_CONTINUE		(0x07)
 #define _UFFDIO_POISON			(0x08)
+#define _UFFDIO_COPY_VEC		(0x09)
+#define _UFFDIO_CONTINUE_VEC		(0x0A)
 #define _UFFDIO_API			(0x3F)
 
 /* userfaultfd ioctl ids */
@@ -103,6 +109,10 @@
 				      struct uffdio_continue)
 #define UFFDIO_POISON		_IOWR(UFFDIO, _UFFDIO_POISON, \
 				      struct uffdio_poison)
+#define UFFDIO_COPY_VEC		_IOWR(UFFDIO, _UFFDIO_COPY_VEC, \
+				      struct uffdio_vec)
+#define UFFDIO_CONTINUE_VEC	_IOWR(UFFDIO, _UFFDIO_CONTINUE_VEC, \
+				      struct uffdio_vec)
 
 /* read() structure */
 struct uffd_msg {
@@ -356,6 +366,23 @@ struct uffdio_poison {
 	__s64 updated;
 };
 
+/*
+ * UFFDIO_COPY_VEC and UFFDIO_CONTINUE_VEC resolve many ranges in one
+ * call: "entries" points to an array of "nr" struct uffdio_copy or
+ * struct uffdio_continue, each handled exactly like the single range
+ * ioctl (including its own mode and its "copy"/"mapped" result).
+ * Processing stops at the first entry that does not complete fully.
+ */
+struct uffdio_vec {
+	__u64 entries;
+	__u64 nr;
+	/*
+	 * "done" is written by the ioctl and must be at the end: the
+	 * number of entries fully resolved.
+	 */
+	__s64 done;
+};
+
 struct uffdio_move {
 	__u64 dst;
 	__u64 src;
@@ -16,6 +16,33 @@
 #include "rsrc.h"
 
 #ifdef CONFIG_PROC_FS
+static __cold void io_uring_show_op_stats(struct seq_file *m,
+					  struct io_ring_ctx *ctx)
+{
+	unsigned int op, i;
+
+	seq_puts(m, "OpStats:\n");
+	for (op = 0; op < IORING_OP_LAST; op++) {
+		struct io_op_stats *st = &ctx->op_stats[op];
+		unsigned long nr_iowq = atomic_long_read(&st->nr_iowq);
+		unsigned long nr_poll = atomic_long_read(&st->nr_poll);
+		unsigned long lat[IO_STATS_LAT_BUCKETS], total = 0;
+
+		for (i = 0; i < IO_STATS_LAT_BUCKETS; i++) {
+			lat[i] = atomic_long_read(&st->lat[i]);
+			total += lat[i];
+		}
+		if (!total && !nr_iowq && !nr_poll)
+			continue;
+
+		seq_printf(m, "  %s: completed=%lu, iowq=%lu, poll=%lu, lat_us_log2=",
+			   io_uring_get_opcode(op), total, nr_iowq, nr_poll);
+		for (i = 0; i < IO_STATS_LAT_BUCKETS; i++)
+			seq_printf(m, "%s%lu", i ? "," : "", lat[i]);
+		seq_putc(m, '\n');
+	}
+}
+
 static __cold int io_uring_show_cred(struct seq_file *m, unsigned int id,
 		const struct cred *cred)
 {
@@ -223,5 +250,8 @@ __cold void io_uring_show_fdinfo(struct seq_file *m, struct file *file)
 	}
 
 	spin_unlock(&ctx->completion_lock);
+
+	if (io_stats_enabled(ctx))
+		io_uring_show_op_stats(m, ctx);
 }
 #endif
@@ -22,6 +22,11 @@ static int io_file_bitmap_get(struct io_ring_ctx *ctx)
 	if (!table->bitmap)
 		return -ENFILE;
 
+	/* freeing a slot outside the allocation range may have moved the hint */
+	if (table->alloc_hint < ctx->file_alloc_start ||
+	    table->alloc_hint >= nr)
+		table->alloc_hint = ctx->file_alloc_start;
+
 	do {
 		ret = find_next_zero_bit(table->bitmap, nr, table->alloc_hint);
 		if (ret != nr)
@@ -271,6 +271,7 @@ int io_futexv_wait(struct io_kiocb *req, unsigned int issue_flags)
 
 	io_ring_submit_lock(ctx, issue_flags);
 
+	futex_hash_pin_global(current->mm);
 	ret = futex_wait_multiple_setup(futexv, iof->futex_nr, &woken);
 
 	/*
@@ -343,6 +344,8 @@ int io_futex_wait(struct io_kiocb *req, unsigned int issue_flags)
 	ifd->q.wake = io_futex_wake_fn;
 	ifd->req = req;
 
+	/* The queued waiter outlives this task's stay in the kernel */
+	futex_hash_pin_global(current->mm);
 	ret = futex_wait_setup(iof->uaddr, iof->futex_val, iof->futex_flags,
 			       &ifd->q, &hb);
 	if (!ret) {
@@ -23,6 +23,7 @@
 #include "io_uring.h"
 
 #define WORKER_IDLE_TIMEOUT	(5 * HZ)
+#define WORKER_RETIRE_INTERVAL	(HZ / 2)
 #define WORKER_INIT_LIMIT	3
 
 enum {
@@ -83,6 +84,8 @@ struct io_wq_acct {
 	raw_spinlock_t lock;
 	struct io_wq_work_list work_list;
 	unsigned long flags;
+	/* protected by wq->lock */
+	unsigned long last_retire;
 };
 
 enum {
@@ -338,14 +341,24 @@ static void create_worker_cb(struct callback_head *cb)
 	struct io_wq *wq;
 
 	struct io_wq_acct *acct;
-	bool do_create = false;
+	bool do_create = false, activated;
 
 	worker = container_of(cb, struct io_worker, create_work);
 	wq = worker->wq;
 	acct = &wq->acct[worker->create_index];
-	raw_spin_lock(&wq->lock);
 
-	if (acct->nr_workers < acct->max_workers) {
+	/*
+	 * An idle worker may have become available since the creation was
+	 * queued. Prefer waking that one over growing the pool, otherwise
+	 * bursts of blocking work end up with many workers that then sit
+	 * idle until they time out.
+	 */
+	rcu_read_lock();
+	activated = io_wq_activate_free_worker(wq, acct);
+	rcu_read_unlock();
+
+	raw_spin_lock(&wq->lock);
+	if (!activated && acct->nr_workers < acct->max_workers) {
 		acct->nr_workers++;
 		do_create = true;
 	}
@@ -627,6 +640,20 @@ static void io_worker_handle_work(struct io_wq_acct *acct,
 	} while (1);
 }
 
+/*
+ * Idle workers that timed out retire at most one per WORKER_RETIRE_INTERVAL
+ * for each acct. A pool that grew for a burst then shrinks back gradually,
+ * instead of all workers expiring together only to have the next burst
+ * create them all over again. Called with wq->lock held.
+ */
+static bool io_acct_may_retire(struct io_wq_acct *acct)
+{
+	if (time_before(jiffies, acct->last_retire + WORKER_RETIRE_INTERVAL))
+		return false;
+	acct->last_retire = jiffies;
+	return true;
+}
+
 static int io_wq_worker(void *data)
 {
 	struct io_worker *worker = data;
@@ -642,6 +669,7 @@ static int io_wq_worker(void *data)
 	set_task_comm(current, buf);
 
 	while (!test_bit(IO_WQ_BIT_EXIT, &wq->state)) {
+		long timeout = WORKER_IDLE_TIMEOUT;
 		long ret;
 
 		set_current_state(TASK_INTERRUPTIBLE);
@@ -656,20 +684,24 @@ static int io_wq_worker(void *data)
 		raw_spin_lock(&wq->lock);
 		/*
 		 * Last sleep timed out. Exit if we're not the last worker,
-		 * or if someone modified our affinity.
+		 * or if someone modified our affinity. If another worker just
+		 * retired, check back again shortly.
 		 */
 		if (last_timeout && (exit_mask || acct->nr_workers > 1)) {
-			acct->nr_workers--;
-			raw_spin_unlock(&wq->lock);
-			__set_current_state(TASK_RUNNING);
-			break;
+			if (exit_mask || io_acct_may_retire(acct)) {
+				acct->nr_workers--;
+				raw_spin_unlock(&wq->lock);
+				__set_current_state(TASK_RUNNING);
+				break;
+			}
+			timeout = WORKER_RETIRE_INTERVAL;
 		}
 		last_timeout = false;
 		__io_worker_idle(wq, worker);
 		raw_spin_unlock(&wq->lock);
 		if (io_run_task_work())
 			continue;
-		ret = schedule_timeout(WORKER_IDLE_TIMEOUT);
+		ret = schedule_timeout(timeout);
 		if (signal_pending(current)) {
 			struct ksignal ksig;
 
@@ -55,6 +55,8 @@ static inline void io_napi_add(struct io_kiocb *req)
 	struct io_ring_ctx *ctx = req->ctx;
 	struct socket *sock;
 
+	if (READ_ONCE(ctx->napi_track_mode) != IO_URING_NAPI_TRACKING_DYNAMIC)
+		return;
 	if (!READ_ONCE(ctx->napi_busy_poll_to))
 		return;
 
@@ -29,6 +29,7 @@ struct io_close {
 	struct file			*file;
 	int				fd;
 	u32				file_slot;
+	u32				nr_slots;
 };
 
 struct io_fixed_install {
@@ -197,10 +198,44 @@ int __io_close_fixed(struct io_ring_ctx *ctx, unsigned int issue_flags,
 	return ret;
 }
 
+/*
+ * Close @nr_slots consecutive direct descriptors starting at @offset. Empty
+ * slots in the range are skipped. Returns the number of files closed.
+ */
+static int io_close_fixed_range(struct io_ring_ctx *ctx,
+				unsigned int issue_flags, unsigned int offset,
+				unsigned int nr_slots)
+{
+	unsigned int end;
+	int ret = 0, nr = 0;
+
+	io_ring_submit_lock(ctx, issue_flags);
+	if (check_add_overflow(offset, nr_slots, &end) ||
+	    end > ctx->nr_user_files) {
+		ret = -EINVAL;
+		goto out;
+	}
+	for (; offset < end; offset++) {
+		ret = io_fixed_fd_remove(ctx, offset);
+		if (!ret)
+			nr++;
+		else if (ret != -EBADF)
+			goto out;
+	}
+	ret = nr;
+out:
+	io_ring_submit_unlock(ctx, issue_flags);
+	return ret;
+}
+
 static inline int io_close_fixed(struct io_kiocb *req, unsigned int issue_flags)
 {
 	struct io_close *close = io_kiocb_to_cmd(req, struct io_close);
 
+	if (close->nr_slots)
+		return io_close_fixed_range(req->ctx, issue_flags,
+					    close->file_slot - 1,
+					    close->nr_slots);
 	return __io_close_fixed(req->ctx, issue_flags, close->file_slot - 1);
 }
 
@@ -208,7 +243,7 @@ int io_close_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 {
 	struct io_close *close = io_kiocb_to_cmd(req, struct io_close);
 
-	if (sqe->off || sqe->addr || sqe->len || sqe->rw_flags || sqe->buf_index)
+	if (sqe->off || sqe->addr || sqe->rw_flags || sqe->buf_index)
 		return -EINVAL;
 	if (req->flags & REQ_F_FIXED_FILE)
 		return -EBADF;
@@ -217,6 +252,10 @@ int io_close_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 	close->file_slot = READ_ONCE(sqe->file_index);
 	if (close->file_slot && close->fd)
 		return -EINVAL;
+	/* a non-zero len closes that many direct descriptors from file_slot */
+	close->nr_slots = READ_ONCE(sqe->len);
+	if (close->nr_slots && !close->file_slot)
+		return -EINVAL;
 
 	return 0;
 }
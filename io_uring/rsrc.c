@@ -849,6 +849,65 @@ static int io_buffer_account_pin(struct io_ring_ctx *ctx, struct page **pages,
 	return ret;
 }
 
+/*
+ * If the buffer is backed by large folios of the same size, each of them
+ * fully covered except for possibly the first and the last one, describe
+ * it with a bvec per folio rather than one per page. On success, @pages is
+ * compacted to hold the head page of each folio, with just one pin left on
+ * each, @folio_shift is set to the folio size and the buffer offset in @off
+ * is made relative to the first folio rather than the first page.
+ */
+static bool io_coalesce_buffer(struct page **pages, int *nr_pages,
+			       unsigned int *folio_shift, unsigned long *off)
+{
+	struct folio *folio = page_folio(pages[0]);
+	struct page *prev = pages[0];
+	unsigned int shift;
+	int i, j;
+
+	if (*nr_pages <= 1 || !folio_test_large(folio))
+		return false;
+
+	shift = folio_shift(folio);
+	for (i = 1; i < *nr_pages; i++) {
+		if (pages[i] == pages[i - 1] + 1 &&
+		    page_folio(pages[i]) == folio)
+			continue;
+		/* previous folio must be used up to its end ... */
+		if (folio_page_idx(folio, pages[i - 1]) !=
+		    folio_nr_pages(folio) - 1)
+			return false;
+		/* ... and the next one used from its start */
+		folio = page_folio(pages[i]);
+		if (folio_shift(folio) != shift ||
+		    folio_page_idx(folio, pages[i]) != 0)
+			return false;
+	}
+
+	/*
+	 * The pages are bound to the folio, it doesn't actually unpin them
+	 * but drops all but one reference per folio, which is put down by
+	 * io_buffer_unmap().
+	 */
+	folio = page_folio(pages[0]);
+	*off += folio_page_idx(folio, pages[0]) << PAGE_SHIFT;
+	pages[0] = folio_page(folio, 0);
+	for (i = 1, j = 0; i < *nr_pages; i++) {
+		struct page *page = pages[i];
+
+		if (page == prev + 1 && page_folio(page) == folio) {
+			unpin_user_page(page);
+		} else {
+			folio = page_folio(page);
+			pages[++j] = page;
+		}
+		prev = page;
+	}
+	*nr_pages = j + 1;
+	*folio_shift = shift;
+	return true;
+}
+
 static int io_sqe_buffer_register(struct io_ring_ctx *ctx, struct iovec *iov,
 				  struct io_mapped_ubuf **pimu,
 				  struct page **last_hpage)
@@ -857,8 +916,8 @@ static int io_sqe_buffer_register(struct io_ring_ctx *ctx, struct iovec *iov,
 	struct page **pages = NULL;
 	unsigned long off;
 	size_t size;
+	unsigned int folio_shift;
 	int ret, nr_pages, i;
-	struct folio *folio = NULL;
 
 	*pimu = (struct io_mapped_ubuf *)&dummy_ubuf;
 	if (!iov->iov_base)
@@ -873,31 +932,10 @@ static int io_sqe_buffer_register(struct io_ring_ctx *ctx, struct iovec *iov,
 		goto done;
 	}
 
-	/* If it's a huge page, try to coalesce them into a single bvec entry */
-	if (nr_pages > 1) {
-		folio = page_folio(pages[0]);
-		for (i = 1; i < nr_pages; i++) {
-			/*
-			 * Pages must be consecutive and on the same folio for
-			 * this to work
-			 */
-			if (page_folio(pages[i]) != folio ||
-			    pages[i] != pages[i - 1] + 1) {
-				folio = NULL;
-				break;
-			}
-		}
-		if (folio) {
-			/*
-			 * The pages are bound to the folio, it doesn't
-			 * actually unpin them but drops all but one reference,
-			 * which is usually put down by io_buffer_unmap().
-			 * Note, needs a better helper.
-			 */
-			unpin_user_pages(&pages[1], nr_pages - 1);
-			nr_pages = 1;
-		}
-	}
+	/* If it's backed by huge pages, try to coalesce them into large bvecs */
+	folio_shift = PAGE_SHIFT;
+	off = (unsigned long) iov->iov_base & ~PAGE_MASK;
+	io_coalesce_buffer(pages, &nr_pages, &folio_shift, &off);
 
 	imu = kvmalloc(struct_size(imu, bvec, nr_pages), GFP_KERNEL);
 	if (!imu)
@@ -909,23 +947,19 @@ static int io_sqe_buffer_register(struct io_ring_ctx *ctx, struct iovec *iov,
 		goto done;
 	}
 
-	off = (unsigned long) iov->iov_base & ~PAGE_MASK;
 	size = iov->iov_len;
 	/* store original address for later verification */
 	imu->ubuf = (unsigned long) iov->iov_base;
 	imu->ubuf_end = imu->ubuf + iov->iov_len;
 	imu->nr_bvecs = nr_pages;
+	imu->folio_shift = folio_shift;
 	*pimu = imu;
 	ret = 0;
 
-	if (folio) {
-		bvec_set_page(&imu->bvec[0], pages[0], size, off);
-		goto done;
-	}
 	for (i = 0; i < nr_pages; i++) {
 		size_t vec_len;
 
-		vec_len = min_t(size_t, size, PAGE_SIZE - off);
+		vec_len = min_t(size_t, size, (1UL << folio_shift) - off);
 		bvec_set_page(&imu->bvec[i], pages[i], vec_len, off);
 		off = 0;
 		size -= vec_len;
@@ -1031,7 +1065,8 @@ int io_import_fixed(int ddir, struct iov_iter *iter,
 		 * we know that:
 		 *
 		 * 1) it's a BVEC iter, we set it up
-		 * 2) all bvecs are PAGE_SIZE in size, except potentially the
+		 * 2) all bvecs are the same size (PAGE_SIZE, or the folio size
+		 *    for coalesced huge page buffers), except potentially the
 		 *    first and last bvec
 		 *
 		 * So just find our index, and adjust the iterator afterwards.
@@ -1043,11 +1078,6 @@ int io_import_fixed(int ddir, struct iov_iter *iter,
 		const struct bio_vec *bvec = imu->bvec;
 
 		if (offset < bvec->bv_len) {
-			/*
-			 * Note, huge pages buffers consists of one large
-			 * bvec entry and should always go this way. The other
-			 * branch doesn't expect non PAGE_SIZE'd chunks.
-			 */
 			iter->bvec = bvec;
 			iter->count -= offset;
 			iter->iov_offset = offset;
@@ -1056,14 +1086,75 @@ int io_import_fixed(int ddir, struct iov_iter *iter,
 
 			/* skip first vec */
 			offset -= bvec->bv_len;
-			seg_skip = 1 + (offset >> PAGE_SHIFT);
+			seg_skip = 1 + (offset >> imu->folio_shift);
 
 			iter->bvec = bvec + seg_skip;
 			iter->nr_segs -= seg_skip;
 			iter->count -= bvec->bv_len + offset;
-			iter->iov_offset = offset & ~PAGE_MASK;
+			iter->iov_offset = offset & ((1UL << imu->folio_shift) - 1);
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Import an iovec array whose segments all point into the registered buffer
+ * @imu. Builds a bvec array covering the segments, which is returned in
+ * @pbvec and must be freed with kvfree() by the caller once the iterator
+ * is done with.
+ */
+int io_import_fixed_vec(int ddir, struct iov_iter *iter,
+			struct io_mapped_ubuf *imu, const struct iovec *iov,
+			unsigned int nr_iovs, struct bio_vec **pbvec)
+{
+	unsigned int i, nr_segs = 0, max_segs = 0;
+	size_t total_len = 0;
+	struct bio_vec *bvec;
+	int ret;
+
+	for (i = 0; i < nr_iovs; i++) {
+		size_t len = iov[i].iov_len;
+
+		if (len > MAX_RW_COUNT - total_len)
+			return -EINVAL;
+		total_len += len;
+		/* a range can straddle one more bvec at either end */
+		max_segs += (len >> imu->folio_shift) + 2;
+	}
+
+	bvec = kvmalloc_array(max_segs, sizeof(*bvec), GFP_KERNEL);
+	if (!bvec)
+		return -ENOMEM;
+
+	for (i = 0; i < nr_iovs; i++) {
+		u64 addr = (u64)(uintptr_t) iov[i].iov_base;
+		size_t off, len = iov[i].iov_len;
+		const struct bio_vec *src;
+		struct iov_iter tmp;
+
+		if (!len)
+			continue;
+		ret = io_import_fixed(ddir, &tmp, imu, addr, len);
+		if (unlikely(ret)) {
+			kvfree(bvec);
+			return ret;
+		}
+
+		src = tmp.bvec;
+		off = tmp.iov_offset;
+		while (len) {
+			size_t seg_len = min_t(size_t, len, src->bv_len - off);
+
+			bvec_set_page(&bvec[nr_segs++], src->bv_page, seg_len,
+				      src->bv_offset + off);
+			len -= seg_len;
+			off = 0;
+			src++;
 		}
 	}
 
+	iov_iter_bvec(iter, ddir, bvec, nr_segs, total_len);
+	*pbvec = bvec;
 	return 0;
 }
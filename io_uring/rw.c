@@ -136,6 +136,14 @@ static inline int io_import_iovec(int rw, struct io_kiocb *req,
 	return 0;
 }
 
+static void io_rw_bvec_free(struct io_async_rw *rw)
+{
+	if (rw->free_bvec) {
+		kvfree(rw->free_bvec);
+		rw->free_bvec = NULL;
+	}
+}
+
 static void io_rw_iovec_free(struct io_async_rw *rw)
 {
 	if (rw->free_iovec) {
@@ -143,6 +151,7 @@ static void io_rw_iovec_free(struct io_async_rw *rw)
 		rw->free_iov_nr = 0;
 		rw->free_iovec = NULL;
 	}
+	io_rw_bvec_free(rw);
 }
 
 static void io_rw_recycle(struct io_kiocb *req, unsigned int issue_flags)
@@ -154,6 +163,7 @@ static void io_rw_recycle(struct io_kiocb *req, unsigned int issue_flags)
 		io_rw_iovec_free(rw);
 		return;
 	}
+	io_rw_bvec_free(rw);
 	iov = rw->free_iovec;
 	if (io_alloc_cache_put(&req->ctx->rw_cache, rw)) {
 		if (iov)
@@ -219,6 +229,7 @@ static int io_rw_alloc_async(struct io_kiocb *req)
 		rw = req->async_data;
 		rw->free_iovec = NULL;
 		rw->free_iov_nr = 0;
+		rw->free_bvec = NULL;
 done:
 		rw->bytes_done = 0;
 		return 0;
@@ -315,24 +326,32 @@ int io_prep_writev(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 	return io_prep_rwv(req, sqe, ITER_SOURCE);
 }
 
+static int io_rw_prep_reg_buf(struct io_kiocb *req)
+{
+	struct io_ring_ctx *ctx = req->ctx;
+	u16 index;
+
+	if (unlikely(req->buf_index >= ctx->nr_user_bufs))
+		return -EFAULT;
+	index = array_index_nospec(req->buf_index, ctx->nr_user_bufs);
+	req->imu = ctx->user_bufs[index];
+	io_req_set_rsrc_node(req, ctx, 0);
+	return 0;
+}
+
 static int io_prep_rw_fixed(struct io_kiocb *req, const struct io_uring_sqe *sqe,
 			    int ddir)
 {
 	struct io_rw *rw = io_kiocb_to_cmd(req, struct io_rw);
-	struct io_ring_ctx *ctx = req->ctx;
 	struct io_async_rw *io;
-	u16 index;
 	int ret;
 
 	ret = io_prep_rw(req, sqe, ddir, false);
 	if (unlikely(ret))
 		return ret;
-
-	if (unlikely(req->buf_index >= ctx->nr_user_bufs))
-		return -EFAULT;
-	index = array_index_nospec(req->buf_index, ctx->nr_user_bufs);
-	req->imu = ctx->user_bufs[index];
-	io_req_set_rsrc_node(req, ctx, 0);
+	ret = io_rw_prep_reg_buf(req);
+	if (unlikely(ret))
+		return ret;
 
 	io = req->async_data;
 	ret = io_import_fixed(ddir, &io->iter, req->imu, rw->addr, rw->len);
@@ -340,6 +359,44 @@ static int io_prep_rw_fixed(struct io_kiocb *req, const struct io_uring_sqe *sqe
 	return ret;
 }
 
+/*
+ * Vectored read/write where the iovec segments all point into the same
+ * registered buffer. The segments are resolved against the buffer's bvecs
+ * at prep time, so no pages need pinning at issue time.
+ */
+static int io_prep_rwv_fixed(struct io_kiocb *req,
+			     const struct io_uring_sqe *sqe, int ddir)
+{
+	struct io_rw *rw = io_kiocb_to_cmd(req, struct io_rw);
+	struct io_async_rw *io;
+	struct iovec *iov;
+	int ret;
+
+	ret = io_prep_rw(req, sqe, ddir, false);
+	if (unlikely(ret))
+		return ret;
+	ret = io_rw_prep_reg_buf(req);
+	if (unlikely(ret))
+		return ret;
+
+	io = req->async_data;
+	iov = iovec_from_user(u64_to_user_ptr(rw->addr), rw->len, 1,
+			      &io->fast_iov, req->ctx->compat);
+	if (IS_ERR(iov))
+		return PTR_ERR(iov);
+
+	ret = io_import_fixed_vec(ddir, &io->iter, req->imu, iov, rw->len,
+				  &io->free_bvec);
+	if (iov != &io->fast_iov)
+		kfree(iov);
+	if (unlikely(ret))
+		return ret;
+
+	req->flags |= REQ_F_NEED_CLEANUP;
+	iov_iter_save_state(&io->iter, &io->iter_state);
+	return 0;
+}
+
 int io_prep_read_fixed(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 {
 	return io_prep_rw_fixed(req, sqe, ITER_DEST);
@@ -350,6 +407,16 @@ int io_prep_write_fixed(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 	return io_prep_rw_fixed(req, sqe, ITER_SOURCE);
 }
 
+int io_prep_readv_fixed(struct io_kiocb *req, const struct io_uring_sqe *sqe)
+{
+	return io_prep_rwv_fixed(req, sqe, ITER_DEST);
+}
+
+int io_prep_writev_fixed(struct io_kiocb *req, const struct io_uring_sqe *sqe)
+{
+	return io_prep_rwv_fixed(req, sqe, ITER_SOURCE);
+}
+
 /*
  * Multishot read is prepared just like a normal read/write request, only
  * difference is that we set the MULTISHOT flag.
@@ -511,7 +578,7 @@ void io_req_rw_complete(struct io_kiocb *req, struct io_tw_state *ts)
 	io_req_io_end(req);
 
 	if (req->flags & (REQ_F_BUFFER_SELECTED|REQ_F_BUFFER_RING))
-		req->cqe.flags |= io_put_kbuf(req, 0);
+		req->cqe.flags |= io_put_kbuf(req, req->cqe.res, 0);
 
 	io_req_rw_cleanup(req, 0);
 	io_req_task_complete(req, ts);
@@ -593,7 +660,7 @@ static int kiocb_done(struct io_kiocb *req, ssize_t ret,
 			 */
 			io_req_io_end(req);
 			io_req_set_res(req, final_ret,
-				       io_put_kbuf(req, issue_flags));
+				       io_put_kbuf(req, ret, issue_flags));
 			io_req_rw_cleanup(req, issue_flags);
 			return IOU_OK;
 		}
@@ -975,7 +1042,7 @@ int io_read_mshot(struct io_kiocb *req, unsigned int issue_flags)
 		 * Put our buffer and post a CQE. If we fail to post a CQE, then
 		 * jump to the termination path. This request is then done.
 		 */
-		cflags = io_put_kbuf(req, issue_flags);
+		cflags = io_put_kbuf(req, ret, issue_flags);
 		rw->len = 0; /* similarly to above, reset len to 0 */
 
 		if (io_req_post_cqe(req, ret, cflags | IORING_CQE_F_MORE)) {
@@ -1167,7 +1234,7 @@ int io_do_iopoll(struct io_ring_ctx *ctx, bool force_nonspin)
 		if (!smp_load_acquire(&req->iopoll_completed))
 			break;
 		nr_events++;
-		req->cqe.flags = io_put_kbuf(req, 0);
+		req->cqe.flags = io_put_kbuf(req, req->cqe.res, 0);
 		if (req->opcode != IORING_OP_URING_CMD)
 			io_req_rw_cleanup(req, 0);
 	}
@@ -19,6 +19,7 @@
 #include "sqpoll.h"
 
 #define IORING_SQPOLL_CAP_ENTRIES_VALUE 8
+#define IORING_SQPOLL_CAP_ROUND_VALUE	64
 #define IORING_TW_CAP_ENTRIES_VALUE	8
 
 enum {
@@ -304,6 +305,7 @@ static int io_sq_thread(void *data)
 	mutex_lock(&sqd->lock);
 	while (1) {
 		bool cap_entries, sqt_spin = false;
+		int budget = IORING_SQPOLL_CAP_ROUND_VALUE;
 
 		if (io_sqd_events_pending(sqd) || signal_pending(current)) {
 			if (io_sqd_handle_event(sqd))
@@ -318,6 +320,22 @@ static int io_sq_thread(void *data)
 
 			if (!sqt_spin && (ret > 0 || !wq_list_empty(&ctx->iopoll_list)))
 				sqt_spin = true;
+			if (!cap_entries || ret <= 0)
+				continue;
+			/*
+			 * With many rings attached, bound the work done in one
+			 * round so task_work and rescheduling aren't held off
+			 * behind every ring. Rotate the list so the next round
+			 * starts with the ring after this one, that way each
+			 * ring still gets its turn.
+			 */
+			budget -= ret;
+			if (budget <= 0) {
+				if (!list_is_last(&ctx->sqd_list, &sqd->ctx_list))
+					list_rotate_to_front(ctx->sqd_list.next,
+							     &sqd->ctx_list);
+				break;
+			}
 		}
 		if (io_sq_tw(&retry_list, IORING_TW_CAP_ENTRIES_VALUE))
 			sqt_spin = true;
@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: GPL-2.0
+#ifndef IOU_STATS_H
+#define IOU_STATS_H
+
+#include <linux/io_uring_types.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+
+/*
+ * Latency buckets are power-of-two ranges in microseconds: bucket 0 holds
+ * completions under 2us, bucket N holds [2^N, 2^(N+1)) usec, and the last
+ * bucket catches everything slower.
+ */
+#define IO_STATS_LAT_BUCKETS	20
+
+struct io_op_stats {
+	atomic_long_t		lat[IO_STATS_LAT_BUCKETS];
+	/* requests punted to io-wq */
+	atomic_long_t		nr_iowq;
+	/* requests that got -EAGAIN and armed async poll for a retry */
+	atomic_long_t		nr_poll;
+};
+
+static inline bool io_stats_enabled(struct io_ring_ctx *ctx)
+{
+	return ctx->flags & IORING_SETUP_OP_STATS;
+}
+
+/* Wraps after ~71 minutes, far beyond the last latency bucket */
+static inline u32 io_stats_now_us(void)
+{
+	return div_u64(ktime_get_ns(), NSEC_PER_USEC);
+}
+
+static inline void io_stats_start(struct io_ring_ctx *ctx,
+				  struct io_kiocb *req)
+{
+	if (unlikely(io_stats_enabled(ctx)))
+		req->submit_us = io_stats_now_us();
+}
+
+static inline void io_stats_complete(struct io_ring_ctx *ctx,
+				     struct io_kiocb *req)
+{
+	u32 us;
+	int bucket = 0;
+
+	if (likely(!io_stats_enabled(ctx)))
+		return;
+
+	us = io_stats_now_us() - req->submit_us;
+	if (us > 1)
+		bucket = min_t(int, ilog2(us), IO_STATS_LAT_BUCKETS - 1);
+	atomic_long_inc(&ctx->op_stats[req->opcode].lat[bucket]);
+}
+
+static inline void io_stats_iowq(struct io_kiocb *req)
+{
+	struct io_ring_ctx *ctx = req->ctx;
+
+	if (unlikely(io_stats_enabled(ctx)))
+		atomic_long_inc(&ctx->op_stats[req->opcode].nr_iowq);
+}
+
+static inline void io_stats_poll(struct io_kiocb *req)
+{
+	struct io_ring_ctx *ctx = req->ctx;
+
+	if (unlikely(io_stats_enabled(ctx)))
+		atomic_long_inc(&ctx->op_stats[req->opcode].nr_poll);
+}
+
+#endif
@@ -12,6 +12,7 @@
 #include "refs.h"
 #include "cancel.h"
 #include "timeout.h"
+#include "alloc_cache.h"
 
 struct io_timeout {
 	struct file			*file;
@@ -524,8 +525,13 @@ static int __io_timeout_prep(struct io_kiocb *req,
 
 	if (WARN_ON_ONCE(req_has_async_data(req)))
 		return -EFAULT;
-	if (io_alloc_async_data(req))
+	data = io_alloc_cache_get(&req->ctx->timeout_cache);
+	if (data) {
+		req->async_data = data;
+		req->flags |= REQ_F_ASYNC_DATA;
+	} else if (io_alloc_async_data(req)) {
 		return -ENOMEM;
+	}
 
 	data = req->async_data;
 	data->req = req;
@@ -553,6 +559,18 @@ static int __io_timeout_prep(struct io_kiocb *req,
 	return 0;
 }
 
+/*
+ * Called from io_clean_op() with ->uring_lock held. Returns true if the
+ * timeout data was recycled into the per-ring cache.
+ */
+bool io_timeout_cache_put(struct io_kiocb *req)
+{
+	if (req->opcode != IORING_OP_TIMEOUT &&
+	    req->opcode != IORING_OP_LINK_TIMEOUT)
+		return false;
+	return io_alloc_cache_put(&req->ctx->timeout_cache, req->async_data);
+}
+
 int io_timeout_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 {
 	return __io_timeout_prep(req, sqe, false);
@@ -20,6 +20,8 @@ static int msg_max_limit_max = HARD_MSGMAX;
 static int msg_maxsize_limit_min = MIN_MSGSIZEMAX;
 static int msg_maxsize_limit_max = HARD_MSGSIZEMAX;
 
+static unsigned int zerocopy_min_limit_max = HARD_MSGSIZEMAX;
+
 static struct ctl_table mq_sysctls[] = {
 	{
 		.procname	= "queues_max",
@@ -64,6 +66,15 @@ static struct ctl_table mq_sysctls[] = {
 		.extra1		= &msg_maxsize_limit_min,
 		.extra2		= &msg_maxsize_limit_max,
 	},
+	{
+		.procname	= "zerocopy_min",
+		.data		= &init_ipc_ns.mq_zerocopy_min,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= &zerocopy_min_limit_max,
+	},
 };
 
 static struct ctl_table_set *set_lookup(struct ctl_table_root *root)
@@ -139,6 +150,9 @@ bool setup_mq_sysctls(struct ipc_namespace *ns)
 
 			else if (tbl[i].data == &init_ipc_ns.mq_msgsize_default)
 				tbl[i].data = &ns->mq_msgsize_default;
+
+			else if (tbl[i].data == &init_ipc_ns.mq_zerocopy_min)
+				tbl[i].data = &ns->mq_zerocopy_min;
 			else
 				tbl[i].data = NULL;
 		}
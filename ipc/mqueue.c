@@ -16,6 +16,7 @@
 #include <linux/capability.h>
 #include <linux/init.h>
 #include <linux/pagemap.h>
+#include <linux/highmem.h>
 #include <linux/file.h>
 #include <linux/mount.h>
 #include <linux/fs_context.h>
@@ -39,6 +40,7 @@
 #include <linux/sched/wake_q.h>
 #include <linux/sched/signal.h>
 #include <linux/sched/user.h>
+#include <linux/security.h>
 
 #include <net/sock.h>
 #include "util.h"
@@ -128,9 +130,24 @@ struct ext_wait_queue {		/* queue of sleeping tasks */
 	struct task_struct *task;
 	struct list_head list;
 	struct msg_msg *msg;	/* ptr of loaded message */
+	struct mq_zc_msg *zc;	/* or of a zero-copy one, see mq_zc_send() */
 	int state;		/* one of STATE_* values */
 };
 
+/*
+ * A message whose payload still sits in the pinned user pages of the
+ * sender, which waits on @done until the receiver has copied it. @msg is
+ * the header only, for the size, the priority and the LSM blob.
+ */
+struct mq_zc_msg {
+	refcount_t ref;
+	struct completion done;
+	struct page **pages;
+	unsigned int nr_pages;
+	unsigned int offset;	/* of the payload in pages[0] */
+	struct msg_msg msg;
+};
+
 struct mqueue_inode_info {
 	spinlock_t lock;
 	struct inode vfs_inode;
@@ -1059,6 +1076,130 @@ static inline void pipelined_receive(struct wake_q_head *wake_q,
 	__pipelined_op(wake_q, info, sender);
 }
 
+static void mq_zc_put(struct mq_zc_msg *zc)
+{
+	if (!refcount_dec_and_test(&zc->ref))
+		return;
+	security_msg_msg_free(&zc->msg);
+	unpin_user_pages(zc->pages, zc->nr_pages);
+	kvfree(zc->pages);
+	kfree(zc);
+}
+
+/*
+ * Messages of at least fs/mqueue/zerocopy_min bytes are not copied into a
+ * msg_msg when a receiver is already waiting. The sender pins its buffer
+ * and hands it over, and the receiver copies the payload straight into
+ * its own buffer, saving one copy and the msg_msg allocation. As the
+ * sender may reuse its buffer once mq_timedsend() returns, it waits for
+ * the receiver to finish. That wait for the receiver's copy replaces the
+ * sender's own copy into the msg_msg, but it is unbounded, so O_NONBLOCK
+ * and timed sends always take the regular way.
+ *
+ * Returns 0 if the message was handed over, 1 if it has to be sent the
+ * regular way, or a negative error code.
+ */
+static int mq_zc_send(struct mqueue_inode_info *info, struct inode *inode,
+		      const char __user *u_msg_ptr, size_t msg_len,
+		      unsigned int msg_prio)
+{
+	unsigned long start = (unsigned long)u_msg_ptr;
+	struct ext_wait_queue *receiver;
+	struct mq_zc_msg *zc;
+	DEFINE_WAKE_Q(wake_q);
+	int pinned, ret;
+
+	/* Racy, pinning is wasted effort if nobody is waiting */
+	if (list_empty_careful(&info->e_wait_q[RECV].list))
+		return 1;
+
+	zc = kzalloc(sizeof(*zc), GFP_KERNEL);
+	if (!zc)
+		return 1;
+	zc->msg.m_ts = msg_len;
+	zc->msg.m_type = msg_prio;
+	/* Same as for the msg_msg that load_msg() would have allocated */
+	ret = security_msg_msg_alloc(&zc->msg);
+	if (ret)
+		goto out_free;
+
+	ret = 1;
+	zc->offset = offset_in_page(start);
+	zc->nr_pages = DIV_ROUND_UP(zc->offset + msg_len, PAGE_SIZE);
+	zc->pages = kvmalloc_array(zc->nr_pages, sizeof(*zc->pages),
+				   GFP_KERNEL);
+	if (!zc->pages)
+		goto out_free;
+
+	pinned = pin_user_pages_fast(start, zc->nr_pages, 0, zc->pages);
+	if (pinned != zc->nr_pages) {
+		/* let load_msg() sort out bad buffers */
+		if (pinned > 0)
+			unpin_user_pages(zc->pages, pinned);
+		goto out_free_pages;
+	}
+	refcount_set(&zc->ref, 2);
+	init_completion(&zc->done);
+
+	spin_lock(&info->lock);
+	/* Receivers only wait on an empty queue */
+	receiver = wq_get_first_waiter(info, RECV);
+	if (!receiver) {
+		spin_unlock(&info->lock);
+		refcount_set(&zc->ref, 1);
+		mq_zc_put(zc);
+		return 1;
+	}
+	receiver->msg = NULL;
+	receiver->zc = zc;
+	__pipelined_op(&wake_q, info, receiver);
+	simple_inode_init_ts(inode);
+	spin_unlock(&info->lock);
+	wake_up_q(&wake_q);
+
+	/*
+	 * The message is delivered either way. The pinned pages stay around
+	 * if we get killed meanwhile, and the -ERESTARTSYS never makes it
+	 * back to user space.
+	 */
+	ret = wait_for_completion_killable(&zc->done);
+	mq_zc_put(zc);
+	return ret;
+
+out_free_pages:
+	kvfree(zc->pages);
+out_free:
+	security_msg_msg_free(&zc->msg);
+	kfree(zc);
+	return ret;
+}
+
+static ssize_t mq_zc_receive(struct mq_zc_msg *zc, char __user *u_msg_ptr,
+			     unsigned int __user *u_msg_prio)
+{
+	size_t off = zc->offset, len = zc->msg.m_ts, copied = 0, n;
+	ssize_t ret = len;
+	unsigned int i;
+	void *kaddr;
+
+	if (u_msg_prio && put_user(zc->msg.m_type, u_msg_prio))
+		ret = -EFAULT;
+
+	for (i = 0; ret >= 0 && copied < len; i++) {
+		n = min_t(size_t, len - copied, PAGE_SIZE - off);
+		kaddr = kmap_local_page(zc->pages[i]);
+		if (copy_to_user(u_msg_ptr + copied, kaddr + off, n))
+			ret = -EFAULT;
+		kunmap_local(kaddr);
+		copied += n;
+		off = 0;
+	}
+
+	complete(&zc->done);
+	mq_zc_put(zc);
+	return ret;
+}
+
 static int do_mq_timedsend(mqd_t mqdes, const char __user *u_msg_ptr,
 		size_t msg_len, unsigned int msg_prio,
 		struct timespec64 *ts)
@@ -1071,6 +1212,7 @@ static int do_mq_timedsend(mqd_t mqdes, const char __user *u_msg_ptr,
 	struct mqueue_inode_info *info;
 	ktime_t expires, *timeout = NULL;
 	struct posix_msg_tree_node *new_leaf = NULL;
+	unsigned int zc_min;
 	int ret = 0;
 	DEFINE_WAKE_Q(wake_q);
 
@@ -1108,6 +1250,15 @@ static int do_mq_timedsend(mqd_t mqdes, const char __user *u_msg_ptr,
 		goto out_fput;
 	}
 
+	zc_min = READ_ONCE(current->nsproxy->ipc_ns->mq_zerocopy_min);
+	if (zc_min && msg_len >= zc_min && !timeout &&
+	    !(f.file->f_flags & O_NONBLOCK)) {
+		ret = mq_zc_send(info, inode, u_msg_ptr, msg_len, msg_prio);
+		if (ret <= 0)
+			goto out_fput;
+		ret = 0;
+	}
+
 	/* First try to allocate memory, before doing anything with
 	 * existing queues. */
 	msg_ptr = load_msg(u_msg_ptr, msg_len);
@@ -1143,6 +1294,7 @@ static int do_mq_timedsend(mqd_t mqdes, const char __user *u_msg_ptr,
 		} else {
 			wait.task = current;
 			wait.msg = (void *) msg_ptr;
+			wait.zc = NULL;
 
 			/* memory barrier not required, we hold info->lock */
 			WRITE_ONCE(wait.state, STATE_NONE);
@@ -1247,10 +1399,16 @@ static int do_mq_timedreceive(mqd_t mqdes, char __user *u_msg_ptr,
 			ret = -EAGAIN;
 		} else {
 			wait.task = current;
+			wait.zc = NULL;
 
 			/* memory barrier not required, we hold info->lock */
 			WRITE_ONCE(wait.state, STATE_NONE);
 			ret = wq_sleep(info, RECV, timeout, &wait);
+			if (ret == 0 && wait.zc) {
+				ret = mq_zc_receive(wait.zc, u_msg_ptr,
+						    u_msg_prio);
+				goto out_fput;
+			}
 			msg_ptr = wait.msg;
 		}
 	} else {
@@ -1697,6 +1855,7 @@ int mq_init_ns(struct ipc_namespace *ns)
 	ns->mq_msgsize_max   = DFLT_MSGSIZEMAX;
 	ns->mq_msg_default   = DFLT_MSG;
 	ns->mq_msgsize_default  = DFLT_MSGSIZE;
+	ns->mq_zerocopy_min  = 0;
 
 	m = mq_create_mount(ns);
 	if (IS_ERR(m))
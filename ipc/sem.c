@@ -994,6 +994,16 @@ static int update_queue(struct sem_array *sma, int semnum, struct wake_q_head *w
 	return semop_completed;
 }
 
+/*
+ * Caller must hold the lock of @sem. Only valid in per-semaphore locking
+ * mode, where the global queues are empty.
+ */
+static inline bool sem_no_waiters(struct sem *sem)
+{
+	return list_empty(&sem->pending_alter) &&
+	       list_empty(&sem->pending_const);
+}
+
 /**
  * set_semotime - set sem_otime
  * @sma: semaphore array
@@ -2099,6 +2109,18 @@ long __do_semtimedop(int semid, struct sembuf *sops,
 	queue.dupsop = dupsop;
 
 	error = perform_atomic_semop(sma, &queue);
+	if (error == 0 && locknum != SEM_GLOBAL_LOCK &&
+	    sem_no_waiters(&sma->sems[locknum])) {
+		/*
+		 * Uncontended simple operation: holding only the semaphore
+		 * lock means there are no complex operations around, so with
+		 * nobody sleeping on this semaphore there is nobody to wake.
+		 */
+		set_semotime(sma, sops);
+		sem_unlock(sma, locknum);
+		rcu_read_unlock();
+		goto out;
+	}
 	if (error == 0) { /* non-blocking successful path */
 		DEFINE_WAKE_Q(wake_q);
 
@@ -496,9 +496,78 @@ static struct bpf_lru_node *bpf_common_lru_pop_free(struct bpf_lru *lru,
 	return node;
 }
 
+/* CLOCK (second chance) eviction.
+ *
+ * Each CPU owns a contiguous slice of the preallocated nodes and a clock
+ * hand into it. A node's clock_type is either free (BPF_LRU_LIST_T_FREE)
+ * or in use (BPF_LRU_LIST_T_ACTIVE), and lookups only set its ref bit. Popping a
+ * node advances the hand: a free node is claimed with cmpxchg, a
+ * referenced one has its ref bit cleared and gets passed over, and the
+ * first unreferenced one is removed from the htab and reused.
+ *
+ * No lists are maintained and no lock other than the htab bucket lock of
+ * the evicted element is taken, which trades exact recency for updates
+ * that do not contend between CPUs.
+ */
+static struct bpf_lru_node *bpf_clock_lru_node(struct bpf_lru *lru,
+					       struct bpf_lru_clock *c, u32 idx)
+{
+	return c->nodes + (size_t)idx * lru->elem_size;
+}
+
+static struct bpf_lru_node *bpf_clock_lru_pop_free(struct bpf_lru *lru,
+						   u32 hash)
+{
+	struct bpf_lru_node *node;
+	struct bpf_lru_clock *c;
+	u32 hand, type, i;
+
+	c = per_cpu_ptr(lru->clock_lru, raw_smp_processor_id());
+	hand = READ_ONCE(c->hand);
+
+	/* One round clears all ref bits, so two always find a victim
+	 * unless the nodes are all being freed or inserted concurrently.
+	 */
+	for (i = 0; i < 2 * c->nr_nodes; i++) {
+		node = bpf_clock_lru_node(lru, c, hand);
+		if (++hand == c->nr_nodes)
+			hand = 0;
+
+		type = READ_ONCE(node->clock_type);
+		if (type == BPF_LRU_LIST_T_FREE) {
+			if (cmpxchg(&node->clock_type, type,
+				    BPF_LRU_LIST_T_ACTIVE) == type)
+				goto found;
+			continue;
+		}
+
+		if (bpf_lru_node_is_ref(node)) {
+			bpf_lru_node_clear_ref(node);
+			continue;
+		}
+
+		/* Whoever removes the element from the htab owns the node,
+		 * this fails if it is not hashed yet or has been deleted.
+		 */
+		if (lru->del_from_htab(lru->del_arg, node))
+			goto found;
+	}
+
+	WRITE_ONCE(c->hand, hand);
+	return NULL;
+
+found:
+	WRITE_ONCE(c->hand, hand);
+	*(u32 *)((void *)node + lru->hash_offset) = hash;
+	bpf_lru_node_clear_ref(node);
+	return node;
+}
+
 struct bpf_lru_node *bpf_lru_pop_free(struct bpf_lru *lru, u32 hash)
 {
-	if (lru->percpu)
+	if (lru->clock)
+		return bpf_clock_lru_pop_free(lru, hash);
+	else if (lru->percpu)
 		return bpf_percpu_lru_pop_free(lru, hash);
 	else
 		return bpf_common_lru_pop_free(lru, hash);
@@ -553,9 +622,22 @@ static void bpf_percpu_lru_push_free(struct bpf_lru *lru,
 	raw_spin_unlock_irqrestore(&l->lock, flags);
 }
 
+static void bpf_clock_lru_push_free(struct bpf_lru *lru,
+				    struct bpf_lru_node *node)
+{
+	if (WARN_ON_ONCE(READ_ONCE(node->clock_type) == BPF_LRU_LIST_T_FREE))
+		return;
+
+	/* The clock hand of the owning CPU picks it up when it comes by */
+	bpf_lru_node_clear_ref(node);
+	smp_store_release(&node->clock_type, BPF_LRU_LIST_T_FREE);
+}
+
 void bpf_lru_push_free(struct bpf_lru *lru, struct bpf_lru_node *node)
 {
-	if (lru->percpu)
+	if (lru->clock)
+		bpf_clock_lru_push_free(lru, node);
+	else if (lru->percpu)
 		bpf_percpu_lru_push_free(lru, node);
 	else
 		bpf_common_lru_push_free(lru, node);
@@ -610,10 +692,43 @@ static void bpf_percpu_lru_populate(struct bpf_lru *lru, void *buf,
 	}
 }
 
+static void bpf_clock_lru_populate(struct bpf_lru *lru, void *buf,
+				   u32 node_offset, u32 elem_size,
+				   u32 nr_elems)
+{
+	u32 i, pcpu_entries, n = 0;
+	struct bpf_lru_clock *c;
+	int cpu;
+
+	/* nr_elems is a non-zero multiple of the number of possible CPUs */
+	pcpu_entries = nr_elems / num_possible_cpus();
+	lru->elem_size = elem_size;
+	buf += node_offset;
+
+	for_each_possible_cpu(cpu) {
+		c = per_cpu_ptr(lru->clock_lru, cpu);
+		c->nodes = buf + (size_t)n * elem_size;
+		c->nr_nodes = pcpu_entries;
+		c->hand = 0;
+
+		for (i = 0; i < pcpu_entries; i++, n++) {
+			struct bpf_lru_node *node;
+
+			node = bpf_clock_lru_node(lru, c, i);
+			node->cpu = cpu;
+			node->clock_type = BPF_LRU_LIST_T_FREE;
+			bpf_lru_node_clear_ref(node);
+		}
+	}
+}
+
 void bpf_lru_populate(struct bpf_lru *lru, void *buf, u32 node_offset,
 		      u32 elem_size, u32 nr_elems)
 {
-	if (lru->percpu)
+	if (lru->clock)
+		bpf_clock_lru_populate(lru, buf, node_offset, elem_size,
+				       nr_elems);
+	else if (lru->percpu)
 		bpf_percpu_lru_populate(lru, buf, node_offset, elem_size,
 					nr_elems);
 	else
@@ -648,12 +763,18 @@ static void bpf_lru_list_init(struct bpf_lru_list *l)
 	raw_spin_lock_init(&l->lock);
 }
 
-int bpf_lru_init(struct bpf_lru *lru, bool percpu, u32 hash_offset,
-		 del_from_htab_func del_from_htab, void *del_arg)
+int bpf_lru_init(struct bpf_lru *lru, bool percpu, bool clock,
+		 u32 hash_offset, del_from_htab_func del_from_htab,
+		 void *del_arg)
 {
 	int cpu;
 
-	if (percpu) {
+	if (clock) {
+		lru->clock_lru = alloc_percpu(struct bpf_lru_clock);
+		if (!lru->clock_lru)
+			return -ENOMEM;
+		lru->nr_scans = 0;
+	} else if (percpu) {
 		lru->percpu_lru = alloc_percpu(struct bpf_lru_list);
 		if (!lru->percpu_lru)
 			return -ENOMEM;
@@ -684,6 +805,7 @@ int bpf_lru_init(struct bpf_lru *lru, bool percpu, u32 hash_offset,
 	}
 
 	lru->percpu = percpu;
+	lru->clock = clock;
 	lru->del_from_htab = del_from_htab;
 	lru->del_arg = del_arg;
 	lru->hash_offset = hash_offset;
@@ -693,7 +815,9 @@ int bpf_lru_init(struct bpf_lru *lru, bool percpu, u32 hash_offset,
 
 void bpf_lru_destroy(struct bpf_lru *lru)
 {
-	if (lru->percpu)
+	if (lru->clock)
+		free_percpu(lru->clock_lru);
+	else if (lru->percpu)
 		free_percpu(lru->percpu_lru);
 	else
 		free_percpu(lru->common_lru.local_list);
@@ -26,6 +26,8 @@ struct bpf_lru_node {
 	u16 cpu;
 	u8 type;
 	u8 ref;
+	/* BPF_F_CLOCK_LRU node type, a word so that it can be cmpxchg'ed */
+	u32 clock_type;
 };
 
 struct bpf_lru_list {
@@ -48,18 +50,28 @@ struct bpf_common_lru {
 	struct bpf_lru_locallist __percpu *local_list;
 };
 
+/* A CPU's slice of the nodes, scanned in CLOCK order from the hand */
+struct bpf_lru_clock {
+	void *nodes;
+	u32 nr_nodes;
+	u32 hand;
+};
+
 typedef bool (*del_from_htab_func)(void *arg, struct bpf_lru_node *node);
 
 struct bpf_lru {
 	union {
 		struct bpf_common_lru common_lru;
 		struct bpf_lru_list __percpu *percpu_lru;
+		struct bpf_lru_clock __percpu *clock_lru;
 	};
 	del_from_htab_func del_from_htab;
 	void *del_arg;
 	unsigned int hash_offset;
 	unsigned int nr_scans;
+	unsigned int elem_size;
 	bool percpu;
+	bool clock;
 };
 
 static inline void bpf_lru_node_set_ref(struct bpf_lru_node *node)
@@ -68,8 +80,9 @@ static inline void bpf_lru_node_set_ref(struct bpf_lru_node *node)
 		WRITE_ONCE(node->ref, 1);
 }
 
-int bpf_lru_init(struct bpf_lru *lru, bool percpu, u32 hash_offset,
-		 del_from_htab_func del_from_htab, void *delete_arg);
+int bpf_lru_init(struct bpf_lru *lru, bool percpu, bool clock,
+		 u32 hash_offset, del_from_htab_func del_from_htab,
+		 void *delete_arg);
 void bpf_lru_populate(struct bpf_lru *lru, void *buf, u32 node_offset,
 		      u32 elem_size, u32 nr_elems);
 void bpf_lru_destroy(struct bpf_lru *lru);
@@ -19,7 +19,10 @@
 
 #define HTAB_CREATE_FLAG_MASK						\
 	(BPF_F_NO_PREALLOC | BPF_F_NO_COMMON_LRU | BPF_F_NUMA_NODE |	\
-	 BPF_F_ACCESS_MASK | BPF_F_ZERO_SEED)
+	 BPF_F_ACCESS_MASK | BPF_F_ZERO_SEED | BPF_F_CLOCK_LRU)
+
+/* Batch ops gather the elements of many buckets before copying them out */
+#define HTAB_BATCH_CHUNK_SIZE	(64 * 1024)
 
 #define BATCH_OPS(_name)			\
 	.map_lookup_batch =			\
@@ -351,6 +354,7 @@ static int prealloc_init(struct bpf_htab *htab)
 	if (htab_is_lru(htab))
 		err = bpf_lru_init(&htab->lru,
 				   htab->map.map_flags & BPF_F_NO_COMMON_LRU,
+				   htab->map.map_flags & BPF_F_CLOCK_LRU,
 				   offsetof(struct htab_elem, hash) -
 				   offsetof(struct htab_elem, lru_node),
 				   htab_lru_map_delete_node,
@@ -423,6 +427,7 @@ static int htab_map_alloc_check(union bpf_attr *attr)
 	 * nothing to do with the map's value.
 	 */
 	bool percpu_lru = (attr->map_flags & BPF_F_NO_COMMON_LRU);
+	bool clock_lru = (attr->map_flags & BPF_F_CLOCK_LRU);
 	bool prealloc = !(attr->map_flags & BPF_F_NO_PREALLOC);
 	bool zero_seed = (attr->map_flags & BPF_F_ZERO_SEED);
 	int numa_node = bpf_map_attr_numa_node(attr);
@@ -438,7 +443,10 @@ static int htab_map_alloc_check(union bpf_attr *attr)
 	    !bpf_map_flags_access_ok(attr->map_flags))
 		return -EINVAL;
 
-	if (!lru && percpu_lru)
+	if (!lru && (percpu_lru || clock_lru))
+		return -EINVAL;
+
+	if (percpu_lru && clock_lru)
 		return -EINVAL;
 
 	if (lru && !prealloc)
@@ -478,6 +486,10 @@ static struct bpf_map *htab_map_alloc(union bpf_attr *attr)
 	 * nothing to do with the map's value.
 	 */
 	bool percpu_lru = (attr->map_flags & BPF_F_NO_COMMON_LRU);
+	/* clock_lru splits the elements between CPUs as well, but
+	 * evicts in CLOCK order without maintaining any lists.
+	 */
+	bool clock_lru = (attr->map_flags & BPF_F_CLOCK_LRU);
 	bool prealloc = !(attr->map_flags & BPF_F_NO_PREALLOC);
 	struct bpf_htab *htab;
 	int err, i;
@@ -490,7 +502,7 @@ static struct bpf_map *htab_map_alloc(union bpf_attr *attr)
 
 	bpf_map_init_from_attr(&htab->map, attr);
 
-	if (percpu_lru) {
+	if (percpu_lru || clock_lru) {
 		/* ensure each CPU's lru list has >=1 elements.
 		 * since we are at it, make each lru list has the same
 		 * number of elements.
@@ -1693,7 +1705,7 @@ __htab_map_lookup_and_delete_batch(struct bpf_map *map,
 				   bool is_percpu)
 {
 	struct bpf_htab *htab = container_of(map, struct bpf_htab, map);
-	u32 bucket_cnt, total, key_size, value_size, roundup_key_size;
+	u32 bucket_cnt, buf_cnt, total, key_size, value_size, roundup_key_size;
 	void *keys = NULL, *values = NULL, *value, *dst_key, *dst_val;
 	void __user *uvalues = u64_to_user_ptr(attr->batch.values);
 	void __user *ukeys = u64_to_user_ptr(attr->batch.keys);
@@ -1704,7 +1716,7 @@ __htab_map_lookup_and_delete_batch(struct bpf_map *map,
 	struct hlist_nulls_head *head;
 	struct hlist_nulls_node *n;
 	unsigned long flags = 0;
-	bool locked = false;
+	bool locked = false, stop = false;
 	struct htab_elem *l;
 	struct bucket *b;
 	int ret = 0;
@@ -1739,10 +1751,15 @@ __htab_map_lookup_and_delete_batch(struct bpf_map *map,
 	if (is_percpu)
 		value_size = size * num_possible_cpus();
 	total = 0;
-	/* while experimenting with hash tables with sizes ranging from 10 to
-	 * 1000, it was observed that a bucket can have up to 5 entries.
+	/* The elements of consecutive buckets are gathered in a chunk of
+	 * HTAB_BATCH_CHUNK_SIZE bytes, so that large dumps do not pay for two
+	 * copy_to_user() calls and an RCU section per bucket. The chunk
+	 * grows if a single bucket does not fit; while experimenting with
+	 * hash tables with sizes ranging from 10 to 1000, it was observed
+	 * that a bucket can have up to 5 entries.
 	 */
-	bucket_size = 5;
+	bucket_size = HTAB_BATCH_CHUNK_SIZE / (key_size + value_size);
+	bucket_size = max_t(u32, 5, min(bucket_size, max_count));
 
 alloc:
 	/* We cannot do copy_from_user or copy_to_user inside
@@ -1758,18 +1775,18 @@ __htab_map_lookup_and_delete_batch(struct bpf_map *map,
 again:
 	bpf_disable_instrumentation();
 	rcu_read_lock();
-again_nocopy:
 	dst_key = keys;
 	dst_val = values;
+	buf_cnt = 0;
+again_nocopy:
 	b = &htab->buckets[batch];
 	head = &b->head;
 	/* do not grab the lock unless need it (bucket_cnt > 0). */
 	if (locked) {
 		ret = htab_lock_bucket(htab, b, batch, &flags);
 		if (ret) {
-			rcu_read_unlock();
-			bpf_enable_instrumentation();
-			goto after_loop;
+			locked = false;
+			goto flush;
 		}
 	}
 
@@ -1782,24 +1799,29 @@ __htab_map_lookup_and_delete_batch(struct bpf_map *map,
 		goto again_nocopy;
 	}
 
-	if (bucket_cnt > (max_count - total)) {
-		if (total == 0)
+	if (bucket_cnt > (max_count - total - buf_cnt)) {
+		if (total + buf_cnt == 0)
 			ret = -ENOSPC;
 		/* Note that since bucket_cnt > 0 here, it is implicit
 		 * that the locked was grabbed, so release it.
 		 */
 		htab_unlock_bucket(htab, b, batch, flags);
-		rcu_read_unlock();
-		bpf_enable_instrumentation();
-		goto after_loop;
+		locked = false;
+		stop = true;
+		goto flush;
 	}
 
-	if (bucket_cnt > bucket_size) {
-		bucket_size = bucket_cnt;
+	if (buf_cnt + bucket_cnt > bucket_size) {
 		/* Note that since bucket_cnt > 0 here, it is implicit
 		 * that the locked was grabbed, so release it.
 		 */
 		htab_unlock_bucket(htab, b, batch, flags);
+		locked = false;
+		/* copy out the chunk, then retry this bucket */
+		if (buf_cnt)
+			goto flush;
+
+		bucket_size = bucket_cnt;
 		rcu_read_unlock();
 		bpf_enable_instrumentation();
 		kvfree(keys);
@@ -1860,6 +1882,7 @@ __htab_map_lookup_and_delete_batch(struct bpf_map *map,
 		dst_key += key_size;
 		dst_val += value_size;
 	}
+	buf_cnt += bucket_cnt;
 
 	htab_unlock_bucket(htab, b, batch, flags);
 	locked = false;
@@ -1871,30 +1894,29 @@ __htab_map_lookup_and_delete_batch(struct bpf_map *map,
 	}
 
 next_batch:
-	/* If we are not copying data, we can go to next bucket and avoid
-	 * unlocking the rcu.
-	 */
-	if (!bucket_cnt && (batch + 1 < htab->n_buckets)) {
-		batch++;
-		goto again_nocopy;
+	/* Keep gathering buckets until the chunk is full */
+	batch++;
+	if (batch >= htab->n_buckets) {
+		ret = -ENOENT;
+		goto flush;
 	}
+	if (buf_cnt < bucket_size)
+		goto again_nocopy;
 
+flush:
 	rcu_read_unlock();
 	bpf_enable_instrumentation();
-	if (bucket_cnt && (copy_to_user(ukeys + total * key_size, keys,
-	    key_size * bucket_cnt) ||
+	if (buf_cnt && (copy_to_user(ukeys + total * key_size, keys,
+	    key_size * buf_cnt) ||
 	    copy_to_user(uvalues + total * value_size, values,
-	    value_size * bucket_cnt))) {
+	    value_size * buf_cnt))) {
 		ret = -EFAULT;
 		goto after_loop;
 	}
 
-	total += bucket_cnt;
-	batch++;
-	if (batch >= htab->n_buckets) {
-		ret = -ENOENT;
+	total += buf_cnt;
+	if (ret || stop)
 		goto after_loop;
-	}
 	goto again;
 
 after_loop:
@@ -29,9 +29,24 @@ struct lpm_trie_node {
 	u8				data[];
 };
 
+/* Bits of the key resolved by the first level stride table */
+#define LPM_STRIDE_BITS		8
+#define LPM_STRIDE_SIZE		(1U << LPM_STRIDE_BITS)
+
+/* For one value of the first key byte, the most specific non-intermediate
+ * node with a shorter prefix that matches it, and the node to resume the
+ * walk at, i.e. the first node on its path with a prefix of at least
+ * LPM_STRIDE_BITS, if that node starts with the same byte.
+ */
+struct lpm_trie_stride {
+	struct lpm_trie_node __rcu	*found;
+	struct lpm_trie_node __rcu	*next;
+};
+
 struct lpm_trie {
 	struct bpf_map			map;
 	struct lpm_trie_node __rcu	*root;
+	struct lpm_trie_stride		*stride;
 	size_t				n_entries;
 	size_t				max_prefixlen;
 	size_t				data_size;
@@ -147,6 +162,13 @@ struct lpm_trie {
  * is a child that can be used to become more specific, the trie is traversed
  * downwards. The last node in the traversal that is a non-intermediate one is
  * returned.
+ *
+ * The top of a large trie is dense, so tries with keys of two bytes or more
+ * skip it with a table indexed by the first byte of the key. Each entry
+ * holds the result of the walk down to the first node with a prefix of at
+ * least 8 bits, which depends on nothing but that byte. Updates recompute
+ * the entries covered by the key they change, before the nodes they unlink
+ * are freed after a grace period.
  */
 
 static inline int extract_bit(const u8 *data, size_t index)
@@ -242,10 +264,21 @@ static void *trie_lookup_elem(struct bpf_map *map, void *_key)
 	if (key->prefixlen > trie->max_prefixlen)
 		return NULL;
 
-	/* Start walking the trie from the root node ... */
+	/* Start walking the trie from the root node, or where the stride
+	 * table leaves off ...
+	 */
+	if (trie->stride && key->prefixlen >= LPM_STRIDE_BITS) {
+		struct lpm_trie_stride *stride = &trie->stride[key->data[0]];
+
+		found = rcu_dereference_check(stride->found,
+					      rcu_read_lock_bh_held());
+		node = rcu_dereference_check(stride->next,
+					     rcu_read_lock_bh_held());
+	} else {
+		node = rcu_dereference_check(trie->root, rcu_read_lock_bh_held());
+	}
 
-	for (node = rcu_dereference_check(trie->root, rcu_read_lock_bh_held());
-	     node;) {
+	while (node) {
 		unsigned int next_bit;
 		size_t matchlen;
 
@@ -287,6 +320,56 @@ static void *trie_lookup_elem(struct bpf_map *map, void *_key)
 	return found->data + trie->data_size;
 }
 
+/* Recompute the stride table entries for the first key bytes covered by
+ * @key after it has been added or removed. Changes to nodes with shorter
+ * prefixes than LPM_STRIDE_BITS affect all entries they cover, others
+ * only the entry of their first byte.
+ */
+static void lpm_trie_stride_update(struct lpm_trie *trie,
+				   const struct bpf_lpm_trie_key_u8 *key)
+{
+	struct lpm_trie_node *node, *found;
+	unsigned int b, first, last;
+
+	if (!trie->stride)
+		return;
+
+	first = last = key->data[0];
+	if (key->prefixlen < LPM_STRIDE_BITS) {
+		first &= ~(0xffU >> key->prefixlen) & 0xff;
+		last = first | (0xffU >> key->prefixlen);
+	}
+
+	for (b = first; b <= last; b++) {
+		found = NULL;
+		node = rcu_dereference_protected(trie->root,
+						 lockdep_is_held(&trie->lock));
+		while (node && node->prefixlen < LPM_STRIDE_BITS) {
+			u8 mask = ~(0xffU >> node->prefixlen);
+			unsigned int next_bit;
+
+			if ((node->data[0] ^ b) & mask) {
+				node = NULL;
+				break;
+			}
+			if (!(node->flags & LPM_TREE_NODE_FLAG_IM))
+				found = node;
+
+			next_bit = (b >> (7 - node->prefixlen)) & 1;
+			node = rcu_dereference_protected(node->child[next_bit],
+						lockdep_is_held(&trie->lock));
+		}
+		/* A node with a different first byte can't match, and only
+		 * the entry of its own first byte is recomputed when it goes
+		 * away.
+		 */
+		if (node && node->data[0] != b)
+			node = NULL;
+		rcu_assign_pointer(trie->stride[b].found, found);
+		rcu_assign_pointer(trie->stride[b].next, node);
+	}
+}
+
 static struct lpm_trie_node *lpm_trie_node_alloc(const struct lpm_trie *trie,
 						 const void *value)
 {
@@ -435,6 +518,8 @@ static long trie_update_elem(struct bpf_map *map,
 
 		kfree(new_node);
 		kfree(im_node);
+	} else {
+		lpm_trie_stride_update(trie, key);
 	}
 
 	spin_unlock_irqrestore(&trie->lock, irq_flags);
@@ -535,6 +620,9 @@ static long trie_delete_elem(struct bpf_map *map, void *_key)
 	free_node = node;
 
 out:
+	if (!ret)
+		lpm_trie_stride_update(trie, key);
+
 	spin_unlock_irqrestore(&trie->lock, irq_flags);
 	kfree_rcu(free_parent, rcu);
 	kfree_rcu(free_node, rcu);
@@ -581,6 +669,17 @@ static struct bpf_map *trie_alloc(union bpf_attr *attr)
 			  offsetof(struct bpf_lpm_trie_key_u8, data);
 	trie->max_prefixlen = trie->data_size * 8;
 
+	/* all pointers start out NULL, just like the root */
+	if (trie->max_prefixlen > LPM_STRIDE_BITS) {
+		trie->stride = bpf_map_area_alloc(LPM_STRIDE_SIZE *
+						  sizeof(*trie->stride),
+						  trie->map.numa_node);
+		if (!trie->stride) {
+			bpf_map_area_free(trie);
+			return ERR_PTR(-ENOMEM);
+		}
+	}
+
 	spin_lock_init(&trie->lock);
 
 	return &trie->map;
@@ -622,6 +721,7 @@ static void trie_free(struct bpf_map *map)
 	}
 
 out:
+	bpf_map_area_free(trie->stride);
 	bpf_map_area_free(trie);
 }
 
@@ -736,11 +836,13 @@ static int trie_check_btf(const struct bpf_map *map,
 static u64 trie_mem_usage(const struct bpf_map *map)
 {
 	struct lpm_trie *trie = container_of(map, struct lpm_trie, map);
-	u64 elem_size;
+	u64 elem_size, usage = 0;
 
+	if (trie->stride)
+		usage += LPM_STRIDE_SIZE * sizeof(*trie->stride);
 	elem_size = sizeof(struct lpm_trie_node) + trie->data_size +
 			    trie->map.value_size;
-	return elem_size * READ_ONCE(trie->n_entries);
+	return usage + elem_size * READ_ONCE(trie->n_entries);
 }
 
 BTF_ID_LIST_SINGLE(trie_map_btf_ids, struct, lpm_trie)
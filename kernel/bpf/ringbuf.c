@@ -12,7 +12,7 @@
 #include <uapi/linux/btf.h>
 #include <linux/btf_ids.h>
 
-#define RINGBUF_CREATE_FLAG_MASK (BPF_F_NUMA_NODE)
+#define RINGBUF_CREATE_FLAG_MASK (BPF_F_NUMA_NODE | BPF_F_RINGBUF_PERCPU)
 
 /* non-mmap()'able part of bpf_ringbuf (everything up to consumer page) */
 #define RINGBUF_PGOFF \
@@ -20,11 +20,16 @@
 /* consumer page and producer page */
 #define RINGBUF_POS_PAGES 2
 #define RINGBUF_NR_META_PAGES (RINGBUF_PGOFF + RINGBUF_POS_PAGES)
+/* mmap()'able pages of one ring (position pages plus double-mapped data) */
+#define RINGBUF_MMAP_PAGES(data_sz) \
+	(RINGBUF_POS_PAGES + 2 * ((data_sz) >> PAGE_SHIFT))
 
 #define RINGBUF_MAX_RECORD_SZ (UINT_MAX/4)
 
 struct bpf_ringbuf {
 	wait_queue_head_t waitq;
+	/* waitq, or the shared one of a per-CPU ring buffer map */
+	wait_queue_head_t *wakeq;
 	struct irq_work work;
 	u64 mask;
 	struct page **pages;
@@ -78,6 +83,11 @@ struct bpf_ringbuf {
 struct bpf_ringbuf_map {
 	struct bpf_map map;
 	struct bpf_ringbuf *rb;
+	/* BPF_F_RINGBUF_PERCPU: one ring per possible CPU, indexed by CPU id,
+	 * which all wake up waitq. rb is NULL then.
+	 */
+	struct bpf_ringbuf **rbs;
+	wait_queue_head_t waitq;
 };
 
 /* 8-byte ring buffer record header structure */
@@ -151,7 +161,7 @@ static void bpf_ringbuf_notify(struct irq_work *work)
 {
 	struct bpf_ringbuf *rb = container_of(work, struct bpf_ringbuf, work);
 
-	wake_up_all(&rb->waitq);
+	wake_up_all(rb->wakeq);
 }
 
 /* Maximum size of ring buffer area is limited by 32-bit page offset within
@@ -176,6 +186,7 @@ static struct bpf_ringbuf *bpf_ringbuf_alloc(size_t data_sz, int numa_node)
 	spin_lock_init(&rb->spinlock);
 	atomic_set(&rb->busy, 0);
 	init_waitqueue_head(&rb->waitq);
+	rb->wakeq = &rb->waitq;
 	init_irq_work(&rb->work, bpf_ringbuf_notify);
 
 	rb->mask = data_sz - 1;
@@ -186,6 +197,39 @@ static struct bpf_ringbuf *bpf_ringbuf_alloc(size_t data_sz, int numa_node)
 	return rb;
 }
 
+static void bpf_ringbuf_free(struct bpf_ringbuf *rb);
+
+static int ringbuf_map_alloc_percpu(struct bpf_ringbuf_map *rb_map)
+{
+	int cpu;
+
+	rb_map->rbs = bpf_map_area_alloc(nr_cpu_ids * sizeof(*rb_map->rbs),
+					 NUMA_NO_NODE);
+	if (!rb_map->rbs)
+		return -ENOMEM;
+
+	init_waitqueue_head(&rb_map->waitq);
+	for_each_possible_cpu(cpu) {
+		struct bpf_ringbuf *rb;
+
+		rb = bpf_ringbuf_alloc(rb_map->map.max_entries,
+				       cpu_to_node(cpu));
+		if (!rb)
+			goto err_free;
+		rb->wakeq = &rb_map->waitq;
+		rb_map->rbs[cpu] = rb;
+	}
+	return 0;
+
+err_free:
+	for_each_possible_cpu(cpu) {
+		if (rb_map->rbs[cpu])
+			bpf_ringbuf_free(rb_map->rbs[cpu]);
+	}
+	bpf_map_area_free(rb_map->rbs);
+	return -ENOMEM;
+}
+
 static struct bpf_map *ringbuf_map_alloc(union bpf_attr *attr)
 {
 	struct bpf_ringbuf_map *rb_map;
@@ -193,6 +237,14 @@ static struct bpf_map *ringbuf_map_alloc(union bpf_attr *attr)
 	if (attr->map_flags & ~RINGBUF_CREATE_FLAG_MASK)
 		return ERR_PTR(-EINVAL);
 
+	/* per-CPU rings are only for kernel producers, and placed on the
+	 * node of their CPU
+	 */
+	if ((attr->map_flags & BPF_F_RINGBUF_PERCPU) &&
+	    (attr->map_type != BPF_MAP_TYPE_RINGBUF ||
+	     (attr->map_flags & BPF_F_NUMA_NODE)))
+		return ERR_PTR(-EINVAL);
+
 	if (attr->key_size || attr->value_size ||
 	    !is_power_of_2(attr->max_entries) ||
 	    !PAGE_ALIGNED(attr->max_entries))
@@ -204,6 +256,14 @@ static struct bpf_map *ringbuf_map_alloc(union bpf_attr *attr)
 
 	bpf_map_init_from_attr(&rb_map->map, attr);
 
+	if (attr->map_flags & BPF_F_RINGBUF_PERCPU) {
+		if (ringbuf_map_alloc_percpu(rb_map)) {
+			bpf_map_area_free(rb_map);
+			return ERR_PTR(-ENOMEM);
+		}
+		return &rb_map->map;
+	}
+
 	rb_map->rb = bpf_ringbuf_alloc(attr->max_entries, rb_map->map.numa_node);
 	if (!rb_map->rb) {
 		bpf_map_area_free(rb_map);
@@ -232,10 +292,49 @@ static void ringbuf_map_free(struct bpf_map *map)
 	struct bpf_ringbuf_map *rb_map;
 
 	rb_map = container_of(map, struct bpf_ringbuf_map, map);
-	bpf_ringbuf_free(rb_map->rb);
+	if (rb_map->rbs) {
+		int cpu;
+
+		for_each_possible_cpu(cpu)
+			bpf_ringbuf_free(rb_map->rbs[cpu]);
+		bpf_map_area_free(rb_map->rbs);
+	} else {
+		bpf_ringbuf_free(rb_map->rb);
+	}
 	bpf_map_area_free(rb_map);
 }
 
+/* The ring that records of the current CPU are reserved from */
+static struct bpf_ringbuf *ringbuf_map_local_rb(struct bpf_map *map)
+{
+	struct bpf_ringbuf_map *rb_map;
+
+	rb_map = container_of(map, struct bpf_ringbuf_map, map);
+	if (rb_map->rbs)
+		return rb_map->rbs[raw_smp_processor_id()];
+	return rb_map->rb;
+}
+
+/* The ring of CPU n of a per-CPU ring buffer map is mapped at page offset
+ * n * RINGBUF_MMAP_PAGES(), with the usual layout of a single ring.
+ * Translate *pgoff into an offset within the ring it selects.
+ */
+static struct bpf_ringbuf *ringbuf_map_mmap_rb(struct bpf_ringbuf_map *rb_map,
+					       unsigned long *pgoff)
+{
+	unsigned long stride, cpu;
+
+	if (!rb_map->rbs)
+		return rb_map->rb;
+
+	stride = RINGBUF_MMAP_PAGES(rb_map->map.max_entries);
+	cpu = *pgoff / stride;
+	if (cpu >= nr_cpu_ids || !cpu_possible(cpu))
+		return NULL;
+	*pgoff %= stride;
+	return rb_map->rbs[cpu];
+}
+
 static void *ringbuf_map_lookup_elem(struct bpf_map *map, void *key)
 {
 	return ERR_PTR(-ENOTSUPP);
@@ -261,19 +360,23 @@ static int ringbuf_map_get_next_key(struct bpf_map *map, void *key,
 static int ringbuf_map_mmap_kern(struct bpf_map *map, struct vm_area_struct *vma)
 {
 	struct bpf_ringbuf_map *rb_map;
+	unsigned long pgoff = vma->vm_pgoff;
+	struct bpf_ringbuf *rb;
 
 	rb_map = container_of(map, struct bpf_ringbuf_map, map);
+	rb = ringbuf_map_mmap_rb(rb_map, &pgoff);
+	if (!rb)
+		return -EINVAL;
 
 	if (vma->vm_flags & VM_WRITE) {
 		/* allow writable mapping for the consumer_pos only */
-		if (vma->vm_pgoff != 0 || vma->vm_end - vma->vm_start != PAGE_SIZE)
+		if (pgoff != 0 || vma->vm_end - vma->vm_start != PAGE_SIZE)
 			return -EPERM;
 	} else {
 		vm_flags_clear(vma, VM_MAYWRITE);
 	}
 	/* remap_vmalloc_range() checks size and offset constraints */
-	return remap_vmalloc_range(vma, rb_map->rb,
-				   vma->vm_pgoff + RINGBUF_PGOFF);
+	return remap_vmalloc_range(vma, rb, pgoff + RINGBUF_PGOFF);
 }
 
 static int ringbuf_map_mmap_user(struct bpf_map *map, struct vm_area_struct *vma)
@@ -314,12 +417,23 @@ static __poll_t ringbuf_map_poll_kern(struct bpf_map *map, struct file *filp,
 				      struct poll_table_struct *pts)
 {
 	struct bpf_ringbuf_map *rb_map;
+	int cpu;
 
 	rb_map = container_of(map, struct bpf_ringbuf_map, map);
-	poll_wait(filp, &rb_map->rb->waitq, pts);
+	if (!rb_map->rbs) {
+		poll_wait(filp, &rb_map->rb->waitq, pts);
 
-	if (ringbuf_avail_data_sz(rb_map->rb))
-		return EPOLLIN | EPOLLRDNORM;
+		if (ringbuf_avail_data_sz(rb_map->rb))
+			return EPOLLIN | EPOLLRDNORM;
+		return 0;
+	}
+
+	/* readable as long as any of the rings has data */
+	poll_wait(filp, &rb_map->waitq, pts);
+	for_each_possible_cpu(cpu) {
+		if (ringbuf_avail_data_sz(rb_map->rbs[cpu]))
+			return EPOLLIN | EPOLLRDNORM;
+	}
 	return 0;
 }
 
@@ -338,17 +452,22 @@ static __poll_t ringbuf_map_poll_user(struct bpf_map *map, struct file *filp,
 
 static u64 ringbuf_map_mem_usage(const struct bpf_map *map)
 {
-	struct bpf_ringbuf *rb;
+	struct bpf_ringbuf_map *rb_map;
 	int nr_data_pages;
 	int nr_meta_pages;
 	u64 usage = sizeof(struct bpf_ringbuf_map);
+	u64 nr_rings = 1, ring_usage;
 
-	rb = container_of(map, struct bpf_ringbuf_map, map)->rb;
-	usage += (u64)rb->nr_pages << PAGE_SHIFT;
+	rb_map = container_of(map, struct bpf_ringbuf_map, map);
+	if (rb_map->rbs) {
+		nr_rings = num_possible_cpus();
+		usage += nr_cpu_ids * sizeof(*rb_map->rbs);
+	}
 	nr_meta_pages = RINGBUF_NR_META_PAGES;
 	nr_data_pages = map->max_entries >> PAGE_SHIFT;
-	usage += (nr_meta_pages + 2 * nr_data_pages) * sizeof(struct page *);
-	return usage;
+	ring_usage = (u64)(nr_meta_pages + nr_data_pages) << PAGE_SHIFT;
+	ring_usage += (nr_meta_pages + 2 * nr_data_pages) * sizeof(struct page *);
+	return usage + nr_rings * ring_usage;
 }
 
 BTF_ID_LIST_SINGLE(ringbuf_map_btf_ids, struct, bpf_ringbuf_map)
@@ -469,13 +588,11 @@ static void *__bpf_ringbuf_reserve(struct bpf_ringbuf *rb, u64 size)
 
 BPF_CALL_3(bpf_ringbuf_reserve, struct bpf_map *, map, u64, size, u64, flags)
 {
-	struct bpf_ringbuf_map *rb_map;
-
 	if (unlikely(flags))
 		return 0;
 
-	rb_map = container_of(map, struct bpf_ringbuf_map, map);
-	return (unsigned long)__bpf_ringbuf_reserve(rb_map->rb, size);
+	return (unsigned long)__bpf_ringbuf_reserve(ringbuf_map_local_rb(map),
+						    size);
 }
 
 const struct bpf_func_proto bpf_ringbuf_reserve_proto = {
@@ -543,14 +660,12 @@ const struct bpf_func_proto bpf_ringbuf_discard_proto = {
 BPF_CALL_4(bpf_ringbuf_output, struct bpf_map *, map, void *, data, u64, size,
 	   u64, flags)
 {
-	struct bpf_ringbuf_map *rb_map;
 	void *rec;
 
 	if (unlikely(flags & ~(BPF_RB_NO_WAKEUP | BPF_RB_FORCE_WAKEUP)))
 		return -EINVAL;
 
-	rb_map = container_of(map, struct bpf_ringbuf_map, map);
-	rec = __bpf_ringbuf_reserve(rb_map->rb, size);
+	rec = __bpf_ringbuf_reserve(ringbuf_map_local_rb(map), size);
 	if (!rec)
 		return -EAGAIN;
 
@@ -572,7 +687,8 @@ BPF_CALL_2(bpf_ringbuf_query, struct bpf_map *, map, u64, flags)
 {
 	struct bpf_ringbuf *rb;
 
-	rb = container_of(map, struct bpf_ringbuf_map, map)->rb;
+	/* a per-CPU ring buffer map reports on the ring of this CPU */
+	rb = ringbuf_map_local_rb(map);
 
 	switch (flags) {
 	case BPF_RB_AVAIL_DATA:
@@ -598,7 +714,6 @@ const struct bpf_func_proto bpf_ringbuf_query_proto = {
 BPF_CALL_4(bpf_ringbuf_reserve_dynptr, struct bpf_map *, map, u32, size, u64, flags,
 	   struct bpf_dynptr_kern *, ptr)
 {
-	struct bpf_ringbuf_map *rb_map;
 	void *sample;
 	int err;
 
@@ -613,9 +728,7 @@ BPF_CALL_4(bpf_ringbuf_reserve_dynptr, struct bpf_map *, map, u32, size, u64, fl
 		return err;
 	}
 
-	rb_map = container_of(map, struct bpf_ringbuf_map, map);
-
-	sample = __bpf_ringbuf_reserve(rb_map->rb, size);
+	sample = __bpf_ringbuf_reserve(ringbuf_map_local_rb(map), size);
 	if (!sample) {
 		bpf_dynptr_set_null(ptr);
 		return -EINVAL;
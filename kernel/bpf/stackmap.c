@@ -9,6 +9,8 @@
 #include <linux/perf_event.h>
 #include <linux/btf_ids.h>
 #include <linux/buildid.h>
+#include <linux/fs.h>
+#include <linux/hash.h>
 #include "percpu_freelist.h"
 #include "mmap_unlock_work.h"
 
@@ -31,6 +33,27 @@ struct bpf_stack_map {
 	struct stack_map_bucket *buckets[] __counted_by(n_buckets);
 };
 
+/* Per-CPU cache of recently resolved build IDs, keyed by the backing
+ * inode. An inode is only considered the same file while its number,
+ * generation and ctime do not change.
+ */
+#define STACK_MAP_BUILD_ID_CACHE_BITS	4
+
+struct stack_map_build_id_entry {
+	struct inode *inode;
+	unsigned long ino;
+	u32 generation;
+	struct timespec64 ctime;
+	unsigned char build_id[BUILD_ID_SIZE_MAX];
+};
+
+struct stack_map_build_id_cache {
+	bool busy;
+	struct stack_map_build_id_entry entries[1 << STACK_MAP_BUILD_ID_CACHE_BITS];
+};
+
+static DEFINE_PER_CPU(struct stack_map_build_id_cache, stack_map_build_id_cache);
+
 static inline bool stack_map_use_build_id(struct bpf_map *map)
 {
 	return (map->map_flags & BPF_F_STACK_BUILD_ID);
@@ -124,6 +147,65 @@ static struct bpf_map *stack_map_alloc(union bpf_attr *attr)
 	return ERR_PTR(err);
 }
 
+static bool stack_map_build_id_match(const struct stack_map_build_id_entry *e,
+				     const struct inode *inode,
+				     const struct timespec64 *ctime)
+{
+	return e->inode == inode && e->ino == inode->i_ino &&
+	       e->generation == inode->i_generation &&
+	       timespec64_equal(&e->ctime, ctime);
+}
+
+/* build_id_parse() maps and parses the first page of the file, and fails
+ * if that page is not in the page cache. Look the build ID up in the
+ * cache first, and remember the result of successful parses.
+ */
+static int stack_map_build_id(struct vm_area_struct *vma,
+			      unsigned char *build_id)
+{
+	struct stack_map_build_id_cache *cache;
+	struct stack_map_build_id_entry *e;
+	struct timespec64 ctime;
+	struct inode *inode;
+	int err;
+
+	if (!vma->vm_file)
+		return -EINVAL;
+
+	inode = file_inode(vma->vm_file);
+	ctime = inode_get_ctime(inode);
+
+	preempt_disable();
+	cache = this_cpu_ptr(&stack_map_build_id_cache);
+	/* an NMI interrupted an update of the cache on this CPU */
+	if (READ_ONCE(cache->busy)) {
+		preempt_enable();
+		return build_id_parse(vma, build_id, NULL);
+	}
+	WRITE_ONCE(cache->busy, true);
+	barrier();
+
+	e = &cache->entries[hash_ptr(inode, STACK_MAP_BUILD_ID_CACHE_BITS)];
+	if (stack_map_build_id_match(e, inode, &ctime)) {
+		memcpy(build_id, e->build_id, BUILD_ID_SIZE_MAX);
+		err = 0;
+	} else {
+		err = build_id_parse(vma, build_id, NULL);
+		if (!err) {
+			e->inode = inode;
+			e->ino = inode->i_ino;
+			e->generation = inode->i_generation;
+			e->ctime = ctime;
+			memcpy(e->build_id, build_id, BUILD_ID_SIZE_MAX);
+		}
+	}
+
+	barrier();
+	WRITE_ONCE(cache->busy, false);
+	preempt_enable();
+	return err;
+}
+
 static void stack_map_get_build_id_offset(struct bpf_stack_build_id *id_offs,
 					  u64 *ips, u32 trace_nr, bool user)
 {
@@ -156,7 +238,7 @@ static void stack_map_get_build_id_offset(struct bpf_stack_build_id *id_offs,
 			goto build_id_valid;
 		}
 		vma = find_vma(current->mm, ips[i]);
-		if (!vma || build_id_parse(vma, id_offs[i].build_id, NULL)) {
+		if (!vma || stack_map_build_id(vma, id_offs[i].build_id)) {
 			/* per entry fall back to ips */
 			id_offs[i].status = BPF_STACK_BUILD_ID_IP;
 			id_offs[i].ip = ips[i];
@@ -17099,6 +17099,13 @@ static bool states_equal(struct bpf_verifier_env *env,
 	for (i = 0; i <= old->curframe; i++) {
 		if (old->frame[i]->callsite != cur->frame[i]->callsite)
 			return false;
+	}
+
+	/* Compare the innermost frame first, that is where the code since
+	 * the checkpoint has most likely changed something. The idmap only
+	 * has to be consistent, so the order does not affect the result.
+	 */
+	for (i = old->curframe; i >= 0; i--) {
 		if (!func_states_equal(env, old->frame[i], cur->frame[i], exact))
 			return false;
 	}
@@ -1057,6 +1057,14 @@ static int swiotlb_search_pool_area(struct device *dev, struct io_tlb_pool *pool
 	 */
 	stride = get_max_slots(max(alloc_align_mask, iotlb_align_mask));
 
+	/*
+	 * Every bounced I/O goes through here in confidential guests, so do
+	 * not bounce the lock of an area that is known to be too full. The
+	 * check is repeated under the lock.
+	 */
+	if (unlikely(nslots > pool->area_nslabs - READ_ONCE(area->used)))
+		return -1;
+
 	spin_lock_irqsave(&area->lock, flags);
 	if (unlikely(nslots > pool->area_nslabs - area->used))
 		goto not_found;
@@ -1112,7 +1120,7 @@ static int swiotlb_search_pool_area(struct device *dev, struct io_tlb_pool *pool
 	 * Update the indices to avoid searching in the next round.
 	 */
 	area->index = wrap_area_index(pool, index + nslots);
-	area->used += nslots;
+	WRITE_ONCE(area->used, area->used + nslots);
 	spin_unlock_irqrestore(&area->lock, flags);
 
 	inc_used_and_hiwater(dev->dma_io_tlb_mem, nslots);
@@ -1487,7 +1495,7 @@ static void swiotlb_release_slots(struct device *dev, phys_addr_t tlb_addr)
 	     io_tlb_offset(i) != IO_TLB_SEGSIZE - 1 && mem->slots[i].list;
 	     i--)
 		mem->slots[i].list = ++count;
-	area->used -= nslots;
+	WRITE_ONCE(area->used, area->used - nslots);
 	spin_unlock_irqrestore(&area->lock, flags);
 
 	dec_used(dev->dma_io_tlb_mem, nslots);
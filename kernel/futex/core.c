@@ -38,6 +38,9 @@
 #include <linux/memblock.h>
 #include <linux/fault-inject.h>
 #include <linux/slab.h>
+#include <linux/prctl.h>
+#include <linux/vmalloc.h>
+#include <linux/sched/mm.h>
 
 #include "futex.h"
 #include "../locking/rtmutex_common.h"
@@ -54,6 +57,13 @@ static struct {
 #define futex_queues   (__futex_data.queues)
 #define futex_hashsize (__futex_data.hashsize)
 
+/*
+ * Per node hashes for FUTEX2_NUMA futexes, allocated on their node. A NULL
+ * entry (single node systems, failed allocation) uses the global hash.
+ */
+static struct futex_hash_bucket *futex_node_queues[MAX_NUMNODES] __read_mostly;
+static unsigned long futex_node_hashsize __read_mostly;
+
 
 /*
  * Fault injections for futexes.
@@ -106,17 +116,171 @@ late_initcall(fail_futex_debugfs);
 
 #endif /* CONFIG_FAIL_FUTEX */
 
+static void futex_hash_bucket_init(struct futex_hash_bucket *hb)
+{
+	atomic_set(&hb->waiters, 0);
+	plist_head_init(&hb->chain);
+	spin_lock_init(&hb->lock);
+}
+
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+/*
+ * Private futexes of a multi-threaded process can only be waited on and woken
+ * by tasks running on that mm, so they may live in a hash of the mm's own
+ * instead of bouncing the global bucket locks with every other process.
+ *
+ * The table is never resized or replaced once installed: a futex_q queued in
+ * the old location would become invisible to wakers. It is therefore only
+ * installed while the mm has a single user, as no futex can be queued with
+ * nobody to queue it. Once a second thread exists the choice is final.
+ */
+#define FUTEX_PHASH_GLOBAL	-1
+
+static int futex_phash_install(struct mm_struct *mm, unsigned int slots)
+{
+	struct futex_hash_bucket *hb;
+	unsigned int i;
+
+	hb = kvmalloc_node(array_size(slots, sizeof(*hb)), GFP_KERNEL_ACCOUNT,
+			   numa_node_id());
+	if (!hb)
+		return -ENOMEM;
+
+	for (i = 0; i < slots; i++)
+		futex_hash_bucket_init(&hb[i]);
+
+	mm->futex_phash = hb;
+	/* Pairs with smp_load_acquire() in futex_hash(). */
+	smp_store_release(&mm->futex_phash_slots, slots);
+	return 0;
+}
+
+/*
+ * Sized to the CPUs the process can run on: that bounds how many threads can
+ * contend concurrently, whatever the eventual thread count.
+ */
+static unsigned int futex_phash_default_slots(void)
+{
+	unsigned int cpus = min_t(unsigned int, current->nr_cpus_allowed,
+				  num_online_cpus());
+
+	return clamp(roundup_pow_of_two(4 * cpus), 16UL, futex_hashsize);
+}
+
+/* Called by copy_process() before the new task can share current->mm. */
+void futex_hash_allocate_default(unsigned long clone_flags)
+{
+	struct mm_struct *mm = current->mm;
+
+	/* vfork() children exec or exit before the parent runs again */
+	if ((clone_flags & (CLONE_VM | CLONE_VFORK)) != CLONE_VM)
+		return;
+	if (!mm || mm->futex_phash_slots)
+		return;
+
+	if (atomic_read(&mm->mm_users) != 1 ||
+	    futex_phash_install(mm, futex_phash_default_slots()))
+		mm->futex_phash_slots = FUTEX_PHASH_GLOBAL;
+}
+
+void futex_hash_free(struct mm_struct *mm)
+{
+	kvfree(mm->futex_phash);
+	mm->futex_phash = NULL;
+}
+
+/**
+ * futex_hash_pin_global - Keep the private futexes of @mm in the global hash
+ * @mm:		The mm about to queue a futex_q not owned by a blocked task
+ *
+ * For users, like io_uring, that queue a waiter and return to user space. A
+ * later first thread must not move the private futexes away from it.
+ */
+void futex_hash_pin_global(struct mm_struct *mm)
+{
+	if (!READ_ONCE(mm->futex_phash_slots))
+		WRITE_ONCE(mm->futex_phash_slots, FUTEX_PHASH_GLOBAL);
+}
+
+int futex_hash_prctl(unsigned long arg2, unsigned long arg3,
+		     unsigned long arg4, unsigned long arg5)
+{
+	struct mm_struct *mm = current->mm;
+	int slots;
+
+	if (arg4 || arg5 || !mm)
+		return -EINVAL;
+
+	switch (arg2) {
+	case PR_FUTEX_HASH_SET_SLOTS:
+		/* 0 selects the global hash */
+		if (arg3 && (arg3 < 2 || arg3 > futex_hashsize ||
+			     !is_power_of_2(arg3)))
+			return -EINVAL;
+		if (mm->futex_phash_slots || atomic_read(&mm->mm_users) != 1)
+			return -EBUSY;
+		if (!arg3) {
+			mm->futex_phash_slots = FUTEX_PHASH_GLOBAL;
+			return 0;
+		}
+		return futex_phash_install(mm, arg3);
+
+	case PR_FUTEX_HASH_GET_SLOTS:
+		slots = READ_ONCE(mm->futex_phash_slots);
+		return slots > 0 ? slots : 0;
+	}
+
+	return -EINVAL;
+}
+
+static inline struct futex_hash_bucket *
+futex_private_hash(union futex_key *key, u32 hash)
+{
+	struct mm_struct *mm;
+	int slots;
+
+	if (key->both.offset & (FUT_OFF_INODE | FUT_OFF_MMSHARED))
+		return NULL;
+
+	mm = key->private.mm;
+	slots = smp_load_acquire(&mm->futex_phash_slots);
+	if (slots <= 0)
+		return NULL;
+
+	return &mm->futex_phash[hash & (slots - 1)];
+}
+#else
+static inline struct futex_hash_bucket *
+futex_private_hash(union futex_key *key, u32 hash)
+{
+	return NULL;
+}
+#endif /* CONFIG_FUTEX_PRIVATE_HASH */
+
 /**
- * futex_hash - Return the hash bucket in the global hash
+ * futex_hash - Return the hash bucket for a futex key
  * @key:	Pointer to the futex key for which the hash is calculated
  *
  * We hash on the keys returned from get_futex_key (see below) and return the
- * corresponding hash bucket in the global hash.
+ * corresponding hash bucket in the hash of the node the key was tagged with,
+ * in the process private hash, if the key is private and the process has
+ * one, or else in the global hash.
  */
 struct futex_hash_bucket *futex_hash(union futex_key *key)
 {
 	u32 hash = jhash2((u32 *)key, offsetof(typeof(*key), both.offset) / 4,
 			  key->both.offset);
+	struct futex_hash_bucket *hb;
+
+	if (key->both.node != FUTEX_NO_NODE) {
+		hb = futex_node_queues[key->both.node];
+		if (hb)
+			return &hb[hash & (futex_node_hashsize - 1)];
+	}
+
+	hb = futex_private_hash(key, hash);
+	if (hb)
+		return hb;
 
 	return &futex_queues[hash & (futex_hashsize - 1)];
 }
@@ -191,6 +355,57 @@ static u64 get_inode_sequence_number(struct inode *inode)
 	}
 }
 
+static int futex_get_node(u32 __user *uaddr, unsigned int flags, int *node)
+{
+	unsigned int size = futex_size(flags);
+	u64 val, none = U64_MAX >> (64 - 8 * size);
+	int ret;
+
+	ret = futex_get_value(&val, (void __user *)uaddr + size, flags);
+	if (ret)
+		return ret;
+
+	if (val == none)
+		return 0;
+
+	if (val >= nr_node_ids || !node_possible(val))
+		return -EINVAL;
+
+	*node = val;
+	return 0;
+}
+
+/**
+ * futex_node_changed - Recheck the FUTEX2_NUMA node word of a keyed futex
+ * @uaddr:	virtual address of the futex
+ * @flags:	FLAGS_*
+ * @key:	key previously set up by get_futex_key()
+ *
+ * The node selects the hash bucket, so a waiter must not queue with a node
+ * that no longer matches what a waker reads. Called with the hash bucket
+ * locked and pagefaults disabled; a fault counts as a change so the caller
+ * redoes get_futex_key(), which faults the word in and validates it.
+ *
+ * Return: true if the caller has to drop the bucket lock and re-key.
+ */
+bool futex_node_changed(void __user *uaddr, unsigned int flags,
+			union futex_key *key)
+{
+	unsigned int size = futex_size(flags);
+	u64 val, none = U64_MAX >> (64 - 8 * size);
+
+	if (!(flags & FLAGS_NUMA))
+		return false;
+
+	if (futex_get_value_sized_locked(&val, uaddr + size, flags))
+		return true;
+
+	if (val == none)
+		return key->both.node != FUTEX_NO_NODE;
+
+	return val != key->both.node;
+}
+
 /**
  * get_futex_key() - Get parameters which are the keys for a futex
  * @uaddr:	virtual address of the futex
@@ -216,6 +431,10 @@ static u64 get_inode_sequence_number(struct inode *inode)
  * This allows (cross process, where applicable) identification of the futex
  * without keeping the page pinned for the duration of the FUTEX_WAIT.
  *
+ * With FLAGS_NUMA the node word following the futex is read into the key's
+ * node, which is part of the match. An out of range node is rejected with
+ * -EINVAL.
+ *
  * lock_page() might sleep, the caller should not hold a spinlock.
  */
 int get_futex_key(u32 __user *uaddr, unsigned int flags, union futex_key *key,
@@ -226,6 +445,7 @@ int get_futex_key(u32 __user *uaddr, unsigned int flags, union futex_key *key,
 	struct page *page;
 	struct folio *folio;
 	struct address_space *mapping;
+	unsigned int size = futex_size(flags);
 	int err, ro = 0;
 	bool fshared;
 
@@ -235,16 +455,23 @@ int get_futex_key(u32 __user *uaddr, unsigned int flags, union futex_key *key,
 	 * The futex address must be "naturally" aligned.
 	 */
 	key->both.offset = address % PAGE_SIZE;
-	if (unlikely((address % sizeof(u32)) != 0))
+	if (unlikely((address % size) != 0))
 		return -EINVAL;
 	address -= key->both.offset;
 
-	if (unlikely(!access_ok(uaddr, sizeof(u32))))
+	if (unlikely(!access_ok(uaddr, flags & FLAGS_NUMA ? 2 * size : size)))
 		return -EFAULT;
 
 	if (unlikely(should_fail_futex(fshared)))
 		return -EFAULT;
 
+	key->both.node = FUTEX_NO_NODE;
+	if (flags & FLAGS_NUMA) {
+		err = futex_get_node(uaddr, flags, &key->both.node);
+		if (unlikely(err))
+			return err;
+	}
+
 	/*
 	 * PROCESS_PRIVATE futexes are fast.
 	 * As the mm cannot disappear under us and the 'key' only needs
@@ -472,6 +699,64 @@ int futex_get_value_locked(u32 *dest, u32 __user *from)
 	return ret ? -EFAULT : 0;
 }
 
+/**
+ * futex_get_value - Read a futex word of the size encoded in @flags
+ * @dest:	Where the zero extended value is stored
+ * @from:	User address of the futex word
+ * @flags:	FLAGS_SIZE_* of the futex
+ *
+ * May fault and sleep. Return: 0 on success, -EFAULT otherwise.
+ */
+int futex_get_value(u64 *dest, void __user *from, unsigned int flags)
+{
+	int ret;
+
+	switch (flags & FLAGS_SIZE_MASK) {
+	case FLAGS_SIZE_8: {
+		u8 val;
+
+		ret = get_user(val, (u8 __user *)from);
+		*dest = val;
+		break;
+	}
+	case FLAGS_SIZE_16: {
+		u16 val;
+
+		ret = get_user(val, (u16 __user *)from);
+		*dest = val;
+		break;
+	}
+	case FLAGS_SIZE_32: {
+		u32 val;
+
+		ret = get_user(val, (u32 __user *)from);
+		*dest = val;
+		break;
+	}
+	default:
+		ret = get_user(*dest, (u64 __user *)from);
+		break;
+	}
+
+	return ret ? -EFAULT : 0;
+}
+
+/*
+ * As futex_get_value(), with pagefaults disabled so that it can be called
+ * with the hash bucket lock held.
+ */
+int futex_get_value_sized_locked(u64 *dest, void __user *from,
+				 unsigned int flags)
+{
+	int ret;
+
+	pagefault_disable();
+	ret = futex_get_value(dest, from, flags);
+	pagefault_enable();
+
+	return ret;
+}
+
 /**
  * wait_for_owner_exiting - Block until the owner has exited
  * @ret: owner's current futex lock status
@@ -1162,10 +1447,26 @@ static int __init futex_init(void)
 					       futex_hashsize, futex_hashsize);
 	futex_hashsize = 1UL << futex_shift;
 
-	for (i = 0; i < futex_hashsize; i++) {
-		atomic_set(&futex_queues[i].waiters, 0);
-		plist_head_init(&futex_queues[i].chain);
-		spin_lock_init(&futex_queues[i].lock);
+	for (i = 0; i < futex_hashsize; i++)
+		futex_hash_bucket_init(&futex_queues[i]);
+
+	if (nr_node_ids > 1) {
+		int node;
+
+		futex_node_hashsize = max(16UL, rounddown_pow_of_two(futex_hashsize /
+								      nr_node_ids));
+		for_each_node(node) {
+			struct futex_hash_bucket *hb;
+
+			hb = kvmalloc_node(array_size(futex_node_hashsize, sizeof(*hb)),
+					   GFP_KERNEL, node);
+			if (!hb)
+				continue;
+
+			for (i = 0; i < futex_node_hashsize; i++)
+				futex_hash_bucket_init(&hb[i]);
+			futex_node_queues[node] = hb;
+		}
 	}
 
 	return 0;
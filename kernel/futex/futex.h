@@ -52,7 +52,7 @@ static inline unsigned int futex_to_flags(unsigned int op)
 	return flags;
 }
 
-#define FUTEX2_VALID_MASK (FUTEX2_SIZE_MASK | FUTEX2_PRIVATE)
+#define FUTEX2_VALID_MASK (FUTEX2_SIZE_MASK | FUTEX2_NUMA | FUTEX2_PRIVATE)
 
 /* FUTEX2_ to FLAGS_ */
 static inline unsigned int futex2_to_flags(unsigned int flags2)
@@ -81,13 +81,18 @@ static inline bool futex_flags_valid(unsigned int flags)
 			return false;
 	}
 
-	/* Only 32bit futexes are implemented -- for now */
-	if ((flags & FLAGS_SIZE_MASK) != FLAGS_SIZE_32)
-		return false;
-
 	return true;
 }
 
+/*
+ * Only wait and wake know about sizes other than 32 bits; the PI, requeue
+ * and wake_op paths operate on u32 futex words.
+ */
+static inline bool futex_flags_32(unsigned int flags)
+{
+	return (flags & FLAGS_SIZE_MASK) == FLAGS_SIZE_32;
+}
+
 static inline bool futex_validate_input(unsigned int flags, u64 val)
 {
 	int bits = 8 * futex_size(flags);
@@ -201,6 +206,14 @@ futex_setup_timer(ktime_t *time, struct hrtimer_sleeper *timeout,
 		  int flags, u64 range_ns);
 
 extern struct futex_hash_bucket *futex_hash(union futex_key *key);
+extern bool futex_node_changed(void __user *uaddr, unsigned int flags,
+			       union futex_key *key);
+
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+extern void futex_hash_pin_global(struct mm_struct *mm);
+#else
+static inline void futex_hash_pin_global(struct mm_struct *mm) { }
+#endif
 
 /**
  * futex_match - Check whether two futex keys are equal
@@ -214,10 +227,11 @@ static inline int futex_match(union futex_key *key1, union futex_key *key2)
 	return (key1 && key2
 		&& key1->both.word == key2->both.word
 		&& key1->both.ptr == key2->both.ptr
-		&& key1->both.offset == key2->both.offset);
+		&& key1->both.offset == key2->both.offset
+		&& key1->both.node == key2->both.node);
 }
 
-extern int futex_wait_setup(u32 __user *uaddr, u32 val, unsigned int flags,
+extern int futex_wait_setup(u32 __user *uaddr, u64 val, unsigned int flags,
 			    struct futex_q *q, struct futex_hash_bucket **hb);
 extern void futex_wait_queue(struct futex_hash_bucket *hb, struct futex_q *q,
 				   struct hrtimer_sleeper *timeout);
@@ -227,6 +241,9 @@ extern void futex_wake_mark(struct wake_q_head *wake_q, struct futex_q *q);
 extern int fault_in_user_writeable(u32 __user *uaddr);
 extern int futex_cmpxchg_value_locked(u32 *curval, u32 __user *uaddr, u32 uval, u32 newval);
 extern int futex_get_value_locked(u32 *dest, u32 __user *from);
+extern int futex_get_value(u64 *dest, void __user *from, unsigned int flags);
+extern int futex_get_value_sized_locked(u64 *dest, void __user *from,
+					unsigned int flags);
 extern struct futex_q *futex_top_waiter(struct futex_hash_bucket *hb, union futex_key *key);
 
 extern void __futex_unqueue(struct futex_q *q);
@@ -343,7 +360,7 @@ extern int futex_requeue(u32 __user *uaddr1, unsigned int flags1,
 			 int nr_wake, int nr_requeue,
 			 u32 *cmpval, int requeue_pi);
 
-extern int __futex_wait(u32 __user *uaddr, unsigned int flags, u32 val,
+extern int __futex_wait(u32 __user *uaddr, unsigned int flags, u64 val,
 			struct hrtimer_sleeper *to, u32 bitset);
 
 extern int futex_wait(u32 __user *uaddr, unsigned int flags, u32 val,
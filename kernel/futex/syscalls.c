@@ -354,6 +354,63 @@ SYSCALL_DEFINE4(futex_wake,
 	return futex_wake(uaddr, FLAGS_STRICT | flags, nr, mask);
 }
 
+/*
+ * sys_futex_wakev - Wake waiters on a list of futexes
+ * @waiters:	List of futexes to wake
+ * @nr_futexes:	Length of the list
+ * @flags:	unused
+ *
+ * For each entry, wake up to @val waiters of the futex at @uaddr, with the
+ * entry's own FUTEX2 flags, as sys_futex_wake() with a full bitmask would.
+ * Saves a syscall per futex for user space schedulers releasing many waiters
+ * at once.
+ *
+ * Returns the total number of woken waiters. An invalid entry stops the walk;
+ * if nothing was woken by then its error is returned.
+ */
+SYSCALL_DEFINE3(futex_wakev, struct futex_waitv __user *, waiters,
+		unsigned int, nr_futexes, unsigned int, flags)
+{
+	struct futex_waitv aux;
+	unsigned int i;
+	int ret = 0, woken = 0;
+
+	if (flags)
+		return -EINVAL;
+
+	if (!nr_futexes || nr_futexes > FUTEX_WAITV_MAX || !waiters)
+		return -EINVAL;
+
+	for (i = 0; i < nr_futexes; i++) {
+		unsigned int fflags;
+
+		if (copy_from_user(&aux, &waiters[i], sizeof(aux))) {
+			ret = -EFAULT;
+			break;
+		}
+
+		if ((aux.flags & ~FUTEX2_VALID_MASK) || aux.__reserved ||
+		    aux.val > INT_MAX) {
+			ret = -EINVAL;
+			break;
+		}
+
+		fflags = futex2_to_flags(aux.flags);
+		if (!futex_flags_valid(fflags)) {
+			ret = -EINVAL;
+			break;
+		}
+
+		ret = futex_wake(u64_to_user_ptr(aux.uaddr), FLAGS_STRICT | fflags,
+				 aux.val, FUTEX_BITSET_MATCH_ANY);
+		if (ret < 0)
+			break;
+		woken += ret;
+	}
+
+	return woken ?: ret;
+}
+
 /*
  * sys_futex_wait - Wait on a futex
  * @uaddr:	Address of the futex to wait on
@@ -431,6 +488,10 @@ SYSCALL_DEFINE4(futex_requeue,
 	if (ret)
 		return ret;
 
+	if (!futex_flags_32(futexes[0].w.flags) ||
+	    !futex_flags_32(futexes[1].w.flags))
+		return -EINVAL;
+
 	cmpval = futexes[0].w.val;
 
 	return futex_requeue(u64_to_user_ptr(futexes[0].w.uaddr), futexes[0].w.flags,
@@ -416,7 +416,7 @@ int futex_wait_multiple_setup(struct futex_vector *vs, int count, int *woken)
 	struct futex_hash_bucket *hb;
 	bool retry = false;
 	int ret, i;
-	u32 uval;
+	u64 uval;
 
 	/*
 	 * Enqueuing multiple futexes is tricky, because we need to enqueue
@@ -448,12 +448,15 @@ int futex_wait_multiple_setup(struct futex_vector *vs, int count, int *woken)
 	set_current_state(TASK_INTERRUPTIBLE|TASK_FREEZABLE);
 
 	for (i = 0; i < count; i++) {
-		u32 __user *uaddr = (u32 __user *)(unsigned long)vs[i].w.uaddr;
+		void __user *uaddr = u64_to_user_ptr(vs[i].w.uaddr);
+		unsigned int flags = vs[i].w.flags;
 		struct futex_q *q = &vs[i].q;
-		u32 val = vs[i].w.val;
+		u64 val = vs[i].w.val;
 
 		hb = futex_q_lock(q);
-		ret = futex_get_value_locked(&uval, uaddr);
+		ret = futex_get_value_sized_locked(&uval, uaddr, flags);
+		if (!ret && futex_node_changed(uaddr, flags, &q->key))
+			ret = -EAGAIN;
 
 		if (!ret && uval == val) {
 			/*
@@ -477,6 +480,12 @@ int futex_wait_multiple_setup(struct futex_vector *vs, int count, int *woken)
 		if (*woken >= 0)
 			return 1;
 
+		if (ret == -EAGAIN) {
+			/* The node word changed, re-key every futex */
+			retry = false;
+			goto retry;
+		}
+
 		if (ret) {
 			/*
 			 * If we need to handle a page fault, we need to do so
@@ -485,7 +494,7 @@ int futex_wait_multiple_setup(struct futex_vector *vs, int count, int *woken)
 			 * undoing all the work done so far. In success, we
 			 * retry all the work.
 			 */
-			if (get_user(uval, uaddr))
+			if (futex_get_value(&uval, uaddr, flags))
 				return -EFAULT;
 
 			retry = true;
@@ -589,10 +598,10 @@ int futex_wait_multiple(struct futex_vector *vs, unsigned int count,
  *  -  0 - uaddr contains val and hb has been locked;
  *  - <1 - -EFAULT or -EWOULDBLOCK (uaddr does not contain val) and hb is unlocked
  */
-int futex_wait_setup(u32 __user *uaddr, u32 val, unsigned int flags,
+int futex_wait_setup(u32 __user *uaddr, u64 val, unsigned int flags,
 		     struct futex_q *q, struct futex_hash_bucket **hb)
 {
-	u32 uval;
+	u64 uval;
 	int ret;
 
 	/*
@@ -621,12 +630,12 @@ int futex_wait_setup(u32 __user *uaddr, u32 val, unsigned int flags,
 retry_private:
 	*hb = futex_q_lock(q);
 
-	ret = futex_get_value_locked(&uval, uaddr);
+	ret = futex_get_value_sized_locked(&uval, uaddr, flags);
 
 	if (ret) {
 		futex_q_unlock(*hb);
 
-		ret = get_user(uval, uaddr);
+		ret = futex_get_value(&uval, uaddr, flags);
 		if (ret)
 			return ret;
 
@@ -638,13 +647,18 @@ int futex_wait_setup(u32 __user *uaddr, u32 val, unsigned int flags,
 
 	if (uval != val) {
 		futex_q_unlock(*hb);
-		ret = -EWOULDBLOCK;
+		return -EWOULDBLOCK;
+	}
+
+	if (futex_node_changed(uaddr, flags, &q->key)) {
+		futex_q_unlock(*hb);
+		goto retry;
 	}
 
 	return ret;
 }
 
-int __futex_wait(u32 __user *uaddr, unsigned int flags, u32 val,
+int __futex_wait(u32 __user *uaddr, unsigned int flags, u64 val,
 		 struct hrtimer_sleeper *to, u32 bitset)
 {
 	struct futex_q q = futex_q_init;
@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Load aware placement of managed interrupts.
+ *
+ * Managed interrupts are spread over CPU groups at allocation time and
+ * user space cannot move them. Each vector is targeted at a single CPU
+ * of its group, no matter how busy that CPU gets with interrupt work.
+ * When enabled, this periodically moves the target of such a vector to
+ * the CPU of its group which spent the least time in hard and soft
+ * interrupt context. The managed affinity mask itself is left untouched,
+ * so CPU hotplug and shutdown handling keep operating on the group.
+ */
+#include <linux/interrupt.h>
+#include <linux/irq.h>
+#include <linux/kernel_stat.h>
+#include <linux/math64.h>
+#include <linux/sched/isolation.h>
+#include <linux/workqueue.h>
+
+#include "internals.h"
+
+/* Balancing interval in milliseconds, 0 disables balancing */
+static unsigned int irq_balance_interval_ms;
+
+static DEFINE_PER_CPU(u64, irq_balance_prev);
+static DEFINE_PER_CPU(u64, irq_balance_load);
+static DEFINE_PER_CPU(unsigned long, irq_balance_prev_irqs);
+static DEFINE_PER_CPU(unsigned long, irq_balance_irqs);
+
+/* CPUs which received an interrupt in the current balancing pass */
+static struct cpumask irq_balance_taken;
+static struct cpumask irq_balance_affinity;
+
+static void irq_balance_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(irq_balance_work, irq_balance_fn);
+
+static int __init irq_balance_setup(char *str)
+{
+	return kstrtouint(str, 0, &irq_balance_interval_ms) == 0;
+}
+__setup("irq_managed_balance=", irq_balance_setup);
+
+static void irq_balance_update_load(void)
+{
+	unsigned int cpu;
+
+	for_each_online_cpu(cpu) {
+		u64 *cpustat = kcpustat_cpu(cpu).cpustat;
+		u64 now = cpustat[CPUTIME_IRQ] + cpustat[CPUTIME_SOFTIRQ];
+
+		unsigned long irqs = kstat_cpu_irqs_sum(cpu);
+
+		per_cpu(irq_balance_load, cpu) = now - per_cpu(irq_balance_prev, cpu);
+		per_cpu(irq_balance_prev, cpu) = now;
+		per_cpu(irq_balance_irqs, cpu) = irqs - per_cpu(irq_balance_prev_irqs, cpu);
+		per_cpu(irq_balance_prev_irqs, cpu) = irqs;
+	}
+}
+
+/*
+ * Estimate the share of @cpu's interrupt load caused by @count interrupts of
+ * one vector, from its share of all interrupts @cpu handled in the interval.
+ */
+static u64 irq_balance_irq_load(unsigned int cpu, unsigned int count)
+{
+	unsigned long total = max(per_cpu(irq_balance_irqs, cpu), (unsigned long)count);
+
+	if (!total)
+		return 0;
+	return mul_u64_u64_div_u64(per_cpu(irq_balance_load, cpu), count, total);
+}
+
+static unsigned int irq_balance_pick(const struct cpumask *affinity)
+{
+	const struct cpumask *hk_mask = housekeeping_cpumask(HK_TYPE_MANAGED_IRQ);
+	unsigned int cpu, best = nr_cpu_ids;
+	u64 load, best_load = U64_MAX;
+
+	for_each_cpu_and(cpu, affinity, cpu_online_mask) {
+		if (!cpumask_test_cpu(cpu, hk_mask) ||
+		    cpumask_test_cpu(cpu, &irq_balance_taken))
+			continue;
+		load = per_cpu(irq_balance_load, cpu);
+		if (load < best_load) {
+			best_load = load;
+			best = cpu;
+		}
+	}
+	return best;
+}
+
+/*
+ * Move a managed single target interrupt to the least loaded housekeeping
+ * CPU of its group, if that stays at least an eighth of the interval less
+ * busy with interrupt work than the current target once the interrupt's
+ * own load has moved over. Moving it back is then never better, so
+ * interrupts don't bounce between CPUs while their load is stable.
+ */
+static void irq_balance_one(struct irq_desc *desc, u64 margin)
+{
+	struct irq_data *data = irq_desc_get_irq_data(desc);
+	unsigned int cur, best, count;
+	const struct cpumask *effective;
+	u64 load;
+
+	count = desc->tot_count - desc->balance_count;
+	desc->balance_count = desc->tot_count;
+
+	if (!irqd_affinity_is_managed(data) || !desc->action ||
+	    !irqd_is_started(data) || irqd_is_per_cpu(data) ||
+	    !irq_can_move_pcntxt(data) || irqd_is_setaffinity_pending(data))
+		return;
+
+	effective = irq_data_get_effective_affinity_mask(data);
+	if (cpumask_weight(effective) != 1)
+		return;
+	cur = cpumask_first(effective);
+
+	best = irq_balance_pick(irq_data_get_affinity_mask(data));
+	if (best >= nr_cpu_ids || best == cur)
+		return;
+
+	load = irq_balance_irq_load(cur, count);
+	if (per_cpu(irq_balance_load, cur) <
+	    per_cpu(irq_balance_load, best) + 2 * load + margin)
+		return;
+
+	/* Retarget, but keep the managed affinity mask of the group */
+	cpumask_copy(&irq_balance_affinity, irq_data_get_affinity_mask(data));
+	if (!irq_do_set_affinity(data, cpumask_of(best), false)) {
+		cpumask_set_cpu(best, &irq_balance_taken);
+		per_cpu(irq_balance_load, cur) -= load;
+		per_cpu(irq_balance_load, best) += load;
+	}
+	irq_data_update_affinity(data, &irq_balance_affinity);
+}
+
+static void irq_balance_fn(struct work_struct *work)
+{
+	u64 margin = (u64)irq_balance_interval_ms * NSEC_PER_MSEC / 8;
+	struct irq_desc *desc;
+	unsigned int irq;
+
+	cpus_read_lock();
+	irq_balance_update_load();
+	cpumask_clear(&irq_balance_taken);
+
+	irq_lock_sparse();
+	for_each_active_irq(irq) {
+		desc = irq_to_desc(irq);
+		raw_spin_lock_irq(&desc->lock);
+		irq_balance_one(desc, margin);
+		raw_spin_unlock_irq(&desc->lock);
+	}
+	irq_unlock_sparse();
+	cpus_read_unlock();
+
+	queue_delayed_work(system_unbound_wq, &irq_balance_work,
+			   msecs_to_jiffies(irq_balance_interval_ms));
+}
+
+static int __init irq_balance_init(void)
+{
+	if (!irq_balance_interval_ms)
+		return 0;
+
+	pr_info("Balancing managed interrupts every %u ms\n",
+		irq_balance_interval_ms);
+	queue_delayed_work(system_unbound_wq, &irq_balance_work,
+			   msecs_to_jiffies(irq_balance_interval_ms));
+	return 0;
+}
+late_initcall(irq_balance_init);
@@ -1227,6 +1227,51 @@ static irqreturn_t irq_thread_fn(struct irq_desc *desc,
 	return ret;
 }
 
+/*
+ * Maximum number of consecutive handler invocations per wakeup of a polling
+ * interrupt thread.
+ */
+#define IRQ_THREAD_POLL_BUDGET	64
+
+/*
+ * Interrupts requested with IRQF_POLL: keep invoking the thread handler with
+ * the line masked as long as it finds work, i.e. returns IRQ_HANDLED. The
+ * line is unmasked only once the handler reports the device idle. When the
+ * budget is used up first, the thread is requeued with the line still
+ * masked and goes through irq_wait_for_interrupt() again; an edge or MSI
+ * source would not raise a new interrupt for the work that is left.
+ */
+static irqreturn_t irq_thread_poll_fn(struct irq_desc *desc,
+		struct irqaction *action)
+{
+	unsigned int budget = IRQ_THREAD_POLL_BUDGET;
+	irqreturn_t ret, handled = IRQ_NONE;
+
+	WRITE_ONCE(action->poll_wakeups, action->poll_wakeups + 1);
+
+	do {
+		ret = action->thread_fn(action->irq, action->dev_id);
+		if (ret != IRQ_HANDLED)
+			break;
+
+		handled = IRQ_HANDLED;
+		WRITE_ONCE(action->poll_rounds, action->poll_rounds + 1);
+	} while (--budget && !kthread_should_stop());
+
+	if (handled == IRQ_HANDLED)
+		atomic_inc(&desc->threads_handled);
+
+	if (ret == IRQ_HANDLED && !kthread_should_stop()) {
+		/* Balanced by wake_threads_waitq(), like __irq_wake_thread() */
+		if (!test_and_set_bit(IRQTF_RUNTHREAD, &action->thread_flags))
+			atomic_inc(&desc->threads_active);
+		return handled;
+	}
+
+	irq_finalize_oneshot(desc, action);
+	return ret == IRQ_WAKE_THREAD ? ret : handled;
+}
+
 void wake_threads_waitq(struct irq_desc *desc)
 {
 	if (atomic_dec_and_test(&desc->threads_active))
@@ -1315,6 +1360,8 @@ static int irq_thread(void *data)
 	if (force_irqthreads() && test_bit(IRQTF_FORCED_THREAD,
 					   &action->thread_flags))
 		handler_fn = irq_forced_thread_fn;
+	else if (action->flags & IRQF_POLL)
+		handler_fn = irq_thread_poll_fn;
 	else
 		handler_fn = irq_thread_fn;
 
@@ -1530,6 +1577,21 @@ __setup_irq(unsigned int irq, struct irq_desc *desc, struct irqaction *new)
 	if (!(new->flags & IRQF_TRIGGER_MASK))
 		new->flags |= irqd_get_trigger_type(&desc->irq_data);
 
+	/*
+	 * Polling needs a thread handler of its own which runs with the line
+	 * masked until the device is idle. Sharing the line would keep the
+	 * other devices masked meanwhile, and nested interrupts have no
+	 * thread of their own which could poll.
+	 */
+	if (new->flags & IRQF_POLL) {
+		if (!new->thread_fn || (new->flags & IRQF_SHARED) ||
+		    irq_settings_is_nested_thread(desc)) {
+			ret = -EINVAL;
+			goto out_mput;
+		}
+		new->flags |= IRQF_ONESHOT;
+	}
+
 	/*
 	 * Check whether the interrupt nests into another interrupt
 	 * thread.
@@ -1577,9 +1639,11 @@ __setup_irq(unsigned int irq, struct irq_desc *desc, struct irqaction *new)
 	 * requires the ONESHOT flag to be set. Some irq chips like
 	 * MSI based interrupts are per se one shot safe. Check the
 	 * chip flags, so we can avoid the unmask dance at the end of
-	 * the threaded handler for those.
+	 * the threaded handler for those. Polling interrupts keep the
+	 * line masked while polling, so they need the unmask dance.
 	 */
-	if (desc->irq_data.chip->flags & IRQCHIP_ONESHOT_SAFE)
+	if ((desc->irq_data.chip->flags & IRQCHIP_ONESHOT_SAFE) &&
+	    !(new->flags & IRQF_POLL))
 		new->flags &= ~IRQF_ONESHOT;
 
 	/*
@@ -2147,6 +2211,7 @@ const void *free_nmi(unsigned int irq, void *dev_id)
  *	IRQF_SHARED		Interrupt is shared
  *	IRQF_TRIGGER_*		Specify active edge(s) or level
  *	IRQF_ONESHOT		Run thread_fn with interrupt line masked
+ *	IRQF_POLL		Poll thread_fn with the line masked until idle
  */
 int request_threaded_irq(unsigned int irq, irq_handler_t handler,
 			 irq_handler_t thread_fn, unsigned long irqflags,
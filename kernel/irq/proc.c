@@ -295,6 +295,16 @@ static int irq_spurious_proc_show(struct seq_file *m, void *v)
 	return 0;
 }
 
+static int irq_poll_proc_show(struct seq_file *m, void *v)
+{
+	struct irqaction *action = m->private;
+
+	seq_printf(m, "wakeups %lu\n" "polls %lu\n",
+		   READ_ONCE(action->poll_wakeups),
+		   READ_ONCE(action->poll_rounds));
+	return 0;
+}
+
 #define MAX_NAMELEN 128
 
 static int name_unique(unsigned int irq, struct irqaction *new_action)
@@ -329,6 +339,11 @@ void register_handler_proc(unsigned int irq, struct irqaction *action)
 
 	/* create /proc/irq/1234/handler/ */
 	action->dir = proc_mkdir(name, desc->dir);
+
+	/* create /proc/irq/1234/handler/poll */
+	if (action->dir && (action->flags & IRQF_POLL))
+		proc_create_single_data("poll", 0444, action->dir,
+					irq_poll_proc_show, action);
 }
 
 #undef MAX_NAMELEN
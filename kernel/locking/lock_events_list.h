@@ -47,6 +47,15 @@ LOCK_EVENT(lock_use_node2)	/* # of locking ops that use 2nd percpu node */
 LOCK_EVENT(lock_use_node3)	/* # of locking ops that use 3rd percpu node */
 LOCK_EVENT(lock_use_node4)	/* # of locking ops that use 4th percpu node */
 LOCK_EVENT(lock_no_node)	/* # of locking ops w/o using percpu node    */
+
+#ifdef CONFIG_NUMA_AWARE_SPINLOCKS
+/*
+ * Locking events for the NUMA-aware (CNA) qspinlock slowpath
+ */
+LOCK_EVENT(lock_cna_splice)	/* # of waiters moved to the secondary queue */
+LOCK_EVENT(lock_cna_local)	/* # of handoffs with the secondary queue    */
+LOCK_EVENT(lock_cna_flush)	/* # of secondary queue flushes		     */
+#endif /* CONFIG_NUMA_AWARE_SPINLOCKS */
 #endif /* CONFIG_QUEUED_SPINLOCKS */
 
 /*
@@ -64,6 +73,9 @@ LOCK_EVENT(rwsem_rlock_steal)	/* # of read locks by lock stealing	*/
 LOCK_EVENT(rwsem_rlock_fast)	/* # of fast read locks acquired	*/
 LOCK_EVENT(rwsem_rlock_fail)	/* # of failed read lock acquisitions	*/
 LOCK_EVENT(rwsem_rlock_handoff)	/* # of read lock handoffs		*/
+LOCK_EVENT(rwsem_rlock_bias)	/* # of per-CPU biased read locks	*/
+LOCK_EVENT(rwsem_bias_on)	/* # of switches to per-CPU reader mode	*/
+LOCK_EVENT(rwsem_bias_off)	/* # of switches back to normal mode	*/
 LOCK_EVENT(rwsem_wlock)		/* # of write locks acquired		*/
 LOCK_EVENT(rwsem_wlock_fail)	/* # of failed write lock acquisitions	*/
 LOCK_EVENT(rwsem_wlock_handoff)	/* # of write lock handoffs		*/
@@ -0,0 +1,256 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _GEN_CNA_LOCK_SLOWPATH
+#error "do not include this file"
+#endif
+
+#include <linux/topology.h>
+
+/*
+ * Implement a NUMA-aware version of MCS (aka CNA, or compact NUMA-aware lock).
+ *
+ * In CNA, spinning threads are organized in two queues, a primary queue for
+ * threads running on the same NUMA node as the current lock holder, and a
+ * secondary queue for threads running on other nodes. Schematically, it
+ * looks like this:
+ *
+ *    cna_node
+ *   +----------+     +--------+         +--------+
+ *   |mcs:next  | --> |mcs:next| --> ... |mcs:next| --> NULL  [Primary queue]
+ *   |mcs:locked| -.  +--------+         +--------+
+ *   +----------+  |
+ *                 `----------------------.
+ *                                        v
+ *                 +--------+         +--------+
+ *                 |mcs:next| --> ... |mcs:next|            [Secondary queue]
+ *                 +--------+         +--------+
+ *                     ^                    |
+ *                     `--------------------'  (sec_tail of the head)
+ *
+ * N.B. locked := 1 if secondary queue is absent. Otherwise, it contains the
+ * encoded tail of the head of the secondary queue, which can never be 1
+ * since the cpu number in it is incremented by one.
+ *
+ * While the queue head waits for the lock holder to go away, it moves the
+ * remote waiters just behind it to the end of the secondary queue, until
+ * it finds a waiter on its own node. When passing on the MCS lock, the
+ * secondary queue is handed along with it as long as there is a local
+ * successor and the number of handoffs within the node since the secondary
+ * queue was formed stays below numa_spinlock_threshold. Otherwise, the
+ * secondary queue is spliced back in front of the primary queue, which
+ * bounds the time remote waiters can be starved.
+ *
+ * The per-CPU qnodes already provide room for the additional fields, as
+ * the CNA slowpath replaces the paravirt one on native hardware only.
+ *
+ * For more details, see https://arxiv.org/abs/1810.05600.
+ */
+
+struct cna_node {
+	struct mcs_spinlock	mcs;
+	u16			numa_node;
+	u32			encoded_tail;	/* self */
+	u32			sec_tail;	/* valid in the secondary head */
+	u32			handoffs;	/* intra-node with a secondary queue */
+};
+
+void __cna_queued_spin_lock_slowpath(struct qspinlock *lock, u32 val);
+
+static bool numa_spinlock __initdata;
+static unsigned int numa_spinlock_threshold __read_mostly = 1U << 8;
+
+/*
+ * The slow path is selected from smp_prepare_boot_cpu(), before __setup()
+ * handlers run, so these have to be early parameters.
+ */
+static int __init numa_spinlock_setup(char *str)
+{
+	if (!str)
+		return -EINVAL;
+	return kstrtobool(str, &numa_spinlock);
+}
+early_param("numa_spinlock", numa_spinlock_setup);
+
+static int __init numa_spinlock_threshold_setup(char *str)
+{
+	if (!str)
+		return -EINVAL;
+	return kstrtouint(str, 0, &numa_spinlock_threshold);
+}
+early_param("numa_spinlock_threshold", numa_spinlock_threshold_setup);
+
+static void __init cna_init_nodes_per_cpu(unsigned int cpu)
+{
+	struct mcs_spinlock *base = per_cpu_ptr(&qnodes[0].mcs, cpu);
+	int i;
+
+	for (i = 0; i < MAX_NODES; i++) {
+		struct cna_node *cn = (struct cna_node *)grab_mcs_node(base, i);
+
+		cn->numa_node = cpu_to_node(cpu);
+		cn->encoded_tail = encode_tail(cpu, i);
+		/*
+		 * make sure @encoded_tail is not confused with other valid
+		 * values for @locked (0 or 1)
+		 */
+		WARN_ON(cn->encoded_tail <= 1);
+	}
+}
+
+static __always_inline void cna_init_node(struct mcs_spinlock *node)
+{
+	((struct cna_node *)node)->handoffs = 0;
+}
+
+/*
+ * Move @next, which sits between @node and @nnext in the primary queue, to
+ * the end of the secondary queue.
+ */
+static void cna_splice_next(struct mcs_spinlock *node,
+			    struct mcs_spinlock *next,
+			    struct mcs_spinlock *nnext)
+{
+	struct cna_node *cn_next = (struct cna_node *)next;
+
+	/* remove @next from the primary queue */
+	WRITE_ONCE(node->next, nnext);
+	next->next = NULL;
+
+	if (node->locked <= 1) {
+		/* @next becomes the secondary queue */
+		cn_next->sec_tail = cn_next->encoded_tail;
+		node->locked = cn_next->encoded_tail;
+	} else {
+		struct cna_node *cn_head = (struct cna_node *)decode_tail(node->locked);
+		struct mcs_spinlock *tail_2nd = decode_tail(cn_head->sec_tail);
+
+		WRITE_ONCE(tail_2nd->next, next);
+		cn_head->sec_tail = cn_next->encoded_tail;
+	}
+	lockevent_inc(lock_cna_splice);
+}
+
+/*
+ * Called by the primary queue head while the lock is still busy. Returns
+ * true once the waiter after @node (if any) runs on the same NUMA node, or
+ * when further reordering is not possible right now.
+ */
+static bool cna_order_queue(struct mcs_spinlock *node)
+{
+	struct cna_node *cn = (struct cna_node *)node;
+	struct mcs_spinlock *next = READ_ONCE(node->next);
+	struct mcs_spinlock *nnext;
+
+	if (!next || ((struct cna_node *)next)->numa_node == cn->numa_node)
+		return true;
+
+	/*
+	 * Never move the primary queue tail, the lock word points to it.
+	 * Keep spinning until somebody queues behind it.
+	 */
+	nnext = READ_ONCE(next->next);
+	if (!nnext)
+		return false;
+
+	cna_splice_next(node, next, nnext);
+	return false;
+}
+
+#define LOCK_IS_BUSY(lock) (atomic_read(&(lock)->val) & _Q_LOCKED_PENDING_MASK)
+
+static __always_inline u32 cna_wait_head_or_lock(struct qspinlock *lock,
+						 struct mcs_spinlock *node)
+{
+	struct cna_node *cn = (struct cna_node *)node;
+
+	/*
+	 * Once the fairness bound is reached, stop moving waiters to the
+	 * secondary queue; it is flushed when the MCS lock is passed on.
+	 */
+	if (cn->handoffs < numa_spinlock_threshold) {
+		while (LOCK_IS_BUSY(lock) && !cna_order_queue(node))
+			cpu_relax();
+	}
+
+	return 0; /* we lied; we didn't wait, go do so now */
+}
+
+/*
+ * The primary queue only has @node. If there is a secondary queue, make it
+ * the primary one and pass the MCS lock to its head.
+ */
+static __always_inline bool cna_try_clear_tail(struct qspinlock *lock,
+					       u32 val,
+					       struct mcs_spinlock *node)
+{
+	struct mcs_spinlock *head_2nd;
+	u32 new;
+
+	if (node->locked <= 1)
+		return __try_clear_tail(lock, val, node);
+
+	head_2nd = decode_tail(node->locked);
+	new = ((struct cna_node *)head_2nd)->sec_tail | _Q_LOCKED_VAL;
+	if (!atomic_try_cmpxchg_relaxed(&lock->val, &val, new))
+		return false;
+
+	((struct cna_node *)head_2nd)->handoffs = 0;
+	arch_mcs_spin_unlock_contended(&head_2nd->locked);
+	lockevent_inc(lock_cna_flush);
+	return true;
+}
+
+static __always_inline void cna_pass_lock(struct mcs_spinlock *node,
+					  struct mcs_spinlock *next)
+{
+	struct cna_node *cn = (struct cna_node *)node;
+	struct cna_node *cn_next = (struct cna_node *)next;
+	u32 val = 1;
+
+	if (node->locked > 1) {
+		if (cn_next->numa_node == cn->numa_node &&
+		    cn->handoffs < numa_spinlock_threshold) {
+			/* hand the secondary queue along */
+			val = node->locked;
+			cn_next->handoffs = cn->handoffs + 1;
+			lockevent_inc(lock_cna_local);
+		} else {
+			/* splice the secondary queue in front of @next */
+			struct cna_node *cn_head = (struct cna_node *)decode_tail(node->locked);
+			struct mcs_spinlock *tail_2nd = decode_tail(cn_head->sec_tail);
+
+			WRITE_ONCE(tail_2nd->next, next);
+			next = &cn_head->mcs;
+			cn_head->handoffs = 0;
+			lockevent_inc(lock_cna_flush);
+		}
+	} else {
+		cn_next->handoffs = 0;
+	}
+
+	smp_store_release(&next->locked, val);
+}
+
+/*
+ * Switch to the NUMA-friendly slow path for spinlocks if asked for with
+ * numa_spinlock=on, we have multiple NUMA nodes and we run on native
+ * hardware, i.e. no paravirt slow path has been installed.
+ */
+void __init cna_configure_spin_lock_slowpath(void)
+{
+	unsigned int cpu;
+
+	BUILD_BUG_ON(sizeof(struct cna_node) > sizeof(struct qnode));
+
+	if (!numa_spinlock || nr_node_ids < 2 ||
+	    pv_ops.lock.queued_spin_lock_slowpath !=
+			native_queued_spin_lock_slowpath)
+		return;
+
+	for_each_possible_cpu(cpu)
+		cna_init_nodes_per_cpu(cpu);
+
+	pv_ops.lock.queued_spin_lock_slowpath = __cna_queued_spin_lock_slowpath;
+
+	pr_info("Enabling CNA spinlock, threshold %u\n",
+		numa_spinlock_threshold);
+}
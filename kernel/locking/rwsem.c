@@ -27,6 +27,9 @@
 #include <linux/export.h>
 #include <linux/rwsem.h>
 #include <linux/atomic.h>
+#include <linux/percpu.h>
+#include <linux/rcuwait.h>
+#include <linux/slab.h>
 #include <trace/events/lock.h>
 
 #ifndef CONFIG_PREEMPT_RT
@@ -327,6 +330,9 @@ void __init_rwsem(struct rw_semaphore *sem, const char *name,
 #ifdef CONFIG_RWSEM_SPIN_ON_OWNER
 	osq_lock_init(&sem->osq);
 #endif
+#ifdef CONFIG_RWSEM_READER_BIAS
+	sem->rbias = NULL;
+#endif
 }
 EXPORT_SYMBOL(__init_rwsem);
 
@@ -1237,6 +1243,222 @@ static struct rw_semaphore *rwsem_downgrade_wake(struct rw_semaphore *sem)
 	return sem;
 }
 
+#ifdef CONFIG_RWSEM_READER_BIAS
+/*
+ * Per-CPU reader mode for read-mostly rwsems.
+ *
+ * Readers of a rwsem which is rarely write locked still bounce the count
+ * cacheline between all CPUs taking it. A rwsem which opted in with
+ * rwsem_enable_reader_bias() switches to per-CPU reader counts once no
+ * writer showed up for RWSEM_BIAS_DELAY, similar to percpu_rw_semaphore.
+ * The first writer to arrive takes the rwsem as usual, which keeps out
+ * new readers using the count, switches the reader mode off and waits for
+ * the per-CPU readers to drain.
+ *
+ * A task holds at most one rwsem in per-CPU reader mode at any time. It
+ * is recorded in current->rwsem_bias, which tells up_read() how the read
+ * lock was taken. As a consequence, rwsems released by another task than
+ * the one which acquired them (up_read_non_owner()) must not opt in.
+ */
+struct rwsem_reader_bias {
+	bool			on;
+	unsigned long		write_ts;	/* jiffies of last up_write() */
+	struct rcuwait		writer;
+	unsigned int __percpu	*readers;
+};
+
+#define RWSEM_BIAS_DELAY	msecs_to_jiffies(10)
+
+static inline bool rwsem_bias_read_trylock(struct rw_semaphore *sem)
+{
+	struct rwsem_reader_bias *rb = READ_ONCE(sem->rbias);
+
+	if (!rb || !READ_ONCE(rb->on) || current->rwsem_bias)
+		return false;
+
+	this_cpu_inc(*rb->readers);
+	smp_mb(); /* A matches D */
+	if (likely(READ_ONCE(rb->on))) {
+		current->rwsem_bias = sem;
+		lockevent_inc(rwsem_rlock_bias);
+		return true;
+	}
+
+	/* A writer is draining the readers, back out and use the count */
+	this_cpu_dec(*rb->readers);
+	rcuwait_wake_up(&rb->writer);
+	return false;
+}
+
+static inline bool rwsem_bias_up_read(struct rw_semaphore *sem)
+{
+	struct rwsem_reader_bias *rb;
+
+	if (current->rwsem_bias != sem)
+		return false;
+
+	rb = sem->rbias;
+	current->rwsem_bias = NULL;
+	smp_mb(); /* B matches C */
+	this_cpu_dec(*rb->readers);
+	rcuwait_wake_up(&rb->writer);
+	return true;
+}
+
+/*
+ * Called with the rwsem read locked through the count, so no writer can
+ * be holding it while the reader mode gets switched on.
+ */
+static inline void rwsem_bias_read_locked(struct rw_semaphore *sem)
+{
+	struct rwsem_reader_bias *rb = READ_ONCE(sem->rbias);
+
+	if (rb && !READ_ONCE(rb->on) &&
+	    time_after(jiffies, READ_ONCE(rb->write_ts) + RWSEM_BIAS_DELAY)) {
+		WRITE_ONCE(rb->on, true);
+		lockevent_inc(rwsem_bias_on);
+	}
+}
+
+static bool rwsem_bias_readers_drained(struct rwsem_reader_bias *rb)
+{
+	unsigned int sum = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		sum += per_cpu(*rb->readers, cpu);
+
+	if (sum)
+		return false;
+
+	smp_mb(); /* C matches B */
+	return true;
+}
+
+/*
+ * Called with the rwsem write locked through the count. Switch the reader
+ * mode off and wait for the per-CPU readers in @state, unless @trylock.
+ * If there are readers left when trying, or the wait is interrupted by a
+ * signal, the reader mode is restored and false is returned; the caller
+ * then has to drop the write lock again.
+ */
+static bool rwsem_bias_write_locked(struct rw_semaphore *sem, bool trylock,
+				    int state)
+{
+	struct rwsem_reader_bias *rb = sem->rbias;
+
+	if (!rb || !READ_ONCE(rb->on))
+		return true;
+
+	WRITE_ONCE(rb->on, false);
+	smp_mb(); /* D matches A */
+
+	if (trylock ? rwsem_bias_readers_drained(rb) :
+	    !rcuwait_wait_event(&rb->writer, rwsem_bias_readers_drained(rb),
+				state)) {
+		lockevent_inc(rwsem_bias_off);
+		return true;
+	}
+
+	/* Still under the write lock, so no other writer saw it off */
+	WRITE_ONCE(rb->on, true);
+	return false;
+}
+
+static inline void rwsem_bias_up_write(struct rw_semaphore *sem)
+{
+	struct rwsem_reader_bias *rb = sem->rbias;
+
+	if (rb && READ_ONCE(rb->write_ts) != jiffies)
+		WRITE_ONCE(rb->write_ts, jiffies);
+}
+
+/**
+ * rwsem_enable_reader_bias - allow a rwsem to use per-CPU reader counts
+ * @sem: the rwsem, not yet used or not held by anyone
+ *
+ * Enabling it again, e.g. from a module loaded anew, is a no-op.
+ *
+ * Return: 0 on success, -ENOMEM if the per-CPU counts can't be allocated.
+ */
+int rwsem_enable_reader_bias(struct rw_semaphore *sem)
+{
+	struct rwsem_reader_bias *rb;
+
+	if (sem->rbias)
+		return 0;
+
+	rb = kzalloc(sizeof(*rb), GFP_KERNEL);
+	if (!rb)
+		return -ENOMEM;
+
+	rb->readers = alloc_percpu(unsigned int);
+	if (!rb->readers) {
+		kfree(rb);
+		return -ENOMEM;
+	}
+	rb->write_ts = jiffies;
+	rcuwait_init(&rb->writer);
+
+	smp_store_release(&sem->rbias, rb);
+	return 0;
+}
+EXPORT_SYMBOL_GPL(rwsem_enable_reader_bias);
+
+/**
+ * rwsem_free_reader_bias - free the per-CPU reader state of a rwsem
+ * @sem: the rwsem, which must not be used by anyone anymore
+ *
+ * Readers look up the per-CPU state without holding anything, so this is
+ * only safe once nobody can take @sem anymore, e.g. before freeing an
+ * object embedding it. Rwsems which stay around must keep their state.
+ */
+void rwsem_free_reader_bias(struct rw_semaphore *sem)
+{
+	struct rwsem_reader_bias *rb = sem->rbias;
+
+	if (!rb)
+		return;
+
+	WARN_ON_ONCE(rwsem_reader_bias_locked(sem));
+	sem->rbias = NULL;
+	free_percpu(rb->readers);
+	kfree(rb);
+}
+EXPORT_SYMBOL_GPL(rwsem_free_reader_bias);
+
+bool rwsem_reader_bias_locked(const struct rw_semaphore *sem)
+{
+	struct rwsem_reader_bias *rb = READ_ONCE(sem->rbias);
+	unsigned int sum = 0;
+	int cpu;
+
+	if (!rb)
+		return false;
+
+	for_each_possible_cpu(cpu)
+		sum += per_cpu(*rb->readers, cpu);
+	return sum;
+}
+EXPORT_SYMBOL_GPL(rwsem_reader_bias_locked);
+#else
+static inline bool rwsem_bias_read_trylock(struct rw_semaphore *sem)
+{
+	return false;
+}
+static inline bool rwsem_bias_up_read(struct rw_semaphore *sem)
+{
+	return false;
+}
+static inline void rwsem_bias_read_locked(struct rw_semaphore *sem) { }
+static inline bool rwsem_bias_write_locked(struct rw_semaphore *sem,
+					   bool trylock, int state)
+{
+	return true;
+}
+static inline void rwsem_bias_up_write(struct rw_semaphore *sem) { }
+#endif /* CONFIG_RWSEM_READER_BIAS */
+
 /*
  * lock for reading
  */
@@ -1245,6 +1467,9 @@ static __always_inline int __down_read_common(struct rw_semaphore *sem, int stat
 	int ret = 0;
 	long count;
 
+	if (rwsem_bias_read_trylock(sem))
+		return 0;
+
 	preempt_disable();
 	if (!rwsem_read_trylock(sem, &count)) {
 		if (IS_ERR(rwsem_down_read_slowpath(sem, count, state))) {
@@ -1253,6 +1478,7 @@ static __always_inline int __down_read_common(struct rw_semaphore *sem, int stat
 		}
 		DEBUG_RWSEMS_WARN_ON(!is_rwsem_reader_owned(sem), sem);
 	}
+	rwsem_bias_read_locked(sem);
 out:
 	preempt_enable();
 	return ret;
@@ -1280,12 +1506,16 @@ static inline int __down_read_trylock(struct rw_semaphore *sem)
 
 	DEBUG_RWSEMS_WARN_ON(sem->magic != sem, sem);
 
+	if (rwsem_bias_read_trylock(sem))
+		return 1;
+
 	preempt_disable();
 	tmp = atomic_long_read(&sem->count);
 	while (!(tmp & RWSEM_READ_FAILED_MASK)) {
 		if (atomic_long_try_cmpxchg_acquire(&sem->count, &tmp,
 						    tmp + RWSEM_READER_BIAS)) {
 			rwsem_set_reader_owned(sem);
+			rwsem_bias_read_locked(sem);
 			ret = 1;
 			break;
 		}
@@ -1294,6 +1524,8 @@ static inline int __down_read_trylock(struct rw_semaphore *sem)
 	return ret;
 }
 
+static inline void __up_write(struct rw_semaphore *sem);
+
 /*
  * lock for writing
  */
@@ -1307,6 +1539,11 @@ static inline int __down_write_common(struct rw_semaphore *sem, int state)
 			ret = -EINTR;
 	}
 	preempt_enable();
+
+	if (!ret && !rwsem_bias_write_locked(sem, false, state)) {
+		__up_write(sem);
+		ret = -EINTR;
+	}
 	return ret;
 }
 
@@ -1329,6 +1566,10 @@ static inline int __down_write_trylock(struct rw_semaphore *sem)
 	ret = rwsem_write_trylock(sem);
 	preempt_enable();
 
+	if (ret && !rwsem_bias_write_locked(sem, true, TASK_RUNNING)) {
+		__up_write(sem);
+		ret = 0;
+	}
 	return ret;
 }
 
@@ -1340,6 +1581,8 @@ static inline void __up_read(struct rw_semaphore *sem)
 	long tmp;
 
 	DEBUG_RWSEMS_WARN_ON(sem->magic != sem, sem);
+	if (rwsem_bias_up_read(sem))
+		return;
 	DEBUG_RWSEMS_WARN_ON(!is_rwsem_reader_owned(sem), sem);
 
 	preempt_disable();
@@ -1369,6 +1612,7 @@ static inline void __up_write(struct rw_semaphore *sem)
 	DEBUG_RWSEMS_WARN_ON((rwsem_owner(sem) != current) &&
 			    !rwsem_test_oflags(sem, RWSEM_NONSPINNABLE), sem);
 
+	rwsem_bias_up_write(sem);
 	preempt_disable();
 	rwsem_clear_owner(sem);
 	tmp = atomic_long_fetch_add_release(-RWSEM_WRITER_LOCKED, &sem->count);
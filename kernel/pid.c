@@ -171,6 +171,7 @@ struct pid *alloc_pid(struct pid_namespace *ns, pid_t *set_tid,
 	int i, nr;
 	struct pid_namespace *tmp;
 	struct upid *upid;
+	bool refilled;
 	int retval = -ENOMEM;
 
 	/*
@@ -191,6 +192,12 @@ struct pid *alloc_pid(struct pid_namespace *ns, pid_t *set_tid,
 	tmp = ns;
 	pid->level = ns->level;
 
+	/*
+	 * Validate the requested PIDs before taking pidmap_lock, so that the
+	 * numbers in all nested namespaces can be allocated and published in
+	 * a single critical section. Forking in deeply nested namespaces used
+	 * to bounce the global lock once per level plus once more.
+	 */
 	for (i = ns->level; i >= 0; i--) {
 		int tid = 0;
 
@@ -212,9 +219,29 @@ struct pid *alloc_pid(struct pid_namespace *ns, pid_t *set_tid,
 			set_tid_size--;
 		}
 
-		idr_preload(GFP_KERNEL);
-		spin_lock_irq(&pidmap_lock);
+		pid->numbers[i].nr = tid;
+		pid->numbers[i].ns = tmp;
+		tmp = tmp->parent;
+	}
+
+	get_pid_ns(ns);
+	refcount_set(&pid->count, 1);
+	spin_lock_init(&pid->lock);
+	for (type = 0; type < PIDTYPE_MAX; ++type)
+		INIT_HLIST_HEAD(&pid->tasks[type]);
 
+	init_waitqueue_head(&pid->wait_pidfd);
+	INIT_HLIST_HEAD(&pid->inodes);
+
+	idr_preload(GFP_KERNEL);
+	spin_lock_irq(&pidmap_lock);
+
+	for (i = ns->level; i >= 0; i--) {
+		int tid = pid->numbers[i].nr;
+
+		tmp = pid->numbers[i].ns;
+		refilled = false;
+retry:
 		if (tid) {
 			nr = idr_alloc(&tmp->idr, NULL, tid,
 				       tid + 1, GFP_ATOMIC);
@@ -240,17 +267,26 @@ struct pid *alloc_pid(struct pid_namespace *ns, pid_t *set_tid,
 			nr = idr_alloc_cyclic(&tmp->idr, NULL, pid_min,
 					      pid_max, GFP_ATOMIC);
 		}
-		spin_unlock_irq(&pidmap_lock);
-		idr_preload_end();
+
+		/*
+		 * The preloaded nodes may have been used up by the outer
+		 * levels; refill them once with GFP_KERNEL and try again.
+		 */
+		if (unlikely(nr == -ENOMEM && !refilled)) {
+			spin_unlock_irq(&pidmap_lock);
+			idr_preload_end();
+			idr_preload(GFP_KERNEL);
+			spin_lock_irq(&pidmap_lock);
+			refilled = true;
+			goto retry;
+		}
 
 		if (nr < 0) {
 			retval = (nr == -ENOSPC) ? -EAGAIN : nr;
-			goto out_free;
+			goto out_unlock;
 		}
 
 		pid->numbers[i].nr = nr;
-		pid->numbers[i].ns = tmp;
-		tmp = tmp->parent;
 	}
 
 	/*
@@ -263,17 +299,7 @@ struct pid *alloc_pid(struct pid_namespace *ns, pid_t *set_tid,
 	 */
 	retval = -ENOMEM;
 
-	get_pid_ns(ns);
-	refcount_set(&pid->count, 1);
-	spin_lock_init(&pid->lock);
-	for (type = 0; type < PIDTYPE_MAX; ++type)
-		INIT_HLIST_HEAD(&pid->tasks[type]);
-
-	init_waitqueue_head(&pid->wait_pidfd);
-	INIT_HLIST_HEAD(&pid->inodes);
-
 	upid = pid->numbers + ns->level;
-	spin_lock_irq(&pidmap_lock);
 	if (!(ns->pid_allocated & PIDNS_ADDING))
 		goto out_unlock;
 	pid->stashed = NULL;
@@ -284,15 +310,11 @@ struct pid *alloc_pid(struct pid_namespace *ns, pid_t *set_tid,
 		upid->ns->pid_allocated++;
 	}
 	spin_unlock_irq(&pidmap_lock);
+	idr_preload_end();
 
 	return pid;
 
 out_unlock:
-	spin_unlock_irq(&pidmap_lock);
-	put_pid_ns(ns);
-
-out_free:
-	spin_lock_irq(&pidmap_lock);
 	while (++i <= ns->level) {
 		upid = pid->numbers + i;
 		idr_remove(&upid->ns->idr, upid->nr);
@@ -303,7 +325,10 @@ struct pid *alloc_pid(struct pid_namespace *ns, pid_t *set_tid,
 		idr_set_cursor(&ns->idr, 0);
 
 	spin_unlock_irq(&pidmap_lock);
+	idr_preload_end();
+	put_pid_ns(ns);
 
+out_free:
 	kmem_cache_free(ns->pid_cachep, pid);
 	return ERR_PTR(retval);
 }
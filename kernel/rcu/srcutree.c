@@ -419,13 +419,18 @@ static void check_init_srcu_struct(struct srcu_struct *ssp)
 /*
  * Returns approximate total of the readers' ->srcu_lock_count[] values
  * for the rank of per-CPU counters specified by idx.
+ *
+ * Only CPUs in ->srcu_reader_cpus can have non-zero counters.  A reader
+ * sets its CPU's bit and executes a full barrier before its first counter
+ * increment there, so finding the bit clear is equivalent to reading that
+ * CPU's counter at that point of the scan, and skipping it is safe.
  */
 static unsigned long srcu_readers_lock_idx(struct srcu_struct *ssp, int idx)
 {
 	int cpu;
 	unsigned long sum = 0;
 
-	for_each_possible_cpu(cpu) {
+	for_each_cpu(cpu, &ssp->srcu_sup->srcu_reader_cpus) {
 		struct srcu_data *cpuc = per_cpu_ptr(ssp->sda, cpu);
 
 		sum += atomic_long_read(&cpuc->srcu_lock_count[idx]);
@@ -443,7 +448,7 @@ static unsigned long srcu_readers_unlock_idx(struct srcu_struct *ssp, int idx)
 	unsigned long mask = 0;
 	unsigned long sum = 0;
 
-	for_each_possible_cpu(cpu) {
+	for_each_cpu(cpu, &ssp->srcu_sup->srcu_reader_cpus) {
 		struct srcu_data *cpuc = per_cpu_ptr(ssp->sda, cpu);
 
 		sum += atomic_long_read(&cpuc->srcu_unlock_count[idx]);
@@ -707,6 +712,26 @@ void srcu_check_nmi_safety(struct srcu_struct *ssp, bool nmi_safe)
 EXPORT_SYMBOL_GPL(srcu_check_nmi_safety);
 #endif /* CONFIG_PROVE_RCU */
 
+/*
+ * Add the current CPU to the set of CPUs that grace periods scan, the first
+ * time a reader touches its counters.  The barrier orders the bit before the
+ * counter increment, see srcu_readers_lock_idx().  Called with preemption
+ * disabled so that the increment lands on the CPU whose bit was set.
+ */
+static void srcu_reader_seen_slow(struct srcu_struct *ssp, struct srcu_data *sdp)
+{
+	cpumask_set_cpu(raw_smp_processor_id(), &ssp->srcu_sup->srcu_reader_cpus);
+	smp_mb__after_atomic();
+	WRITE_ONCE(sdp->srcu_reader_seen, true);
+}
+
+static __always_inline void srcu_reader_note(struct srcu_struct *ssp,
+					     struct srcu_data *sdp)
+{
+	if (unlikely(!READ_ONCE(sdp->srcu_reader_seen)))
+		srcu_reader_seen_slow(ssp, sdp);
+}
+
 /*
  * Counts the new reader in the appropriate per-CPU element of the
  * srcu_struct.
@@ -717,7 +742,10 @@ int __srcu_read_lock(struct srcu_struct *ssp)
 	int idx;
 
 	idx = READ_ONCE(ssp->srcu_idx) & 0x1;
+	preempt_disable_notrace();
+	srcu_reader_note(ssp, this_cpu_ptr(ssp->sda));
 	this_cpu_inc(ssp->sda->srcu_lock_count[idx].counter);
+	preempt_enable_notrace();
 	smp_mb(); /* B */  /* Avoid leaking the critical section. */
 	return idx;
 }
@@ -731,7 +759,10 @@ EXPORT_SYMBOL_GPL(__srcu_read_lock);
 void __srcu_read_unlock(struct srcu_struct *ssp, int idx)
 {
 	smp_mb(); /* C */  /* Avoid leaking the critical section. */
+	preempt_disable_notrace();
+	srcu_reader_note(ssp, this_cpu_ptr(ssp->sda));
 	this_cpu_inc(ssp->sda->srcu_unlock_count[idx].counter);
+	preempt_enable_notrace();
 }
 EXPORT_SYMBOL_GPL(__srcu_read_unlock);
 
@@ -745,10 +776,14 @@ EXPORT_SYMBOL_GPL(__srcu_read_unlock);
 int __srcu_read_lock_nmisafe(struct srcu_struct *ssp)
 {
 	int idx;
-	struct srcu_data *sdp = raw_cpu_ptr(ssp->sda);
+	struct srcu_data *sdp;
 
 	idx = READ_ONCE(ssp->srcu_idx) & 0x1;
+	preempt_disable_notrace();
+	sdp = this_cpu_ptr(ssp->sda);
+	srcu_reader_note(ssp, sdp);
 	atomic_long_inc(&sdp->srcu_lock_count[idx]);
+	preempt_enable_notrace();
 	smp_mb__after_atomic(); /* B */  /* Avoid leaking the critical section. */
 	return idx;
 }
@@ -761,10 +796,14 @@ EXPORT_SYMBOL_GPL(__srcu_read_lock_nmisafe);
  */
 void __srcu_read_unlock_nmisafe(struct srcu_struct *ssp, int idx)
 {
-	struct srcu_data *sdp = raw_cpu_ptr(ssp->sda);
+	struct srcu_data *sdp;
 
 	smp_mb__before_atomic(); /* C */  /* Avoid leaking the critical section. */
+	preempt_disable_notrace();
+	sdp = this_cpu_ptr(ssp->sda);
+	srcu_reader_note(ssp, sdp);
 	atomic_long_inc(&sdp->srcu_unlock_count[idx]);
+	preempt_enable_notrace();
 }
 EXPORT_SYMBOL_GPL(__srcu_read_unlock_nmisafe);
 
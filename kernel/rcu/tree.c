@@ -63,6 +63,7 @@
 #include <linux/vmalloc.h>
 #include <linux/mm.h>
 #include <linux/kasan.h>
+#include <linux/sort.h>
 #include <linux/context_tracking.h>
 #include "../time/tick-internal.h"
 
@@ -3387,6 +3388,35 @@ drain_page_cache(struct kfree_rcu_cpu *krcp)
 	return freed;
 }
 
+/*
+ * Below this many records, sorting costs more than it saves.
+ */
+#define KFREE_BULK_SORT_MIN	16
+
+static int kfree_bulk_cmp(const void *a, const void *b)
+{
+	unsigned long pa = *(unsigned long *)a, pb = *(unsigned long *)b;
+
+	return pa < pb ? -1 : pa > pb;
+}
+
+/*
+ * kfree_bulk() peels off one detached freelist per slab, looking only a few
+ * records ahead for more objects of the same slab. Pointers arrive in call
+ * order, so objects of one slab are scattered throughout the block and most
+ * of them get returned one cmpxchg at a time. Sorting by address makes each
+ * slab's objects, and mostly each cache's slabs, adjacent so that every slab
+ * is handed back to its cache's per-CPU freelist with a single update.
+ */
+static void kfree_bulk_sort(struct kvfree_rcu_bulk_data *bnode)
+{
+	if (bnode->nr_records < KFREE_BULK_SORT_MIN)
+		return;
+
+	sort(bnode->records, bnode->nr_records, sizeof(bnode->records[0]),
+	     kfree_bulk_cmp, NULL);
+}
+
 static void
 kvfree_rcu_bulk(struct kfree_rcu_cpu *krcp,
 	struct kvfree_rcu_bulk_data *bnode, int idx)
@@ -3402,6 +3432,7 @@ kvfree_rcu_bulk(struct kfree_rcu_cpu *krcp,
 				rcu_state.name, bnode->nr_records,
 				bnode->records);
 
+			kfree_bulk_sort(bnode);
 			kfree_bulk(bnode->nr_records, bnode->records);
 		} else { // vmalloc() / vfree().
 			for (i = 0; i < bnode->nr_records; i++) {
@@ -243,6 +243,8 @@ struct rcu_data {
 	u8 nocb_gp_gp;			/* GP to wait for on last scan? */
 	unsigned long nocb_gp_seq;	/*  If so, ->gp_seq to wait for. */
 	unsigned long nocb_gp_loops;	/* # passes through wait code. */
+	long nocb_gp_backlog;		/* Group CBs seen on last scan. */
+	long nocb_gp_backlog_max;	/* Largest ->nocb_gp_backlog. */
 	struct swait_queue_head nocb_gp_wq; /* For nocb kthreads to sleep on. */
 	bool nocb_cb_sleep;		/* Is the nocb CB thread asleep? */
 	struct task_struct *nocb_cb_kthread;
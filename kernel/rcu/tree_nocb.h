@@ -664,6 +664,7 @@ static void nocb_gp_sleep(struct rcu_data *my_rdp, int cpu)
 static void nocb_gp_wait(struct rcu_data *my_rdp)
 {
 	bool bypass = false;
+	long backlog = 0;
 	int __maybe_unused cpu = my_rdp->cpu;
 	unsigned long cur_gp_seq;
 	unsigned long flags;
@@ -728,6 +729,7 @@ static void nocb_gp_wait(struct rcu_data *my_rdp)
 			bypass_ncbs = rcu_cblist_n_cbs(&rdp->nocb_bypass);
 			lazy_ncbs = READ_ONCE(rdp->lazy_len);
 		}
+		backlog += bypass_ncbs + rcu_segcblist_n_cbs(&rdp->cblist);
 
 		if (bypass_ncbs) {
 			trace_rcu_nocb_wake(rcu_state.name, rdp->cpu,
@@ -779,6 +781,9 @@ static void nocb_gp_wait(struct rcu_data *my_rdp)
 	}
 
 	my_rdp->nocb_gp_bypass = bypass;
+	WRITE_ONCE(my_rdp->nocb_gp_backlog, backlog);
+	if (backlog > my_rdp->nocb_gp_backlog_max)
+		WRITE_ONCE(my_rdp->nocb_gp_backlog_max, backlog);
 	my_rdp->nocb_gp_gp = needwait_gp;
 	my_rdp->nocb_gp_seq = needwait_gp ? wait_gp_seq : 0;
 
@@ -1480,21 +1485,32 @@ static void rcu_spawn_cpu_nocb_kthread(int cpu)
 	mutex_unlock(&rcu_state.barrier_mutex);
 }
 
-/* How many CB CPU IDs per GP kthread?  Default of -1 for sqrt(nr_cpu_ids). */
+/* How many CB CPUs per GP kthread?  Default of -1 for sqrt(nr_cpu_ids). */
 static int rcu_nocb_gp_stride = -1;
 module_param(rcu_nocb_gp_stride, int, 0444);
 
+/* Node whose GP kthread group @cpu joins, CPUs of unknown node go first. */
+static int __init rcu_nocb_cpu_node(int cpu)
+{
+	int node = cpu_to_node(cpu);
+
+	if (node == NUMA_NO_NODE || !node_possible(node))
+		node = first_node(node_possible_map);
+	return node;
+}
+
 /*
  * Initialize GP-CB relationships for all no-CBs CPU.
  */
 static void __init rcu_organize_nocb_kthreads(void)
 {
-	int cpu;
+	int cpu, node;
 	bool firsttime = true;
 	bool gotnocbs = false;
 	bool gotnocbscbs = true;
 	int ls = rcu_nocb_gp_stride;
-	int nl = 0;  /* Next GP kthread. */
+	int nl;  /* Index of the node's next GP kthread CPU. */
+	int idx;
 	struct rcu_data *rdp;
 	struct rcu_data *rdp_gp = NULL;  /* Suppress misguided gcc warn. */
 
@@ -1506,36 +1522,45 @@ static void __init rcu_organize_nocb_kthreads(void)
 	}
 
 	/*
-	 * Each pass through this loop sets up one rcu_data structure.
+	 * Each pass through the inner loop sets up one rcu_data structure.
 	 * Should the corresponding CPU come online in the future, then
 	 * we will spawn the needed set of rcu_nocb_kthread() kthreads.
+	 *
+	 * Groups are carved out of each node's CPUs separately, so that a
+	 * GP kthread never has to touch the callback lists of another node.
 	 */
-	for_each_possible_cpu(cpu) {
-		rdp = per_cpu_ptr(&rcu_data, cpu);
-		if (rdp->cpu >= nl) {
-			/* New GP kthread, set up for CBs & next GP. */
-			gotnocbs = true;
-			nl = DIV_ROUND_UP(rdp->cpu + 1, ls) * ls;
-			rdp_gp = rdp;
-			INIT_LIST_HEAD(&rdp->nocb_head_rdp);
-			if (dump_tree) {
-				if (!firsttime)
-					pr_cont("%s\n", gotnocbscbs
-							? "" : " (self only)");
-				gotnocbscbs = false;
-				firsttime = false;
-				pr_alert("%s: No-CB GP kthread CPU %d:",
-					 __func__, cpu);
+	for_each_node(node) {
+		idx = 0;
+		nl = 0;
+		for_each_possible_cpu(cpu) {
+			if (rcu_nocb_cpu_node(cpu) != node)
+				continue;
+			rdp = per_cpu_ptr(&rcu_data, cpu);
+			if (idx++ >= nl) {
+				/* New GP kthread, set up for CBs & next GP. */
+				gotnocbs = true;
+				nl += ls;
+				rdp_gp = rdp;
+				INIT_LIST_HEAD(&rdp->nocb_head_rdp);
+				if (dump_tree) {
+					if (!firsttime)
+						pr_cont("%s\n", gotnocbscbs
+								? "" : " (self only)");
+					gotnocbscbs = false;
+					firsttime = false;
+					pr_alert("%s: No-CB GP kthread CPU %d node %d:",
+						 __func__, cpu, node);
+				}
+			} else {
+				/* Another CB kthread, link to previous GP kthread. */
+				gotnocbscbs = true;
+				if (dump_tree)
+					pr_cont(" %d", cpu);
 			}
-		} else {
-			/* Another CB kthread, link to previous GP kthread. */
-			gotnocbscbs = true;
-			if (dump_tree)
-				pr_cont(" %d", cpu);
+			rdp->nocb_gp_rdp = rdp_gp;
+			if (cpumask_test_cpu(cpu, rcu_nocb_mask))
+				list_add_tail(&rdp->nocb_entry_rdp, &rdp_gp->nocb_head_rdp);
 		}
-		rdp->nocb_gp_rdp = rdp_gp;
-		if (cpumask_test_cpu(cpu, rcu_nocb_mask))
-			list_add_tail(&rdp->nocb_entry_rdp, &rdp_gp->nocb_head_rdp);
 	}
 	if (gotnocbs && dump_tree)
 		pr_cont("%s\n", gotnocbscbs ? "" : " (self only)");
@@ -1573,7 +1598,7 @@ static void show_rcu_nocb_gp_state(struct rcu_data *rdp)
 {
 	struct rcu_node *rnp = rdp->mynode;
 
-	pr_info("nocb GP %d %c%c%c%c%c %c[%c%c] %c%c:%ld rnp %d:%d %lu %c CPU %d%s\n",
+	pr_info("nocb GP %d %c%c%c%c%c %c[%c%c] %c%c:%ld rnp %d:%d %lu %c CPU %d%s backlog %ld/%ld\n",
 		rdp->cpu,
 		"kK"[!!rdp->nocb_gp_kthread],
 		"lL"[raw_spin_is_locked(&rdp->nocb_gp_lock)],
@@ -1589,7 +1614,9 @@ static void show_rcu_nocb_gp_state(struct rcu_data *rdp)
 		rnp->grplo, rnp->grphi, READ_ONCE(rdp->nocb_gp_loops),
 		rdp->nocb_gp_kthread ? task_state_to_char(rdp->nocb_gp_kthread) : '.',
 		rdp->nocb_gp_kthread ? (int)task_cpu(rdp->nocb_gp_kthread) : -1,
-		show_rcu_should_be_on_cpu(rdp->nocb_gp_kthread));
+		show_rcu_should_be_on_cpu(rdp->nocb_gp_kthread),
+		READ_ONCE(rdp->nocb_gp_backlog),
+		READ_ONCE(rdp->nocb_gp_backlog_max));
 }
 
 /* Dump out nocb kthread state for the specified rcu_data structure. */
@@ -245,6 +245,8 @@ void sched_core_enqueue(struct rq *rq, struct task_struct *p)
 		return;
 
 	rb_add(&p->core_node, &rq->core_tree, rb_sched_core_less);
+	if (p->core_cookie == rq->core_find_cookie)
+		rq->core_find_cookie = 0UL;
 }
 
 void sched_core_dequeue(struct rq *rq, struct task_struct *p, int flags)
@@ -254,6 +256,8 @@ void sched_core_dequeue(struct rq *rq, struct task_struct *p, int flags)
 	if (sched_core_enqueued(p)) {
 		rb_erase(&p->core_node, &rq->core_tree);
 		RB_CLEAR_NODE(&p->core_node);
+		if (p->core_cookie == rq->core_find_cookie)
+			rq->core_find_cookie = 0UL;
 	}
 
 	/*
@@ -296,17 +300,29 @@ static struct task_struct *sched_core_next(struct task_struct *p, unsigned long
 /*
  * Find left-most (aka, highest priority) and unthrottled task matching @cookie.
  * If no suitable task is found, NULL will be returned.
+ *
+ * Siblings forced to match the same cookie keep asking for it, so the
+ * left-most task of the last cookie looked up is cached until an enqueue
+ * or dequeue of that cookie changes the tree.
  */
 static struct task_struct *sched_core_find(struct rq *rq, unsigned long cookie)
 {
 	struct task_struct *p;
 	struct rb_node *node;
 
-	node = rb_find_first((void *)cookie, &rq->core_tree, rb_sched_core_cmp);
-	if (!node)
+	if (cookie && cookie == rq->core_find_cookie) {
+		p = rq->core_find_task;
+	} else {
+		node = rb_find_first((void *)cookie, &rq->core_tree,
+				     rb_sched_core_cmp);
+		p = node ? __node_2_sc(node) : NULL;
+		rq->core_find_cookie = cookie;
+		rq->core_find_task = p;
+	}
+
+	if (!p)
 		return NULL;
 
-	p = __node_2_sc(node);
 	if (!sched_task_is_throttled(p, rq->cpu))
 		return p;
 
@@ -4591,6 +4607,10 @@ void set_numabalancing_state(bool enabled)
 }
 
 #ifdef CONFIG_PROC_SYSCTL
+static int sysctl_numa_balancing_max = NUMA_BALANCING_NORMAL |
+				       NUMA_BALANCING_MEMORY_TIERING |
+				       NUMA_BALANCING_SAMPLING;
+
 static void reset_memory_tiering(void)
 {
 	struct pglist_data *pgdat;
@@ -4737,7 +4757,7 @@ static struct ctl_table sched_core_sysctls[] = {
 		.mode		= 0644,
 		.proc_handler	= sysctl_numa_balancing,
 		.extra1		= SYSCTL_ZERO,
-		.extra2		= SYSCTL_FOUR,
+		.extra2		= &sysctl_numa_balancing_max,
 	},
 #endif /* CONFIG_NUMA_BALANCING */
 };
@@ -4782,6 +4802,7 @@ int sched_fork(unsigned long clone_flags, struct task_struct *p)
 
 		p->prio = p->normal_prio = p->static_prio;
 		set_load_weight(p, false);
+		p->sched_latency_sensitive = 0;
 
 		/*
 		 * We don't need the reset flag anymore after the fork. It has
@@ -6103,6 +6124,60 @@ static inline struct task_struct *pick_task(struct rq *rq)
 
 extern void task_vruntime_update(struct rq *rq, struct task_struct *p, bool in_fi);
 
+/*
+ * Charge the forced idle of the selection that ended to the cookie that
+ * caused it. Only a running task of that cookie is known to keep it alive.
+ */
+static void sched_core_charge_budget(struct rq *rq, unsigned long cookie)
+{
+	u64 start = rq->core->core_forceidle_charge;
+	u64 now = rq_clock(rq->core);
+	int i;
+
+	rq->core->core_forceidle_charge = 0;
+	if (!start || !cookie || (s64)(now - start) <= 0)
+		return;
+
+	for_each_cpu(i, cpu_smt_mask(cpu_of(rq))) {
+		if (cpu_rq(i)->curr->core_cookie == cookie) {
+			sched_core_charge_forceidle(cookie, now,
+				(now - start) * rq->core->core_forceidle_count);
+			return;
+		}
+	}
+}
+
+/*
+ * When @max belongs to a cookie out of forced idle budget, let the best
+ * fair pick of another, in-budget, cookie drive the selection instead.
+ * RT and DL picks are never demoted.
+ */
+static struct task_struct *
+sched_core_budget_max(struct rq *rq, struct task_struct *max, bool in_fi)
+{
+	u64 now = rq_clock(rq->core);
+	struct task_struct *p, *alt = NULL;
+	int i;
+
+	if (!READ_ONCE(sysctl_sched_core_forceidle_budget_pct) ||
+	    max->sched_class != &fair_sched_class ||
+	    !sched_core_forceidle_exhausted(max->core_cookie, now))
+		return max;
+
+	for_each_cpu(i, cpu_smt_mask(cpu_of(rq))) {
+		p = cpu_rq(i)->core_pick;
+		if (!p || p->sched_class != &fair_sched_class ||
+		    cookie_equals(p, max->core_cookie) ||
+		    sched_core_forceidle_exhausted(p->core_cookie, now))
+			continue;
+
+		if (!alt || prio_less(alt, p, in_fi))
+			alt = p;
+	}
+
+	return alt ?: max;
+}
+
 static void queue_core_balance(struct rq *rq);
 
 static struct task_struct *
@@ -6112,7 +6187,7 @@ pick_next_task(struct rq *rq, struct task_struct *prev, struct rq_flags *rf)
 	const struct cpumask *smt_mask;
 	bool fi_before = false;
 	bool core_clock_updated = (rq == rq->core);
-	unsigned long cookie;
+	unsigned long cookie, prev_cookie;
 	int i, cpu, occ = 0;
 	struct rq *rq_i;
 	bool need_sync;
@@ -6160,7 +6235,8 @@ pick_next_task(struct rq *rq, struct task_struct *prev, struct rq_flags *rf)
 	put_prev_task_balance(rq, prev, rf);
 
 	smt_mask = cpu_smt_mask(cpu);
-	need_sync = !!rq->core->core_cookie;
+	prev_cookie = rq->core->core_cookie;
+	need_sync = !!prev_cookie;
 
 	/* reset state */
 	rq->core->core_cookie = 0UL;
@@ -6170,6 +6246,7 @@ pick_next_task(struct rq *rq, struct task_struct *prev, struct rq_flags *rf)
 			core_clock_updated = true;
 		}
 		sched_core_account_forceidle(rq);
+		sched_core_charge_budget(rq, prev_cookie);
 		/* reset after accounting force idle */
 		rq->core->core_forceidle_start = 0;
 		rq->core->core_forceidle_count = 0;
@@ -6230,6 +6307,7 @@ pick_next_task(struct rq *rq, struct task_struct *prev, struct rq_flags *rf)
 			max = p;
 	}
 
+	max = sched_core_budget_max(rq, max, fi_before);
 	cookie = rq->core->core_cookie = max->core_cookie;
 
 	/*
@@ -6266,6 +6344,10 @@ pick_next_task(struct rq *rq, struct task_struct *prev, struct rq_flags *rf)
 		rq->core->core_forceidle_occupation = occ;
 	}
 
+	if (READ_ONCE(sysctl_sched_core_forceidle_budget_pct) &&
+	    rq->core->core_forceidle_count && cookie)
+		rq->core->core_forceidle_charge = rq_clock(rq->core);
+
 	rq->core->core_pick_seq = rq->core->core_task_seq;
 	next = rq->core_pick;
 	rq->core_sched_seq = rq->core->core_pick_seq;
@@ -6527,6 +6609,7 @@ static void sched_core_cpu_deactivate(unsigned int cpu)
 	 * have a cookie.
 	 */
 	core_rq->core_forceidle_start = 0;
+	core_rq->core_forceidle_charge = 0;
 
 	/* install new leader */
 	for_each_cpu(t, smt_mask) {
@@ -7694,6 +7777,11 @@ static int user_check_sched_setscheduler(struct task_struct *p,
 	if (p->sched_reset_on_fork && !reset_on_fork)
 		goto req_priv;
 
+	/* The latency-sensitive hint boosts wakeup preemption: */
+	if ((attr->sched_flags & SCHED_FLAG_LATENCY_SENSITIVE) &&
+	    !p->sched_latency_sensitive)
+		goto req_priv;
+
 	return 0;
 
 req_priv:
@@ -7703,6 +7791,21 @@ static int user_check_sched_setscheduler(struct task_struct *p,
 	return 0;
 }
 
+/*
+ * Tasks of a group only get to carry the latency-sensitive hint if the group
+ * is marked latency sensitive itself through cpu.latency_sensitive.
+ */
+static bool sched_latency_sensitive_allowed(struct task_struct *p)
+{
+#ifdef CONFIG_FAIR_GROUP_SCHED
+	struct task_group *tg = task_group(p);
+
+	return tg == &root_task_group || READ_ONCE(tg->latency_sensitive);
+#else
+	return true;
+#endif
+}
+
 static int __sched_setscheduler(struct task_struct *p,
 				const struct sched_attr *attr,
 				bool user, bool pi)
@@ -7712,7 +7815,7 @@ static int __sched_setscheduler(struct task_struct *p,
 	const struct sched_class *prev_class;
 	struct balance_callback *head;
 	struct rq_flags rf;
-	int reset_on_fork;
+	int reset_on_fork, latency_sensitive;
 	int queue_flags = DEQUEUE_SAVE | DEQUEUE_MOVE | DEQUEUE_NOCLOCK;
 	struct rq *rq;
 	bool cpuset_locked = false;
@@ -7723,9 +7826,12 @@ static int __sched_setscheduler(struct task_struct *p,
 	/* Double check policy once rq lock held: */
 	if (policy < 0) {
 		reset_on_fork = p->sched_reset_on_fork;
+		latency_sensitive = p->sched_latency_sensitive;
 		policy = oldpolicy = p->policy;
 	} else {
 		reset_on_fork = !!(attr->sched_flags & SCHED_FLAG_RESET_ON_FORK);
+		latency_sensitive = !!(attr->sched_flags &
+				       SCHED_FLAG_LATENCY_SENSITIVE);
 
 		if (!valid_policy(policy))
 			return -EINVAL;
@@ -7792,6 +7898,12 @@ static int __sched_setscheduler(struct task_struct *p,
 		goto unlock;
 	}
 
+	if (latency_sensitive && !p->sched_latency_sensitive &&
+	    !sched_latency_sensitive_allowed(p)) {
+		retval = -EPERM;
+		goto unlock;
+	}
+
 	/*
 	 * If not changing anything there's no need to proceed further,
 	 * but store a possible modification of reset_on_fork.
@@ -7807,6 +7919,7 @@ static int __sched_setscheduler(struct task_struct *p,
 			goto change;
 
 		p->sched_reset_on_fork = reset_on_fork;
+		p->sched_latency_sensitive = latency_sensitive;
 		retval = 0;
 		goto unlock;
 	}
@@ -7864,6 +7977,7 @@ static int __sched_setscheduler(struct task_struct *p,
 	}
 
 	p->sched_reset_on_fork = reset_on_fork;
+	p->sched_latency_sensitive = latency_sensitive;
 	oldprio = p->prio;
 
 	newprio = __normal_prio(policy, attr->sched_priority, attr->sched_nice);
@@ -8313,6 +8427,8 @@ SYSCALL_DEFINE4(sched_getattr, pid_t, pid, struct sched_attr __user *, uattr,
 		kattr.sched_policy = p->policy;
 		if (p->sched_reset_on_fork)
 			kattr.sched_flags |= SCHED_FLAG_RESET_ON_FORK;
+		if (p->sched_latency_sensitive)
+			kattr.sched_flags |= SCHED_FLAG_LATENCY_SENSITIVE;
 		get_params(p, &kattr);
 		kattr.sched_flags &= SCHED_FLAG_ALL;
 
@@ -10062,6 +10178,9 @@ void __init sched_init(void)
 		rq->core_forceidle_count = 0;
 		rq->core_forceidle_occupation = 0;
 		rq->core_forceidle_start = 0;
+		rq->core_forceidle_charge = 0;
+		rq->core_find_cookie = 0UL;
+		rq->core_find_task = NULL;
 
 		rq->core_cookie = 0UL;
 #endif
@@ -11182,6 +11301,24 @@ static int cpu_idle_write_s64(struct cgroup_subsys_state *css,
 {
 	return sched_group_set_idle(css_tg(css), idle);
 }
+
+static u64 cpu_latency_sensitive_read_u64(struct cgroup_subsys_state *css,
+					  struct cftype *cft)
+{
+	return READ_ONCE(css_tg(css)->latency_sensitive);
+}
+
+static int cpu_latency_sensitive_write_u64(struct cgroup_subsys_state *css,
+					   struct cftype *cft, u64 val)
+{
+	if (css_tg(css) == &root_task_group)
+		return -EINVAL;
+	if (val > 1)
+		return -EINVAL;
+
+	WRITE_ONCE(css_tg(css)->latency_sensitive, val);
+	return 0;
+}
 #endif
 
 static struct cftype cpu_legacy_files[] = {
@@ -11196,6 +11333,11 @@ static struct cftype cpu_legacy_files[] = {
 		.read_s64 = cpu_idle_read_s64,
 		.write_s64 = cpu_idle_write_s64,
 	},
+	{
+		.name = "latency_sensitive",
+		.read_u64 = cpu_latency_sensitive_read_u64,
+		.write_u64 = cpu_latency_sensitive_write_u64,
+	},
 #endif
 #ifdef CONFIG_CFS_BANDWIDTH
 	{
@@ -11435,6 +11577,12 @@ static struct cftype cpu_files[] = {
 		.read_s64 = cpu_idle_read_s64,
 		.write_s64 = cpu_idle_write_s64,
 	},
+	{
+		.name = "latency_sensitive",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = cpu_latency_sensitive_read_u64,
+		.write_u64 = cpu_latency_sensitive_write_u64,
+	},
 #endif
 #ifdef CONFIG_CFS_BANDWIDTH
 	{
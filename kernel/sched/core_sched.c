@@ -3,9 +3,14 @@
 /*
  * A simple wrapper around refcount. An allocated sched_core_cookie's
  * address is used to compute the cookie of the task.
+ *
+ * It also tracks how much forced idle the cookie caused on its siblings
+ * during the current budget window.
  */
 struct sched_core_cookie {
 	refcount_t refcnt;
+	u64 fi_window;
+	atomic64_t fi_time;
 };
 
 static unsigned long sched_core_alloc_cookie(void)
@@ -15,6 +20,8 @@ static unsigned long sched_core_alloc_cookie(void)
 		return 0;
 
 	refcount_set(&ck->refcnt, 1);
+	ck->fi_window = 0;
+	atomic64_set(&ck->fi_time, 0);
 	sched_core_get();
 
 	return (unsigned long)ck;
@@ -234,6 +241,41 @@ int sched_core_share_pid(unsigned int cmd, pid_t pid, enum pid_type type,
 	return err;
 }
 
+/*
+ * Forced idle budget: a cookie that kept siblings forced idle for more than
+ * sysctl_sched_core_forceidle_budget_pct of the current window stops winning
+ * core-wide selection against fair tasks of other cookies until the window
+ * rolls over, see sched_core_budget_max().
+ *
+ * The cookie must be held by a task the caller has locked.
+ */
+unsigned int sysctl_sched_core_forceidle_budget_pct;
+
+#define SCHED_CORE_FI_WINDOW	(100 * NSEC_PER_MSEC)
+
+void sched_core_charge_forceidle(unsigned long cookie, u64 now, u64 delta)
+{
+	struct sched_core_cookie *ck = (void *)cookie;
+	u64 window = READ_ONCE(ck->fi_window);
+
+	if (now - window > SCHED_CORE_FI_WINDOW &&
+	    try_cmpxchg64(&ck->fi_window, &window, now))
+		atomic64_set(&ck->fi_time, 0);
+
+	atomic64_add(delta, &ck->fi_time);
+}
+
+bool sched_core_forceidle_exhausted(unsigned long cookie, u64 now)
+{
+	struct sched_core_cookie *ck = (void *)cookie;
+	unsigned int pct = READ_ONCE(sysctl_sched_core_forceidle_budget_pct);
+
+	if (!pct || !ck || now - READ_ONCE(ck->fi_window) > SCHED_CORE_FI_WINDOW)
+		return false;
+
+	return atomic64_read(&ck->fi_time) > SCHED_CORE_FI_WINDOW / 100 * pct;
+}
+
 #ifdef CONFIG_SCHEDSTATS
 
 /* REQUIRES: rq->core's clock recently updated. */
@@ -13,6 +13,12 @@ struct sugov_tunables {
 	unsigned int		rate_limit_us;
 };
 
+struct sugov_stats {
+	u64			nr_updates;
+	u64			nr_burst;
+	u64			nr_burst_noop;
+};
+
 struct sugov_policy {
 	struct cpufreq_policy	*policy;
 
@@ -35,6 +41,10 @@ struct sugov_policy {
 
 	bool			limits_changed;
 	bool			need_freq_update;
+	bool			burst_early;
+
+	struct sugov_stats	stats;
+	struct dentry		*debugfs;
 };
 
 struct sugov_cpu {
@@ -59,7 +69,8 @@ static DEFINE_PER_CPU(struct sugov_cpu, sugov_cpu);
 
 /************************ Governor internals ***********************/
 
-static bool sugov_should_update_freq(struct sugov_policy *sg_policy, u64 time)
+static bool sugov_should_update_freq(struct sugov_policy *sg_policy, u64 time,
+				     unsigned int flags)
 {
 	s64 delta_ns;
 
@@ -88,8 +99,35 @@ static bool sugov_should_update_freq(struct sugov_policy *sg_policy, u64 time)
 	}
 
 	delta_ns = time - sg_policy->last_freq_update_time;
+	if (delta_ns >= sg_policy->freq_update_delay_ns)
+		return true;
+
+	/*
+	 * A task waking up for a burst of known size may raise, but not
+	 * lower, the frequency ahead of the rate limit.
+	 */
+	if (flags & SCHED_CPUFREQ_BURST) {
+		sg_policy->burst_early = true;
+		return true;
+	}
+
+	return false;
+}
+
+/* Returns true if an update let through for a burst would not raise. */
+static bool sugov_burst_reject(struct sugov_policy *sg_policy, bool raise)
+{
+	if (likely(!sg_policy->burst_early))
+		return false;
 
-	return delta_ns >= sg_policy->freq_update_delay_ns;
+	sg_policy->burst_early = false;
+	if (raise) {
+		sg_policy->stats.nr_burst++;
+		return false;
+	}
+
+	sg_policy->stats.nr_burst_noop++;
+	return true;
 }
 
 static bool sugov_update_next_freq(struct sugov_policy *sg_policy, u64 time,
@@ -102,6 +140,7 @@ static bool sugov_update_next_freq(struct sugov_policy *sg_policy, u64 time,
 
 	sg_policy->next_freq = next_freq;
 	sg_policy->last_freq_update_time = time;
+	sg_policy->stats.nr_updates++;
 
 	return true;
 }
@@ -358,7 +397,7 @@ static inline bool sugov_update_single_common(struct sugov_cpu *sg_cpu,
 
 	ignore_dl_rate_limit(sg_cpu);
 
-	if (!sugov_should_update_freq(sg_cpu->sg_policy, time))
+	if (!sugov_should_update_freq(sg_cpu->sg_policy, time, flags))
 		return false;
 
 	boost = sugov_iowait_apply(sg_cpu, time, max_cap);
@@ -397,6 +436,11 @@ static void sugov_update_single_freq(struct update_util_data *hook, u64 time,
 		sg_policy->cached_raw_freq = cached_freq;
 	}
 
+	if (sugov_burst_reject(sg_policy, next_f > sg_policy->next_freq)) {
+		sg_policy->cached_raw_freq = cached_freq;
+		return;
+	}
+
 	if (!sugov_update_next_freq(sg_policy, time, next_f))
 		return;
 
@@ -446,10 +490,16 @@ static void sugov_update_single_perf(struct update_util_data *hook, u64 time,
 	    sugov_cpu_is_busy(sg_cpu) && sg_cpu->util < prev_util)
 		sg_cpu->util = prev_util;
 
+	if (sugov_burst_reject(sg_cpu->sg_policy, sg_cpu->util > prev_util)) {
+		sg_cpu->util = prev_util;
+		return;
+	}
+
 	cpufreq_driver_adjust_perf(sg_cpu->cpu, sg_cpu->bw_min,
 				   sg_cpu->util, max_cap);
 
 	sg_cpu->sg_policy->last_freq_update_time = time;
+	sg_cpu->sg_policy->stats.nr_updates++;
 }
 
 static unsigned int sugov_next_freq_shared(struct sugov_cpu *sg_cpu, u64 time)
@@ -479,7 +529,7 @@ sugov_update_shared(struct update_util_data *hook, u64 time, unsigned int flags)
 {
 	struct sugov_cpu *sg_cpu = container_of(hook, struct sugov_cpu, update_util);
 	struct sugov_policy *sg_policy = sg_cpu->sg_policy;
-	unsigned int next_f;
+	unsigned int cached_freq, next_f;
 
 	raw_spin_lock(&sg_policy->update_lock);
 
@@ -488,9 +538,15 @@ sugov_update_shared(struct update_util_data *hook, u64 time, unsigned int flags)
 
 	ignore_dl_rate_limit(sg_cpu);
 
-	if (sugov_should_update_freq(sg_policy, time)) {
+	if (sugov_should_update_freq(sg_policy, time, flags)) {
+		cached_freq = sg_policy->cached_raw_freq;
 		next_f = sugov_next_freq_shared(sg_cpu, time);
 
+		if (sugov_burst_reject(sg_policy, next_f > sg_policy->next_freq)) {
+			sg_policy->cached_raw_freq = cached_freq;
+			goto unlock;
+		}
+
 		if (!sugov_update_next_freq(sg_policy, time, next_f))
 			goto unlock;
 
@@ -641,6 +697,41 @@ static void sugov_policy_free(struct sugov_policy *sg_policy)
 	kfree(sg_policy);
 }
 
+/*
+ * /sys/kernel/debug/schedutil/policyN: how often the governor changes the
+ * frequency and the transition latency that costs, and how often a burst
+ * wakeup raised it ahead of the rate limit.
+ */
+static struct dentry *sugov_debugfs_dir;
+
+static int sugov_stats_show(struct seq_file *m, void *v)
+{
+	struct sugov_policy *sg_policy = m->private;
+	struct sugov_stats *stats = &sg_policy->stats;
+	unsigned int latency = sg_policy->policy->cpuinfo.transition_latency;
+
+	seq_printf(m, "updates %llu\n", READ_ONCE(stats->nr_updates));
+	seq_printf(m, "transition_latency_ns %u\n", latency);
+	seq_printf(m, "transition_cost_ns %llu\n",
+		   READ_ONCE(stats->nr_updates) * latency);
+	seq_printf(m, "burst_raise %llu\n", READ_ONCE(stats->nr_burst));
+	seq_printf(m, "burst_noop %llu\n", READ_ONCE(stats->nr_burst_noop));
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(sugov_stats);
+
+static void sugov_debugfs_add(struct sugov_policy *sg_policy)
+{
+	char name[24];
+
+	if (!sugov_debugfs_dir)
+		sugov_debugfs_dir = debugfs_create_dir("schedutil", NULL);
+
+	snprintf(name, sizeof(name), "policy%u", sg_policy->policy->cpu);
+	sg_policy->debugfs = debugfs_create_file(name, 0444, sugov_debugfs_dir,
+						 sg_policy, &sugov_stats_fops);
+}
+
 static int sugov_kthread_create(struct sugov_policy *sg_policy)
 {
 	struct task_struct *thread;
@@ -778,6 +869,7 @@ static int sugov_init(struct cpufreq_policy *policy)
 	sugov_eas_rebuild_sd();
 
 out:
+	sugov_debugfs_add(sg_policy);
 	mutex_unlock(&global_tunables_lock);
 	return 0;
 
@@ -808,6 +900,7 @@ static void sugov_exit(struct cpufreq_policy *policy)
 
 	mutex_lock(&global_tunables_lock);
 
+	debugfs_remove(sg_policy->debugfs);
 	count = gov_attr_set_put(&tunables->attr_set, &sg_policy->tunables_hook);
 	policy->governor_data = NULL;
 	if (!count)
@@ -833,6 +926,7 @@ static int sugov_start(struct cpufreq_policy *policy)
 	sg_policy->next_freq			= 0;
 	sg_policy->work_in_progress		= false;
 	sg_policy->limits_changed		= false;
+	sg_policy->burst_early			= false;
 	sg_policy->cached_raw_freq		= 0;
 
 	sg_policy->need_freq_update = cpufreq_driver_test_flags(CPUFREQ_NEED_UPDATE_LIMITS);
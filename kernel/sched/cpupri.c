@@ -150,7 +150,12 @@ int cpupri_find_fitness(struct cpupri *cp, struct task_struct *p,
 
 	WARN_ON_ONCE(task_pri >= CPUPRI_NR_PRIORITIES);
 
-	for (idx = 0; idx < task_pri; idx++) {
+	/*
+	 * Only visit the priorities that have CPUs in them rather than
+	 * walking all the empty vectors below task_pri. The bitmap can lag
+	 * the vectors the same way vec->count can, see __cpupri_find().
+	 */
+	for_each_set_bit(idx, cp->pri_active, task_pri) {
 
 		if (!__cpupri_find(cp, p, lowest_mask, idx))
 			continue;
@@ -236,7 +241,8 @@ void cpupri_set(struct cpupri *cp, int cpu, int newpri)
 		 * make sure the vector is visible when count is set.
 		 */
 		smp_mb__before_atomic();
-		atomic_inc(&(vec)->count);
+		if (atomic_inc_return(&(vec)->count) == 1)
+			set_bit(newpri, cp->pri_active);
 		do_mb = 1;
 	}
 	if (likely(oldpri != CPUPRI_INVALID)) {
@@ -261,7 +267,18 @@ void cpupri_set(struct cpupri *cp, int cpu, int newpri)
 		 * When removing from the vector, we decrement the counter first
 		 * do a memory barrier and then clear the mask.
 		 */
-		atomic_dec(&(vec)->count);
+		if (!atomic_dec_return(&(vec)->count)) {
+			clear_bit(oldpri, cp->pri_active);
+			/*
+			 * Pairs with the full barrier implied by
+			 * atomic_inc_return() above: if a racing
+			 * cpupri_set() raised the count again, make sure
+			 * its set_bit() is not lost to our clear_bit().
+			 */
+			smp_mb__after_atomic();
+			if (atomic_read(&(vec)->count))
+				set_bit(oldpri, cp->pri_active);
+		}
 		smp_mb__after_atomic();
 		cpumask_clear_cpu(cpu, vec->mask);
 	}
@@ -286,6 +303,7 @@ int cpupri_init(struct cpupri *cp)
 		if (!zalloc_cpumask_var(&vec->mask, GFP_KERNEL))
 			goto cleanup;
 	}
+	bitmap_zero(cp->pri_active, CPUPRI_NR_PRIORITIES);
 
 	cp->cpu_to_pri = kcalloc(nr_cpu_ids, sizeof(int), GFP_KERNEL);
 	if (!cp->cpu_to_pri)
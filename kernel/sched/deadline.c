@@ -177,20 +177,6 @@ static inline bool dl_bw_visited(int cpu, u64 gen)
 	return false;
 }
 
-static inline
-void __dl_update(struct dl_bw *dl_b, s64 bw)
-{
-	struct root_domain *rd = container_of(dl_b, struct root_domain, dl_bw);
-	int i;
-
-	RCU_LOCKDEP_WARN(!rcu_read_lock_sched_held(),
-			 "sched RCU must be held");
-	for_each_cpu_and(i, rd->span, cpu_active_mask) {
-		struct rq *rq = cpu_rq(i);
-
-		rq->dl.extra_bw += bw;
-	}
-}
 #else
 static inline struct dl_bw *dl_bw_of(int i)
 {
@@ -211,28 +197,35 @@ static inline bool dl_bw_visited(int cpu, u64 gen)
 {
 	return false;
 }
+#endif
 
-static inline
-void __dl_update(struct dl_bw *dl_b, s64 bw)
+/*
+ * Allocated bandwidth is tracked per root domain only; GRUB derives each
+ * CPU's unallocated bandwidth from the root domain's per-CPU share rather
+ * than having every admission write to all of the root domain's runqueues.
+ */
+static inline void __dl_update(struct dl_bw *dl_b, int cpus)
 {
-	struct dl_rq *dl = container_of(dl_b, struct dl_rq, dl_bw);
+	WRITE_ONCE(dl_b->cpu_bw, div_u64(dl_b->total_bw, cpus));
+}
 
-	dl->extra_bw += bw;
+static inline u64 dl_extra_bw(struct rq *rq)
+{
+	return rq->dl.max_bw - READ_ONCE(dl_bw_of(cpu_of(rq))->cpu_bw);
 }
-#endif
 
 static inline
 void __dl_sub(struct dl_bw *dl_b, u64 tsk_bw, int cpus)
 {
 	dl_b->total_bw -= tsk_bw;
-	__dl_update(dl_b, (s32)tsk_bw / cpus);
+	__dl_update(dl_b, cpus);
 }
 
 static inline
 void __dl_add(struct dl_bw *dl_b, u64 tsk_bw, int cpus)
 {
 	dl_b->total_bw += tsk_bw;
-	__dl_update(dl_b, -((s32)tsk_bw / cpus));
+	__dl_update(dl_b, cpus);
 }
 
 static inline bool
@@ -521,6 +514,7 @@ void init_dl_bw(struct dl_bw *dl_b)
 	else
 		dl_b->bw = to_ratio(global_rt_period(), global_rt_runtime());
 	dl_b->total_bw = 0;
+	dl_b->cpu_bw = 0;
 }
 
 void init_dl_rq(struct dl_rq *dl_rq)
@@ -1303,6 +1297,7 @@ static u64 grub_reclaim(u64 delta, struct rq *rq, struct sched_dl_entity *dl_se)
 {
 	u64 u_act;
 	u64 u_inact = rq->dl.this_bw - rq->dl.running_bw; /* Utot - Uact */
+	u64 u_extra = dl_extra_bw(rq);
 
 	/*
 	 * Instead of computing max{u, (u_max - u_inact - u_extra)}, we
@@ -1310,10 +1305,10 @@ static u64 grub_reclaim(u64 delta, struct rq *rq, struct sched_dl_entity *dl_se)
 	 * can be larger than u_max. So, u_max - u_inact - u_extra would be
 	 * negative leading to wrong results.
 	 */
-	if (u_inact + rq->dl.extra_bw > rq->dl.max_bw - dl_se->dl_bw)
+	if (u_inact + u_extra > rq->dl.max_bw - dl_se->dl_bw)
 		u_act = dl_se->dl_bw;
 	else
-		u_act = rq->dl.max_bw - u_inact - rq->dl.extra_bw;
+		u_act = rq->dl.max_bw - u_inact - u_extra;
 
 	u_act = (u_act * rq->dl.bw_ratio) >> RATIO_SHIFT;
 	return (delta * u_act) >> BW_SHIFT;
@@ -2670,6 +2665,7 @@ void dl_clear_root_domain(struct root_domain *rd)
 
 	raw_spin_lock_irqsave(&rd->dl_bw.lock, flags);
 	rd->dl_bw.total_bw = 0;
+	rd->dl_bw.cpu_bw = 0;
 	raw_spin_unlock_irqrestore(&rd->dl_bw.lock, flags);
 }
 
@@ -2899,12 +2895,12 @@ static void init_dl_rq_bw_ratio(struct dl_rq *dl_rq)
 {
 	if (global_rt_runtime() == RUNTIME_INF) {
 		dl_rq->bw_ratio = 1 << RATIO_SHIFT;
-		dl_rq->max_bw = dl_rq->extra_bw = 1 << BW_SHIFT;
+		dl_rq->max_bw = 1 << BW_SHIFT;
 	} else {
 		dl_rq->bw_ratio = to_ratio(global_rt_runtime(),
 			  global_rt_period()) >> (BW_SHIFT - RATIO_SHIFT);
-		dl_rq->max_bw = dl_rq->extra_bw =
-			to_ratio(global_rt_period(), global_rt_runtime());
+		dl_rq->max_bw = to_ratio(global_rt_period(),
+					 global_rt_runtime());
 	}
 }
 
@@ -42,7 +42,9 @@
 #include <linux/interrupt.h>
 #include <linux/memory-tiers.h>
 #include <linux/mempolicy.h>
+#include <linux/migrate.h>
 #include <linux/mutex_api.h>
+#include <linux/perf_event.h>
 #include <linux/profile.h>
 #include <linux/psi.h>
 #include <linux/ratelimit.h>
@@ -468,6 +470,13 @@ static int se_is_idle(struct sched_entity *se)
 	return cfs_rq_is_idle(group_cfs_rq(se));
 }
 
+static bool se_latency_sensitive(struct sched_entity *se)
+{
+	if (entity_is_task(se))
+		return task_of(se)->sched_latency_sensitive;
+	return READ_ONCE(group_cfs_rq(se)->tg->latency_sensitive);
+}
+
 #else	/* !CONFIG_FAIR_GROUP_SCHED */
 
 #define for_each_sched_entity(se) \
@@ -514,6 +523,11 @@ static int se_is_idle(struct sched_entity *se)
 	return 0;
 }
 
+static bool se_latency_sensitive(struct sched_entity *se)
+{
+	return task_of(se)->sched_latency_sensitive;
+}
+
 #endif	/* CONFIG_FAIR_GROUP_SCHED */
 
 static __always_inline
@@ -1771,25 +1785,42 @@ static int numa_hint_fault_latency(struct folio *folio)
 	return (time - last_time) & PAGE_ACCESS_TIME_MASK;
 }
 
+static unsigned long node_nr_demoted(struct pglist_data *pgdat)
+{
+	return node_page_state(pgdat, PGDEMOTE_KSWAPD) +
+	       node_page_state(pgdat, PGDEMOTE_DIRECT) +
+	       node_page_state(pgdat, PGDEMOTE_KHUGEPAGED);
+}
+
 /*
  * For memory tiering mode, too high promotion/demotion throughput may
  * hurt application latency.  So we provide a mechanism to rate limit
  * the number of pages that are tried to be promoted.
+ *
+ * Promoting into a full node makes it demote in turn, so pages demoted
+ * from the node during the period are charged to the same budget: the
+ * limit bounds the migration traffic in and out of the node, and
+ * promotion backs off while the node is busy demoting instead of
+ * thrashing pages between the tiers.
  */
 static bool numa_promotion_rate_limit(struct pglist_data *pgdat,
 				      unsigned long rate_limit, int nr)
 {
-	unsigned long nr_cand;
+	unsigned long nr_cand, nr_demoted;
 	unsigned int now, start;
 
 	now = jiffies_to_msecs(jiffies);
 	mod_node_page_state(pgdat, PGPROMOTE_CANDIDATE, nr);
 	nr_cand = node_page_state(pgdat, PGPROMOTE_CANDIDATE);
+	nr_demoted = node_nr_demoted(pgdat);
 	start = pgdat->nbp_rl_start;
 	if (now - start > MSEC_PER_SEC &&
-	    cmpxchg(&pgdat->nbp_rl_start, start, now) == start)
+	    cmpxchg(&pgdat->nbp_rl_start, start, now) == start) {
 		pgdat->nbp_rl_nr_cand = nr_cand;
-	if (nr_cand - pgdat->nbp_rl_nr_cand >= rate_limit)
+		pgdat->nbp_rl_nr_demoted = nr_demoted;
+	}
+	if (nr_cand - pgdat->nbp_rl_nr_cand +
+	    nr_demoted - pgdat->nbp_rl_nr_demoted >= rate_limit)
 		return true;
 	return false;
 }
@@ -3193,6 +3224,220 @@ static bool vma_is_accessed(struct mm_struct *mm, struct vm_area_struct *vma)
 
 #define VMA_PID_RESET_PERIOD (4 * sysctl_numa_balancing_scan_delay)
 
+#ifdef CONFIG_PERF_EVENTS
+/*
+ * Access sampling as an alternative to PTE scanning: a per-task precise
+ * load event records the sampled data addresses from its overflow handler
+ * and task_numa_work() feeds them to task_numa_fault() and the misplaced
+ * folio migration path, without unmapping and refaulting anything.
+ */
+#define NUMA_SAMPLE_NR		256
+#define NUMA_SAMPLE_PERIOD	10007
+
+struct numa_sample_buf {
+	unsigned int		head;	/* overflow handler only */
+	unsigned int		tail;	/* task_numa_work() only */
+	unsigned long		addr[NUMA_SAMPLE_NR];
+};
+
+/*
+ * Fill in a precise event reporting data addresses of user loads, or
+ * return false if the PMU has no such event.
+ */
+bool __weak arch_numa_sample_attr(struct perf_event_attr *attr)
+{
+	return false;
+}
+
+/* Runs from NMI on the CPU the sampled task is running on. */
+static void task_numa_sample_overflow(struct perf_event *event,
+				      struct perf_sample_data *data,
+				      struct pt_regs *regs)
+{
+	struct numa_sample_buf *buf = event->overflow_handler_context;
+	unsigned int head;
+
+	if (!(data->sample_flags & PERF_SAMPLE_ADDR) || !data->addr)
+		return;
+
+	head = READ_ONCE(buf->head);
+	WRITE_ONCE(buf->addr[head % NUMA_SAMPLE_NR], data->addr);
+	barrier();
+	WRITE_ONCE(buf->head, head + 1);
+}
+
+static bool task_numa_sample_start(struct task_struct *p)
+{
+	struct perf_event_attr attr = {
+		.size		= sizeof(attr),
+		.sample_period	= NUMA_SAMPLE_PERIOD,
+		.sample_type	= PERF_SAMPLE_ADDR,
+		.exclude_kernel	= 1,
+		.exclude_hv	= 1,
+	};
+	struct numa_sample_buf *buf;
+	struct perf_event *event;
+
+	if (p->numa_sample_event)
+		return true;
+
+	if (!arch_numa_sample_attr(&attr))
+		return false;
+
+	buf = kzalloc(sizeof(*buf), GFP_KERNEL);
+	if (!buf)
+		return false;
+
+	event = perf_event_create_kernel_counter(&attr, -1, p,
+						 task_numa_sample_overflow, buf);
+	if (IS_ERR(event)) {
+		kfree(buf);
+		return false;
+	}
+
+	p->numa_samples = buf;
+	p->numa_sample_event = event;
+	return true;
+}
+
+static void task_numa_sample_stop(struct task_struct *p)
+{
+	if (!p->numa_sample_event)
+		return;
+
+	perf_event_release_kernel(p->numa_sample_event);
+	p->numa_sample_event = NULL;
+	kfree(p->numa_samples);
+	p->numa_samples = NULL;
+}
+
+/*
+ * Account one sampled access the way do_numa_page() accounts a hinting
+ * fault. Only VMAs following the default policy are handled, which is
+ * what mpol_misplaced() reduces to for them.
+ */
+static void task_numa_sample_one(struct task_struct *p, unsigned long addr)
+{
+	int cpu = raw_smp_processor_id();
+	int last_cpupid, nid, flags = 0;
+	struct vm_area_struct *vma;
+	struct folio *folio;
+	struct page *page;
+
+	vma = vma_lookup(p->mm, addr);
+	if (!vma || !vma_migratable(vma) || !vma_policy_mof(vma) ||
+	    is_vm_hugetlb_page(vma) || (vma->vm_flags & VM_MIXEDMAP) ||
+	    vma->vm_policy || p->mempolicy)
+		return;
+
+	page = follow_page(vma, addr, FOLL_GET);
+	if (IS_ERR_OR_NULL(page))
+		return;
+
+	folio = page_folio(page);
+	if (folio_is_zone_device(folio)) {
+		folio_put(folio);
+		return;
+	}
+
+	/* As in do_numa_page(), avoid grouping on read-only mappings */
+	if (!(vma->vm_flags & VM_WRITE))
+		flags |= TNF_NO_GROUP;
+	if (folio_likely_mapped_shared(folio) && (vma->vm_flags & VM_SHARED))
+		flags |= TNF_SHARED;
+
+	nid = folio_nid(folio);
+	if ((sysctl_numa_balancing_mode & NUMA_BALANCING_MEMORY_TIERING) &&
+	    !node_is_toptier(nid))
+		last_cpupid = (-1 & LAST_CPUPID_MASK);
+	else
+		last_cpupid = folio_last_cpupid(folio);
+
+	if (nid != cpu_to_node(cpu) &&
+	    should_numa_migrate_memory(p, folio, nid, cpu)) {
+		/* Consumes the folio reference */
+		if (migrate_misplaced_folio(folio, vma, cpu_to_node(cpu))) {
+			nid = cpu_to_node(cpu);
+			flags |= TNF_MIGRATED;
+		} else {
+			flags |= TNF_MIGRATE_FAIL;
+		}
+	} else {
+		folio_put(folio);
+	}
+
+	task_numa_fault(last_cpupid, nid, 1, flags);
+}
+
+/*
+ * Drain the samples taken since the last call. Returns false when PTE
+ * scanning should be used instead.
+ */
+static bool task_numa_work_sampled(struct task_struct *p, unsigned long now)
+{
+	struct mm_struct *mm = p->mm;
+	struct numa_sample_buf *buf;
+	unsigned long migrate;
+	unsigned int head, tail;
+
+	if (!(sysctl_numa_balancing_mode & NUMA_BALANCING_SAMPLING)) {
+		task_numa_sample_stop(p);
+		return false;
+	}
+
+	if (!task_numa_sample_start(p))
+		return false;
+
+	if (p->numa_scan_period == 0) {
+		p->numa_scan_period_max = task_scan_max(p);
+		p->numa_scan_period = task_scan_start(p);
+	}
+
+	/*
+	 * There is no scan pass to complete, so advance the scan sequence
+	 * once per scan period instead; that is what triggers placement.
+	 */
+	migrate = mm->numa_next_scan;
+	if (!time_before(now, migrate) &&
+	    try_cmpxchg(&mm->numa_next_scan, &migrate,
+			now + msecs_to_jiffies(p->numa_scan_period)))
+		WRITE_ONCE(mm->numa_scan_seq, READ_ONCE(mm->numa_scan_seq) + 1);
+
+	buf = p->numa_samples;
+	head = READ_ONCE(buf->head);
+	tail = buf->tail;
+	if (head - tail > NUMA_SAMPLE_NR)
+		tail = head - NUMA_SAMPLE_NR;
+	if (tail == head || !mmap_read_trylock(mm))
+		return true;
+
+	for (; tail != head; tail++)
+		task_numa_sample_one(p, READ_ONCE(buf->addr[tail % NUMA_SAMPLE_NR]));
+
+	mmap_read_unlock(mm);
+	buf->tail = tail;
+	return true;
+}
+#else
+static void task_numa_sample_stop(struct task_struct *p)
+{
+}
+
+static bool task_numa_work_sampled(struct task_struct *p, unsigned long now)
+{
+	return false;
+}
+#endif /* CONFIG_PERF_EVENTS */
+
+/*
+ * Called from do_exit() once the task's perf context is gone; the sampling
+ * event pins the task_struct, so it can't wait for task_numa_free().
+ */
+void task_numa_exit(struct task_struct *p)
+{
+	task_numa_sample_stop(p);
+}
+
 /*
  * The expensive part of numa migration is done from task_work context.
  * Triggered from task_tick_numa().
@@ -3230,6 +3475,9 @@ static void task_numa_work(struct callback_head *work)
 			msecs_to_jiffies(sysctl_numa_balancing_scan_delay);
 	}
 
+	if (task_numa_work_sampled(p, now))
+		return;
+
 	/*
 	 * Enforce maximal scan/migration frequency..
 	 */
@@ -3458,6 +3706,10 @@ void init_numa_balancing(unsigned long clone_flags, struct task_struct *p)
 	/* Protect against double add, see task_tick_numa and task_numa_work */
 	p->numa_work.next		= &p->numa_work;
 	p->numa_faults			= NULL;
+#ifdef CONFIG_PERF_EVENTS
+	p->numa_sample_event		= NULL;
+	p->numa_samples			= NULL;
+#endif
 	p->numa_pages_migrated		= 0;
 	p->total_numa_faults		= 0;
 	RCU_INIT_POINTER(p->numa_group, NULL);
@@ -3932,7 +4184,7 @@ static long calc_group_shares(struct cfs_rq *cfs_rq)
 
 	load = max(scale_load_down(cfs_rq->load.weight), cfs_rq->avg.load_avg);
 
-	tg_weight = atomic_long_read(&tg->load_avg);
+	tg_weight = tg_load_avg(tg);
 
 	/* Ensure tg_weight >= load */
 	tg_weight -= cfs_rq->tg_load_avg_contrib;
@@ -4120,7 +4372,7 @@ static inline void update_tg_load_avg(struct cfs_rq *cfs_rq)
 
 	delta = cfs_rq->avg.load_avg - cfs_rq->tg_load_avg_contrib;
 	if (abs(delta) > cfs_rq->tg_load_avg_contrib / 64) {
-		atomic_long_add(delta, &cfs_rq->tg->load_avg);
+		tg_load_avg_add(cfs_rq->tg, cpu_of(rq_of(cfs_rq)), delta);
 		cfs_rq->tg_load_avg_contrib = cfs_rq->avg.load_avg;
 		cfs_rq->last_update_tg_load_avg = now;
 	}
@@ -4139,7 +4391,7 @@ static inline void clear_tg_load_avg(struct cfs_rq *cfs_rq)
 
 	now = sched_clock_cpu(cpu_of(rq_of(cfs_rq)));
 	delta = 0 - cfs_rq->tg_load_avg_contrib;
-	atomic_long_add(delta, &cfs_rq->tg->load_avg);
+	tg_load_avg_add(cfs_rq->tg, cpu_of(rq_of(cfs_rq)), delta);
 	cfs_rq->tg_load_avg_contrib = 0;
 	cfs_rq->last_update_tg_load_avg = now;
 }
@@ -4860,6 +5112,20 @@ static inline void util_est_enqueue(struct cfs_rq *cfs_rq,
 	trace_sched_util_est_cfs_tp(cfs_rq);
 }
 
+/*
+ * A task whose util_est is well above its util_avg decayed over the sleep
+ * is waking up for another burst of a size it has shown before.
+ */
+static inline bool util_est_burst(struct task_struct *p)
+{
+	unsigned long est = _task_util_est(p);
+
+	if (!sched_feat(UTIL_EST) || est < SCHED_CAPACITY_SCALE / 16)
+		return false;
+
+	return est > task_util(p) + (est >> 2);
+}
+
 static inline void util_est_dequeue(struct cfs_rq *cfs_rq,
 				    struct task_struct *p)
 {
@@ -5163,6 +5429,11 @@ static inline int sched_balance_newidle(struct rq *rq, struct rq_flags *rf)
 static inline void
 util_est_enqueue(struct cfs_rq *cfs_rq, struct task_struct *p) {}
 
+static inline bool util_est_burst(struct task_struct *p)
+{
+	return false;
+}
+
 static inline void
 util_est_dequeue(struct cfs_rq *cfs_rq, struct task_struct *p) {}
 
@@ -5268,6 +5539,14 @@ place_entity(struct cfs_rq *cfs_rq, struct sched_entity *se, int flags)
 	if (sched_feat(PLACE_DEADLINE_INITIAL) && (flags & ENQUEUE_INITIAL))
 		vslice /= 2;
 
+	/*
+	 * Latency sensitive entities waking up get a deadline half a slice
+	 * out, so they are picked sooner. Their vruntime, and thus their
+	 * share of CPU time, is unchanged.
+	 */
+	if ((flags & ENQUEUE_WAKEUP) && se_latency_sensitive(se))
+		vslice /= 2;
+
 	/*
 	 * EEVDF: vd_i = ve_i + r_i/w_i
 	 */
@@ -6808,6 +7087,14 @@ enqueue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 	/* At this point se is NULL and we are at root level*/
 	add_nr_running(rq, 1);
 
+	/*
+	 * Let schedutil raise the frequency for a predictable burst at its
+	 * start, rather than once util_avg has caught up with it. This has to
+	 * look at util_avg as decayed over the sleep by the updates above.
+	 */
+	if (!task_new && util_est_burst(p))
+		cpufreq_update_util(rq, SCHED_CPUFREQ_BURST);
+
 	/*
 	 * Since new tasks are assigned an initial util_avg equal to
 	 * half of the spare capacity of their CPU, tiny tasks have the
@@ -7266,6 +7553,96 @@ static inline int __select_idle_cpu(int cpu, struct task_struct *p)
 	return -1;
 }
 
+/*
+ * Flag the CPU in its LLC's idle_cpus mask on idle entry. The bit is only
+ * written when clear so that a CPU bouncing in and out of idle does not
+ * keep dirtying the shared cacheline.
+ */
+void update_idle_cpus(struct rq *rq)
+{
+	struct sched_domain_shared *sds;
+	int cpu = cpu_of(rq);
+
+	if (!sched_feat(SIS_FILTER))
+		return;
+
+	rcu_read_lock();
+	sds = rcu_dereference(per_cpu(sd_llc_shared, cpu));
+	if (sds && !cpumask_test_cpu(cpu, sds_idle_cpus(sds)))
+		cpumask_set_cpu(cpu, sds_idle_cpus(sds));
+	rcu_read_unlock();
+}
+
+/*
+ * Track in the LLC's overload mask whether @rq has more than one runnable
+ * task; called from add/sub_nr_running() when crossing that threshold.
+ */
+void update_overload_cpus(struct rq *rq, bool overloaded)
+{
+	struct sched_domain_shared *sds;
+	int cpu = cpu_of(rq);
+
+	if (!sched_feat(STEAL))
+		return;
+
+	rcu_read_lock();
+	sds = rcu_dereference(per_cpu(sd_llc_shared, cpu));
+	if (sds) {
+		if (overloaded)
+			cpumask_set_cpu(cpu, sds_overload_cpus(sds));
+		else
+			cpumask_clear_cpu(cpu, sds_overload_cpus(sds));
+	}
+	rcu_read_unlock();
+}
+
+static int select_idle_flagged(struct task_struct *p, const struct cpumask *span,
+			       struct cpumask *idle, struct cpumask *cpus,
+			       int target)
+{
+	int cpu;
+
+	for_each_cpu_wrap(cpu, span, target + 1) {
+		if (!cpumask_test_cpu(cpu, idle) || !cpumask_test_cpu(cpu, cpus))
+			continue;
+		if (!available_idle_cpu(cpu)) {
+			cpumask_clear_cpu(cpu, idle);
+			continue;
+		}
+		if (sched_cpu_cookie_match(cpu_rq(cpu), p))
+			return cpu;
+	}
+
+	return -1;
+}
+
+/*
+ * Pick an idle CPU from the LLC's idle_cpus mask, preferring @target's
+ * cluster. This only visits CPUs that went idle, so its cost does not grow
+ * with the LLC size; stale bits are dropped as they are found. A miss falls
+ * back to the regular scan, which also finds SCHED_IDLE-only CPUs.
+ */
+static int select_idle_cpu_filtered(struct task_struct *p, struct sched_domain *sd,
+				    struct sched_domain_shared *sds,
+				    struct cpumask *cpus, int target)
+{
+	struct cpumask *idle = sds_idle_cpus(sds);
+	int cpu;
+
+	if (static_branch_unlikely(&sched_cluster_active)) {
+		struct sched_group *sg = sd->groups;
+
+		if (sg->flags & SD_CLUSTER) {
+			cpu = select_idle_flagged(p, sched_group_span(sg), idle,
+						  cpus, target);
+			if ((unsigned int)cpu < nr_cpumask_bits)
+				return cpu;
+		}
+	}
+
+	return select_idle_flagged(p, idle, idle, cpus, target);
+}
+
 #ifdef CONFIG_SCHED_SMT
 DEFINE_STATIC_KEY_FALSE(sched_smt_present);
 EXPORT_SYMBOL_GPL(sched_smt_present);
@@ -7411,15 +7788,20 @@ static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, bool
 
 	cpumask_and(cpus, sched_domain_span(sd), p->cpus_ptr);
 
-	if (sched_feat(SIS_UTIL)) {
-		sd_share = rcu_dereference(per_cpu(sd_llc_shared, target));
-		if (sd_share) {
-			/* because !--nr is the condition to stop scan */
-			nr = READ_ONCE(sd_share->nr_idle_scan) + 1;
-			/* overloaded LLC is unlikely to have idle cpu/core */
-			if (nr == 1)
-				return -1;
-		}
+	sd_share = rcu_dereference(per_cpu(sd_llc_shared, target));
+
+	if (sched_feat(SIS_UTIL) && sd_share) {
+		/* because !--nr is the condition to stop scan */
+		nr = READ_ONCE(sd_share->nr_idle_scan) + 1;
+		/* overloaded LLC is unlikely to have idle cpu/core */
+		if (nr == 1)
+			return -1;
+	}
+
+	if (sched_feat(SIS_FILTER) && sd_share && !has_idle_core) {
+		i = select_idle_cpu_filtered(p, sd, sd_share, cpus, target);
+		if ((unsigned int)i < nr_cpumask_bits)
+			return i;
 	}
 
 	if (static_branch_unlikely(&sched_cluster_active)) {
@@ -8412,6 +8794,16 @@ static void check_preempt_wakeup_fair(struct rq *rq, struct task_struct *p, int
 	cfs_rq = cfs_rq_of(se);
 	update_curr(cfs_rq);
 
+	/*
+	 * A latency sensitive entity preempts one that is not as soon as it
+	 * is eligible with the earlier deadline, without waiting for the
+	 * current one to run to parity.
+	 */
+	if (se_latency_sensitive(pse) && !se_latency_sensitive(se) &&
+	    entity_eligible(cfs_rq, pse) &&
+	    (s64)(pse->deadline - se->deadline) < 0)
+		goto preempt;
+
 	/*
 	 * XXX pick_eevdf(cfs_rq) != se ?
 	 */
@@ -12338,6 +12730,87 @@ static inline bool nohz_idle_balance(struct rq *this_rq, enum cpu_idle_type idle
 static inline void nohz_newidle_balance(struct rq *this_rq) { }
 #endif /* CONFIG_NO_HZ_COMMON */
 
+/*
+ * Move one fair task from @src_rq to @dst_rq within the LLC domain @sd.
+ * Both runqueues must be unlocked.
+ */
+static bool steal_from(struct rq *dst_rq, struct rq *src_rq,
+		       struct sched_domain *sd)
+{
+	struct lb_env env = {
+		.sd		= sd,
+		.dst_cpu	= cpu_of(dst_rq),
+		.dst_rq		= dst_rq,
+		.src_cpu	= cpu_of(src_rq),
+		.src_rq		= src_rq,
+		.idle		= CPU_NEWLY_IDLE,
+		.flags		= LBF_ALL_PINNED,
+	};
+	struct task_struct *p = NULL;
+	struct rq_flags rf;
+
+	rq_lock(src_rq, &rf);
+	/* Recheck under the lock, the mask is only a hint */
+	if (src_rq->cfs.h_nr_running >= 2) {
+		update_rq_clock(src_rq);
+		p = detach_one_task(&env);
+	}
+	rq_unlock(src_rq, &rf);
+
+	if (!p)
+		return false;
+
+	attach_one_task(dst_rq, p);
+	return true;
+}
+
+/*
+ * Work-conserving fallback for newidle balance: instead of going idle, take a
+ * task straight from an overloaded CPU of the LLC. Unlike sched_balance_rq()
+ * this does not compute group statistics, so it is cheap enough to try even
+ * when avg_idle says a full balance would not pay off.
+ *
+ * Called with @this_rq unlocked; returns whether a task was moved here.
+ */
+static bool sched_steal_task(struct rq *this_rq)
+{
+	int this_cpu = cpu_of(this_rq), cpu;
+	struct sched_domain_shared *sds;
+	struct sched_domain *sd;
+	bool stolen = false;
+
+	if (!sched_feat(STEAL))
+		return false;
+
+	rcu_read_lock();
+	sd = rcu_dereference(per_cpu(sd_llc, this_cpu));
+	sds = rcu_dereference(per_cpu(sd_llc_shared, this_cpu));
+	if (!sd || !sds)
+		goto unlock;
+
+	for_each_cpu_wrap(cpu, sds_overload_cpus(sds), this_cpu + 1) {
+		if (cpu == this_cpu)
+			continue;
+		if (steal_from(this_rq, cpu_rq(cpu), sd)) {
+			stolen = true;
+			break;
+		}
+		/* Stop if work showed up here meanwhile */
+		if (READ_ONCE(this_rq->ttwu_pending) ||
+		    READ_ONCE(this_rq->nr_running))
+			break;
+	}
+unlock:
+	rcu_read_unlock();
+
+	if (stolen)
+		schedstat_inc(this_rq->steal_count);
+	else
+		schedstat_inc(this_rq->steal_fail);
+
+	return stolen;
+}
+
 /*
  * sched_balance_newidle is called by schedule() if this_cpu is about to become
  * idle. Attempts to pull tasks from other CPUs.
@@ -12396,6 +12869,13 @@ static int sched_balance_newidle(struct rq *this_rq, struct rq_flags *rf)
 			update_next_balance(sd, &next_balance);
 		rcu_read_unlock();
 
+		if (get_rd_overloaded(this_rq->rd)) {
+			raw_spin_rq_unlock(this_rq);
+			pulled_task = sched_steal_task(this_rq);
+			raw_spin_rq_lock(this_rq);
+			goto recheck;
+		}
+
 		goto out;
 	}
 	rcu_read_unlock();
@@ -12437,11 +12917,15 @@ static int sched_balance_newidle(struct rq *this_rq, struct rq_flags *rf)
 	}
 	rcu_read_unlock();
 
+	if (!pulled_task && !this_rq->nr_running)
+		pulled_task = sched_steal_task(this_rq);
+
 	raw_spin_rq_lock(this_rq);
 
 	if (curr_cost > this_rq->max_idle_balance_cost)
 		this_rq->max_idle_balance_cost = curr_cost;
 
+recheck:
 	/*
 	 * While browsing the domains, we released the rq lock, a task could
 	 * have been enqueued in the meantime. Since we're not going idle,
@@ -12914,6 +13398,9 @@ void free_fair_sched_group(struct task_group *tg)
 
 	kfree(tg->cfs_rq);
 	kfree(tg->se);
+#ifdef CONFIG_SMP
+	kfree(tg->node_load);
+#endif
 }
 
 int alloc_fair_sched_group(struct task_group *tg, struct task_group *parent)
@@ -12928,6 +13415,12 @@ int alloc_fair_sched_group(struct task_group *tg, struct task_group *parent)
 	tg->se = kcalloc(nr_cpu_ids, sizeof(se), GFP_KERNEL);
 	if (!tg->se)
 		goto err;
+#ifdef CONFIG_SMP
+	tg->node_load = kcalloc(nr_node_ids, sizeof(*tg->node_load),
+				GFP_KERNEL);
+	if (!tg->node_load)
+		goto err;
+#endif
 
 	tg->shares = NICE_0_LOAD;
 
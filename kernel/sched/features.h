@@ -50,6 +50,17 @@ SCHED_FEAT(TTWU_QUEUE, true)
  * When doing wakeups, attempt to limit superfluous scans of the LLC domain.
  */
 SCHED_FEAT(SIS_UTIL, true)
+/*
+ * Look for an idle CPU among those flagged in the LLC's idle_cpus mask
+ * before scanning the LLC.
+ */
+SCHED_FEAT(SIS_FILTER, true)
+
+/*
+ * When newidle balance finds nothing to pull, take a task directly from an
+ * overloaded CPU of the LLC.
+ */
+SCHED_FEAT(STEAL, true)
 
 /*
  * Issue a WARN when we do multiple update_rq_clock() calls
@@ -87,3 +98,9 @@ SCHED_FEAT(UTIL_EST, true)
 SCHED_FEAT(LATENCY_WARN, false)
 
 SCHED_FEAT(HZ_BW, true)
+
+/*
+ * Hand out the free mm_cid last used on the current node before the lowest
+ * free one, so that per-cid data placed on a node stays node local.
+ */
+SCHED_FEAT(MM_CID_NODE_LOCAL, false)
@@ -153,6 +153,16 @@ static int __init setup_psi(char *str)
 }
 __setup("psi=", setup_psi);
 
+#ifdef CONFIG_CGROUPS
+unsigned int psi_cgroup_depth __read_mostly;
+
+static int __init setup_psi_cgroup_depth(char *str)
+{
+	return kstrtouint(str, 0, &psi_cgroup_depth) == 0;
+}
+__setup("psi_cgroup_depth=", setup_psi_cgroup_depth);
+#endif
+
 /* Running averages - we need to be higher-res than loadavg */
 #define PSI_FREQ	(2*HZ+1)	/* 2 sec intervals */
 #define EXP_10s		1677		/* 1/exp(2s/10s) as fixed-point */
@@ -1105,6 +1115,15 @@ int psi_cgroup_alloc(struct cgroup *cgroup)
 	if (!static_branch_likely(&psi_cgroups_enabled))
 		return 0;
 
+	/*
+	 * Every task state change walks all psi groups up to the root, so
+	 * deep hierarchies can opt out of accounting below a given level.
+	 */
+	if (cgroup_psi_shared(cgroup)) {
+		cgroup->psi = cgroup_psi(cgroup_parent(cgroup));
+		return 0;
+	}
+
 	cgroup->psi = kzalloc(sizeof(struct psi_group), GFP_KERNEL);
 	if (!cgroup->psi)
 		return -ENOMEM;
@@ -1124,6 +1143,9 @@ void psi_cgroup_free(struct cgroup *cgroup)
 	if (!static_branch_likely(&psi_cgroups_enabled))
 		return;
 
+	if (cgroup_psi_shared(cgroup))
+		return;
+
 	cancel_delayed_work_sync(&cgroup->psi->avgs_work);
 	free_percpu(cgroup->psi->pcpu);
 	/* All triggers must be removed by now */
@@ -2296,6 +2296,29 @@ void rto_push_irq_work_func(struct irq_work *work)
 }
 #endif /* HAVE_RT_PUSH_IPI */
 
+#ifdef HAVE_RT_PUSH_IPI
+/*
+ * The push IPI chain visits every overloaded CPU in the root domain. Only
+ * start it when some overloaded CPU has a pushable task that would preempt
+ * us; the same racy check the direct pull below does before taking locks.
+ */
+static bool rt_pull_has_candidate(struct rq *this_rq)
+{
+	int cpu;
+
+	for_each_cpu(cpu, this_rq->rd->rto_mask) {
+		if (cpu == this_rq->cpu)
+			continue;
+
+		if (READ_ONCE(cpu_rq(cpu)->rt.highest_prio.next) <
+		    this_rq->rt.highest_prio.curr)
+			return true;
+	}
+
+	return false;
+}
+#endif
+
 static void pull_rt_task(struct rq *this_rq)
 {
 	int this_cpu = this_rq->cpu, cpu;
@@ -2320,7 +2343,8 @@ static void pull_rt_task(struct rq *this_rq)
 
 #ifdef HAVE_RT_PUSH_IPI
 	if (sched_feat(RT_PUSH_IPI)) {
-		tell_cpu_to_push(this_rq);
+		if (rt_pull_has_candidate(this_rq))
+			tell_cpu_to_push(this_rq);
 		return;
 	}
 #endif
@@ -316,6 +316,8 @@ struct dl_bw {
 	raw_spinlock_t		lock;
 	u64			bw;
 	u64			total_bw;
+	/* total_bw / CPUs, read locklessly by GRUB reclaim */
+	u64			cpu_bw;
 };
 
 extern void init_dl_bw(struct dl_bw *dl_b);
@@ -389,6 +391,12 @@ struct cfs_bandwidth {
 #endif
 };
 
+#if defined(CONFIG_FAIR_GROUP_SCHED) && defined(CONFIG_SMP)
+struct tg_node_load {
+	atomic_long_t		load_avg;
+} ____cacheline_aligned_in_smp;
+#endif
+
 /* Task group related information */
 struct task_group {
 	struct cgroup_subsys_state css;
@@ -403,13 +411,16 @@ struct task_group {
 	/* A positive value indicates that this is a SCHED_IDLE group. */
 	int			idle;
 
+	/* Entities of this group get the latency-sensitive treatment */
+	int			latency_sensitive;
+
 #ifdef	CONFIG_SMP
 	/*
-	 * load_avg can be heavily contended at clock tick time, so put
-	 * it in its own cacheline separated from the fields above which
-	 * will also be accessed at each tick.
+	 * load_avg can be heavily contended at clock tick time, so it is
+	 * split per node, each on its own cacheline, and CPUs only write
+	 * their node's share; see tg_load_avg().
 	 */
-	atomic_long_t		load_avg ____cacheline_aligned;
+	struct tg_node_load	*node_load;
 #endif
 #endif
 
@@ -444,6 +455,28 @@ struct task_group {
 
 };
 
+#if defined(CONFIG_FAIR_GROUP_SCHED) && defined(CONFIG_SMP)
+/* Sum of the cfs_rq load contributions of @tg over all nodes */
+static inline long tg_load_avg(struct task_group *tg)
+{
+	long load_avg = 0;
+	int nid;
+
+	if (!tg->node_load)
+		return 0;
+
+	for_each_node(nid)
+		load_avg += atomic_long_read(&tg->node_load[nid].load_avg);
+
+	return load_avg;
+}
+
+static inline void tg_load_avg_add(struct task_group *tg, int cpu, long delta)
+{
+	atomic_long_add(delta, &tg->node_load[cpu_to_node(cpu)].load_avg);
+}
+#endif
+
 #ifdef CONFIG_FAIR_GROUP_SCHED
 #define ROOT_TASK_GROUP_LOAD	NICE_0_LOAD
 
@@ -787,11 +820,12 @@ struct dl_rq {
 	 * runqueue (inactive utilization = this_bw - running_bw).
 	 */
 	u64			this_bw;
-	u64			extra_bw;
 
 	/*
 	 * Maximum available bandwidth for reclaiming by SCHED_FLAG_RECLAIM
 	 * tasks of this rq. Used in calculation of reclaimable bandwidth(GRUB).
+	 * The extra (unallocated) bandwidth is max_bw minus the per-CPU share
+	 * of the root domain's allocated bandwidth, see dl_extra_bw().
 	 */
 	u64			max_bw;
 
@@ -1163,6 +1197,10 @@ struct rq {
 	/* try_to_wake_up() stats */
 	unsigned int		ttwu_count;
 	unsigned int		ttwu_local;
+
+	/* newidle task stealing stats */
+	unsigned int		steal_count;
+	unsigned int		steal_fail;
 #endif
 
 #ifdef CONFIG_CPU_IDLE
@@ -1183,6 +1221,9 @@ struct rq {
 	unsigned int		core_enabled;
 	unsigned int		core_sched_seq;
 	struct rb_root		core_tree;
+	/* last sched_core_find() lookup, reset when core_tree changes */
+	unsigned long		core_find_cookie;
+	struct task_struct	*core_find_task;
 
 	/* shared state -- careful with sched_core_cpu_deactivate() */
 	unsigned int		core_task_seq;
@@ -1192,6 +1233,7 @@ struct rq {
 	unsigned int		core_forceidle_seq;
 	unsigned int		core_forceidle_occupation;
 	u64			core_forceidle_start;
+	u64			core_forceidle_charge;
 #endif
 
 	/* Scratch cpumask to be temporarily used under rq_lock */
@@ -1353,6 +1395,10 @@ extern void sched_core_dequeue(struct rq *rq, struct task_struct *p, int flags);
 extern void sched_core_get(void);
 extern void sched_core_put(void);
 
+extern unsigned int sysctl_sched_core_forceidle_budget_pct;
+extern void sched_core_charge_forceidle(unsigned long cookie, u64 now, u64 delta);
+extern bool sched_core_forceidle_exhausted(unsigned long cookie, u64 now);
+
 #else /* !CONFIG_SCHED_CORE */
 
 static inline bool sched_core_enabled(struct rq *rq)
@@ -1451,6 +1497,13 @@ static inline void update_idle_core(struct rq *rq)
 static inline void update_idle_core(struct rq *rq) { }
 #endif
 
+#ifdef CONFIG_SMP
+extern void update_idle_cpus(struct rq *rq);
+extern void update_overload_cpus(struct rq *rq, bool overloaded);
+#else
+static inline void update_idle_cpus(struct rq *rq) { }
+#endif
+
 #ifdef CONFIG_FAIR_GROUP_SCHED
 static inline struct task_struct *task_of(struct sched_entity *se)
 {
@@ -2521,8 +2574,10 @@ static inline void add_nr_running(struct rq *rq, unsigned count)
 	}
 
 #ifdef CONFIG_SMP
-	if (prev_nr < 2 && rq->nr_running >= 2)
+	if (prev_nr < 2 && rq->nr_running >= 2) {
 		set_rd_overloaded(rq->rd, 1);
+		update_overload_cpus(rq, true);
+	}
 #endif
 
 	sched_update_tick_dependency(rq);
@@ -2530,11 +2585,18 @@ static inline void add_nr_running(struct rq *rq, unsigned count)
 
 static inline void sub_nr_running(struct rq *rq, unsigned count)
 {
-	rq->nr_running -= count;
+	unsigned prev_nr = rq->nr_running;
+
+	rq->nr_running = prev_nr - count;
 	if (trace_sched_update_nr_running_tp_enabled()) {
 		call_trace_sched_update_nr_running(rq, -count);
 	}
 
+#ifdef CONFIG_SMP
+	if (prev_nr >= 2 && rq->nr_running < 2)
+		update_overload_cpus(rq, false);
+#endif
+
 	/* Check if we still need preemption */
 	sched_update_tick_dependency(rq);
 }
@@ -3311,12 +3373,26 @@ static inline void mm_cid_put(struct mm_struct *mm)
 	__mm_cid_put(mm, mm_cid_clear_lazy_put(cid));
 }
 
-static inline int __mm_cid_try_get(struct mm_struct *mm)
+static inline int __mm_cid_try_get(struct rq *rq, struct mm_struct *mm)
 {
-	struct cpumask *cpumask;
-	int cid;
+	int node = cpu_to_node(cpu_of(rq));
+	struct cpumask *cpumask, *node_mask;
+	int cid, i;
 
 	cpumask = mm_cidmask(mm);
+	node_mask = mm_node_cidmask(mm, node);
+
+	/*
+	 * Prefer a free cid that was last used on this node. That cid need
+	 * not be the lowest free one, so this is opt-in: users that size
+	 * per-cid data by the lowest-free bound want compact ids instead.
+	 */
+	if (sched_feat(MM_CID_NODE_LOCAL)) {
+		cid = cpumask_nth_andnot(0, node_mask, cpumask);
+		if (cid < nr_cpu_ids && !cpumask_test_and_set_cpu(cid, cpumask))
+			return cid;
+	}
+
 	/*
 	 * Retry finding first zero bit if the mask is temporarily
 	 * filled. This only happens during concurrent remote-clear
@@ -3330,6 +3406,16 @@ static inline int __mm_cid_try_get(struct mm_struct *mm)
 	}
 	if (cpumask_test_and_set_cpu(cid, cpumask))
 		return -1;
+
+	if (!sched_feat(MM_CID_NODE_LOCAL))
+		return cid;
+
+	/* The cid moves to this node. */
+	for (i = 0; i < nr_node_ids; i++) {
+		if (i != node)
+			cpumask_clear_cpu(cid, mm_node_cidmask(mm, i));
+	}
+	cpumask_set_cpu(cid, node_mask);
 	return cid;
 }
 
@@ -3355,13 +3441,13 @@ static inline int __mm_cid_get(struct rq *rq, struct mm_struct *mm)
 	 * guarantee forward progress.
 	 */
 	if (!READ_ONCE(use_cid_lock)) {
-		cid = __mm_cid_try_get(mm);
+		cid = __mm_cid_try_get(rq, mm);
 		if (cid >= 0)
 			goto end;
 		raw_spin_lock(&cid_lock);
 	} else {
 		raw_spin_lock(&cid_lock);
-		cid = __mm_cid_try_get(mm);
+		cid = __mm_cid_try_get(rq, mm);
 		if (cid >= 0)
 			goto unlock;
 	}
@@ -3381,7 +3467,7 @@ static inline int __mm_cid_get(struct rq *rq, struct mm_struct *mm)
 	 * all newcoming allocations observe the use_cid_lock flag set.
 	 */
 	do {
-		cid = __mm_cid_try_get(mm);
+		cid = __mm_cid_try_get(rq, mm);
 		cpu_relax();
 	} while (cid < 0);
 	/*
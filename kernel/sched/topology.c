@@ -2248,8 +2248,8 @@ static int __sdt_alloc(const struct cpumask *cpu_map)
 
 			*per_cpu_ptr(sdd->sd, j) = sd;
 
-			sds = kzalloc_node(sizeof(struct sched_domain_shared),
-					GFP_KERNEL, cpu_to_node(j));
+			sds = kzalloc_node(sizeof(struct sched_domain_shared) +
+					2 * cpumask_size(), GFP_KERNEL, cpu_to_node(j));
 			if (!sds)
 				return -ENOMEM;
 
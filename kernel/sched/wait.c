@@ -57,6 +57,41 @@ void remove_wait_queue(struct wait_queue_head *wq_head, struct wait_queue_entry
 }
 EXPORT_SYMBOL(remove_wait_queue);
 
+/*
+ * How many exclusive waiters a wake-one scans for one that last ran in the
+ * waker's LLC. Bounds the time spent under wq_head->lock on long queues.
+ */
+#define WAKE_AFFINE_SCAN	8
+
+/*
+ * Exclusive waiters tagged WQ_FLAG_AFFINE have a task in ->private and don't
+ * care which of them consumes the event (epoll_wait(), accept()). Rather than
+ * waking the oldest, which may be sleeping on a remote node while a waiter
+ * sharing the waker's cache sits right behind it, pick the first of the next
+ * few such waiters whose last CPU shares cache with the current one.
+ */
+static wait_queue_entry_t *wake_affine_pick(struct wait_queue_head *wq_head,
+					    wait_queue_entry_t *curr)
+{
+	int this_cpu = smp_processor_id();
+	int budget = WAKE_AFFINE_SCAN;
+	wait_queue_entry_t *pos = curr;
+
+	list_for_each_entry_from(pos, &wq_head->head, entry) {
+		struct task_struct *p = pos->private;
+
+		if ((pos->flags & (WQ_FLAG_EXCLUSIVE | WQ_FLAG_AFFINE)) !=
+		    (WQ_FLAG_EXCLUSIVE | WQ_FLAG_AFFINE))
+			break;
+		if (cpus_share_cache(this_cpu, task_cpu(p)))
+			return pos;
+		if (!--budget)
+			break;
+	}
+
+	return curr;
+}
+
 /*
  * The core wakeup function. Non-exclusive wakeups (nr_exclusive == 0) just
  * wake everything up. If it's an exclusive wakeup (nr_exclusive == small +ve
@@ -64,7 +99,8 @@ EXPORT_SYMBOL(remove_wait_queue);
  * the non-exclusive tasks. Normally, exclusive tasks will be at the end of
  * the list and any non-exclusive tasks will be woken first. A priority task
  * may be at the head of the list, and can consume the event without any other
- * tasks being woken.
+ * tasks being woken. A wake-one may skip ahead to a cache-local waiter among
+ * the WQ_FLAG_AFFINE ones, see wake_affine_pick().
  *
  * There are circumstances in which we can try to wake a task which has already
  * started to run but is not in state TASK_RUNNING. try_to_wake_up() returns
@@ -86,6 +122,25 @@ static int __wake_up_common(struct wait_queue_head *wq_head, unsigned int mode,
 		unsigned flags = curr->flags;
 		int ret;
 
+		if (nr_exclusive == 1 && (flags & WQ_FLAG_AFFINE) &&
+		    (flags & WQ_FLAG_EXCLUSIVE)) {
+			wait_queue_entry_t *pick = wake_affine_pick(wq_head, curr);
+
+			/*
+			 * An unsuccessful wakeup leaves @pick queued, so @next
+			 * is still valid and we fall back to FIFO order.
+			 */
+			if (pick != curr) {
+				ret = pick->func(pick, mode, wake_flags, key);
+				if (ret < 0)
+					break;
+				if (ret) {
+					nr_exclusive--;
+					break;
+				}
+			}
+		}
+
 		ret = curr->func(curr, mode, wake_flags, key);
 		if (ret < 0)
 			break;
@@ -552,6 +552,7 @@ static void handle_softirqs(bool ksirqd)
 
 		trace_softirq_entry(vec_nr);
 		h->action(h);
+		hrtimer_flush_deferred_reprogram();
 		trace_softirq_exit(vec_nr);
 		if (unlikely(prev_count != preempt_count())) {
 			pr_err("huh, entered softirq %u %s %p with preempt_count %08x, exited with %08x?\n",
@@ -86,6 +86,7 @@ COND_SYSCALL(get_robust_list);
 COND_SYSCALL_COMPAT(get_robust_list);
 COND_SYSCALL(futex_waitv);
 COND_SYSCALL(futex_wake);
+COND_SYSCALL(futex_wakev);
 COND_SYSCALL(futex_wait);
 COND_SYSCALL(futex_requeue);
 COND_SYSCALL(kexec_load);
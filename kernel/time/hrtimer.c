@@ -673,12 +673,74 @@ static void __hrtimer_reprogram(struct hrtimer_cpu_base *cpu_base,
 	 * set. So we'd effectively block all timers until the T2 event
 	 * fires.
 	 */
+	cpu_base->deferred_reprogram = false;
+
 	if (!hrtimer_hres_active(cpu_base) || cpu_base->hang_detected)
 		return;
 
 	tick_program_event(expires_next, 1);
 }
 
+/*
+ * Only timers at least this far out are deferred. The device is programmed
+ * once the softirq handler which armed them returns, so a deferred timer
+ * is only late if that handler runs longer than this after arming it.
+ * NET_RX, the main source of such bursts, limits itself to
+ * netdev_budget_usecs (2ms by default).
+ */
+#define HRTIMER_DEFER_MIN_NS	(2 * NSEC_PER_MSEC)
+
+/*
+ * Softirq handlers like the network stack or block completions arm timers in
+ * bursts, each one earlier than the last programmed event, and each one would
+ * reprogram the clock event device. Only record the new first expiry then and
+ * program the device once from hrtimer_flush_deferred_reprogram() after the
+ * handler returned.
+ *
+ * Softirq handlers are preemptible on PREEMPT_RT, which would make the delay
+ * unbounded, so nothing is deferred there.
+ */
+static bool hrtimer_defer_reprogram(struct hrtimer_cpu_base *cpu_base,
+				    ktime_t expires)
+{
+	if (IS_ENABLED(CONFIG_PREEMPT_RT))
+		return false;
+
+	if (!in_serving_softirq() || in_hardirq())
+		return false;
+
+	if (!hrtimer_hres_active(cpu_base) || cpu_base->hang_detected)
+		return false;
+
+	if (ktime_before(expires, ktime_add_ns(ktime_get(), HRTIMER_DEFER_MIN_NS)))
+		return false;
+
+	cpu_base->expires_next = expires;
+	cpu_base->deferred_reprogram = true;
+	return true;
+}
+
+/**
+ * hrtimer_flush_deferred_reprogram - Program the clock event device for timers
+ *				       armed by the last softirq handler
+ *
+ * Called after each softirq handler returns.
+ */
+void hrtimer_flush_deferred_reprogram(void)
+{
+	struct hrtimer_cpu_base *cpu_base = this_cpu_ptr(&hrtimer_bases);
+	unsigned long flags;
+
+	if (likely(!data_race(cpu_base->deferred_reprogram)))
+		return;
+
+	raw_spin_lock_irqsave(&cpu_base->lock, flags);
+	if (cpu_base->deferred_reprogram && !cpu_base->in_hrtirq)
+		__hrtimer_reprogram(cpu_base, cpu_base->next_timer,
+				    cpu_base->expires_next);
+	raw_spin_unlock_irqrestore(&cpu_base->lock, flags);
+}
+
 /*
  * Reprogram the event source with checking both queues for the
  * next event
@@ -861,6 +923,9 @@ static void hrtimer_reprogram(struct hrtimer *timer, bool reprogram)
 
 	cpu_base->next_timer = timer;
 
+	if (hrtimer_defer_reprogram(cpu_base, expires))
+		return;
+
 	__hrtimer_reprogram(cpu_base, timer, expires);
 }
 
@@ -1821,6 +1886,7 @@ void hrtimer_interrupt(struct clock_event_device *dev)
 	 * against it.
 	 */
 	cpu_base->expires_next = expires_next;
+	cpu_base->deferred_reprogram = false;
 	cpu_base->in_hrtirq = 0;
 	raw_spin_unlock_irqrestore(&cpu_base->lock, flags);
 
@@ -16,6 +16,7 @@
 #include <linux/compat.h>
 #include <linux/sched/deadline.h>
 #include <linux/task_work.h>
+#include <linux/slab.h>
 
 #include "posix-timers.h"
 
@@ -259,6 +260,35 @@ static void update_gt_cputime(struct task_cputime_atomic *cputime_atomic,
 	__update_gt_cputime(&cputime_atomic->sum_exec_runtime, sum->sum_exec_runtime);
 }
 
+/*
+ * Read the per-CPU group cputime sums, if the thread group has them. Once
+ * started, they are the process clock while no process wide timer is armed
+ * and the source the cputimer is seeded from when one gets armed.
+ */
+static bool group_cputime_pcpu_read(struct task_struct *tsk,
+				    struct task_cputime *sum)
+{
+	struct thread_group_cputime_pcpu *pc = READ_ONCE(tsk->signal->cputime_pcpu);
+	int cpu;
+
+	if (!pc || !smp_load_acquire(&pc->ready))
+		return false;
+
+	/* Account the pending runtime of current, like thread_group_cputime() */
+	if (same_thread_group(current, tsk))
+		(void) task_sched_runtime(current);
+
+	*sum = pc->base;
+	for_each_possible_cpu(cpu) {
+		struct task_cputime *c = per_cpu_ptr(pc->sums, cpu);
+
+		sum->utime += READ_ONCE(c->utime);
+		sum->stime += READ_ONCE(c->stime);
+		sum->sum_exec_runtime += READ_ONCE(c->sum_exec_runtime);
+	}
+	return true;
+}
+
 /**
  * thread_group_sample_cputime - Sample cputime for a given task
  * @tsk:	Task for which cputime needs to be started
@@ -307,8 +337,11 @@ static void thread_group_start_cputime(struct task_struct *tsk, u64 *samples)
 		 * The POSIX timer interface allows for absolute time expiry
 		 * values through the TIMER_ABSTIME flag, therefore we have
 		 * to synchronize the timer to the clock every time we start it.
+		 * With the per-CPU sums running, synchronize to them rather than
+		 * to a walk, which would disagree with them.
 		 */
-		thread_group_cputime(tsk, &sum);
+		if (!group_cputime_pcpu_read(tsk, &sum))
+			thread_group_cputime(tsk, &sum);
 		update_gt_cputime(&cputimer->cputime_atomic, &sum);
 
 		/*
@@ -331,6 +364,117 @@ static void __thread_group_cputime(struct task_struct *tsk, u64 *samples)
 	store_samples(samples, ct.stime, ct.utime, ct.sum_exec_runtime);
 }
 
+/*
+ * Thread groups below this size keep walking their threads to sample the
+ * process clocks. The walk is cheap for them and the per-CPU sums are not
+ * free to maintain.
+ */
+#define GROUP_CPUTIME_PCPU_MIN_THREADS	64
+
+void posix_cputimers_group_free(struct signal_struct *sig)
+{
+	struct thread_group_cputime_pcpu *pc = sig->cputime_pcpu;
+
+	if (pc) {
+		free_percpu(pc->sums);
+		kfree(pc);
+	}
+}
+
+/*
+ * Start the per-CPU group cputime sums and return a sample taken by a full
+ * walk. Called within a RCU read side critical section, so the allocation
+ * must not sleep. On failure or when losing the race against a concurrent
+ * start, the sample is just taken by walking the threads.
+ */
+static void group_cputime_pcpu_start(struct task_struct *tsk, u64 *samples)
+{
+	struct signal_struct *sig = tsk->signal;
+	struct thread_group_cputime_pcpu *pc;
+	struct task_cputime sum;
+	int cpu;
+
+	pc = kzalloc(sizeof(*pc), GFP_NOWAIT | __GFP_NOWARN);
+	if (!pc)
+		goto walk;
+	pc->sums = alloc_percpu_gfp(struct task_cputime,
+				    GFP_NOWAIT | __GFP_NOWARN);
+	if (!pc->sums)
+		goto free;
+	/*
+	 * Publish the zeroed sums before taking the base, so everything
+	 * accounted after the walk lands in them. Fully ordered, so the
+	 * accounting sees the initialized sums.
+	 */
+	if (cmpxchg(&sig->cputime_pcpu, NULL, pc))
+		goto free;
+
+	thread_group_cputime(tsk, &sum);
+	store_samples(samples, sum.stime, sum.utime, sum.sum_exec_runtime);
+
+	/*
+	 * The walk already covers what was fed into the sums since the
+	 * publication, take it out of the base so it is not counted twice.
+	 * Time accounted between the walk and this read is subtracted too,
+	 * leaving the clock slightly behind, but never behind the sample
+	 * returned here.
+	 */
+	for_each_possible_cpu(cpu) {
+		struct task_cputime *c = per_cpu_ptr(pc->sums, cpu);
+
+		sum.utime -= min(sum.utime, READ_ONCE(c->utime));
+		sum.stime -= min(sum.stime, READ_ONCE(c->stime));
+		sum.sum_exec_runtime -= min(sum.sum_exec_runtime,
+					    READ_ONCE(c->sum_exec_runtime));
+	}
+	pc->base = sum;
+	/* Pairs with the acquire in group_cputime_pcpu_read() */
+	smp_store_release(&pc->ready, true);
+	return;
+free:
+	free_percpu(pc->sums);
+	kfree(pc);
+walk:
+	thread_group_cputime(tsk, &sum);
+	store_samples(samples, sum.stime, sum.utime, sum.sum_exec_runtime);
+}
+
+/*
+ * Sample the process clocks from the per-CPU sums if the thread group has
+ * them, or start them for large thread groups. Provides the same precision
+ * as the cputimer: cputime pending on other CPUs is not included.
+ */
+static bool group_cputime_pcpu_sample(struct task_struct *tsk, u64 *samples)
+{
+	struct signal_struct *sig = tsk->signal;
+	struct task_cputime_atomic *at = &sig->cputimer.cputime_atomic;
+	struct task_cputime sum;
+
+	if (!READ_ONCE(sig->cputime_pcpu)) {
+		/* 64bit percpu counters can't be read tear free on 32bit */
+		if (!IS_ENABLED(CONFIG_64BIT) ||
+		    READ_ONCE(sig->nr_threads) < GROUP_CPUTIME_PCPU_MIN_THREADS)
+			return false;
+		group_cputime_pcpu_start(tsk, samples);
+		return true;
+	}
+
+	if (!group_cputime_pcpu_read(tsk, &sum))
+		return false;
+
+	/*
+	 * The cputimer may have been seeded by a walk before the sums were
+	 * started and stopped with a value ahead of them. Never go back
+	 * behind what a process wide timer has seen.
+	 */
+	store_samples(samples,
+		      max_t(u64, sum.stime, atomic64_read(&at->stime)),
+		      max_t(u64, sum.utime, atomic64_read(&at->utime)),
+		      max_t(u64, sum.sum_exec_runtime,
+			    atomic64_read(&at->sum_exec_runtime)));
+	return true;
+}
+
 /*
  * Sample a process (thread group) clock for the given task clkid. If the
  * group's cputime accounting is already enabled, read the atomic
@@ -346,7 +490,7 @@ static u64 cpu_clock_sample_group(const clockid_t clkid, struct task_struct *p,
 	if (!READ_ONCE(pct->timers_active)) {
 		if (start)
 			thread_group_start_cputime(p, samples);
-		else
+		else if (!group_cputime_pcpu_sample(p, samples))
 			__thread_group_cputime(p, samples);
 	} else {
 		proc_sample_cputime_atomic(&cputimer->cputime_atomic, samples);
@@ -966,6 +1110,27 @@ static void check_cpu_itimer(struct task_struct *tsk, struct cpu_itimer *it,
 		*expires = it->expires;
 }
 
+/**
+ * task_cputimers_expired - Check whether posix CPU timers are expired
+ *
+ * @samples:	Array of current samples for the CPUCLOCK clocks
+ * @pct:	Pointer to a posix_cputimers container
+ *
+ * Returns true if any member of @samples is greater than the corresponding
+ * member of @pct->bases[CLK].nextevt. False otherwise
+ */
+static inline bool
+task_cputimers_expired(const u64 *samples, struct posix_cputimers *pct)
+{
+	int i;
+
+	for (i = 0; i < CPUCLOCK_MAX; i++) {
+		if (samples[i] >= pct->bases[i].nextevt)
+			return true;
+	}
+	return false;
+}
+
 /*
  * Check for any per-thread CPU timers that have fired and move them
  * off the tsk->*_timers list onto the firing list.  Per-thread timers
@@ -987,17 +1152,27 @@ static void check_process_timers(struct task_struct *tsk,
 	if (!READ_ONCE(pct->timers_active) || pct->expiry_active)
 		return;
 
+	/*
+	 * Collect the current process totals. Group accounting is active
+	 * so the sample can be taken directly.
+	 */
+	proc_sample_cputime_atomic(&sig->cputimer.cputime_atomic, samples);
+
+	/*
+	 * Nothing is due when only a thread timer fired or another thread
+	 * handled the expiry between the lockless fastpath check and
+	 * acquiring sighand lock. The expiry cache covers the itimers and
+	 * RLIMIT_CPU as well, so there is nothing to collect either.
+	 */
+	if (!expiry_cache_is_inactive(pct) && !task_cputimers_expired(samples, pct))
+		return;
+
 	/*
 	 * Signify that a thread is checking for process timers.
 	 * Write access to this field is protected by the sighand lock.
 	 */
 	pct->expiry_active = true;
 
-	/*
-	 * Collect the current process totals. Group accounting is active
-	 * so the sample can be taken directly.
-	 */
-	proc_sample_cputime_atomic(&sig->cputimer.cputime_atomic, samples);
 	collect_posix_cputimers(pct, samples, firing);
 
 	/*
@@ -1081,27 +1256,6 @@ static void posix_cpu_timer_rearm(struct k_itimer *timer)
 	rcu_read_unlock();
 }
 
-/**
- * task_cputimers_expired - Check whether posix CPU timers are expired
- *
- * @samples:	Array of current samples for the CPUCLOCK clocks
- * @pct:	Pointer to a posix_cputimers container
- *
- * Returns true if any member of @samples is greater than the corresponding
- * member of @pct->bases[CLK].nextevt. False otherwise
- */
-static inline bool
-task_cputimers_expired(const u64 *samples, struct posix_cputimers *pct)
-{
-	int i;
-
-	for (i = 0; i < CPUCLOCK_MAX; i++) {
-		if (samples[i] >= pct->bases[i].nextevt)
-			return true;
-	}
-	return false;
-}
-
 /**
  * fastpath_timer_check - POSIX CPU timers fast path.
  *
@@ -41,7 +41,10 @@
 #include <linux/sched/sysctl.h>
 #include <linux/sched/nohz.h>
 #include <linux/sched/debug.h>
+#include <linux/sched/isolation.h>
 #include <linux/slab.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <linux/compat.h>
 #include <linux/random.h>
 #include <linux/sysctl.h>
@@ -241,6 +244,9 @@ EXPORT_SYMBOL(jiffies_64);
  *			for this base.
  * @timers_pending:	Is set, when a timer is pending in the base. It is only
  *			reliable when next_expiry_recalc is not set.
+ * @expired_local:	Number of timers expired by the CPU owning the base.
+ * @expired_remote:	Number of timers expired on behalf of an idle or
+ *			isolated base by another CPU.
  * @pending_map:	bitmap of the timer wheel; each bit reflects a
  *			bucket of the wheel. When a bit is set, at least a
  *			single timer is enqueued in the related bucket.
@@ -261,12 +267,19 @@ struct timer_base {
 	bool			next_expiry_recalc;
 	bool			is_idle;
 	bool			timers_pending;
+	unsigned long		expired_local;
+	unsigned long		expired_remote;
 	DECLARE_BITMAP(pending_map, WHEEL_SIZE);
 	struct hlist_head	vectors[WHEEL_SIZE];
 } ____cacheline_aligned;
 
 static DEFINE_PER_CPU(struct timer_base, timer_bases[NR_BASES]);
 
+#if defined(CONFIG_DEBUG_FS) || (defined(CONFIG_NO_HZ_COMMON) && defined(CONFIG_SMP))
+/* Timers armed on this CPU but enqueued on a housekeeping CPU's base. */
+static DEFINE_PER_CPU(unsigned long, timers_routed);
+#endif
+
 #ifdef CONFIG_NO_HZ_COMMON
 
 static DEFINE_STATIC_KEY_FALSE(timers_nohz_active);
@@ -280,12 +293,25 @@ static unsigned int sysctl_timer_migration = 1;
 
 DEFINE_STATIC_KEY_FALSE(timers_migration_enabled);
 
+/*
+ * Enqueue non-pinned timers armed on nohz_full CPUs on the nearest
+ * housekeeping CPU instead, so that they never tick the isolated CPU.
+ */
+static unsigned int sysctl_timer_isolated_route;
+
+static DEFINE_STATIC_KEY_FALSE(timers_isolated_route);
+
 static void timers_update_migration(void)
 {
 	if (sysctl_timer_migration && tick_nohz_active)
 		static_branch_enable(&timers_migration_enabled);
 	else
 		static_branch_disable(&timers_migration_enabled);
+
+	if (sysctl_timer_isolated_route && housekeeping_enabled(HK_TYPE_TIMER))
+		static_branch_enable(&timers_isolated_route);
+	else
+		static_branch_disable(&timers_isolated_route);
 }
 
 #ifdef CONFIG_SYSCTL
@@ -312,6 +338,15 @@ static struct ctl_table timer_sysctl[] = {
 		.extra1		= SYSCTL_ZERO,
 		.extra2		= SYSCTL_ONE,
 	},
+	{
+		.procname	= "timer_isolated_route",
+		.data		= &sysctl_timer_isolated_route,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= timer_migration_handler,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= SYSCTL_ONE,
+	},
 };
 
 static int __init timer_sysctl_init(void)
@@ -991,6 +1026,31 @@ static inline struct timer_base *get_timer_base(u32 tflags)
 	return get_timer_cpu_base(tflags, tflags & TIMER_CPUMASK);
 }
 
+/*
+ * Base a timer armed on this CPU is enqueued on: the local one, or the one
+ * of the nearest housekeeping CPU for non-pinned timers armed on a nohz_full
+ * CPU when kernel.timer_isolated_route is set.
+ */
+static inline struct timer_base *get_timer_enqueue_base(u32 tflags)
+{
+#if defined(CONFIG_NO_HZ_COMMON) && defined(CONFIG_SMP)
+	if (static_branch_unlikely(&timers_isolated_route) &&
+	    !(tflags & TIMER_PINNED)) {
+		int cpu = smp_processor_id();
+
+		if (!housekeeping_cpu(cpu, HK_TYPE_TIMER)) {
+			int target = housekeeping_any_cpu(HK_TYPE_TIMER);
+
+			if (target != cpu) {
+				__this_cpu_inc(timers_routed);
+				return get_timer_cpu_base(tflags, target);
+			}
+		}
+	}
+#endif
+	return get_timer_this_cpu_base(tflags);
+}
+
 static inline void __forward_timer_base(struct timer_base *base,
 					unsigned long basej)
 {
@@ -1145,7 +1205,7 @@ __mod_timer(struct timer_list *timer, unsigned long expires, unsigned int option
 	if (!ret && (options & MOD_TIMER_PENDING_ONLY))
 		goto out_unlock;
 
-	new_base = get_timer_this_cpu_base(timer->flags);
+	new_base = get_timer_enqueue_base(timer->flags);
 
 	if (base != new_base) {
 		/*
@@ -1815,6 +1875,7 @@ static void expire_timers(struct timer_base *base, struct hlist_head *head)
 	 * is related to the old base->clk value.
 	 */
 	unsigned long baseclk = base->clk - 1;
+	bool remote = base->cpu != smp_processor_id();
 
 	while (!hlist_empty(head)) {
 		struct timer_list *timer;
@@ -1822,6 +1883,11 @@ static void expire_timers(struct timer_base *base, struct hlist_head *head)
 
 		timer = hlist_entry(head->first, struct timer_list, entry);
 
+		if (remote)
+			base->expired_remote++;
+		else
+			base->expired_local++;
+
 		base->running_timer = timer;
 		detach_timer(timer, true);
 
@@ -2724,6 +2790,37 @@ void __init init_timers(void)
 	open_softirq(TIMER_SOFTIRQ, run_timer_softirq);
 }
 
+#ifdef CONFIG_DEBUG_FS
+static int timer_expiry_stats_show(struct seq_file *m, void *v)
+{
+	int cpu, i;
+
+	seq_puts(m, "cpu       routed        local       remote\n");
+	for_each_possible_cpu(cpu) {
+		unsigned long local = 0, remote = 0;
+
+		for (i = 0; i < NR_BASES; i++) {
+			struct timer_base *base = per_cpu_ptr(&timer_bases[i], cpu);
+
+			local += READ_ONCE(base->expired_local);
+			remote += READ_ONCE(base->expired_remote);
+		}
+		seq_printf(m, "%3d %12lu %12lu %12lu\n", cpu,
+			   READ_ONCE(per_cpu(timers_routed, cpu)), local, remote);
+	}
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(timer_expiry_stats);
+
+static int __init timer_debugfs_init(void)
+{
+	debugfs_create_file("timer_expiry_stats", 0444, NULL, NULL,
+			    &timer_expiry_stats_fops);
+	return 0;
+}
+late_initcall(timer_debugfs_init);
+#endif
+
 /**
  * msleep - sleep safely even with waitqueue interruptions
  * @msecs: Time in milliseconds to sleep for
@@ -55,6 +55,8 @@
 #include <linux/kvm_para.h>
 #include <linux/delay.h>
 #include <linux/irq_work.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include "workqueue_internal.h"
 
@@ -232,7 +234,8 @@ struct worker_pool {
 
 /*
  * Per-pool_workqueue statistics. These can be monitored using
- * tools/workqueue/wq_monitor.py.
+ * tools/workqueue/wq_monitor.py, per-workqueue totals are also available in
+ * debugfs, see wq_stats_show().
  */
 enum pool_workqueue_stats {
 	PWQ_STAT_STARTED,	/* work items started execution */
@@ -243,6 +246,9 @@ enum pool_workqueue_stats {
 	PWQ_STAT_REPATRIATED,	/* unbound workers brought back into scope */
 	PWQ_STAT_MAYDAY,	/* maydays to rescuer */
 	PWQ_STAT_RESCUED,	/* linked work items executed by rescuer */
+	PWQ_STAT_RUN_TIME,	/* total execution time in nsecs, see cost_stats */
+	PWQ_STAT_WAIT_TIME,	/* total queueing latency in nsecs, see cost_stats */
+	PWQ_STAT_STOLEN,	/* unbound work items redirected from a busy pod */
 
 	PWQ_NR_STATS,
 };
@@ -285,6 +291,8 @@ struct pool_workqueue {
 	struct list_head	pwqs_node;	/* WR: node on wq->pwqs */
 	struct list_head	mayday_node;	/* MD: node on wq->maydays */
 
+	int			nr_queued;	/* L: queued, not yet started */
+	u64			queued_ts;	/* L: last nr_queued change */
 	u64			stats[PWQ_NR_STATS];
 
 	/*
@@ -475,6 +483,21 @@ static bool wq_debug_force_rr_cpu = false;
 #endif
 module_param_named(debug_force_rr_cpu, wq_debug_force_rr_cpu, bool, 0644);
 
+/*
+ * Account execution time and queueing latency of work items in the pwq
+ * stats. Off by default as it costs two clock reads per work item.
+ */
+static bool wq_cost_stats;
+module_param_named(cost_stats, wq_cost_stats, bool, 0644);
+
+/*
+ * Number of other pods an unbound work item queued without a CPU preference
+ * may be redirected to, when the pool of the local pod is backlogged. 0
+ * disables stealing. Workqueues with strict affinity are never redirected.
+ */
+static unsigned int wq_steal_pods;
+module_param_named(steal_pods, wq_steal_pods, uint, 0644);
+
 /* to raise softirq for the BH worker pools on other CPUs */
 static DEFINE_PER_CPU_SHARED_ALIGNED(struct irq_work [NR_STD_WORKER_POOLS],
 				     bh_pool_irq_works);
@@ -2018,6 +2041,29 @@ static void pwq_dec_nr_in_flight(struct pool_workqueue *pwq, unsigned long work_
 	put_pwq(pwq);
 }
 
+/*
+ * Track the number of queued, not yet started work items of @pwq. With
+ * cost_stats enabled, the integral of that number over time, which is the
+ * sum of the queueing latencies of all work items, is accumulated into
+ * PWQ_STAT_WAIT_TIME.
+ */
+static void pwq_account_queued(struct pool_workqueue *pwq, int delta)
+{
+	lockdep_assert_held(&pwq->pool->lock);
+
+	if (READ_ONCE(wq_cost_stats)) {
+		u64 now = ktime_get_mono_fast_ns();
+
+		if (pwq->queued_ts && now > pwq->queued_ts)
+			pwq->stats[PWQ_STAT_WAIT_TIME] +=
+				(u64)pwq->nr_queued * (now - pwq->queued_ts);
+		pwq->queued_ts = now;
+	} else {
+		pwq->queued_ts = 0;
+	}
+	pwq->nr_queued += delta;
+}
+
 /**
  * try_to_grab_pending - steal work item from worklist and disable irq
  * @work: work item to steal
@@ -2113,6 +2159,7 @@ static int try_to_grab_pending(struct work_struct *work, u32 cflags,
 			move_linked_works(work, &pwq->pool->worklist, NULL);
 
 		list_del_init(&work->entry);
+		pwq_account_queued(pwq, -1);
 
 		/*
 		 * work->data points to pwq iff queued. Let's point to pool. As
@@ -2187,6 +2234,7 @@ static void insert_work(struct pool_workqueue *pwq, struct work_struct *work,
 	/* we own @work, set data and link */
 	set_work_pwq(work, pwq, extra_flags);
 	list_add_tail(&work->entry, head);
+	pwq_account_queued(pwq, 1);
 	get_pwq(pwq);
 }
 
@@ -2234,9 +2282,77 @@ static int wq_select_unbound_cpu(int cpu)
 	return new_cpu;
 }
 
+/*
+ * The pool lists are protected by pool->lock, which is not held for the
+ * lockless steal heuristics below; hence list_empty_careful(). The decision
+ * to steal is rechecked under the lock in __queue_work().
+ */
+static bool pwq_is_backlogged(struct pool_workqueue *pwq)
+{
+	struct worker_pool *pool = pwq->pool;
+
+	return !list_empty_careful(&pwq->inactive_works) ||
+		(!READ_ONCE(pool->nr_idle) && !list_empty_careful(&pool->worklist));
+}
+
+/* @pwq's pool has idle workers and nothing queued */
+static bool pwq_can_take_stolen(struct pool_workqueue *pwq)
+{
+	struct worker_pool *pool = pwq->pool;
+
+	return READ_ONCE(pool->nr_idle) && list_empty_careful(&pool->worklist) &&
+		list_empty_careful(&pwq->inactive_works);
+}
+
+/*
+ * An unbound work item without CPU preference is about to be queued on
+ * @pwq of @cpu's pod. If that pool is backlogged, look at up to steal_pods
+ * following pods of the same affinity scope and return the pwq of the
+ * first one whose pool has idle workers and nothing queued. Called under
+ * RCU; all the checks are lockless heuristics.
+ */
+static struct pool_workqueue *unbound_pwq_steal(struct workqueue_struct *wq,
+						struct pool_workqueue *pwq,
+						int cpu)
+{
+	unsigned int nr_steal = READ_ONCE(wq_steal_pods);
+	const struct workqueue_attrs *attrs = wq->unbound_attrs;
+	enum wq_affn_scope scope = attrs->affn_scope;
+	const struct wq_pod_type *pt;
+	int pod, i;
+
+	if (!nr_steal || (wq->flags & __WQ_ORDERED) ||
+	    READ_ONCE(attrs->affn_strict) || !pwq_is_backlogged(pwq))
+		return pwq;
+
+	if (scope == WQ_AFFN_DFL)
+		scope = READ_ONCE(wq_affn_dfl);
+	pt = &wq_pod_types[scope];
+	if (pt->nr_pods <= 1)
+		return pwq;
+
+	nr_steal = min_t(unsigned int, nr_steal, pt->nr_pods - 1);
+	pod = pt->cpu_pod[cpu];
+	for (i = 1; i <= nr_steal; i++) {
+		int target = (pod + i) % pt->nr_pods;
+		struct pool_workqueue *cand;
+		int tcpu;
+
+		tcpu = cpumask_any_and(pt->pod_cpus[target], cpu_online_mask);
+		if (tcpu >= nr_cpu_ids)
+			continue;
+
+		cand = rcu_dereference(*per_cpu_ptr(wq->cpu_pwq, tcpu));
+		if (cand->pool != pwq->pool && pwq_can_take_stolen(cand))
+			return cand;
+	}
+	return pwq;
+}
+
 static void __queue_work(int cpu, struct workqueue_struct *wq,
 			 struct work_struct *work)
 {
+	struct pool_workqueue *stolen;
 	struct pool_workqueue *pwq;
 	struct worker_pool *last_pool, *pool;
 	unsigned int work_flags;
@@ -2269,6 +2385,13 @@ static void __queue_work(int cpu, struct workqueue_struct *wq,
 	}
 
 	pwq = rcu_dereference(*per_cpu_ptr(wq->cpu_pwq, cpu));
+	stolen = NULL;
+	if (req_cpu == WORK_CPU_UNBOUND && (wq->flags & WQ_UNBOUND)) {
+		struct pool_workqueue *cand = unbound_pwq_steal(wq, pwq, cpu);
+
+		if (cand != pwq)
+			stolen = pwq = cand;
+	}
 	pool = pwq->pool;
 
 	/*
@@ -2301,6 +2424,20 @@ static void __queue_work(int cpu, struct workqueue_struct *wq,
 		raw_spin_lock(&pool->lock);
 	}
 
+	/*
+	 * The steal was decided without the lock. If the pool got busy since,
+	 * queue on the pwq of @cpu's own pod after all, unless @work may still
+	 * be running on the stolen pool and has to stay there.
+	 */
+	if (pwq == stolen && last_pool != pool &&
+	    unlikely(!pwq_can_take_stolen(pwq))) {
+		raw_spin_unlock(&pool->lock);
+		stolen = NULL;
+		pwq = rcu_dereference(*per_cpu_ptr(wq->cpu_pwq, cpu));
+		pool = pwq->pool;
+		raw_spin_lock(&pool->lock);
+	}
+
 	/*
 	 * pwq is determined and locked. For unbound pools, we could have raced
 	 * with pwq release and it could already be dead. If its refcnt is zero,
@@ -2322,6 +2459,9 @@ static void __queue_work(int cpu, struct workqueue_struct *wq,
 	/* pwq determined, queue */
 	trace_workqueue_queue_work(req_cpu, pwq, work);
 
+	if (pwq == stolen)
+		pwq->stats[PWQ_STAT_STOLEN]++;
+
 	if (WARN_ON(!list_empty(&work->entry)))
 		goto out;
 
@@ -3135,6 +3275,7 @@ __acquires(&pool->lock)
 	struct worker_pool *pool = worker->pool;
 	unsigned long work_data;
 	int lockdep_start_depth, rcu_start_depth;
+	u64 start;
 	bool bh_draining = pool->flags & POOL_BH_DRAINING;
 #ifdef CONFIG_LOCKDEP
 	/*
@@ -3170,6 +3311,7 @@ __acquires(&pool->lock)
 	strscpy(worker->desc, pwq->wq->name, WORKER_DESC_LEN);
 
 	list_del_init(&work->entry);
+	pwq_account_queued(pwq, -1);
 
 	/*
 	 * CPU intensive works don't participate in concurrency management.
@@ -3228,12 +3370,15 @@ __acquires(&pool->lock)
 	 */
 	lockdep_invariant_state(true);
 	trace_workqueue_execute_start(work);
+	start = READ_ONCE(wq_cost_stats) ? ktime_get_mono_fast_ns() : 0;
 	worker->current_func(work);
 	/*
 	 * While we must be careful to not use "work" after this, the trace
 	 * point will only record its address.
 	 */
 	trace_workqueue_execute_end(work, worker->current_func);
+	if (start)
+		pwq->stats[PWQ_STAT_RUN_TIME] += ktime_get_mono_fast_ns() - start;
 	pwq->stats[PWQ_STAT_COMPLETED]++;
 	lock_map_release(&lockdep_map);
 	if (!bh_draining)
@@ -7373,6 +7518,55 @@ static void workqueue_sysfs_unregister(struct workqueue_struct *wq)
 static void workqueue_sysfs_unregister(struct workqueue_struct *wq)	{ }
 #endif	/* CONFIG_SYSFS */
 
+#ifdef CONFIG_DEBUG_FS
+/*
+ * /sys/kernel/debug/workqueue/stats: per-workqueue totals of the pwq stats
+ * relevant for cost accounting. RUN_TIME and WAIT_TIME are only collected
+ * while workqueue.cost_stats is enabled; mean latency is wait / started.
+ */
+static int wq_stats_show(struct seq_file *m, void *v)
+{
+	struct workqueue_struct *wq;
+	struct pool_workqueue *pwq;
+
+	seq_printf(m, "%-24s %12s %12s %12s %14s %14s %10s\n", "workqueue",
+		   "started", "completed", "cpu_us", "run_us", "wait_us",
+		   "stolen");
+
+	mutex_lock(&wq_pool_mutex);
+	list_for_each_entry(wq, &workqueues, list) {
+		u64 stats[PWQ_NR_STATS] = { };
+		int i;
+
+		rcu_read_lock();
+		for_each_pwq(pwq, wq) {
+			for (i = 0; i < PWQ_NR_STATS; i++)
+				stats[i] += READ_ONCE(pwq->stats[i]);
+		}
+		rcu_read_unlock();
+
+		seq_printf(m, "%-24s %12llu %12llu %12llu %14llu %14llu %10llu\n",
+			   wq->name, stats[PWQ_STAT_STARTED],
+			   stats[PWQ_STAT_COMPLETED], stats[PWQ_STAT_CPU_TIME],
+			   div_u64(stats[PWQ_STAT_RUN_TIME], NSEC_PER_USEC),
+			   div_u64(stats[PWQ_STAT_WAIT_TIME], NSEC_PER_USEC),
+			   stats[PWQ_STAT_STOLEN]);
+	}
+	mutex_unlock(&wq_pool_mutex);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(wq_stats);
+
+static int __init wq_debugfs_init(void)
+{
+	struct dentry *dir = debugfs_create_dir("workqueue", NULL);
+
+	debugfs_create_file("stats", 0444, dir, NULL, &wq_stats_fops);
+	return 0;
+}
+late_initcall(wq_debugfs_init);
+#endif	/* CONFIG_DEBUG_FS */
+
 /*
  * Workqueue watchdog.
  *
@@ -54,6 +54,7 @@ __param(int, run_test_mask, INT_MAX,
 		"\t\tid: 256,  name: kvfree_rcu_1_arg_vmalloc_test\n"
 		"\t\tid: 512,  name: kvfree_rcu_2_arg_vmalloc_test\n"
 		"\t\tid: 1024, name: vm_map_ram_test\n"
+		"\t\tid: 2048, name: lazy_purge_churn_test\n"
 		/* Add a new test case description here. */
 );
 
@@ -394,6 +395,32 @@ vm_map_ram_test(void)
 	return nr_allocated != map_nr_pages;
 }
 
+/*
+ * Each worker churns through short-lived areas of up to 512 pages, so
+ * lazily freed ranges pile up on every vmap node the workers run on and
+ * the per-node purge path gets exercised concurrently.
+ */
+static int
+lazy_purge_churn_test(void)
+{
+	unsigned long size;
+	void *ptr;
+	int i;
+
+	for (i = 0; i < test_loop_count; i++) {
+		size = ((get_random_u32() % 512) + 1) * PAGE_SIZE;
+
+		ptr = vmalloc(size);
+		if (!ptr)
+			return -1;
+
+		*((__u8 *)ptr) = 'a';
+		vfree(ptr);
+	}
+
+	return 0;
+}
+
 struct test_case_desc {
 	const char *test_name;
 	int (*test_func)(void);
@@ -411,6 +438,7 @@ static struct test_case_desc test_case_array[] = {
 	{ "kvfree_rcu_1_arg_vmalloc_test", kvfree_rcu_1_arg_vmalloc_test },
 	{ "kvfree_rcu_2_arg_vmalloc_test", kvfree_rcu_2_arg_vmalloc_test },
 	{ "vm_map_ram_test", vm_map_ram_test },
+	{ "lazy_purge_churn_test", lazy_purge_churn_test },
 	/* Add a new test case here. */
 };
 
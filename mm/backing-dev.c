@@ -212,7 +212,7 @@ static int cgwb_debug_stats_show(struct seq_file *m, void *v)
 		 * Calculate thresh of wb in writeback cgroup which is min of
 		 * thresh in global domain and thresh in cgroup domain. Drop
 		 * rcu lock because cgwb_calc_thresh may sleep in
-		 * cgroup_rstat_flush. We can do so here because we have a ref.
+		 * css_rstat_flush. We can do so here because we have a ref.
 		 */
 		if (mem_cgroup_wb_domain(wb)) {
 			rcu_read_unlock();
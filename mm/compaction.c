@@ -2223,18 +2223,67 @@ static bool kswapd_is_running(pg_data_t *pgdat)
 	return running;
 }
 
+/*
+ * Record that an allocation of @order had to enter the slow path on
+ * @pgdat, so that proactive compaction can aim at the orders actually
+ * being asked for (e.g. mTHP sizes) rather than only at huge pages.
+ * Racy updates are fine, this is only a hint.
+ */
+void compaction_note_demand(pg_data_t *pgdat, unsigned int order)
+{
+	if (order > COMPACTION_HPAGE_ORDER || order > MAX_PAGE_ORDER)
+		return;
+
+	WRITE_ONCE(pgdat->compact_order_demand[order],
+		   READ_ONCE(pgdat->compact_order_demand[order]) + 1);
+}
+
+/*
+ * Pick the order proactive compaction should target next: the highest order
+ * seeing at least a quarter of the peak demand since the last update, or
+ * COMPACTION_HPAGE_ORDER when nothing was asked for.  The demand counters
+ * are halved each time so that the choice follows changes in the workload.
+ */
+static void kcompactd_update_proactive_order(pg_data_t *pgdat)
+{
+	unsigned int max_order = min_t(unsigned int, COMPACTION_HPAGE_ORDER,
+				       MAX_PAGE_ORDER);
+	unsigned long demand[NR_PAGE_ORDERS];
+	unsigned long peak = 0;
+	unsigned int order;
+
+	for (order = 1; order <= max_order; order++) {
+		demand[order] = READ_ONCE(pgdat->compact_order_demand[order]);
+		WRITE_ONCE(pgdat->compact_order_demand[order],
+			   demand[order] >> 1);
+		peak = max(peak, demand[order]);
+	}
+
+	if (!peak) {
+		pgdat->proactive_compact_order = COMPACTION_HPAGE_ORDER;
+		return;
+	}
+
+	for (order = max_order; order > 1; order--)
+		if (demand[order] >= peak / 4)
+			break;
+
+	pgdat->proactive_compact_order = order;
+}
+
 /*
  * A zone's fragmentation score is the external fragmentation wrt to the
- * COMPACTION_HPAGE_ORDER. It returns a value in the range [0, 100].
+ * node's proactive compaction order (COMPACTION_HPAGE_ORDER by default).
+ * It returns a value in the range [0, 100].
  */
 static unsigned int fragmentation_score_zone(struct zone *zone)
 {
-	return extfrag_for_order(zone, COMPACTION_HPAGE_ORDER);
+	return extfrag_for_order(zone, zone->zone_pgdat->proactive_compact_order);
 }
 
 /*
  * A weighted zone's fragmentation score is the external fragmentation
- * wrt to the COMPACTION_HPAGE_ORDER scaled by the zone's size. It
+ * wrt to the proactive compaction order scaled by the zone's size. It
  * returns a value in the range [0, 100].
  *
  * The scaling factor ensures that proactive compaction focuses on larger
@@ -3192,6 +3241,7 @@ static int kcompactd(void *p)
 
 	pgdat->kcompactd_max_order = 0;
 	pgdat->kcompactd_highest_zoneidx = pgdat->nr_zones - 1;
+	pgdat->proactive_compact_order = COMPACTION_HPAGE_ORDER;
 
 	while (!kthread_should_stop()) {
 		unsigned long pflags;
@@ -3239,6 +3289,11 @@ static int kcompactd(void *p)
 			if (unlikely(score >= prev_score))
 				timeout =
 				   default_timeout << COMPACT_MAX_DEFER_SHIFT;
+			else
+				kcompactd_update_proactive_order(pgdat);
+		} else {
+			/* Nothing left to do for the current order */
+			kcompactd_update_proactive_order(pgdat);
 		}
 		if (unlikely(pgdat->proactive_compact_trigger))
 			pgdat->proactive_compact_trigger = false;
@@ -619,6 +619,7 @@ int damon_set_attrs(struct damon_ctx *ctx, struct damon_attrs *attrs)
 {
 	unsigned long sample_interval = attrs->sample_interval ?
 		attrs->sample_interval : 1;
+	struct damon_intervals_goal *goal = &attrs->intervals_goal;
 	struct damos *s;
 
 	if (attrs->min_nr_regions < 3)
@@ -627,6 +628,11 @@ int damon_set_attrs(struct damon_ctx *ctx, struct damon_attrs *attrs)
 		return -EINVAL;
 	if (attrs->sample_interval > attrs->aggr_interval)
 		return -EINVAL;
+	if (goal->access_bp > 10000)
+		return -EINVAL;
+	if (goal->access_bp && goal->aggrs && goal->max_sample_us &&
+			goal->min_sample_us > goal->max_sample_us)
+		return -EINVAL;
 
 	ctx->next_aggregation_sis = ctx->passed_sample_intervals +
 		attrs->aggr_interval / sample_interval;
@@ -812,11 +818,19 @@ int damon_stop(struct damon_ctx **ctxs, int nr_ctxs)
 	return err;
 }
 
+static bool damon_intervals_goal_enabled(struct damon_ctx *c)
+{
+	return c->attrs.intervals_goal.access_bp &&
+		c->attrs.intervals_goal.aggrs;
+}
+
 /*
  * Reset the aggregated monitoring results ('nr_accesses' of each region).
  */
 static void kdamond_reset_aggregated(struct damon_ctx *c)
 {
+	unsigned int max_nr_accesses = damon_max_nr_accesses(&c->attrs);
+	bool tune = damon_intervals_goal_enabled(c);
 	struct damon_target *t;
 	unsigned int ti = 0;	/* target's index */
 
@@ -825,6 +839,15 @@ static void kdamond_reset_aggregated(struct damon_ctx *c)
 
 		damon_for_each_region(r, t) {
 			trace_damon_aggregated(ti, r, damon_nr_regions(t));
+			if (tune) {
+				unsigned long nr_pages = damon_sz_region(r) >>
+					PAGE_SHIFT;
+
+				c->tune_access_events +=
+					(u64)r->nr_accesses * nr_pages;
+				c->tune_max_access_events +=
+					(u64)max_nr_accesses * nr_pages;
+			}
 			r->last_nr_accesses = r->nr_accesses;
 			r->nr_accesses = 0;
 		}
@@ -832,6 +855,42 @@ static void kdamond_reset_aggregated(struct damon_ctx *c)
 	}
 }
 
+/*
+ * Scale the sampling and aggregation intervals towards the intervals goal,
+ * by at most a factor of two per tuning, keeping the number of samples per
+ * aggregation unchanged.
+ */
+static void kdamond_tune_intervals(struct damon_ctx *c)
+{
+	struct damon_intervals_goal *goal = &c->attrs.intervals_goal;
+	struct damon_attrs new_attrs = c->attrs;
+	unsigned long sample_interval, nr_samples;
+	u64 target, score_bp, factor_bp;
+
+	target = div_u64(c->tune_max_access_events * goal->access_bp, 10000);
+	score_bp = target ?
+		div64_u64(c->tune_access_events * 10000, target) : 10000;
+	c->nr_tune_aggrs = 0;
+	c->tune_access_events = 0;
+	c->tune_max_access_events = 0;
+
+	factor_bp = score_bp ? div64_u64(10000ULL * 10000, score_bp) : 20000;
+	factor_bp = clamp_t(u64, factor_bp, 5000, 20000);
+
+	sample_interval = c->attrs.sample_interval ? c->attrs.sample_interval : 1;
+	nr_samples = c->attrs.aggr_interval / sample_interval;
+	sample_interval = div_u64((u64)sample_interval * factor_bp, 10000);
+	if (goal->max_sample_us)
+		sample_interval = min(sample_interval, goal->max_sample_us);
+	sample_interval = max3(sample_interval, goal->min_sample_us, 1UL);
+	if (sample_interval == c->attrs.sample_interval)
+		return;
+
+	new_attrs.sample_interval = sample_interval;
+	new_attrs.aggr_interval = sample_interval * max(nr_samples, 1UL);
+	damon_set_attrs(c, &new_attrs);
+}
+
 static void damon_split_region_at(struct damon_target *t,
 				  struct damon_region *r, unsigned long sz_r);
 
@@ -1677,6 +1736,11 @@ static int kdamond_fn(void *data)
 			kdamond_split_regions(ctx);
 			if (ctx->ops.reset_aggregated)
 				ctx->ops.reset_aggregated(ctx);
+
+			if (damon_intervals_goal_enabled(ctx) &&
+					++ctx->nr_tune_aggrs >=
+					ctx->attrs.intervals_goal.aggrs)
+				kdamond_tune_intervals(ctx);
 		}
 
 		if (ctx->passed_sample_intervals == next_ops_update_sis) {
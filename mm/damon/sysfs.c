@@ -417,6 +417,10 @@ struct damon_sysfs_intervals {
 	unsigned long sample_us;
 	unsigned long aggr_us;
 	unsigned long update_us;
+	unsigned long goal_access_bp;
+	unsigned long goal_aggrs;
+	unsigned long goal_min_sample_us;
+	unsigned long goal_max_sample_us;
 };
 
 static struct damon_sysfs_intervals *damon_sysfs_intervals_alloc(
@@ -433,6 +437,10 @@ static struct damon_sysfs_intervals *damon_sysfs_intervals_alloc(
 	intervals->sample_us = sample_us;
 	intervals->aggr_us = aggr_us;
 	intervals->update_us = update_us;
+	intervals->goal_access_bp = 0;
+	intervals->goal_aggrs = 0;
+	intervals->goal_min_sample_us = 5000;
+	intervals->goal_max_sample_us = 10 * USEC_PER_SEC;
 	return intervals;
 }
 
@@ -508,6 +516,102 @@ static ssize_t update_us_store(struct kobject *kobj,
 	return count;
 }
 
+static ssize_t goal_access_bp_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	struct damon_sysfs_intervals *intervals = container_of(kobj,
+			struct damon_sysfs_intervals, kobj);
+
+	return sysfs_emit(buf, "%lu\n", intervals->goal_access_bp);
+}
+
+static ssize_t goal_access_bp_store(struct kobject *kobj,
+		struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	struct damon_sysfs_intervals *intervals = container_of(kobj,
+			struct damon_sysfs_intervals, kobj);
+	unsigned long val;
+	int err = kstrtoul(buf, 0, &val);
+
+	if (err)
+		return err;
+
+	intervals->goal_access_bp = val;
+	return count;
+}
+
+static ssize_t goal_aggrs_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	struct damon_sysfs_intervals *intervals = container_of(kobj,
+			struct damon_sysfs_intervals, kobj);
+
+	return sysfs_emit(buf, "%lu\n", intervals->goal_aggrs);
+}
+
+static ssize_t goal_aggrs_store(struct kobject *kobj,
+		struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	struct damon_sysfs_intervals *intervals = container_of(kobj,
+			struct damon_sysfs_intervals, kobj);
+	unsigned long val;
+	int err = kstrtoul(buf, 0, &val);
+
+	if (err)
+		return err;
+
+	intervals->goal_aggrs = val;
+	return count;
+}
+
+static ssize_t goal_min_sample_us_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	struct damon_sysfs_intervals *intervals = container_of(kobj,
+			struct damon_sysfs_intervals, kobj);
+
+	return sysfs_emit(buf, "%lu\n", intervals->goal_min_sample_us);
+}
+
+static ssize_t goal_min_sample_us_store(struct kobject *kobj,
+		struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	struct damon_sysfs_intervals *intervals = container_of(kobj,
+			struct damon_sysfs_intervals, kobj);
+	unsigned long val;
+	int err = kstrtoul(buf, 0, &val);
+
+	if (err)
+		return err;
+
+	intervals->goal_min_sample_us = val;
+	return count;
+}
+
+static ssize_t goal_max_sample_us_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	struct damon_sysfs_intervals *intervals = container_of(kobj,
+			struct damon_sysfs_intervals, kobj);
+
+	return sysfs_emit(buf, "%lu\n", intervals->goal_max_sample_us);
+}
+
+static ssize_t goal_max_sample_us_store(struct kobject *kobj,
+		struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	struct damon_sysfs_intervals *intervals = container_of(kobj,
+			struct damon_sysfs_intervals, kobj);
+	unsigned long val;
+	int err = kstrtoul(buf, 0, &val);
+
+	if (err)
+		return err;
+
+	intervals->goal_max_sample_us = val;
+	return count;
+}
+
 static void damon_sysfs_intervals_release(struct kobject *kobj)
 {
 	kfree(container_of(kobj, struct damon_sysfs_intervals, kobj));
@@ -522,10 +626,26 @@ static struct kobj_attribute damon_sysfs_intervals_aggr_us_attr =
 static struct kobj_attribute damon_sysfs_intervals_update_us_attr =
 		__ATTR_RW_MODE(update_us, 0600);
 
+static struct kobj_attribute damon_sysfs_intervals_goal_access_bp_attr =
+		__ATTR_RW_MODE(goal_access_bp, 0600);
+
+static struct kobj_attribute damon_sysfs_intervals_goal_aggrs_attr =
+		__ATTR_RW_MODE(goal_aggrs, 0600);
+
+static struct kobj_attribute damon_sysfs_intervals_goal_min_sample_us_attr =
+		__ATTR_RW_MODE(goal_min_sample_us, 0600);
+
+static struct kobj_attribute damon_sysfs_intervals_goal_max_sample_us_attr =
+		__ATTR_RW_MODE(goal_max_sample_us, 0600);
+
 static struct attribute *damon_sysfs_intervals_attrs[] = {
 	&damon_sysfs_intervals_sample_us_attr.attr,
 	&damon_sysfs_intervals_aggr_us_attr.attr,
 	&damon_sysfs_intervals_update_us_attr.attr,
+	&damon_sysfs_intervals_goal_access_bp_attr.attr,
+	&damon_sysfs_intervals_goal_aggrs_attr.attr,
+	&damon_sysfs_intervals_goal_min_sample_us_attr.attr,
+	&damon_sysfs_intervals_goal_max_sample_us_attr.attr,
 	NULL,
 };
 ATTRIBUTE_GROUPS(damon_sysfs_intervals);
@@ -1092,6 +1212,12 @@ static int damon_sysfs_set_attrs(struct damon_ctx *ctx,
 		.ops_update_interval = sys_intervals->update_us,
 		.min_nr_regions = sys_nr_regions->min,
 		.max_nr_regions = sys_nr_regions->max,
+		.intervals_goal = {
+			.access_bp = sys_intervals->goal_access_bp,
+			.aggrs = sys_intervals->goal_aggrs,
+			.min_sample_us = sys_intervals->goal_min_sample_us,
+			.max_sample_us = sys_intervals->goal_max_sample_us,
+		},
 	};
 	return damon_set_attrs(ctx, &attrs);
 }
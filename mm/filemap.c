@@ -38,6 +38,7 @@
 #include <linux/memcontrol.h>
 #include <linux/shmem_fs.h>
 #include <linux/rmap.h>
+#include <linux/mm_inline.h>
 #include <linux/delayacct.h>
 #include <linux/psi.h>
 #include <linux/ramfs.h>
@@ -146,8 +147,10 @@ static void page_cache_delete(struct address_space *mapping,
 
 	VM_BUG_ON_FOLIO(!folio_test_locked(folio), folio);
 
+	write_seqcount_begin(&mapping->i_pages_delete_seqcnt);
 	xas_store(&xas, shadow);
 	xas_init_marks(&xas);
+	write_seqcount_end(&mapping->i_pages_delete_seqcnt);
 
 	folio->mapping = NULL;
 	/* Leave page->index set: truncation lookup relies upon it */
@@ -292,6 +295,7 @@ static void page_cache_delete_batch(struct address_space *mapping,
 	struct folio *folio;
 
 	mapping_set_update(&xas, mapping);
+	write_seqcount_begin(&mapping->i_pages_delete_seqcnt);
 	xas_for_each(&xas, folio, ULONG_MAX) {
 		if (i >= folio_batch_count(fbatch))
 			break;
@@ -321,6 +325,7 @@ static void page_cache_delete_batch(struct address_space *mapping,
 		xas_store(&xas, NULL);
 		total_pages += folio_nr_pages(folio);
 	}
+	write_seqcount_end(&mapping->i_pages_delete_seqcnt);
 	mapping->nrpages -= total_pages;
 }
 
@@ -2574,6 +2579,60 @@ static inline bool pos_same_folio(loff_t pos1, loff_t pos2, struct folio *folio)
 	return (pos1 >> shift == pos2 >> shift);
 }
 
+/*
+ * Copy up to @size bytes at @pos from the page cache into @buffer without
+ * taking a folio reference.  The folio may be freed and reused under us, so
+ * the copy is only trusted if no folio was deleted from the mapping meanwhile
+ * and the xarray still points at the same folio afterwards.
+ *
+ * Folios that would need readahead or an LRU update from
+ * folio_mark_accessed() are left to the regular path.
+ *
+ * Return: the number of bytes copied, 0 to fall back to the regular path.
+ */
+static noinline size_t filemap_read_fast_rcu(struct address_space *mapping,
+		loff_t pos, char *buffer, size_t size)
+{
+	XA_STATE(xas, &mapping->i_pages, pos >> PAGE_SHIFT);
+	struct folio *folio;
+	loff_t file_size;
+	unsigned int seq;
+
+	lockdep_assert_in_rcu_read_lock();
+
+	if (lru_gen_enabled() || mapping_writably_mapped(mapping))
+		return 0;
+
+	seq = read_seqcount_begin(&mapping->i_pages_delete_seqcnt);
+
+	folio = xas_load(&xas);
+	if (!folio || xas_retry(&xas, folio) || xa_is_value(folio))
+		return 0;
+
+	if (!folio_test_uptodate(folio) || folio_test_readahead(folio))
+		return 0;
+	/* folio_mark_accessed() must have nothing left to do */
+	if (!folio_test_referenced(folio) || folio_test_idle(folio) ||
+	    !(folio_test_active(folio) || folio_test_unevictable(folio)))
+		return 0;
+
+	/* i_size check must be after folio_test_uptodate() */
+	file_size = i_size_read(mapping->host);
+	if (unlikely(pos >= file_size))
+		return 0;
+	size = min_t(loff_t, size, file_size - pos);
+
+	if (memcpy_from_file_folio(buffer, folio, pos, size) != size)
+		return 0;
+
+	if (xas_reload(&xas) != folio)
+		return 0;
+	if (read_seqcount_retry(&mapping->i_pages_delete_seqcnt, seq))
+		return 0;
+
+	return size;
+}
+
 /**
  * filemap_read - Read data from the page cache.
  * @iocb: The iocb to read.
@@ -2594,7 +2653,10 @@ ssize_t filemap_read(struct kiocb *iocb, struct iov_iter *iter,
 	struct file_ra_state *ra = &filp->f_ra;
 	struct address_space *mapping = filp->f_mapping;
 	struct inode *inode = mapping->host;
-	struct folio_batch fbatch;
+	union {
+		struct folio_batch fbatch;
+		__DECLARE_FLEX_ARRAY(char, buffer);
+	} area __uninitialized;
 	int i, error = 0;
 	bool writably_mapped;
 	loff_t isize, end_offset;
@@ -2606,7 +2668,30 @@ ssize_t filemap_read(struct kiocb *iocb, struct iov_iter *iter,
 		return 0;
 
 	iov_iter_truncate(iter, inode->i_sb->s_maxbytes);
-	folio_batch_init(&fbatch);
+
+	/*
+	 * Short read of cached data: copy it out under RCU into the folio
+	 * batch's stack space, without taking a folio reference.
+	 */
+	if (iov_iter_count(iter) <= sizeof(area) && !already_read) {
+		size_t copied;
+
+		rcu_read_lock();
+		copied = filemap_read_fast_rcu(mapping, iocb->ki_pos,
+					       area.buffer, iov_iter_count(iter));
+		rcu_read_unlock();
+		if (copied) {
+			copied = copy_to_iter(area.buffer, copied, iter);
+			if (likely(copied)) {
+				iocb->ki_pos += copied;
+				ra->prev_pos = iocb->ki_pos;
+				file_accessed(filp);
+				return copied;
+			}
+		}
+	}
+
+	folio_batch_init(&area.fbatch);
 
 	do {
 		cond_resched();
@@ -2622,7 +2707,7 @@ ssize_t filemap_read(struct kiocb *iocb, struct iov_iter *iter,
 		if (unlikely(iocb->ki_pos >= i_size_read(inode)))
 			break;
 
-		error = filemap_get_pages(iocb, iter->count, &fbatch, false);
+		error = filemap_get_pages(iocb, iter->count, &area.fbatch, false);
 		if (error < 0)
 			break;
 
@@ -2650,11 +2735,11 @@ ssize_t filemap_read(struct kiocb *iocb, struct iov_iter *iter,
 		 * mark it as accessed the first time.
 		 */
 		if (!pos_same_folio(iocb->ki_pos, last_pos - 1,
-				    fbatch.folios[0]))
-			folio_mark_accessed(fbatch.folios[0]);
+				    area.fbatch.folios[0]))
+			folio_mark_accessed(area.fbatch.folios[0]);
 
-		for (i = 0; i < folio_batch_count(&fbatch); i++) {
-			struct folio *folio = fbatch.folios[i];
+		for (i = 0; i < folio_batch_count(&area.fbatch); i++) {
+			struct folio *folio = area.fbatch.folios[i];
 			size_t fsize = folio_size(folio);
 			size_t offset = iocb->ki_pos & (fsize - 1);
 			size_t bytes = min_t(loff_t, end_offset - iocb->ki_pos,
@@ -2685,9 +2770,9 @@ ssize_t filemap_read(struct kiocb *iocb, struct iov_iter *iter,
 			}
 		}
 put_folios:
-		for (i = 0; i < folio_batch_count(&fbatch); i++)
-			folio_put(fbatch.folios[i]);
-		folio_batch_init(&fbatch);
+		for (i = 0; i < folio_batch_count(&area.fbatch); i++)
+			folio_put(area.fbatch.folios[i]);
+		folio_batch_init(&area.fbatch);
 	} while (iov_iter_count(iter) && iocb->ki_pos < isize && !error);
 
 	file_accessed(filp);
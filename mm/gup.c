@@ -2912,6 +2912,42 @@ static void __maybe_unused gup_fast_undo_dev_pagemap(int *nr, int nr_start,
 }
 
 #ifdef CONFIG_ARCH_HAS_PTE_SPECIAL
+/*
+ * Whether @next, found @idx entries after @pte, maps the page following
+ * @pte's page @idx times over with the same access, so that both can be
+ * grabbed together with a single folio reference update.
+ */
+static inline bool gup_fast_pte_follows(pte_t pte, pte_t next, int idx,
+					unsigned int flags)
+{
+	if (pte_protnone(next) || pte_devmap(next) || pte_special(next))
+		return false;
+	if (!pte_access_permitted(next, flags & FOLL_WRITE))
+		return false;
+	return pte_pfn(next) == pte_pfn(pte) + idx &&
+	       pte_write(next) == pte_write(pte);
+}
+
+/*
+ * Count how many entries from @ptep, up to @end, map consecutive pages
+ * starting at @pte's so that a PTE-mapped large folio is grabbed in one go.
+ * The result may still span folios; callers must check after taking the
+ * references.
+ */
+static int gup_fast_pte_batch(pte_t *ptep, pte_t pte, unsigned long addr,
+			      unsigned long end, unsigned int flags)
+{
+	int max_nr = (end - addr) >> PAGE_SHIFT;
+	int nr = 1;
+
+	if (pte_devmap(pte))
+		return 1;
+	while (nr < max_nr &&
+	       gup_fast_pte_follows(pte, ptep_get_lockless(ptep + nr), nr, flags))
+		nr++;
+	return nr;
+}
+
 /*
  * GUP-fast relies on pte change detection to avoid concurrent pgtable
  * operations.
@@ -2946,6 +2982,7 @@ static int gup_fast_pte_range(pmd_t pmd, pmd_t *pmdp, unsigned long addr,
 		pte_t pte = ptep_get_lockless(ptep);
 		struct page *page;
 		struct folio *folio;
+		int i, batch;
 
 		/*
 		 * Always fallback to ordinary GUP on PROT_NONE-mapped pages:
@@ -2974,44 +3011,69 @@ static int gup_fast_pte_range(pmd_t pmd, pmd_t *pmdp, unsigned long addr,
 
 		VM_BUG_ON(!pfn_valid(pte_pfn(pte)));
 		page = pte_page(pte);
+		batch = gup_fast_pte_batch(ptep, pte, addr, end, flags);
 
-		folio = try_grab_folio_fast(page, 1, flags);
+		folio = try_grab_folio_fast(page, batch, flags);
 		if (!folio)
 			goto pte_unmap;
 
 		if (unlikely(pmd_val(pmd) != pmd_val(*pmdp)) ||
 		    unlikely(pte_val(pte) != pte_val(ptep_get(ptep)))) {
-			gup_put_folio(folio, 1, flags);
+			gup_put_folio(folio, batch, flags);
 			goto pte_unmap;
 		}
 
-		if (!gup_fast_folio_allowed(folio, flags)) {
-			gup_put_folio(folio, 1, flags);
-			goto pte_unmap;
+		/*
+		 * The batch was sized without a reference; now that the folio
+		 * is stable, trim it to the folio and to entries that still
+		 * map the pages it was sized for.
+		 */
+		if (batch > 1) {
+			int fit = folio_nr_pages(folio) - folio_page_idx(folio, page);
+
+			for (i = 1; i < min(batch, fit); i++)
+				if (!gup_fast_pte_follows(pte, ptep_get(ptep + i),
+							  i, flags))
+					break;
+			if (i < batch) {
+				gup_put_folio(folio, batch - i, flags);
+				batch = i;
+			}
 		}
 
-		if (!pte_write(pte) && gup_must_unshare(NULL, flags, page)) {
-			gup_put_folio(folio, 1, flags);
+		if (!gup_fast_folio_allowed(folio, flags)) {
+			gup_put_folio(folio, batch, flags);
 			goto pte_unmap;
 		}
 
-		/*
-		 * We need to make the page accessible if and only if we are
-		 * going to access its content (the FOLL_PIN case).  Please
-		 * see Documentation/core-api/pin_user_pages.rst for
-		 * details.
-		 */
-		if (flags & FOLL_PIN) {
-			ret = arch_make_page_accessible(page);
-			if (ret) {
-				gup_put_folio(folio, 1, flags);
+		for (i = 0; i < batch; i++) {
+			if (!pte_write(pte) &&
+			    gup_must_unshare(NULL, flags, page + i)) {
+				gup_put_folio(folio, batch - i, flags);
 				goto pte_unmap;
 			}
+
+			/*
+			 * We need to make the page accessible if and only if
+			 * we are going to access its content (the FOLL_PIN
+			 * case).  Please see
+			 * Documentation/core-api/pin_user_pages.rst for
+			 * details.
+			 */
+			if (flags & FOLL_PIN) {
+				ret = arch_make_page_accessible(page + i);
+				if (ret) {
+					gup_put_folio(folio, batch - i, flags);
+					goto pte_unmap;
+				}
+			}
+			pages[*nr] = page + i;
+			(*nr)++;
 		}
 		folio_set_referenced(folio);
-		pages[*nr] = page;
-		(*nr)++;
-	} while (ptep++, addr += PAGE_SIZE, addr != end);
+		ptep += batch;
+		addr += batch * PAGE_SIZE;
+	} while (addr != end);
 
 	ret = 1;
 
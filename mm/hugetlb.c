@@ -2313,6 +2313,100 @@ static struct folio *alloc_pool_huge_folio(struct hstate *h,
 	return NULL;
 }
 
+/*
+ * Growing a big pool one folio at a time is bound by a single CPU clearing
+ * and splitting memory of every node in turn.  Large runtime requests
+ * spanning several nodes instead get one worker per node, each allocating
+ * its share of node local folios.
+ */
+struct hugetlb_pool_work {
+	struct work_struct work;
+	struct hstate *h;
+	struct task_struct *task;
+	nodemask_t *nodes_allowed;
+	nodemask_t *node_alloc_noretry;
+	struct list_head folios;
+	unsigned long nr;
+	unsigned long allocated;
+	int nid;
+};
+
+static void hugetlb_pool_workfn(struct work_struct *work)
+{
+	struct hugetlb_pool_work *w = container_of(work,
+					struct hugetlb_pool_work, work);
+	gfp_t gfp_mask = htlb_alloc_mask(w->h) | __GFP_THISNODE;
+	struct folio *folio;
+
+	while (w->allocated < w->nr && !signal_pending(w->task)) {
+		folio = only_alloc_fresh_hugetlb_folio(w->h, gfp_mask, w->nid,
+				w->nodes_allowed, w->node_alloc_noretry);
+		if (!folio)
+			break;
+
+		list_add(&folio->lru, &w->folios);
+		w->allocated++;
+		cond_resched();
+	}
+}
+
+/*
+ * Allocate up to @nr fresh folios spread over @nodes_allowed in parallel
+ * and add them to @folio_list.  Returns the number allocated, which may be
+ * short if some node ran out of memory; the caller falls back to the
+ * interleaved serial allocation for the rest.
+ */
+static unsigned long alloc_pool_huge_folios_parallel(struct hstate *h,
+					nodemask_t *nodes_allowed,
+					nodemask_t *node_alloc_noretry,
+					unsigned long nr,
+					struct list_head *folio_list)
+{
+	struct hugetlb_pool_work *works;
+	unsigned long allocated = 0;
+	int i, node, nr_nodes = 0;
+
+	for_each_node_mask(node, *nodes_allowed)
+		if (node_state(node, N_MEMORY))
+			nr_nodes++;
+
+	if (nr_nodes < 2 || nr < nr_nodes)
+		return 0;
+
+	works = kcalloc(nr_nodes, sizeof(*works), GFP_KERNEL);
+	if (!works)
+		return 0;
+
+	i = 0;
+	for_each_node_mask(node, *nodes_allowed) {
+		struct hugetlb_pool_work *w;
+
+		if (!node_state(node, N_MEMORY))
+			continue;
+
+		w = &works[i];
+		w->h = h;
+		w->task = current;
+		w->nodes_allowed = nodes_allowed;
+		w->node_alloc_noretry = node_alloc_noretry;
+		INIT_LIST_HEAD(&w->folios);
+		w->nr = nr / nr_nodes + (i < nr % nr_nodes);
+		w->nid = node;
+		INIT_WORK(&w->work, hugetlb_pool_workfn);
+		queue_work_node(node, system_unbound_wq, &w->work);
+		i++;
+	}
+
+	for (i = 0; i < nr_nodes; i++) {
+		flush_work(&works[i].work);
+		list_splice_tail(&works[i].folios, folio_list);
+		allocated += works[i].allocated;
+	}
+
+	kfree(works);
+	return allocated;
+}
+
 /*
  * Remove huge page from pool from next node to free.  Attempt to keep
  * persistent huge pages more or less balanced over allowed nodes.
@@ -3804,6 +3898,15 @@ static int set_max_huge_pages(struct hstate *h, unsigned long count, int nid,
 	}
 
 	allocated = 0;
+	if (count > persistent_huge_pages(h)) {
+		unsigned long nr = count - persistent_huge_pages(h);
+
+		spin_unlock_irq(&hugetlb_lock);
+		allocated = alloc_pool_huge_folios_parallel(h, nodes_allowed,
+					node_alloc_noretry, nr, &page_list);
+		spin_lock_irq(&hugetlb_lock);
+	}
+
 	while (count > (persistent_huge_pages(h) + allocated)) {
 		/*
 		 * If this allocation races such that we no longer need the
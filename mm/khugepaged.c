@@ -89,6 +89,13 @@ static unsigned int khugepaged_max_ptes_none __read_mostly;
 static unsigned int khugepaged_max_ptes_swap __read_mostly;
 static unsigned int khugepaged_max_ptes_shared __read_mostly;
 
+/*
+ * An mm whose last full pass collapsed nothing is skipped for an exponentially
+ * growing number of passes, capped at khugepaged_max_skip_passes, so that the
+ * scan budget goes to processes that are actually touching their memory.
+ */
+static unsigned int khugepaged_max_skip_passes __read_mostly = 7;
+
 #define MM_SLOTS_HASH_BITS 10
 static DEFINE_READ_MOSTLY_HASHTABLE(mm_slots_hash, MM_SLOTS_HASH_BITS);
 
@@ -107,9 +114,15 @@ struct collapse_control {
 /**
  * struct khugepaged_mm_slot - khugepaged information per mm that is being scanned
  * @slot: hash lookup from mm to mm_slot
+ * @collapsed: a collapse succeeded during the current pass over this mm
+ * @cold_passes: consecutive full passes without a collapse
+ * @skip_passes: number of upcoming passes over the mm list to skip this mm
  */
 struct khugepaged_mm_slot {
 	struct mm_slot slot;
+	bool collapsed;
+	unsigned int cold_passes;
+	unsigned int skip_passes;
 };
 
 /**
@@ -327,11 +340,38 @@ static ssize_t max_ptes_shared_store(struct kobject *kobj,
 static struct kobj_attribute khugepaged_max_ptes_shared_attr =
 	__ATTR_RW(max_ptes_shared);
 
+static ssize_t max_skip_passes_show(struct kobject *kobj,
+				    struct kobj_attribute *attr,
+				    char *buf)
+{
+	return sysfs_emit(buf, "%u\n", khugepaged_max_skip_passes);
+}
+
+static ssize_t max_skip_passes_store(struct kobject *kobj,
+				     struct kobj_attribute *attr,
+				     const char *buf, size_t count)
+{
+	unsigned int max_skip_passes;
+	int err;
+
+	err = kstrtouint(buf, 10, &max_skip_passes);
+	if (err || max_skip_passes > 255)
+		return -EINVAL;
+
+	WRITE_ONCE(khugepaged_max_skip_passes, max_skip_passes);
+
+	return count;
+}
+
+static struct kobj_attribute khugepaged_max_skip_passes_attr =
+	__ATTR_RW(max_skip_passes);
+
 static struct attribute *khugepaged_attr[] = {
 	&khugepaged_defrag_attr.attr,
 	&khugepaged_max_ptes_none_attr.attr,
 	&khugepaged_max_ptes_swap_attr.attr,
 	&khugepaged_max_ptes_shared_attr.attr,
+	&khugepaged_max_skip_passes_attr.attr,
 	&pages_to_scan_attr.attr,
 	&pages_collapsed_attr.attr,
 	&full_scans_attr.attr,
@@ -2312,6 +2352,25 @@ static int hpage_collapse_scan_file(struct mm_struct *mm, unsigned long addr,
 }
 #endif
 
+/*
+ * Called when a pass over @mm_slot completed: back off from mms where the
+ * pass found nothing hot enough to collapse.
+ */
+static void khugepaged_mm_slot_pass_done(struct khugepaged_mm_slot *mm_slot)
+{
+	unsigned int max_skip = READ_ONCE(khugepaged_max_skip_passes);
+
+	if (mm_slot->collapsed || !max_skip) {
+		mm_slot->cold_passes = 0;
+		mm_slot->skip_passes = 0;
+		return;
+	}
+
+	if (mm_slot->cold_passes < ilog2(max_skip) + 1)
+		mm_slot->cold_passes++;
+	mm_slot->skip_passes = min((1U << mm_slot->cold_passes) - 1, max_skip);
+}
+
 static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 					    struct collapse_control *cc)
 	__releases(&khugepaged_mm_lock)
@@ -2322,6 +2381,7 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 	struct mm_slot *slot;
 	struct mm_struct *mm;
 	struct vm_area_struct *vma;
+	bool walked = false;
 	int progress = 0;
 
 	VM_BUG_ON(!pages);
@@ -2341,14 +2401,25 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 	spin_unlock(&khugepaged_mm_lock);
 
 	mm = slot->mm;
+	vma = NULL;
+	if (!khugepaged_scan.address) {
+		/* Starting a new pass over this mm: skip it if it went cold */
+		if (mm_slot->skip_passes) {
+			mm_slot->skip_passes--;
+			progress++;
+			goto breakouterloop_mmap_lock;
+		}
+		mm_slot->collapsed = false;
+	}
+
 	/*
 	 * Don't wait for semaphore (to avoid long wait times).  Just move to
 	 * the next mm on the list.
 	 */
-	vma = NULL;
 	if (unlikely(!mmap_read_trylock(mm)))
 		goto breakouterloop_mmap_lock;
 
+	walked = true;
 	progress++;
 	if (unlikely(hpage_collapse_test_exit_or_disable(mm)))
 		goto breakouterloop;
@@ -2411,8 +2482,10 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 					khugepaged_scan.address, &mmap_locked, cc);
 			}
 
-			if (*result == SCAN_SUCCEED)
+			if (*result == SCAN_SUCCEED) {
 				++khugepaged_pages_collapsed;
+				mm_slot->collapsed = true;
+			}
 
 			/* move to next address */
 			khugepaged_scan.address += HPAGE_PMD_SIZE;
@@ -2446,6 +2519,8 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 		 * khugepaged runs here, khugepaged_exit will find
 		 * mm_slot not pointing to the exiting mm.
 		 */
+		if (walked)
+			khugepaged_mm_slot_pass_done(mm_slot);
 		if (slot->mm_node.next != &khugepaged_scan.mm_head) {
 			slot = list_entry(slot->mm_node.next,
 					  struct mm_slot, mm_node);
@@ -180,6 +180,7 @@ struct ksm_stable_node {
 	 */
 #define STABLE_NODE_CHAIN -1024
 	int rmap_hlist_len;
+	u32 checksum;		/* of kpfn's content, for ksm_stable_filter */
 #ifdef CONFIG_NUMA
 	int nid;
 #endif
@@ -285,6 +286,17 @@ static unsigned int ksm_thread_pages_to_scan = DEFAULT_PAGES_TO_SCAN;
 /* Milliseconds ksmd should sleep between batches */
 static unsigned int ksm_thread_sleep_millisecs = 20;
 
+/*
+ * Counting filter of the checksums of all stable_node dups, protected by
+ * ksm_thread_mutex like the stable trees themselves.  A zero counter means
+ * no KSM page can have that content, so the scanner can skip the stable
+ * tree walk and its page compares.  Counters saturate and then stay put.
+ * Sized once, on the first scan, before any stable node exists.
+ */
+static u8 *ksm_stable_filter;
+static unsigned int ksm_stable_filter_shift;
+static bool ksm_stable_filter_tried;
+
 /* Checksum of an empty (zeroed) page */
 static unsigned int zero_checksum __read_mostly;
 
@@ -592,10 +604,70 @@ static inline struct ksm_stable_node *alloc_stable_node(void)
 	return kmem_cache_alloc(stable_node_cache, GFP_KERNEL | __GFP_HIGH);
 }
 
+static u32 calc_checksum(struct page *page)
+{
+	u32 checksum;
+	void *addr = kmap_local_page(page);
+	checksum = xxhash(addr, PAGE_SIZE, 0);
+	kunmap_local(addr);
+	return checksum;
+}
+
+static void ksm_stable_filter_init(void)
+{
+	unsigned long nr;
+
+	ksm_stable_filter_tried = true;
+
+	/* One counter per 64 pages of RAM, between 4K and 64M counters. */
+	nr = clamp(totalram_pages() >> 6, 1UL << 12, 1UL << 26);
+	ksm_stable_filter_shift = ilog2(nr);
+	ksm_stable_filter = kvzalloc(1UL << ksm_stable_filter_shift,
+				     GFP_KERNEL | __GFP_NOWARN);
+}
+
+static inline u8 *ksm_stable_filter_slot(u32 checksum)
+{
+	return &ksm_stable_filter[hash_32(checksum, ksm_stable_filter_shift)];
+}
+
+static inline bool ksm_stable_filter_test(u32 checksum)
+{
+	return !ksm_stable_filter || *ksm_stable_filter_slot(checksum);
+}
+
+static inline void ksm_stable_filter_add(struct ksm_stable_node *dup,
+					 struct page *kpage)
+{
+	u8 *slot;
+
+	if (!ksm_stable_filter)
+		return;
+
+	dup->checksum = calc_checksum(kpage);
+	slot = ksm_stable_filter_slot(dup->checksum);
+	if (*slot != U8_MAX)
+		(*slot)++;
+}
+
+static inline void ksm_stable_filter_del(struct ksm_stable_node *dup)
+{
+	u8 *slot;
+
+	if (!ksm_stable_filter)
+		return;
+
+	slot = ksm_stable_filter_slot(dup->checksum);
+	if (*slot != U8_MAX)
+		(*slot)--;
+}
+
 static inline void free_stable_node(struct ksm_stable_node *stable_node)
 {
 	VM_BUG_ON(stable_node->rmap_hlist_len &&
 		  !is_stable_node_chain(stable_node));
+	if (!is_stable_node_chain(stable_node))
+		ksm_stable_filter_del(stable_node);
 	kmem_cache_free(stable_node_cache, stable_node);
 }
 
@@ -1266,15 +1338,6 @@ static int unmerge_and_remove_all_rmap_items(void)
 }
 #endif /* CONFIG_SYSFS */
 
-static u32 calc_checksum(struct page *page)
-{
-	u32 checksum;
-	void *addr = kmap_local_page(page);
-	checksum = xxhash(addr, PAGE_SIZE, 0);
-	kunmap_local(addr);
-	return checksum;
-}
-
 static int write_protect_page(struct vm_area_struct *vma, struct folio *folio,
 			      pte_t *orig_pte)
 {
@@ -2154,6 +2217,7 @@ static struct ksm_stable_node *stable_tree_insert(struct folio *kfolio)
 	stable_node_dup->kpfn = kpfn;
 	stable_node_dup->rmap_hlist_len = 0;
 	DO_NUMA(stable_node_dup->nid = nid);
+	ksm_stable_filter_add(stable_node_dup, &kfolio->page);
 	if (!need_chain) {
 		rb_link_node(&stable_node_dup->node, parent, new);
 		rb_insert_color(&stable_node_dup->node, root);
@@ -2312,6 +2376,7 @@ static void cmp_and_merge_page(struct page *page, struct ksm_rmap_item *rmap_ite
 	struct ksm_stable_node *stable_node;
 	struct page *kpage;
 	unsigned int checksum;
+	bool checksummed = false;
 	int err;
 	bool max_page_sharing_bypass = false;
 
@@ -2335,8 +2400,21 @@ static void cmp_and_merge_page(struct page *page, struct ksm_rmap_item *rmap_ite
 			max_page_sharing_bypass = true;
 	}
 
+	/*
+	 * A page that is not a KSM page yet needs its checksum below anyway
+	 * if the stable tree has nothing for it: take it now and use it to
+	 * skip the stable tree walk when no KSM page can match.
+	 */
+	if (!stable_node && ksm_stable_filter) {
+		checksum = calc_checksum(page);
+		checksummed = true;
+	}
+
 	/* We first start with searching the page inside the stable tree */
-	kpage = stable_tree_search(page);
+	if (checksummed && !ksm_stable_filter_test(checksum))
+		kpage = NULL;
+	else
+		kpage = stable_tree_search(page);
 	if (kpage == page && rmap_item->head == stable_node) {
 		put_page(kpage);
 		return;
@@ -2369,7 +2447,8 @@ static void cmp_and_merge_page(struct page *page, struct ksm_rmap_item *rmap_ite
 	 * don't want to insert it in the unstable tree, and we don't want
 	 * to waste our time searching for something identical to it there.
 	 */
-	checksum = calc_checksum(page);
+	if (!checksummed)
+		checksum = calc_checksum(page);
 	if (rmap_item->oldchecksum != checksum) {
 		rmap_item->oldchecksum = checksum;
 		return;
@@ -2754,6 +2833,9 @@ static void ksm_do_scan(unsigned int scan_npages)
 	struct ksm_rmap_item *rmap_item;
 	struct page *page;
 
+	if (unlikely(!ksm_stable_filter_tried))
+		ksm_stable_filter_init();
+
 	while (scan_npages-- && likely(!freezing(current))) {
 		cond_resched();
 		rmap_item = scan_get_next_rmap_item(&page);
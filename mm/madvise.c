@@ -577,9 +577,15 @@ static inline bool can_madv_lru_vma(struct vm_area_struct *vma)
 	return !(vma->vm_flags & (VM_LOCKED|VM_PFNMAP|VM_HUGETLB));
 }
 
+/*
+ * With @batch_tlb, MADV_COLD and MADV_PAGEOUT gather into the caller's
+ * mmu_gather and leave the TLB flush to the caller, which also drained the
+ * LRU caches.  Otherwise each VMA is flushed on its own.
+ */
 static long madvise_cold(struct vm_area_struct *vma,
 			struct vm_area_struct **prev,
-			unsigned long start_addr, unsigned long end_addr)
+			unsigned long start_addr, unsigned long end_addr,
+			struct mmu_gather *batch_tlb)
 {
 	struct mm_struct *mm = vma->vm_mm;
 	struct mmu_gather tlb;
@@ -588,6 +594,11 @@ static long madvise_cold(struct vm_area_struct *vma,
 	if (!can_madv_lru_vma(vma))
 		return -EINVAL;
 
+	if (batch_tlb) {
+		madvise_cold_page_range(batch_tlb, vma, start_addr, end_addr);
+		return 0;
+	}
+
 	lru_add_drain();
 	tlb_gather_mmu(&tlb, mm);
 	madvise_cold_page_range(&tlb, vma, start_addr, end_addr);
@@ -612,7 +623,8 @@ static void madvise_pageout_page_range(struct mmu_gather *tlb,
 
 static long madvise_pageout(struct vm_area_struct *vma,
 			struct vm_area_struct **prev,
-			unsigned long start_addr, unsigned long end_addr)
+			unsigned long start_addr, unsigned long end_addr,
+			struct mmu_gather *batch_tlb)
 {
 	struct mm_struct *mm = vma->vm_mm;
 	struct mmu_gather tlb;
@@ -631,6 +643,12 @@ static long madvise_pageout(struct vm_area_struct *vma,
 				(vma->vm_flags & VM_MAYSHARE)))
 		return 0;
 
+	if (batch_tlb) {
+		madvise_pageout_page_range(batch_tlb, vma, start_addr,
+					   end_addr);
+		return 0;
+	}
+
 	lru_add_drain();
 	tlb_gather_mmu(&tlb, mm);
 	madvise_pageout_page_range(&tlb, vma, start_addr, end_addr);
@@ -840,10 +858,15 @@ static int madvise_free_single_vma(struct vm_area_struct *vma,
  * An interface that causes the system to free clean pages and flush
  * dirty pages is already available as msync(MS_INVALIDATE).
  */
-static long madvise_dontneed_single_vma(struct vm_area_struct *vma,
+static long madvise_dontneed_single_vma(struct mmu_gather *tlb,
+					struct vm_area_struct *vma,
 					unsigned long start, unsigned long end)
 {
-	zap_page_range_single(vma, start, end - start, NULL);
+	if (tlb)
+		zap_page_range_single_batched(tlb, vma, start, end - start,
+					      NULL);
+	else
+		zap_page_range_single(vma, start, end - start, NULL);
 	return 0;
 }
 
@@ -877,10 +900,14 @@ static bool madvise_dontneed_free_valid_vma(struct vm_area_struct *vma,
 	return true;
 }
 
+/*
+ * With @tlb, MADV_DONTNEED zaps into the caller's mmu_gather and the TLB
+ * flush is left to the caller. Otherwise each VMA is flushed on its own.
+ */
 static long madvise_dontneed_free(struct vm_area_struct *vma,
 				  struct vm_area_struct **prev,
 				  unsigned long start, unsigned long end,
-				  int behavior)
+				  int behavior, struct mmu_gather *tlb)
 {
 	struct mm_struct *mm = vma->vm_mm;
 
@@ -891,6 +918,15 @@ static long madvise_dontneed_free(struct vm_area_struct *vma,
 	if (start == end)
 		return 0;
 
+	/*
+	 * userfaultfd_remove() may drop mmap_lock: don't leave the zapped
+	 * ranges unflushed while others can change the address space.
+	 */
+	if (tlb && userfaultfd_armed(vma)) {
+		tlb_finish_mmu(tlb);
+		tlb_gather_mmu(tlb, mm);
+	}
+
 	if (!userfaultfd_remove(vma, start, end)) {
 		*prev = NULL; /* mmap_lock has been dropped, prev is stale */
 
@@ -924,13 +960,127 @@ static long madvise_dontneed_free(struct vm_area_struct *vma,
 	}
 
 	if (behavior == MADV_DONTNEED || behavior == MADV_DONTNEED_LOCKED)
-		return madvise_dontneed_single_vma(vma, start, end);
+		return madvise_dontneed_single_vma(tlb, vma, start, end);
 	else if (behavior == MADV_FREE)
 		return madvise_free_single_vma(vma, start, end);
 	else
 		return -EINVAL;
 }
 
+#ifdef CONFIG_PER_VMA_LOCK
+/*
+ * MADV_DONTNEED on a range inside a single VMA only zaps page table entries,
+ * for which the per-VMA read lock is enough. Try that before mmap_lock so that
+ * threads discarding memory don't contend with page faults and mmap changes.
+ * Return -EAGAIN to fall back to the mmap_lock path.
+ */
+static int madvise_dontneed_vma_locked(struct mm_struct *mm,
+				       unsigned long start, unsigned long end,
+				       int behavior)
+{
+	struct vm_area_struct *vma;
+
+	vma = lock_vma_under_rcu(mm, start);
+	if (!vma)
+		goto fallback;
+
+	/*
+	 * userfaultfd_remove() may drop mmap_lock, hugetlb zapping needs the
+	 * hugetlb vma lock, and anything else is left for the full walk.
+	 */
+	if (end > vma->vm_end || is_vm_hugetlb_page(vma) ||
+	    userfaultfd_armed(vma) || !can_modify_vma_madv(vma, behavior) ||
+	    !madvise_dontneed_free_valid_vma(vma, start, &end, behavior)) {
+		vma_end_read(vma);
+		goto fallback;
+	}
+
+	madvise_dontneed_single_vma(NULL, vma, start, end);
+	vma_end_read(vma);
+	count_vm_vma_lock_event(VMA_LOCK_MADVISE);
+	return 0;
+
+fallback:
+	count_vm_vma_lock_event(VMA_LOCK_MADVISE_FALLBACK);
+	return -EAGAIN;
+}
+#else
+static int madvise_dontneed_vma_locked(struct mm_struct *mm,
+				       unsigned long start, unsigned long end,
+				       int behavior)
+{
+	return -EAGAIN;
+}
+#endif /* CONFIG_PER_VMA_LOCK */
+
+struct madvise_batch {
+	struct mmu_gather tlb;
+	int behavior;
+};
+
+static inline bool madvise_behavior_batched(int behavior)
+{
+	switch (behavior) {
+	case MADV_DONTNEED:
+	case MADV_DONTNEED_LOCKED:
+	case MADV_COLD:
+	case MADV_PAGEOUT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static int madvise_batch_vma(struct vm_area_struct *vma,
+			     struct vm_area_struct **prev,
+			     unsigned long start, unsigned long end,
+			     unsigned long arg)
+{
+	struct madvise_batch *batch = (void *)arg;
+
+	switch (batch->behavior) {
+	case MADV_COLD:
+		return madvise_cold(vma, prev, start, end, &batch->tlb);
+	case MADV_PAGEOUT:
+		return madvise_pageout(vma, prev, start, end, &batch->tlb);
+	default:
+		return madvise_dontneed_free(vma, prev, start, end,
+					     batch->behavior, &batch->tlb);
+	}
+}
+
+static void madvise_batch_start(struct madvise_batch *batch,
+				struct mm_struct *mm, int behavior)
+{
+	batch->behavior = behavior;
+	lru_add_drain();
+	tlb_gather_mmu(&batch->tlb, mm);
+}
+
+static void madvise_batch_finish(struct madvise_batch *batch)
+{
+	tlb_finish_mmu(&batch->tlb);
+}
+
+/*
+ * MADV_DONTNEED, MADV_COLD or MADV_PAGEOUT over a range spanning several
+ * VMAs: gather all of them into one mmu_gather, so that the range costs a
+ * single TLB shootdown instead of one per VMA.
+ */
+static int madvise_batched(struct mm_struct *mm, unsigned long start,
+			   unsigned long end, int behavior)
+{
+	struct madvise_batch batch;
+	int error;
+
+	madvise_batch_start(&batch, mm, behavior);
+	error = madvise_walk_vmas(mm, start, end, (unsigned long)&batch,
+				  madvise_batch_vma);
+	madvise_batch_finish(&batch);
+
+	return error;
+}
+
 static long madvise_populate(struct mm_struct *mm, unsigned long start,
 		unsigned long end, int behavior)
 {
@@ -1037,13 +1187,14 @@ static int madvise_vma_behavior(struct vm_area_struct *vma,
 	case MADV_WILLNEED:
 		return madvise_willneed(vma, prev, start, end);
 	case MADV_COLD:
-		return madvise_cold(vma, prev, start, end);
+		return madvise_cold(vma, prev, start, end, NULL);
 	case MADV_PAGEOUT:
-		return madvise_pageout(vma, prev, start, end);
+		return madvise_pageout(vma, prev, start, end, NULL);
 	case MADV_FREE:
 	case MADV_DONTNEED:
 	case MADV_DONTNEED_LOCKED:
-		return madvise_dontneed_free(vma, prev, start, end, behavior);
+		return madvise_dontneed_free(vma, prev, start, end, behavior,
+					     NULL);
 	case MADV_NORMAL:
 		new_flags = new_flags & ~VM_RAND_READ & ~VM_SEQ_READ;
 		break;
@@ -1331,6 +1482,24 @@ int madvise_set_anon_name(struct mm_struct *mm, unsigned long start,
 				 madvise_vma_anon_name);
 }
 #endif /* CONFIG_ANON_VMA_NAME */
+
+static int madvise_check_range(unsigned long start, size_t len_in,
+			       size_t *len)
+{
+	if (!PAGE_ALIGNED(start))
+		return -EINVAL;
+	*len = PAGE_ALIGN(len_in);
+
+	/* Check to see whether len was rounded up from small -ve to zero */
+	if (len_in && !*len)
+		return -EINVAL;
+
+	if (start + *len < start)
+		return -EINVAL;
+
+	return 0;
+}
+
 /*
  * The madvise(2) system call.
  *
@@ -1414,17 +1583,10 @@ int do_madvise(struct mm_struct *mm, unsigned long start, size_t len_in, int beh
 	if (!madvise_behavior_valid(behavior))
 		return -EINVAL;
 
-	if (!PAGE_ALIGNED(start))
-		return -EINVAL;
-	len = PAGE_ALIGN(len_in);
-
-	/* Check to see whether len was rounded up from small -ve to zero */
-	if (len_in && !len)
-		return -EINVAL;
-
+	error = madvise_check_range(start, len_in, &len);
+	if (error)
+		return error;
 	end = start + len;
-	if (end < start)
-		return -EINVAL;
 
 	if (end == start)
 		return 0;
@@ -1434,6 +1596,16 @@ int do_madvise(struct mm_struct *mm, unsigned long start, size_t len_in, int beh
 		return madvise_inject_error(behavior, start, start + len_in);
 #endif
 
+	if ((behavior == MADV_DONTNEED || behavior == MADV_DONTNEED_LOCKED) &&
+	    mm == current->mm) {
+		unsigned long ustart = untagged_addr(start);
+
+		error = madvise_dontneed_vma_locked(mm, ustart, ustart + len,
+						    behavior);
+		if (error != -EAGAIN)
+			return error;
+	}
+
 	write = madvise_need_mmap_write(behavior);
 	if (write) {
 		if (mmap_write_lock_killable(mm))
@@ -1460,6 +1632,12 @@ int do_madvise(struct mm_struct *mm, unsigned long start, size_t len_in, int beh
 	case MADV_POPULATE_WRITE:
 		error = madvise_populate(mm, start, end, behavior);
 		break;
+	case MADV_DONTNEED:
+	case MADV_DONTNEED_LOCKED:
+	case MADV_COLD:
+	case MADV_PAGEOUT:
+		error = madvise_batched(mm, start, end, behavior);
+		break;
 	default:
 		error = madvise_walk_vmas(mm, start, end, behavior,
 					  madvise_vma_behavior);
@@ -1481,6 +1659,71 @@ SYSCALL_DEFINE3(madvise, unsigned long, start, size_t, len_in, int, behavior)
 	return do_madvise(current->mm, start, len_in, behavior);
 }
 
+/*
+ * process_madvise() with MADV_COLD or MADV_PAGEOUT: take mmap_lock once and
+ * gather every range into one mmu_gather, so that a vector of many small
+ * ranges costs a single VMA lookup per range and one TLB flush, instead of
+ * a lock round trip and a flush per VMA of every range.  The lock and the
+ * gather are cycled when someone else is waiting for the lock or the CPU.
+ */
+static int vector_madvise_batched(struct mm_struct *mm, struct iov_iter *iter,
+				  int behavior)
+{
+	struct madvise_batch batch;
+	struct blk_plug plug;
+	int ret = 0;
+
+	mmap_read_lock(mm);
+	madvise_batch_start(&batch, mm, behavior);
+	blk_start_plug(&plug);
+
+	while (iov_iter_count(iter)) {
+		unsigned long start = (unsigned long)iter_iov_addr(iter);
+		size_t len;
+
+		ret = madvise_check_range(start, iter_iov_len(iter), &len);
+		if (ret)
+			break;
+
+		if (len) {
+			start = untagged_addr_remote(mm, start);
+			if (unlikely(!can_modify_mm_madv(mm, start, start + len,
+							 behavior))) {
+				ret = -EPERM;
+				break;
+			}
+			ret = madvise_walk_vmas(mm, start, start + len,
+						(unsigned long)&batch,
+						madvise_batch_vma);
+			if (ret < 0)
+				break;
+		}
+		iov_iter_advance(iter, iter_iov_len(iter));
+
+		if (!iov_iter_count(iter))
+			break;
+		if (fatal_signal_pending(current)) {
+			ret = -EINTR;
+			break;
+		}
+		if (need_resched() || mmap_lock_is_contended(mm)) {
+			blk_finish_plug(&plug);
+			madvise_batch_finish(&batch);
+			mmap_read_unlock(mm);
+			cond_resched();
+			mmap_read_lock(mm);
+			madvise_batch_start(&batch, mm, behavior);
+			blk_start_plug(&plug);
+		}
+	}
+
+	blk_finish_plug(&plug);
+	madvise_batch_finish(&batch);
+	mmap_read_unlock(mm);
+
+	return ret;
+}
+
 SYSCALL_DEFINE5(process_madvise, int, pidfd, const struct iovec __user *, vec,
 		size_t, vlen, int, behavior, unsigned int, flags)
 {
@@ -1531,12 +1774,16 @@ SYSCALL_DEFINE5(process_madvise, int, pidfd, const struct iovec __user *, vec,
 
 	total_len = iov_iter_count(&iter);
 
-	while (iov_iter_count(&iter)) {
-		ret = do_madvise(mm, (unsigned long)iter_iov_addr(&iter),
-					iter_iov_len(&iter), behavior);
-		if (ret < 0)
-			break;
-		iov_iter_advance(&iter, iter_iov_len(&iter));
+	if (madvise_behavior_batched(behavior)) {
+		ret = vector_madvise_batched(mm, &iter, behavior);
+	} else {
+		while (iov_iter_count(&iter)) {
+			ret = do_madvise(mm, (unsigned long)iter_iov_addr(&iter),
+					 iter_iov_len(&iter), behavior);
+			if (ret < 0)
+				break;
+			iov_iter_advance(&iter, iter_iov_len(&iter));
+		}
 	}
 
 	ret = (total_len - iov_iter_count(&iter)) ? : ret;
@@ -64,6 +64,7 @@
 #include <linux/resume_user_mode.h>
 #include <linux/psi.h>
 #include <linux/seq_buf.h>
+#include <linux/random.h>
 #include <linux/sched/isolation.h>
 #include <linux/kmemleak.h>
 #include "internal.h"
@@ -606,6 +607,9 @@ static const unsigned int memcg_node_stat_items[] = {
 #ifdef CONFIG_SWAP
 	NR_SWAPCACHE,
 #endif
+#ifdef CONFIG_NUMA_BALANCING
+	PGPROMOTE_SUCCESS,
+#endif
 };
 
 static const unsigned int memcg_stat_items[] = {
@@ -852,7 +856,7 @@ static inline void memcg_rstat_updated(struct mem_cgroup *memcg, int val)
 	if (!val)
 		return;
 
-	cgroup_rstat_updated(memcg->css.cgroup, cpu);
+	css_rstat_updated(&memcg->css, cpu);
 	statc = this_cpu_ptr(memcg->vmstats_percpu);
 	for (; statc; statc = statc->parent) {
 		stats_updates = READ_ONCE(statc->stats_updates) + abs(val);
@@ -876,14 +880,14 @@ static void do_flush_stats(struct mem_cgroup *memcg)
 	if (mem_cgroup_is_root(memcg))
 		WRITE_ONCE(flush_last_time, jiffies_64);
 
-	cgroup_rstat_flush(memcg->css.cgroup);
+	css_rstat_flush(&memcg->css);
 }
 
 /*
  * mem_cgroup_flush_stats - flush the stats of a memory cgroup subtree
  * @memcg: root of the subtree to flush
  *
- * Flushing is serialized by the underlying global rstat lock. There is also a
+ * Flushing is serialized by the memory controller's rstat lock. There is also a
  * minimum amount of work to be done even if there are no stat updates to flush.
  * Hence, we only flush the stats if the updates delta exceeds a threshold. This
  * avoids unnecessary work and contention on the underlying lock.
@@ -900,6 +904,27 @@ void mem_cgroup_flush_stats(struct mem_cgroup *memcg)
 		do_flush_stats(memcg);
 }
 
+/*
+ * mem_cgroup_try_flush_stats - flush the stats of a memory cgroup subtree
+ * unless a flush is already in progress
+ * @memcg: root of the subtree to flush
+ *
+ * For readers which can't or don't want to wait on the rstat lock.  If
+ * another flush holds it, the stats are read as they are.
+ */
+static void mem_cgroup_try_flush_stats(struct mem_cgroup *memcg)
+{
+	if (mem_cgroup_disabled())
+		return;
+
+	if (!memcg)
+		memcg = root_mem_cgroup;
+
+	if (memcg_vmstats_needs_flush(memcg->vmstats) &&
+	    css_rstat_try_flush(&memcg->css) && mem_cgroup_is_root(memcg))
+		WRITE_ONCE(flush_last_time, jiffies_64);
+}
+
 void mem_cgroup_flush_stats_ratelimited(struct mem_cgroup *memcg)
 {
 	/* Only flush if the periodic flusher is one full cycle late */
@@ -1273,6 +1298,24 @@ struct mem_cgroup *get_mem_cgroup_from_mm(struct mm_struct *mm)
 }
 EXPORT_SYMBOL(get_mem_cgroup_from_mm);
 
+/**
+ * get_mem_cgroup_from_folio - Obtain a reference on a given folio's memcg.
+ * @folio: folio from which memcg should be extracted.
+ */
+struct mem_cgroup *get_mem_cgroup_from_folio(struct folio *folio)
+{
+	struct mem_cgroup *memcg = folio_memcg(folio);
+
+	if (mem_cgroup_disabled())
+		return NULL;
+
+	rcu_read_lock();
+	if (!memcg || WARN_ON_ONCE(!css_tryget(&memcg->css)))
+		memcg = root_mem_cgroup;
+	rcu_read_unlock();
+	return memcg;
+}
+
 /**
  * get_mem_cgroup_from_current - Obtain a reference on current task's memcg.
  */
@@ -1744,6 +1787,9 @@ static const struct memory_stat memory_stats[] = {
 	{ "workingset_restore_anon",	WORKINGSET_RESTORE_ANON		},
 	{ "workingset_restore_file",	WORKINGSET_RESTORE_FILE		},
 	{ "workingset_nodereclaim",	WORKINGSET_NODERECLAIM		},
+#ifdef CONFIG_NUMA_BALANCING
+	{ "pgpromote_success",		PGPROMOTE_SUCCESS		},
+#endif
 };
 
 /* The actual unit of the state item, not the same as the output unit */
@@ -1777,6 +1823,9 @@ static int memcg_page_state_output_unit(int item)
 	case WORKINGSET_RESTORE_ANON:
 	case WORKINGSET_RESTORE_FILE:
 	case WORKINGSET_NODERECLAIM:
+#ifdef CONFIG_NUMA_BALANCING
+	case PGPROMOTE_SUCCESS:
+#endif
 		return 1;
 	default:
 		return memcg_page_state_unit(item);
@@ -1811,8 +1860,6 @@ static void memcg_stat_format(struct mem_cgroup *memcg, struct seq_buf *s)
 	 *
 	 * Current memory state:
 	 */
-	mem_cgroup_flush_stats(memcg);
-
 	for (i = 0; i < ARRAY_SIZE(memory_stats); i++) {
 		u64 size;
 
@@ -1852,8 +1899,19 @@ static void memcg_stat_format(struct mem_cgroup *memcg, struct seq_buf *s)
 
 static void memcg1_stat_format(struct mem_cgroup *memcg, struct seq_buf *s);
 
-static void memory_stat_format(struct mem_cgroup *memcg, struct seq_buf *s)
+/*
+ * With @nowait, don't wait for a flush of the memory stats which is already
+ * in progress.  The stats can then be stale by up to FLUSH_TIME, which is
+ * what monitoring readers polling many cgroups usually prefer over latency.
+ */
+static void memory_stat_format(struct mem_cgroup *memcg, struct seq_buf *s,
+			       bool nowait)
 {
+	if (nowait)
+		mem_cgroup_try_flush_stats(memcg);
+	else
+		mem_cgroup_flush_stats(memcg);
+
 	if (cgroup_subsys_on_dfl(memory_cgrp_subsys))
 		memcg_stat_format(memcg, s);
 	else
@@ -1919,7 +1977,7 @@ void mem_cgroup_print_oom_meminfo(struct mem_cgroup *memcg)
 	pr_cont_cgroup_path(memcg->css.cgroup);
 	pr_cont(":");
 	seq_buf_init(&s, buf, sizeof(buf));
-	memory_stat_format(memcg, &s);
+	memory_stat_format(memcg, &s, false);
 	seq_buf_do_printk(&s, KERN_INFO);
 }
 
@@ -2409,10 +2467,17 @@ void folio_memcg_unlock(struct folio *folio)
 	__folio_memcg_unlock(folio_memcg(folio));
 }
 
+/*
+ * Number of memcgs whose charges a CPU can stock at once, so that tasks of
+ * a few cgroups sharing a CPU don't keep draining each other's stock.
+ */
+#define NR_MEMCG_STOCK 7
+
 struct memcg_stock_pcp {
 	local_lock_t stock_lock;
-	struct mem_cgroup *cached; /* this never be root cgroup */
-	unsigned int nr_pages;
+	/* these never be root cgroup */
+	struct mem_cgroup *cached[NR_MEMCG_STOCK];
+	unsigned int nr_pages[NR_MEMCG_STOCK];
 
 #ifdef CONFIG_MEMCG_KMEM
 	struct obj_cgroup *cached_objcg;
@@ -2457,9 +2522,9 @@ static void memcg_account_kmem(struct mem_cgroup *memcg, int nr_pages)
  * @memcg: memcg to consume from.
  * @nr_pages: how many pages to charge.
  *
- * The charges will only happen if @memcg matches the current cpu's memcg
- * stock, and at least @nr_pages are available in that stock.  Failure to
- * service an allocation will refill the stock.
+ * The charges will only happen if @memcg is one of the current cpu's
+ * stocked memcgs, and at least @nr_pages are available in its stock.
+ * Failure to service an allocation will refill the stock.
  *
  * returns true if successful, false otherwise.
  */
@@ -2469,6 +2534,7 @@ static bool consume_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 	unsigned int stock_pages;
 	unsigned long flags;
 	bool ret = false;
+	int i;
 
 	if (nr_pages > MEMCG_CHARGE_BATCH)
 		return ret;
@@ -2476,10 +2542,16 @@ static bool consume_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 	local_lock_irqsave(&memcg_stock.stock_lock, flags);
 
 	stock = this_cpu_ptr(&memcg_stock);
-	stock_pages = READ_ONCE(stock->nr_pages);
-	if (memcg == READ_ONCE(stock->cached) && stock_pages >= nr_pages) {
-		WRITE_ONCE(stock->nr_pages, stock_pages - nr_pages);
-		ret = true;
+	for (i = 0; i < NR_MEMCG_STOCK; i++) {
+		if (memcg != READ_ONCE(stock->cached[i]))
+			continue;
+
+		stock_pages = READ_ONCE(stock->nr_pages[i]);
+		if (stock_pages >= nr_pages) {
+			WRITE_ONCE(stock->nr_pages[i], stock_pages - nr_pages);
+			ret = true;
+		}
+		break;
 	}
 
 	local_unlock_irqrestore(&memcg_stock.stock_lock, flags);
@@ -2488,12 +2560,12 @@ static bool consume_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 }
 
 /*
- * Returns stocks cached in percpu and reset cached information.
+ * Returns stocks cached in percpu slot @i and reset its cached information.
  */
-static void drain_stock(struct memcg_stock_pcp *stock)
+static void drain_stock_slot(struct memcg_stock_pcp *stock, int i)
 {
-	unsigned int stock_pages = READ_ONCE(stock->nr_pages);
-	struct mem_cgroup *old = READ_ONCE(stock->cached);
+	unsigned int stock_pages = READ_ONCE(stock->nr_pages[i]);
+	struct mem_cgroup *old = READ_ONCE(stock->cached[i]);
 
 	if (!old)
 		return;
@@ -2503,11 +2575,19 @@ static void drain_stock(struct memcg_stock_pcp *stock)
 		if (do_memsw_account())
 			page_counter_uncharge(&old->memsw, stock_pages);
 
-		WRITE_ONCE(stock->nr_pages, 0);
+		WRITE_ONCE(stock->nr_pages[i], 0);
 	}
 
 	css_put(&old->css);
-	WRITE_ONCE(stock->cached, NULL);
+	WRITE_ONCE(stock->cached[i], NULL);
+}
+
+static void drain_stock(struct memcg_stock_pcp *stock)
+{
+	int i;
+
+	for (i = 0; i < NR_MEMCG_STOCK; i++)
+		drain_stock_slot(stock, i);
 }
 
 static void drain_local_stock(struct work_struct *dummy)
@@ -2540,18 +2620,35 @@ static void __refill_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 {
 	struct memcg_stock_pcp *stock;
 	unsigned int stock_pages;
+	int i, slot = -1, empty = -1;
 
 	stock = this_cpu_ptr(&memcg_stock);
-	if (READ_ONCE(stock->cached) != memcg) { /* reset if necessary */
-		drain_stock(stock);
+	for (i = 0; i < NR_MEMCG_STOCK; i++) {
+		struct mem_cgroup *cached = READ_ONCE(stock->cached[i]);
+
+		if (cached == memcg) {
+			slot = i;
+			break;
+		}
+		if (!cached && empty < 0)
+			empty = i;
+	}
+
+	if (slot < 0) {
+		/* No free slot left: evict a random memcg's stock. */
+		if (empty < 0) {
+			empty = get_random_u32_below(NR_MEMCG_STOCK);
+			drain_stock_slot(stock, empty);
+		}
+		slot = empty;
 		css_get(&memcg->css);
-		WRITE_ONCE(stock->cached, memcg);
+		WRITE_ONCE(stock->cached[slot], memcg);
 	}
-	stock_pages = READ_ONCE(stock->nr_pages) + nr_pages;
-	WRITE_ONCE(stock->nr_pages, stock_pages);
+	stock_pages = READ_ONCE(stock->nr_pages[slot]) + nr_pages;
+	WRITE_ONCE(stock->nr_pages[slot], stock_pages);
 
 	if (stock_pages > MEMCG_CHARGE_BATCH)
-		drain_stock(stock);
+		drain_stock_slot(stock, slot);
 }
 
 static void refill_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
@@ -2586,13 +2683,18 @@ static void drain_all_stock(struct mem_cgroup *root_memcg)
 		struct memcg_stock_pcp *stock = &per_cpu(memcg_stock, cpu);
 		struct mem_cgroup *memcg;
 		bool flush = false;
+		int i;
 
 		rcu_read_lock();
-		memcg = READ_ONCE(stock->cached);
-		if (memcg && READ_ONCE(stock->nr_pages) &&
-		    mem_cgroup_is_descendant(memcg, root_memcg))
-			flush = true;
-		else if (obj_stock_flush_required(stock, root_memcg))
+		for (i = 0; i < NR_MEMCG_STOCK; i++) {
+			memcg = READ_ONCE(stock->cached[i]);
+			if (memcg && READ_ONCE(stock->nr_pages[i]) &&
+			    mem_cgroup_is_descendant(memcg, root_memcg)) {
+				flush = true;
+				break;
+			}
+		}
+		if (!flush && obj_stock_flush_required(stock, root_memcg))
 			flush = true;
 		rcu_read_unlock();
 
@@ -4509,8 +4611,6 @@ static void memcg1_stat_format(struct mem_cgroup *memcg, struct seq_buf *s)
 
 	BUILD_BUG_ON(ARRAY_SIZE(memcg1_stat_names) != ARRAY_SIZE(memcg1_stats));
 
-	mem_cgroup_flush_stats(memcg);
-
 	for (i = 0; i < ARRAY_SIZE(memcg1_stats); i++) {
 		unsigned long nr;
 
@@ -7104,7 +7204,7 @@ static int memory_stat_show(struct seq_file *m, void *v)
 	if (!buf)
 		return -ENOMEM;
 	seq_buf_init(&s, buf, PAGE_SIZE);
-	memory_stat_format(memcg, &s);
+	memory_stat_format(memcg, &s, m->file->f_flags & O_NONBLOCK);
 	seq_puts(m, buf);
 	kfree(buf);
 	return 0;
@@ -1337,11 +1337,126 @@ vma_needs_copy(struct vm_area_struct *dst_vma, struct vm_area_struct *src_vma)
 	return false;
 }
 
-int
-copy_page_range(struct vm_area_struct *dst_vma, struct vm_area_struct *src_vma)
+static int copy_pgd_range(struct vm_area_struct *dst_vma,
+			  struct vm_area_struct *src_vma,
+			  unsigned long addr, unsigned long end)
 {
 	pgd_t *src_pgd, *dst_pgd;
 	unsigned long next;
+
+	dst_pgd = pgd_offset(dst_vma->vm_mm, addr);
+	src_pgd = pgd_offset(src_vma->vm_mm, addr);
+	do {
+		next = pgd_addr_end(addr, end);
+		if (pgd_none_or_clear_bad(src_pgd))
+			continue;
+		if (unlikely(copy_p4d_range(dst_vma, src_vma, dst_pgd, src_pgd,
+					    addr, next)))
+			return -ENOMEM;
+	} while (dst_pgd++, src_pgd++, addr = next, addr != end);
+
+	return 0;
+}
+
+/*
+ * Copying the page tables of a very large VMA dominates fork latency for
+ * processes with huge populated address spaces.  Split such VMAs into
+ * PUD-aligned chunks and let unbound workers copy them concurrently: the
+ * chunks never share a page table page or split a PUD leaf (DAX), which
+ * copy_pud_range() can't handle, the upper level table allocations
+ * are already safe against concurrent populators, and both mmaps are held
+ * for write by the forking task for the whole duration.
+ */
+#define COPY_PARALLEL_MIN_CHUNK		SZ_256M
+#define COPY_PARALLEL_MAX_WORKERS	8
+
+struct copy_range_work {
+	struct work_struct work;
+	struct vm_area_struct *dst_vma;
+	struct vm_area_struct *src_vma;
+	struct mem_cgroup *memcg;
+	unsigned long addr;
+	unsigned long end;
+	int ret;
+};
+
+static void copy_range_workfn(struct work_struct *work)
+{
+	struct copy_range_work *w = container_of(work, struct copy_range_work,
+						 work);
+	struct mem_cgroup *old_memcg;
+
+	/* Page tables are __GFP_ACCOUNT: charge them like the forking task. */
+	old_memcg = set_active_memcg(w->memcg);
+	w->ret = copy_pgd_range(w->dst_vma, w->src_vma, w->addr, w->end);
+	set_active_memcg(old_memcg);
+}
+
+static int copy_pgd_range_parallel(struct vm_area_struct *dst_vma,
+				   struct vm_area_struct *src_vma,
+				   unsigned long addr, unsigned long end)
+{
+	struct copy_range_work *works;
+	struct mem_cgroup *memcg;
+	unsigned long chunk, start;
+	int i, nr, ret;
+
+	nr = min3((unsigned long)num_online_cpus(),
+		  (unsigned long)COPY_PARALLEL_MAX_WORKERS,
+		  (end - addr) / COPY_PARALLEL_MIN_CHUNK);
+	if (nr < 2)
+		return copy_pgd_range(dst_vma, src_vma, addr, end);
+
+	chunk = ALIGN(DIV_ROUND_UP(end - addr, nr), PUD_SIZE);
+	nr = DIV_ROUND_UP(end - addr, chunk);
+	if (nr < 2)
+		return copy_pgd_range(dst_vma, src_vma, addr, end);
+
+	works = kmalloc_array(nr, sizeof(*works), GFP_KERNEL);
+	if (!works)
+		return copy_pgd_range(dst_vma, src_vma, addr, end);
+
+	/*
+	 * The child isn't attached to its cgroups yet, so its mm resolves to
+	 * the root memcg. The serial copy charges the forking task's.
+	 */
+	memcg = get_mem_cgroup_from_current();
+	start = addr;
+	for (i = 0; i < nr; i++) {
+		struct copy_range_work *w = &works[i];
+
+		w->dst_vma = dst_vma;
+		w->src_vma = src_vma;
+		w->memcg = memcg;
+		w->addr = start;
+		if (i == nr - 1)
+			w->end = end;
+		else
+			w->end = ALIGN_DOWN(addr + (i + 1) * chunk, PUD_SIZE);
+		start = w->end;
+
+		/* The first chunk is copied by the forking task itself. */
+		if (i) {
+			INIT_WORK(&w->work, copy_range_workfn);
+			queue_work(system_unbound_wq, &w->work);
+		}
+	}
+
+	ret = copy_pgd_range(dst_vma, src_vma, works[0].addr, works[0].end);
+	for (i = 1; i < nr; i++) {
+		flush_work(&works[i].work);
+		if (works[i].ret)
+			ret = works[i].ret;
+	}
+
+	mem_cgroup_put(memcg);
+	kfree(works);
+	return ret;
+}
+
+int
+copy_page_range(struct vm_area_struct *dst_vma, struct vm_area_struct *src_vma)
+{
 	unsigned long addr = src_vma->vm_start;
 	unsigned long end = src_vma->vm_end;
 	struct mm_struct *dst_mm = dst_vma->vm_mm;
@@ -1389,20 +1504,9 @@ copy_page_range(struct vm_area_struct *dst_vma, struct vm_area_struct *src_vma)
 		raw_write_seqcount_begin(&src_mm->write_protect_seq);
 	}
 
-	ret = 0;
-	dst_pgd = pgd_offset(dst_mm, addr);
-	src_pgd = pgd_offset(src_mm, addr);
-	do {
-		next = pgd_addr_end(addr, end);
-		if (pgd_none_or_clear_bad(src_pgd))
-			continue;
-		if (unlikely(copy_p4d_range(dst_vma, src_vma, dst_pgd, src_pgd,
-					    addr, next))) {
-			untrack_pfn_clear(dst_vma);
-			ret = -ENOMEM;
-			break;
-		}
-	} while (dst_pgd++, src_pgd++, addr = next, addr != end);
+	ret = copy_pgd_range_parallel(dst_vma, src_vma, addr, end);
+	if (ret)
+		untrack_pfn_clear(dst_vma);
 
 	if (is_cow) {
 		raw_write_seqcount_end(&src_mm->write_protect_seq);
@@ -1891,36 +1995,67 @@ void unmap_vmas(struct mmu_gather *tlb, struct ma_state *mas,
 }
 
 /**
- * zap_page_range_single - remove user pages in a given range
+ * zap_page_range_single_batched - remove user pages in a given range
+ * @tlb: pointer to the caller's struct mmu_gather
  * @vma: vm_area_struct holding the applicable pages
- * @address: starting address of pages to zap
- * @size: number of bytes to zap
+ * @address: starting address of pages to remove
+ * @size: number of bytes to remove
  * @details: details of shared cache invalidation
  *
- * The range must fit into one VMA.
+ * @tlb shouldn't be NULL.  The range must fit into one VMA.  The TLB flush
+ * and the freeing of the pages are left to the caller's tlb_finish_mmu(),
+ * so several ranges can share one flush; hugetlb ranges are flushed right
+ * away.
  */
-void zap_page_range_single(struct vm_area_struct *vma, unsigned long address,
+void zap_page_range_single_batched(struct mmu_gather *tlb,
+		struct vm_area_struct *vma, unsigned long address,
 		unsigned long size, struct zap_details *details)
 {
 	const unsigned long end = address + size;
 	struct mmu_notifier_range range;
-	struct mmu_gather tlb;
 
-	lru_add_drain();
+	VM_WARN_ON_ONCE(tlb->mm != vma->vm_mm);
+
 	mmu_notifier_range_init(&range, MMU_NOTIFY_CLEAR, 0, vma->vm_mm,
 				address, end);
 	hugetlb_zap_begin(vma, &range.start, &range.end);
-	tlb_gather_mmu(&tlb, vma->vm_mm);
 	update_hiwater_rss(vma->vm_mm);
 	mmu_notifier_invalidate_range_start(&range);
 	/*
 	 * unmap 'address-end' not 'range.start-range.end' as range
 	 * could have been expanded for hugetlb pmd sharing.
 	 */
-	unmap_single_vma(&tlb, vma, address, end, details, false);
+	unmap_single_vma(tlb, vma, address, end, details, false);
 	mmu_notifier_invalidate_range_end(&range);
+	if (is_vm_hugetlb_page(vma)) {
+		/*
+		 * Flush and free the pages before hugetlb_zap_end() drops the
+		 * hugetlb locks, so that concurrent faults can reuse them.
+		 */
+		tlb_finish_mmu(tlb);
+		hugetlb_zap_end(vma, details);
+		tlb_gather_mmu(tlb, vma->vm_mm);
+	}
+}
+
+/**
+ * zap_page_range_single - remove user pages in a given range
+ * @vma: vm_area_struct holding the applicable pages
+ * @address: starting address of pages to zap
+ * @size: number of bytes to zap
+ * @details: details of shared cache invalidation
+ *
+ * The range must fit into one VMA.
+ */
+void zap_page_range_single(struct vm_area_struct *vma, unsigned long address,
+		unsigned long size, struct zap_details *details)
+{
+	struct mmu_gather tlb;
+
+	lru_add_drain();
+	tlb_gather_mmu(&tlb, vma->vm_mm);
+	zap_page_range_single_batched(&tlb, vma, address, size, details);
 	tlb_finish_mmu(&tlb);
-	hugetlb_zap_end(vma, details);
 }
 
 /**
@@ -4832,6 +4967,46 @@ static int __init fault_around_debugfs(void)
 late_initcall(fault_around_debugfs);
 #endif
 
+/*
+ * vma->fault_around_info holds the page number of the last fault-around in the
+ * VMA and, in the low bits, the window order plus one (zero means no fault has
+ * been seen yet).
+ */
+#define FAULT_AROUND_ORDER_BITS		4
+#define FAULT_AROUND_ORDER_MASK		((1UL << FAULT_AROUND_ORDER_BITS) - 1)
+
+/*
+ * Size the fault-around window for this fault. It starts at
+ * fault_around_pages, doubles (up to fault_around_pages) when the fault lands
+ * next to the window mapped by the previous one, and halves down to a single
+ * page when it doesn't, so sparsely accessed mappings don't pay for mapping
+ * pages that won't be touched.
+ */
+static pgoff_t fault_around_window(struct vm_fault *vmf)
+{
+	unsigned int max_order = ilog2(READ_ONCE(fault_around_pages));
+	unsigned long pfn = vmf->address >> PAGE_SHIFT;
+	unsigned long info, last;
+	unsigned int order;
+
+	info = atomic_long_read(&vmf->vma->fault_around_info);
+	if (!info) {
+		order = max_order;
+	} else {
+		order = (info & FAULT_AROUND_ORDER_MASK) - 1;
+		last = info >> FAULT_AROUND_ORDER_BITS;
+		if (abs_diff(pfn, last) <= 2UL << order)
+			order++;
+		else if (order)
+			order--;
+		order = min(order, max_order);
+	}
+
+	atomic_long_set(&vmf->vma->fault_around_info,
+			(pfn << FAULT_AROUND_ORDER_BITS) | (order + 1));
+	return 1UL << order;
+}
+
 /*
  * do_fault_around() tries to map few pages around the fault address. The hope
  * is that the pages will be needed soon and this will lower the number of
@@ -4843,18 +5018,19 @@ late_initcall(fault_around_debugfs);
  * This function doesn't cross VMA or page table boundaries, in order to call
  * map_pages() and acquire a PTE lock only once.
  *
- * fault_around_pages defines how many pages we'll try to map.
+ * fault_around_pages defines the maximum number of pages we'll try to map.
  * do_fault_around() expects it to be set to a power of two less than or equal
- * to PTRS_PER_PTE.
+ * to PTRS_PER_PTE. The window actually used adapts to the VMA's fault pattern,
+ * see fault_around_window().
  *
  * The virtual address of the area that we map is naturally aligned to
- * fault_around_pages * PAGE_SIZE rounded down to the machine page size
- * (and therefore to page order).  This way it's easier to guarantee
- * that we don't cross page table boundaries.
+ * the window size rounded down to the machine page size (and therefore to
+ * page order).  This way it's easier to guarantee that we don't cross page
+ * table boundaries.
  */
 static vm_fault_t do_fault_around(struct vm_fault *vmf)
 {
-	pgoff_t nr_pages = READ_ONCE(fault_around_pages);
+	pgoff_t nr_pages = fault_around_window(vmf);
 	pgoff_t pte_off = pte_index(vmf->address);
 	/* The page offset of vmf->address within the VMA. */
 	pgoff_t vma_off = vmf->pgoff - vmf->vma->vm_pgoff;
@@ -50,6 +50,7 @@
 #include <linux/random.h>
 #include <linux/sched/sysctl.h>
 #include <linux/memory-tiers.h>
+#include <linux/srcu.h>
 
 #include <asm/tlbflush.h>
 
@@ -660,9 +661,73 @@ void folio_migrate_flags(struct folio *newfolio, struct folio *folio)
 }
 EXPORT_SYMBOL(folio_migrate_flags);
 
+static const struct migrate_copy_ops __rcu *migrate_copy_ops;
+static DEFINE_STATIC_KEY_FALSE(migrate_copy_offload);
+DEFINE_STATIC_SRCU(migrate_copy_srcu);
+static DEFINE_MUTEX(migrate_copy_mutex);
+
+/**
+ * migrate_register_copy_ops - Offload migration copies to a copy engine.
+ * @ops: The copy backend.
+ *
+ * Only one backend can be registered at a time.
+ *
+ * Return: 0 on success, -EBUSY if another backend is already registered.
+ */
+int migrate_register_copy_ops(const struct migrate_copy_ops *ops)
+{
+	int ret = 0;
+
+	mutex_lock(&migrate_copy_mutex);
+	if (rcu_access_pointer(migrate_copy_ops)) {
+		ret = -EBUSY;
+	} else {
+		rcu_assign_pointer(migrate_copy_ops, ops);
+		static_branch_enable(&migrate_copy_offload);
+	}
+	mutex_unlock(&migrate_copy_mutex);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(migrate_register_copy_ops);
+
+/**
+ * migrate_unregister_copy_ops - Stop offloading migration copies.
+ * @ops: The copy backend passed to migrate_register_copy_ops().
+ *
+ * On return, no copy through @ops is in flight anymore.
+ */
+void migrate_unregister_copy_ops(const struct migrate_copy_ops *ops)
+{
+	mutex_lock(&migrate_copy_mutex);
+	if (rcu_access_pointer(migrate_copy_ops) == ops) {
+		static_branch_disable(&migrate_copy_offload);
+		RCU_INIT_POINTER(migrate_copy_ops, NULL);
+		synchronize_srcu(&migrate_copy_srcu);
+	}
+	mutex_unlock(&migrate_copy_mutex);
+}
+EXPORT_SYMBOL_GPL(migrate_unregister_copy_ops);
+
+static bool folio_copy_offload(struct folio *dst, struct folio *src)
+{
+	const struct migrate_copy_ops *ops;
+	bool copied = false;
+	int idx;
+
+	idx = srcu_read_lock(&migrate_copy_srcu);
+	ops = srcu_dereference(migrate_copy_ops, &migrate_copy_srcu);
+	if (ops && folio_order(src) >= ops->min_order)
+		copied = !ops->copy(dst, src);
+	srcu_read_unlock(&migrate_copy_srcu, idx);
+
+	return copied;
+}
+
 void folio_migrate_copy(struct folio *newfolio, struct folio *folio)
 {
-	folio_copy(newfolio, folio);
+	if (!static_branch_unlikely(&migrate_copy_offload) ||
+	    !folio_copy_offload(newfolio, folio))
+		folio_copy(newfolio, folio);
 	folio_migrate_flags(newfolio, folio);
 }
 EXPORT_SYMBOL(folio_migrate_copy);
@@ -2613,6 +2678,9 @@ int migrate_misplaced_folio(struct folio *folio, struct vm_area_struct *vma,
 	unsigned int nr_succeeded;
 	LIST_HEAD(migratepages);
 	int nr_pages = folio_nr_pages(folio);
+	bool promotion = !node_is_toptier(folio_nid(folio)) &&
+			 node_is_toptier(node);
+	struct mem_cgroup *memcg;
 
 	/*
 	 * Don't migrate file folios that are mapped in multiple processes
@@ -2636,6 +2704,8 @@ int migrate_misplaced_folio(struct folio *folio, struct vm_area_struct *vma,
 	if (!isolated)
 		goto out;
 
+	/* the folio may be freed by the migration, keep its memcg around */
+	memcg = get_mem_cgroup_from_folio(folio);
 	list_add(&folio->lru, &migratepages);
 	nr_remaining = migrate_pages(&migratepages, alloc_misplaced_dst_folio,
 				     NULL, node, MIGRATE_ASYNC,
@@ -2651,10 +2721,11 @@ int migrate_misplaced_folio(struct folio *folio, struct vm_area_struct *vma,
 	}
 	if (nr_succeeded) {
 		count_vm_numa_events(NUMA_PAGE_MIGRATE, nr_succeeded);
-		if (!node_is_toptier(folio_nid(folio)) && node_is_toptier(node))
-			mod_node_page_state(pgdat, PGPROMOTE_SUCCESS,
-					    nr_succeeded);
+		if (promotion)
+			mod_lruvec_state(mem_cgroup_lruvec(memcg, pgdat),
+					 PGPROMOTE_SUCCESS, nr_succeeded);
 	}
+	mem_cgroup_put(memcg);
 	BUG_ON(!list_empty(&migratepages));
 	return isolated;
 
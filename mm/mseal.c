@@ -107,6 +107,22 @@ bool can_modify_mm_madv(struct mm_struct *mm, unsigned long start, unsigned long
 	return true;
 }
 
+/*
+ * Check if a single vma is allowed to be modified by madvise, for callers
+ * holding only the vma lock.
+ * return true, if it is allowed.
+ */
+bool can_modify_vma_madv(struct vm_area_struct *vma, int behavior)
+{
+	if (!is_madv_discard(behavior))
+		return true;
+
+	if (unlikely(is_ro_anon(vma) && !can_modify_vma(vma)))
+		return false;
+
+	return true;
+}
+
 static int mseal_fixup(struct vma_iterator *vmi, struct vm_area_struct *vma,
 		struct vm_area_struct **prev, unsigned long start,
 		unsigned long end, vm_flags_t newflags)
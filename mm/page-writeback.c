@@ -35,6 +35,7 @@
 #include <linux/syscalls.h>
 #include <linux/pagevec.h>
 #include <linux/timer.h>
+#include <linux/hrtimer.h>
 #include <linux/sched/rt.h>
 #include <linux/sched/signal.h>
 #include <linux/mm_inline.h>
@@ -1703,6 +1704,23 @@ static inline void wb_dirty_limits(struct dirty_throttle_control *dtc)
 	}
 }
 
+/*
+ * Sleep for the computed dirty pause with hrtimer precision.  A jiffy-sized
+ * timer would round short pauses to the tick, which on fast devices either
+ * leaves the dirtier idle while the device drains or lets it overshoot its
+ * rate limit.
+ */
+static void balance_dirty_pages_sleep(u64 pause_ns)
+{
+	ktime_t expires = ns_to_ktime(pause_ns);
+	int token;
+
+	token = io_schedule_prepare();
+	schedule_hrtimeout_range(&expires, current->timer_slack_ns,
+				 HRTIMER_MODE_REL);
+	io_schedule_finish(token);
+}
+
 /*
  * balance_dirty_pages() must be called by processes which are generating dirty
  * data.  It looks at the number of dirty pages in the machine and will force
@@ -1722,6 +1740,8 @@ static int balance_dirty_pages(struct bdi_writeback *wb,
 	unsigned long nr_dirty;
 	long period;
 	long pause;
+	u64 period_ns;
+	u64 pause_ns;
 	long max_pause;
 	long min_pause;
 	int nr_dirtied_pause;
@@ -1902,12 +1922,15 @@ static int balance_dirty_pages(struct bdi_writeback *wb,
 					 task_ratelimit, dirty_ratelimit,
 					 &nr_dirtied_pause);
 
+		pause_ns = 0;
 		if (unlikely(task_ratelimit == 0)) {
 			period = max_pause;
 			pause = max_pause;
 			goto pause;
 		}
-		period = HZ * pages_dirtied / task_ratelimit;
+		period_ns = div_u64((u64)NSEC_PER_SEC * pages_dirtied,
+				    task_ratelimit);
+		period = div_u64(period_ns, TICK_NSEC);
 		pause = period;
 		if (current->dirty_paused_when)
 			pause -= now - current->dirty_paused_when;
@@ -1945,6 +1968,9 @@ static int balance_dirty_pages(struct bdi_writeback *wb,
 			/* for occasional dropped task_ratelimit */
 			now += min(pause - max_pause, max_pause);
 			pause = max_pause;
+		} else {
+			/* don't round the period down to whole jiffies */
+			pause_ns = period_ns - (u64)period * TICK_NSEC;
 		}
 
 pause:
@@ -1966,7 +1992,7 @@ static int balance_dirty_pages(struct bdi_writeback *wb,
 		}
 		__set_current_state(TASK_KILLABLE);
 		bdi->last_bdp_sleep = jiffies;
-		io_schedule_timeout(pause);
+		balance_dirty_pages_sleep(jiffies_to_nsecs(pause) + pause_ns);
 
 		current->dirty_paused_when = now + pause;
 		current->nr_dirtied = 0;
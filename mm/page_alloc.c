@@ -502,16 +502,40 @@ static void bad_page(struct page *page, const char *reason)
 	add_taint(TAINT_BAD_PAGE, LOCKDEP_NOW_UNRELIABLE);
 }
 
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+#define PCP_MTHP_MIN_ORDER	(PAGE_ALLOC_COSTLY_ORDER + 1)
+#define PCP_MTHP_MAX_ORDER	(PAGE_ALLOC_COSTLY_ORDER + NR_PCP_MTHP_ORDERS)
+/* mTHP orders kept on the pcp lists, see "pcp_mthp_orders=" */
+static unsigned long pcp_mthp_orders __read_mostly =
+	GENMASK(PCP_MTHP_MAX_ORDER, PCP_MTHP_MIN_ORDER);
+
+static int __init pcp_mthp_orders_setup(char *str)
+{
+	unsigned long orders;
+
+	if (kstrtoul(str, 0, &orders))
+		return -EINVAL;
+
+	pcp_mthp_orders = orders & GENMASK(PCP_MTHP_MAX_ORDER, PCP_MTHP_MIN_ORDER);
+	return 0;
+}
+early_param("pcp_mthp_orders", pcp_mthp_orders_setup);
+#endif
+
 static inline unsigned int order_to_pindex(int migratetype, int order)
 {
 	bool __maybe_unused movable;
 
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
 	if (order > PAGE_ALLOC_COSTLY_ORDER) {
-		VM_BUG_ON(order != HPAGE_PMD_ORDER);
-
 		movable = migratetype == MIGRATE_MOVABLE;
 
+		if (order != HPAGE_PMD_ORDER) {
+			VM_BUG_ON(order > PCP_MTHP_MAX_ORDER);
+			return NR_LOWORDER_PCP_LISTS + NR_PCP_THP +
+			       2 * (order - PCP_MTHP_MIN_ORDER) + movable;
+		}
+
 		return NR_LOWORDER_PCP_LISTS + movable;
 	}
 #else
@@ -526,7 +550,10 @@ static inline int pindex_to_order(unsigned int pindex)
 	int order = pindex / MIGRATE_PCPTYPES;
 
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
-	if (pindex >= NR_LOWORDER_PCP_LISTS)
+	if (pindex >= NR_LOWORDER_PCP_LISTS + NR_PCP_THP)
+		order = PCP_MTHP_MIN_ORDER +
+			(pindex - NR_LOWORDER_PCP_LISTS - NR_PCP_THP) / 2;
+	else if (pindex >= NR_LOWORDER_PCP_LISTS)
 		order = HPAGE_PMD_ORDER;
 #else
 	VM_BUG_ON(order > PAGE_ALLOC_COSTLY_ORDER);
@@ -535,13 +562,25 @@ static inline int pindex_to_order(unsigned int pindex)
 	return order;
 }
 
+static inline bool pcp_thp_order(unsigned int order)
+{
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+	return order == HPAGE_PMD_ORDER;
+#else
+	return false;
+#endif
+}
+
 static inline bool pcp_allowed_order(unsigned int order)
 {
 	if (order <= PAGE_ALLOC_COSTLY_ORDER)
 		return true;
-#ifdef CONFIG_TRANSPARENT_HUGEPAGE
-	if (order == HPAGE_PMD_ORDER)
+	if (pcp_thp_order(order))
 		return true;
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+	/* Never overlap the THP lists with the mTHP ones */
+	if (order <= PCP_MTHP_MAX_ORDER && order < HPAGE_PMD_ORDER)
+		return pcp_mthp_orders & BIT(order);
 #endif
 	return false;
 }
@@ -687,8 +726,12 @@ static inline void __del_page_from_free_list(struct page *page, struct zone *zon
 		     get_pageblock_migratetype(page), migratetype, 1 << order);
 
 	/* clear reported state and update reported page count */
-	if (page_reported(page))
+	if (page_reported(page)) {
 		__ClearPageReported(page);
+#ifdef CONFIG_PAGE_REPORTING
+		__count_vm_events(PAGE_REPORTED_REUSED, 1 << order);
+#endif
+	}
 
 	list_del(&page->buddy_list);
 	__ClearPageBuddy(page);
@@ -2545,9 +2588,10 @@ static void free_unref_page_commit(struct zone *zone, struct per_cpu_pages *pcp,
 	 * As high-order pages other than THP's stored on PCP can contribute
 	 * to fragmentation, limit the number stored when PCP is heavily
 	 * freeing without allocation. The remainder after bulk freeing
-	 * stops will be drained from vmstat refresh context.
+	 * stops will be drained from vmstat refresh context. This also
+	 * bounds the mTHP lists, which otherwise share the pcp high mark.
 	 */
-	if (order && order <= PAGE_ALLOC_COSTLY_ORDER) {
+	if (order && !pcp_thp_order(order)) {
 		free_high = (pcp->free_count >= batch &&
 			     (pcp->flags & PCPF_PREV_FREE_HIGH_ORDER) &&
 			     (!(pcp->flags & PCPF_FREE_HIGH_BATCH) ||
@@ -4209,6 +4253,10 @@ __alloc_pages_slowpath(gfp_t gfp_mask, unsigned int order,
 	if (alloc_flags & ALLOC_KSWAPD)
 		wake_all_kswapds(order, gfp_mask, ac);
 
+	if (order)
+		compaction_note_demand(zone_pgdat(ac->preferred_zoneref->zone),
+				       order);
+
 	/*
 	 * The adjusted alloc_flags might result in immediate success, so try
 	 * that first
@@ -69,6 +69,7 @@
 #define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
 
 #include <linux/bitmap.h>
+#include <linux/cpuhotplug.h>
 #include <linux/cpumask.h>
 #include <linux/memblock.h>
 #include <linux/err.h>
@@ -79,6 +80,7 @@
 #include <linux/mutex.h>
 #include <linux/percpu.h>
 #include <linux/pfn.h>
+#include <linux/shrinker.h>
 #include <linux/slab.h>
 #include <linux/spinlock.h>
 #include <linux/vmalloc.h>
@@ -1725,6 +1727,191 @@ static void pcpu_alloc_tag_free_hook(struct pcpu_chunk *chunk, int off, size_t s
 }
 #endif
 
+/*
+ * Per-cpu cache of recently freed small areas.  Freed areas of the common
+ * power-of-two sizes are parked here still allocated in their chunk, so a
+ * later allocation of the same size can take one without touching
+ * pcpu_alloc_mutex or pcpu_lock and without needing populated free pages.
+ * The caches are handed back to the chunks by the balance work once an
+ * atomic allocation has failed, when their CPU goes offline and under
+ * memory pressure.
+ */
+#define PCPU_CACHE_MAX_SHIFT	6	/* 64 bytes */
+#define PCPU_CACHE_NR_CLASSES	(PCPU_CACHE_MAX_SHIFT - PCPU_MIN_ALLOC_SHIFT + 1)
+#define PCPU_CACHE_DEPTH	16
+
+struct pcpu_area_cache {
+	spinlock_t lock;
+	unsigned int nr[PCPU_CACHE_NR_CLASSES];
+	void __percpu *areas[PCPU_CACHE_NR_CLASSES][PCPU_CACHE_DEPTH];
+};
+
+static DEFINE_PER_CPU(struct pcpu_area_cache, pcpu_area_cache) = {
+	.lock = __SPIN_LOCK_UNLOCKED(pcpu_area_cache.lock),
+};
+
+static int pcpu_cache_class(size_t size, size_t align)
+{
+	if (!is_power_of_2(size) || size > (1 << PCPU_CACHE_MAX_SHIFT) ||
+	    align > size)
+		return -1;
+
+	return ilog2(size) - PCPU_MIN_ALLOC_SHIFT;
+}
+
+static void __percpu *pcpu_cache_get(int class)
+{
+	struct pcpu_area_cache *cache;
+	void __percpu *ptr = NULL;
+	unsigned long flags;
+
+	/* Migrating after this just means using another CPU's cache. */
+	cache = raw_cpu_ptr(&pcpu_area_cache);
+
+	spin_lock_irqsave(&cache->lock, flags);
+	if (cache->nr[class])
+		ptr = cache->areas[class][--cache->nr[class]];
+	spin_unlock_irqrestore(&cache->lock, flags);
+
+	return ptr;
+}
+
+static bool pcpu_cache_put(struct pcpu_chunk *chunk, int off, size_t size,
+			   void __percpu *ptr)
+{
+	struct pcpu_area_cache *cache;
+	unsigned long flags;
+	bool cached = false;
+	int class;
+
+	class = pcpu_cache_class(size, size);
+	if (class < 0 || !IS_ALIGNED(off, size) || chunk == pcpu_reserved_chunk)
+		return false;
+
+	cache = raw_cpu_ptr(&pcpu_area_cache);
+
+	spin_lock_irqsave(&cache->lock, flags);
+	if (cache->nr[class] < PCPU_CACHE_DEPTH) {
+		cache->areas[class][cache->nr[class]++] = ptr;
+		cached = true;
+	}
+	spin_unlock_irqrestore(&cache->lock, flags);
+
+	return cached;
+}
+
+/* Lockless size lookup, valid as long as the area is still allocated. */
+static int pcpu_area_size(struct pcpu_chunk *chunk, int off)
+{
+	unsigned long bit_off, end;
+
+	bit_off = off / PCPU_MIN_ALLOC_SIZE;
+	end = find_next_bit(chunk->bound_map, pcpu_chunk_map_bits(chunk),
+			    bit_off + 1);
+	return (end - bit_off) * PCPU_MIN_ALLOC_SIZE;
+}
+
+/**
+ * pcpu_release_area - return an area to its chunk
+ * @chunk: chunk of interest
+ * @off: offset of the area into @chunk
+ *
+ * Frees the area at @off and works out whether @chunk became a candidate
+ * for the balance work to reclaim.
+ *
+ * CONTEXT:
+ * pcpu_lock.
+ *
+ * RETURNS:
+ * %true if the balance work should be scheduled.
+ */
+static bool pcpu_release_area(struct pcpu_chunk *chunk, int off)
+{
+	bool need_balance = false;
+
+	lockdep_assert_held(&pcpu_lock);
+
+	pcpu_free_area(chunk, off);
+
+	/*
+	 * If there are more than one fully free chunks, wake up grim reaper.
+	 * If the chunk is isolated, it may be in the process of being
+	 * reclaimed.  Let reclaim manage cleaning up of that chunk.
+	 */
+	if (!chunk->isolated && chunk->free_bytes == pcpu_unit_size) {
+		struct pcpu_chunk *pos;
+
+		list_for_each_entry(pos, &pcpu_chunk_lists[pcpu_free_slot], list)
+			if (pos != chunk) {
+				need_balance = true;
+				break;
+			}
+	} else if (pcpu_should_reclaim_chunk(chunk)) {
+		pcpu_isolate_chunk(chunk);
+		need_balance = true;
+	}
+
+	return need_balance;
+}
+
+/**
+ * pcpu_cache_drain_cpu - give a CPU's cached areas back to their chunks
+ * @cpu: cpu whose cache is drained
+ * @need_balance: set to %true if the balance work should be scheduled
+ *
+ * CONTEXT:
+ * pcpu_lock.
+ *
+ * RETURNS:
+ * The number of areas released.
+ */
+static unsigned long pcpu_cache_drain_cpu(unsigned int cpu, bool *need_balance)
+{
+	struct pcpu_area_cache *cache = per_cpu_ptr(&pcpu_area_cache, cpu);
+	struct pcpu_chunk *chunk;
+	unsigned long nr = 0;
+	int class;
+	void *addr;
+
+	lockdep_assert_held(&pcpu_lock);
+
+	spin_lock(&cache->lock);
+	for (class = 0; class < PCPU_CACHE_NR_CLASSES; class++) {
+		while (cache->nr[class]) {
+			addr = __pcpu_ptr_to_addr(
+				cache->areas[class][--cache->nr[class]]);
+			chunk = pcpu_chunk_addr_search(addr);
+			if (pcpu_release_area(chunk, addr - chunk->base_addr))
+				*need_balance = true;
+			nr++;
+		}
+	}
+	spin_unlock(&cache->lock);
+
+	return nr;
+}
+
+/**
+ * pcpu_cache_drain - give all cached areas back to their chunks
+ * @need_balance: set to %true if the balance work should be scheduled
+ *
+ * CONTEXT:
+ * pcpu_lock.
+ *
+ * RETURNS:
+ * The number of areas released.
+ */
+static unsigned long pcpu_cache_drain(bool *need_balance)
+{
+	unsigned long nr = 0;
+	unsigned int cpu;
+
+	for_each_possible_cpu(cpu)
+		nr += pcpu_cache_drain_cpu(cpu, need_balance);
+
+	return nr;
+}
+
 /**
  * pcpu_alloc - the percpu allocator
  * @size: size of area to allocate in bytes
@@ -1784,6 +1971,19 @@ void __percpu *pcpu_alloc_noprof(size_t size, size_t align, bool reserved,
 	if (unlikely(!pcpu_memcg_pre_alloc_hook(size, gfp, &objcg)))
 		return NULL;
 
+	if (!reserved) {
+		int class = pcpu_cache_class(size, align);
+
+		ptr = class >= 0 ? pcpu_cache_get(class) : NULL;
+		if (ptr) {
+			void *addr = __pcpu_ptr_to_addr(ptr);
+
+			chunk = pcpu_chunk_addr_search(addr);
+			off = addr - chunk->base_addr;
+			goto area_ready;
+		}
+	}
+
 	if (!is_atomic) {
 		/*
 		 * pcpu_balance_workfn() allocates memory under this mutex,
@@ -1894,6 +2094,7 @@ void __percpu *pcpu_alloc_noprof(size_t size, size_t align, bool reserved,
 	if (pcpu_nr_empty_pop_pages < PCPU_EMPTY_POP_PAGES_LOW)
 		pcpu_schedule_balance_work();
 
+area_ready:
 	/* clear the areas and return address relative to base address */
 	for_each_possible_cpu(cpu)
 		memset((void *)pcpu_chunk_addr(chunk, cpu, 0) + off, 0, size);
@@ -2207,6 +2408,14 @@ static void pcpu_balance_workfn(struct work_struct *work)
 	mutex_lock(&pcpu_alloc_mutex);
 	spin_lock_irq(&pcpu_lock);
 
+	/* Cached areas are stranded free space when atomic allocs fail. */
+	if (pcpu_atomic_alloc_failed) {
+		bool need_balance = false;
+
+		/* the balancing below runs regardless */
+		pcpu_cache_drain(&need_balance);
+	}
+
 	pcpu_balance_free(false);
 	pcpu_reclaim_populated();
 	pcpu_balance_populated();
@@ -2232,7 +2441,6 @@ static void pcpu_balance_workfn(struct work_struct *work)
 size_t pcpu_alloc_size(void __percpu *ptr)
 {
 	struct pcpu_chunk *chunk;
-	unsigned long bit_off, end;
 	void *addr;
 
 	if (!ptr)
@@ -2241,10 +2449,7 @@ size_t pcpu_alloc_size(void __percpu *ptr)
 	addr = __pcpu_ptr_to_addr(ptr);
 	/* No pcpu_lock here: ptr has not been freed, so chunk is still alive */
 	chunk = pcpu_chunk_addr_search(addr);
-	bit_off = (addr - chunk->base_addr) / PCPU_MIN_ALLOC_SIZE;
-	end = find_next_bit(chunk->bound_map, pcpu_chunk_map_bits(chunk),
-			    bit_off + 1);
-	return (end - bit_off) * PCPU_MIN_ALLOC_SIZE;
+	return pcpu_area_size(chunk, addr - chunk->base_addr);
 }
 
 /**
@@ -2272,32 +2477,20 @@ void free_percpu(void __percpu *ptr)
 	addr = __pcpu_ptr_to_addr(ptr);
 	chunk = pcpu_chunk_addr_search(addr);
 	off = addr - chunk->base_addr;
-
-	spin_lock_irqsave(&pcpu_lock, flags);
-	size = pcpu_free_area(chunk, off);
+	size = pcpu_area_size(chunk, off);
 
 	pcpu_alloc_tag_free_hook(chunk, off, size);
 
 	pcpu_memcg_free_hook(chunk, off, size);
 
-	/*
-	 * If there are more than one fully free chunks, wake up grim reaper.
-	 * If the chunk is isolated, it may be in the process of being
-	 * reclaimed.  Let reclaim manage cleaning up of that chunk.
-	 */
-	if (!chunk->isolated && chunk->free_bytes == pcpu_unit_size) {
-		struct pcpu_chunk *pos;
-
-		list_for_each_entry(pos, &pcpu_chunk_lists[pcpu_free_slot], list)
-			if (pos != chunk) {
-				need_balance = true;
-				break;
-			}
-	} else if (pcpu_should_reclaim_chunk(chunk)) {
-		pcpu_isolate_chunk(chunk);
-		need_balance = true;
+	if (pcpu_cache_put(chunk, off, size, ptr)) {
+		trace_percpu_free_percpu(chunk->base_addr, off, ptr);
+		return;
 	}
 
+	spin_lock_irqsave(&pcpu_lock, flags);
+	need_balance = pcpu_release_area(chunk, off);
+
 	trace_percpu_free_percpu(chunk->base_addr, off, ptr);
 
 	spin_unlock_irqrestore(&pcpu_lock, flags);
@@ -3435,3 +3628,77 @@ static int __init percpu_enable_async(void)
 	return 0;
 }
 subsys_initcall(percpu_enable_async);
+
+/* A dead CPU's cache would otherwise keep its areas until the CPU returns. */
+static int pcpu_cache_cpu_dead(unsigned int cpu)
+{
+	bool need_balance = false;
+
+	spin_lock_irq(&pcpu_lock);
+	pcpu_cache_drain_cpu(cpu, &need_balance);
+	spin_unlock_irq(&pcpu_lock);
+
+	if (need_balance)
+		pcpu_schedule_balance_work();
+
+	return 0;
+}
+
+static unsigned long pcpu_cache_shrink_count(struct shrinker *shrink,
+					     struct shrink_control *sc)
+{
+	unsigned long nr = 0;
+	unsigned int cpu;
+	int class;
+
+	for_each_possible_cpu(cpu) {
+		struct pcpu_area_cache *cache = per_cpu_ptr(&pcpu_area_cache, cpu);
+
+		for (class = 0; class < PCPU_CACHE_NR_CLASSES; class++)
+			nr += READ_ONCE(cache->nr[class]);
+	}
+
+	return nr ?: SHRINK_EMPTY;
+}
+
+/*
+ * Cached areas pin their chunks' pages.  Hand them back so the balance work
+ * can depopulate and free chunks that became empty.
+ */
+static unsigned long pcpu_cache_shrink_scan(struct shrinker *shrink,
+					    struct shrink_control *sc)
+{
+	bool need_balance = false;
+	unsigned long nr;
+
+	spin_lock_irq(&pcpu_lock);
+	nr = pcpu_cache_drain(&need_balance);
+	spin_unlock_irq(&pcpu_lock);
+
+	if (need_balance)
+		pcpu_schedule_balance_work();
+
+	return nr ?: SHRINK_STOP;
+}
+
+static int __init pcpu_cache_init(void)
+{
+	struct shrinker *shrinker;
+	int ret;
+
+	ret = cpuhp_setup_state_nocalls(CPUHP_BP_PREPARE_DYN, "mm/percpu:dead",
+					NULL, pcpu_cache_cpu_dead);
+	if (ret < 0)
+		return ret;
+
+	shrinker = shrinker_alloc(0, "percpu-area-cache");
+	if (!shrinker)
+		return -ENOMEM;
+
+	shrinker->count_objects = pcpu_cache_shrink_count;
+	shrinker->scan_objects = pcpu_cache_shrink_scan;
+	shrinker_register(shrinker);
+
+	return 0;
+}
+subsys_initcall(pcpu_cache_init);
@@ -30,16 +30,39 @@ static int process_vm_rw_pages(struct page **pages,
 			       struct iov_iter *iter,
 			       int vm_write)
 {
-	/* Do the copy for each page */
+	/* Do the copy for each run of pages */
 	while (len && iov_iter_count(iter)) {
 		struct page *page = *pages++;
 		size_t copy = PAGE_SIZE - offset;
 		size_t copied;
+		bool lowmem = !PageHighMem(page);
+
+		/*
+		 * Pages of a large folio that GUP returned back to back are
+		 * contiguous in the direct map unless highmem, so copy the
+		 * whole run with one iterator pass instead of page by page.
+		 */
+		if (lowmem) {
+			struct folio *folio = page_folio(page);
+
+			while (copy < len && *pages == nth_page(page,
+					(offset + copy) / PAGE_SIZE) &&
+			       page_folio(*pages) == folio) {
+				copy += PAGE_SIZE;
+				pages++;
+			}
+		}
 
 		if (copy > len)
 			copy = len;
 
-		if (vm_write)
+		if (lowmem && vm_write)
+			copied = copy_from_iter(page_address(page) + offset,
+						copy, iter);
+		else if (lowmem)
+			copied = copy_to_iter(page_address(page) + offset,
+					      copy, iter);
+		else if (vm_write)
 			copied = copy_page_from_iter(page, offset, copy, iter);
 		else
 			copied = copy_page_to_iter(page, offset, copy, iter);
@@ -547,6 +547,44 @@ void page_cache_ra_order(struct readahead_control *ractl,
 	do_page_cache_ra(ractl, ra->size, ra->async_size);
 }
 
+/* Maximum number of records read ahead of a strided access pattern */
+#define RA_STRIDE_RECORDS	8
+
+/*
+ * Strided reads: fixed size records separated by a fixed gap. The gap
+ * between the end of the previous read and this one is remembered in
+ * ra->stride; once it repeats, read the next few records along with this
+ * one, within the readahead window.
+ */
+static bool try_stride_readahead(struct readahead_control *ractl,
+				 pgoff_t prev_index, unsigned long req_size,
+				 unsigned long max_pages)
+{
+	struct file_ra_state *ra = ractl->ra;
+	pgoff_t index = readahead_index(ractl);
+	unsigned long gap = index - prev_index;
+	unsigned long nr_records;
+
+	if (index <= prev_index || gap > max_pages) {
+		ra->stride = 0;
+		return false;
+	}
+
+	if (gap != ra->stride) {
+		ra->stride = gap;
+		return false;
+	}
+
+	nr_records = min(max_pages / req_size, RA_STRIDE_RECORDS + 1UL);
+	do {
+		do_page_cache_ra(ractl, req_size, 0);
+		index += req_size + gap - 1;
+		ractl->_index = index;
+	} while (--nr_records);
+
+	return true;
+}
+
 /*
  * A minimal readahead algorithm for trivial sequential/random reads.
  */
@@ -635,6 +673,9 @@ static void ondemand_readahead(struct readahead_control *ractl,
 			max_pages))
 		goto readit;
 
+	if (try_stride_readahead(ractl, prev_index, req_size, max_pages))
+		return;
+
 	/*
 	 * standalone, small random read
 	 * Read as is, and do not pollute the readahead state.
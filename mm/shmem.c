@@ -119,6 +119,7 @@ struct shmem_options {
 	umode_t mode;
 	bool full_inums;
 	int huge;
+	unsigned int huge_order;
 	int seen;
 	bool noswap;
 	unsigned short quota_types;
@@ -129,6 +130,7 @@ struct shmem_options {
 #define SHMEM_SEEN_INUMS 8
 #define SHMEM_SEEN_NOSWAP 16
 #define SHMEM_SEEN_QUOTA 32
+#define SHMEM_SEEN_HUGE_ORDER 64
 };
 
 #ifdef CONFIG_TMPFS
@@ -541,6 +543,12 @@ static bool shmem_confirm_swap(struct address_space *mapping,
 
 static int shmem_huge __read_mostly = SHMEM_HUGE_NEVER;
 
+/* Order of the large folios allocated for @inode, PMD order by default. */
+static unsigned int shmem_huge_order(struct inode *inode)
+{
+	return SHMEM_SB(inode->i_sb)->huge_order ?: HPAGE_PMD_ORDER;
+}
+
 static bool __shmem_is_huge(struct inode *inode, pgoff_t index,
 			    bool shmem_huge_force, struct mm_struct *mm,
 			    unsigned long vm_flags)
@@ -560,7 +568,7 @@ static bool __shmem_is_huge(struct inode *inode, pgoff_t index,
 	case SHMEM_HUGE_ALWAYS:
 		return true;
 	case SHMEM_HUGE_WITHIN_SIZE:
-		index = round_up(index + 1, HPAGE_PMD_NR);
+		index = round_up(index + 1, 1UL << shmem_huge_order(inode));
 		i_size = round_up(i_size_read(inode), PAGE_SIZE);
 		if (i_size >> PAGE_SHIFT >= index)
 			return true;
@@ -574,12 +582,29 @@ static bool __shmem_is_huge(struct inode *inode, pgoff_t index,
 	}
 }
 
+/*
+ * Whether PMD-sized folios may be used; this is what the THP fault and
+ * khugepaged paths ask, so mounts using a smaller order answer no here.
+ */
 bool shmem_is_huge(struct inode *inode, pgoff_t index,
 		   bool shmem_huge_force, struct mm_struct *mm,
 		   unsigned long vm_flags)
 {
 	if (HPAGE_PMD_ORDER > MAX_PAGECACHE_ORDER)
 		return false;
+	if (shmem_huge_order(inode) != HPAGE_PMD_ORDER)
+		return false;
+
+	return __shmem_is_huge(inode, index, shmem_huge_force, mm, vm_flags);
+}
+
+/* Whether shmem itself should allocate a folio of shmem_huge_order(). */
+static bool shmem_huge_allowed(struct inode *inode, pgoff_t index,
+			       bool shmem_huge_force, struct mm_struct *mm,
+			       unsigned long vm_flags)
+{
+	if (shmem_huge_order(inode) > MAX_PAGECACHE_ORDER)
+		return false;
 
 	return __shmem_is_huge(inode, index, shmem_huge_force, mm, vm_flags);
 }
@@ -655,7 +680,8 @@ static unsigned long shmem_unused_huge_shrink(struct shmem_sb_info *sbinfo,
 
 		/* Check if there's anything to gain */
 		if (round_up(inode->i_size, PAGE_SIZE) ==
-				round_up(inode->i_size, HPAGE_PMD_SIZE)) {
+				round_up(inode->i_size,
+					 PAGE_SIZE << shmem_huge_order(inode))) {
 			list_move(&info->shrinklist, &to_remove);
 			goto next;
 		}
@@ -685,7 +711,8 @@ static unsigned long shmem_unused_huge_shrink(struct shmem_sb_info *sbinfo,
 		if (nr_to_split && split >= nr_to_split)
 			goto move_back;
 
-		index = (inode->i_size & HPAGE_PMD_MASK) >> PAGE_SHIFT;
+		index = round_down(inode->i_size >> PAGE_SHIFT,
+				   1UL << shmem_huge_order(inode));
 		folio = filemap_get_folio(inode->i_mapping, index);
 		if (IS_ERR(folio))
 			goto drop;
@@ -759,6 +786,18 @@ static long shmem_unused_huge_count(struct super_block *sb,
 
 #define shmem_huge SHMEM_HUGE_DENY
 
+static unsigned int shmem_huge_order(struct inode *inode)
+{
+	return 0;
+}
+
+static bool shmem_huge_allowed(struct inode *inode, pgoff_t index,
+			       bool shmem_huge_force, struct mm_struct *mm,
+			       unsigned long vm_flags)
+{
+	return false;
+}
+
 static unsigned long shmem_unused_huge_shrink(struct shmem_sb_info *sbinfo,
 		struct shrink_control *sc, unsigned long nr_to_split)
 {
@@ -1149,8 +1188,8 @@ static int shmem_getattr(struct mnt_idmap *idmap,
 			STATX_ATTR_NODUMP);
 	generic_fillattr(idmap, request_mask, inode, stat);
 
-	if (shmem_is_huge(inode, 0, false, NULL, 0))
-		stat->blksize = HPAGE_PMD_SIZE;
+	if (shmem_huge_allowed(inode, 0, false, NULL, 0))
+		stat->blksize = PAGE_SIZE << shmem_huge_order(inode);
 
 	if (request_mask & STATX_BTIME) {
 		stat->result_mask |= STATX_BTIME;
@@ -1615,14 +1654,14 @@ static gfp_t limit_gfp_mask(gfp_t huge_gfp, gfp_t limit_gfp)
 }
 
 static struct folio *shmem_alloc_hugefolio(gfp_t gfp,
-		struct shmem_inode_info *info, pgoff_t index)
+		struct shmem_inode_info *info, pgoff_t index, unsigned int order)
 {
 	struct mempolicy *mpol;
 	pgoff_t ilx;
 	struct page *page;
 
-	mpol = shmem_get_pgoff_policy(info, index, HPAGE_PMD_ORDER, &ilx);
-	page = alloc_pages_mpol(gfp, HPAGE_PMD_ORDER, mpol, ilx, numa_node_id());
+	mpol = shmem_get_pgoff_policy(info, index, order, &ilx);
+	page = alloc_pages_mpol(gfp, order, mpol, ilx, numa_node_id());
 	mpol_cond_put(mpol);
 
 	return page_rmappable_folio(page);
@@ -1656,8 +1695,10 @@ static struct folio *shmem_alloc_and_add_folio(gfp_t gfp,
 		huge = false;
 
 	if (huge) {
-		pages = HPAGE_PMD_NR;
-		index = round_down(index, HPAGE_PMD_NR);
+		unsigned int order = shmem_huge_order(inode);
+
+		pages = 1UL << order;
+		index = round_down(index, pages);
 
 		/*
 		 * Check for conflict before waiting on a huge allocation.
@@ -1668,10 +1709,10 @@ static struct folio *shmem_alloc_and_add_folio(gfp_t gfp,
 		 * Elsewhere -EEXIST would be the right code, but not here.
 		 */
 		if (xa_find(&mapping->i_pages, &index,
-				index + HPAGE_PMD_NR - 1, XA_PRESENT))
+				index + pages - 1, XA_PRESENT))
 			return ERR_PTR(-E2BIG);
 
-		folio = shmem_alloc_hugefolio(gfp, info, index);
+		folio = shmem_alloc_hugefolio(gfp, info, index, order);
 		if (!folio)
 			count_vm_event(THP_FILE_FALLBACK);
 	} else {
@@ -2047,8 +2088,8 @@ static int shmem_get_folio_gfp(struct inode *inode, pgoff_t index,
 		return 0;
 	}
 
-	if (shmem_is_huge(inode, index, false, fault_mm,
-			  vma ? vma->vm_flags : 0)) {
+	if (shmem_huge_allowed(inode, index, false, fault_mm,
+			       vma ? vma->vm_flags : 0)) {
 		gfp_t huge_gfp;
 
 		huge_gfp = vma_thp_gfp_mask(vma);
@@ -2074,7 +2115,7 @@ static int shmem_get_folio_gfp(struct inode *inode, pgoff_t index,
 
 alloced:
 	alloced = true;
-	if (folio_test_pmd_mappable(folio) &&
+	if (folio_test_large(folio) &&
 	    DIV_ROUND_UP(i_size_read(inode), PAGE_SIZE) <
 					folio_next_index(folio) - 1) {
 		struct shmem_sb_info *sbinfo = SHMEM_SB(inode->i_sb);
@@ -3890,6 +3931,7 @@ static const struct export_operations shmem_export_ops = {
 enum shmem_param {
 	Opt_gid,
 	Opt_huge,
+	Opt_huge_order,
 	Opt_mode,
 	Opt_mpol,
 	Opt_nr_blocks,
@@ -3919,6 +3961,7 @@ static const struct constant_table shmem_param_enums_huge[] = {
 const struct fs_parameter_spec shmem_fs_parameters[] = {
 	fsparam_gid   ("gid",		Opt_gid),
 	fsparam_enum  ("huge",		Opt_huge,  shmem_param_enums_huge),
+	fsparam_u32   ("huge_order",	Opt_huge_order),
 	fsparam_u32oct("mode",		Opt_mode),
 	fsparam_string("mpol",		Opt_mpol),
 	fsparam_string("nr_blocks",	Opt_nr_blocks),
@@ -4015,6 +4058,20 @@ static int shmem_parse_one(struct fs_context *fc, struct fs_parameter *param)
 			goto unsupported_parameter;
 		ctx->seen |= SHMEM_SEEN_HUGE;
 		break;
+	case Opt_huge_order:
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+		if (!has_transparent_hugepage())
+			goto unsupported_parameter;
+		if (result.uint_32 < 1 || result.uint_32 > HPAGE_PMD_ORDER ||
+		    result.uint_32 > MAX_PAGECACHE_ORDER)
+			goto bad_value;
+		ctx->huge_order = result.uint_32 == HPAGE_PMD_ORDER ?
+				  0 : result.uint_32;
+		ctx->seen |= SHMEM_SEEN_HUGE_ORDER;
+		break;
+#else
+		goto unsupported_parameter;
+#endif
 	case Opt_mpol:
 		if (IS_ENABLED(CONFIG_NUMA)) {
 			mpol_put(ctx->mpol);
@@ -4221,6 +4278,8 @@ static int shmem_reconfigure(struct fs_context *fc)
 
 	if (ctx->seen & SHMEM_SEEN_HUGE)
 		sbinfo->huge = ctx->huge;
+	if (ctx->seen & SHMEM_SEEN_HUGE_ORDER)
+		sbinfo->huge_order = ctx->huge_order;
 	if (ctx->seen & SHMEM_SEEN_INUMS)
 		sbinfo->full_inums = ctx->full_inums;
 	if (ctx->seen & SHMEM_SEEN_BLOCKS)
@@ -4294,6 +4353,8 @@ static int shmem_show_options(struct seq_file *seq, struct dentry *root)
 	/* Rightly or wrongly, show huge mount option unmasked by shmem_huge */
 	if (sbinfo->huge)
 		seq_printf(seq, ",huge=%s", shmem_format_huge(sbinfo->huge));
+	if (sbinfo->huge_order)
+		seq_printf(seq, ",huge_order=%u", sbinfo->huge_order);
 #endif
 	mpol = shmem_get_sbmpol(sbinfo);
 	shmem_show_mpol(seq, mpol);
@@ -4387,6 +4448,7 @@ static int shmem_fill_super(struct super_block *sb, struct fs_context *fc)
 	sbinfo->full_inums = ctx->full_inums;
 	sbinfo->mode = ctx->mode;
 	sbinfo->huge = ctx->huge;
+	sbinfo->huge_order = ctx->huge_order;
 	sbinfo->mpol = ctx->mpol;
 	ctx->mpol = NULL;
 
@@ -364,6 +364,36 @@ static long add_nr_deferred(long nr, struct shrinker *shrinker,
 	return atomic_long_add_return(nr, &shrinker->nr_deferred[nid]);
 }
 
+#ifdef CONFIG_SHRINKER_DEBUG
+static inline u64 shrinker_stats_start(void)
+{
+	return ktime_get_ns();
+}
+
+static inline void shrinker_stats_end(struct shrinker *shrinker, u64 start,
+				      long scanned, unsigned long freed,
+				      bool empty)
+{
+	atomic_long_inc(&shrinker->nr_calls);
+	if (empty)
+		atomic_long_inc(&shrinker->nr_empty);
+	atomic_long_add(scanned, &shrinker->nr_scanned);
+	atomic_long_add(freed, &shrinker->nr_freed);
+	atomic64_add(ktime_get_ns() - start, &shrinker->scan_time_ns);
+}
+#else
+static inline u64 shrinker_stats_start(void)
+{
+	return 0;
+}
+
+static inline void shrinker_stats_end(struct shrinker *shrinker, u64 start,
+				      long scanned, unsigned long freed,
+				      bool empty)
+{
+}
+#endif
+
 #define SHRINK_BATCH 128
 
 static unsigned long do_shrink_slab(struct shrink_control *shrinkctl,
@@ -378,10 +408,13 @@ static unsigned long do_shrink_slab(struct shrink_control *shrinkctl,
 	long batch_size = shrinker->batch ? shrinker->batch
 					  : SHRINK_BATCH;
 	long scanned = 0, next_deferred;
+	u64 start = shrinker_stats_start();
 
 	freeable = shrinker->count_objects(shrinker, shrinkctl);
-	if (freeable == 0 || freeable == SHRINK_EMPTY)
+	if (freeable == 0 || freeable == SHRINK_EMPTY) {
+		shrinker_stats_end(shrinker, start, 0, 0, true);
 		return freeable;
+	}
 
 	/*
 	 * copy the current shrinker scan count into a local variable
@@ -460,6 +493,7 @@ static unsigned long do_shrink_slab(struct shrink_control *shrinkctl,
 	new_nr = add_nr_deferred(next_deferred, shrinker, shrinkctl);
 
 	trace_mm_shrink_slab_end(shrinker, shrinkctl->nid, freed, nr, new_nr, total_scan);
+	shrinker_stats_end(shrinker, start, scanned, freed, false);
 	return freed;
 }
 
@@ -542,8 +576,10 @@ static unsigned long shrink_slab_memcg(gfp_t gfp_mask, int nid,
 
 			/* Call non-slab shrinkers even though kmem is disabled */
 			if (!memcg_kmem_online() &&
-			    !(shrinker->flags & SHRINKER_NONSLAB))
+			    !(shrinker->flags & SHRINKER_NONSLAB)) {
+				shrinker_put(shrinker);
 				continue;
+			}
 
 			ret = do_shrink_slab(&sc, shrinker, priority);
 			if (ret == SHRINK_EMPTY) {
@@ -95,6 +95,20 @@ static int shrinker_debugfs_count_show(struct seq_file *m, void *v)
 }
 DEFINE_SHOW_ATTRIBUTE(shrinker_debugfs_count);
 
+static int shrinker_debugfs_stats_show(struct seq_file *m, void *v)
+{
+	struct shrinker *shrinker = m->private;
+
+	seq_printf(m, "calls %lu\n", atomic_long_read(&shrinker->nr_calls));
+	seq_printf(m, "empty %lu\n", atomic_long_read(&shrinker->nr_empty));
+	seq_printf(m, "scanned %lu\n", atomic_long_read(&shrinker->nr_scanned));
+	seq_printf(m, "freed %lu\n", atomic_long_read(&shrinker->nr_freed));
+	seq_printf(m, "time_ns %llu\n",
+		   (u64)atomic64_read(&shrinker->scan_time_ns));
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(shrinker_debugfs_stats);
+
 static int shrinker_debugfs_scan_open(struct inode *inode, struct file *file)
 {
 	file->private_data = inode->i_private;
@@ -190,6 +204,8 @@ int shrinker_debugfs_add(struct shrinker *shrinker)
 			    &shrinker_debugfs_count_fops);
 	debugfs_create_file("scan", 0220, entry, shrinker,
 			    &shrinker_debugfs_scan_fops);
+	debugfs_create_file("stats", 0440, entry, shrinker,
+			    &shrinker_debugfs_stats_fops);
 	return 0;
 }
 
@@ -251,6 +251,8 @@ struct kmem_cache_order_objects {
 struct kmem_cache {
 #ifndef CONFIG_SLUB_TINY
 	struct kmem_cache_cpu __percpu *cpu_slab;
+	struct slub_percpu_sheaves __percpu *cpu_sheaves;
+	unsigned int sheaf_capacity;
 #endif
 	/* Used for retrieving partial slabs, etc. */
 	slab_flags_t flags;
@@ -453,7 +455,8 @@ static inline bool is_kmalloc_cache(struct kmem_cache *s)
 
 #define SLAB_CACHE_FLAGS (SLAB_NOLEAKTRACE | SLAB_RECLAIM_ACCOUNT | \
 			  SLAB_TEMPORARY | SLAB_ACCOUNT | \
-			  SLAB_NO_USER_FLAGS | SLAB_KMALLOC | SLAB_NO_MERGE)
+			  SLAB_NO_USER_FLAGS | SLAB_KMALLOC | SLAB_NO_MERGE | \
+			  SLAB_PERCPU_SHEAVES)
 
 /* Common flags available with current configuration */
 #define CACHE_CREATE_MASK (SLAB_CORE_FLAGS | SLAB_DEBUG_FLAGS | SLAB_CACHE_FLAGS)
@@ -471,7 +474,8 @@ static inline bool is_kmalloc_cache(struct kmem_cache *s)
 			      SLAB_ACCOUNT | \
 			      SLAB_KMALLOC | \
 			      SLAB_NO_MERGE | \
-			      SLAB_NO_USER_FLAGS)
+			      SLAB_NO_USER_FLAGS | \
+			      SLAB_PERCPU_SHEAVES)
 
 bool __kmem_cache_empty(struct kmem_cache *);
 int __kmem_cache_shutdown(struct kmem_cache *);
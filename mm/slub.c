@@ -373,6 +373,10 @@ enum stat_item {
 	CPU_PARTIAL_FREE,	/* Refill cpu partial on free */
 	CPU_PARTIAL_NODE,	/* Refill cpu partial from node partial */
 	CPU_PARTIAL_DRAIN,	/* Drain cpu partial to node partial */
+	ALLOC_PCS,		/* Allocation from percpu sheaf */
+	FREE_PCS,		/* Free to percpu sheaf */
+	SHEAF_REFILL,		/* Sheaf refilled from slabs in bulk */
+	SHEAF_FLUSH,		/* Sheaf flushed back to slabs in bulk */
 	NR_SLUB_STAT_ITEMS
 };
 
@@ -398,6 +402,35 @@ struct kmem_cache_cpu {
 	unsigned int stat[NR_SLUB_STAT_ITEMS];
 #endif
 };
+
+/*
+ * Percpu sheaves are an opt-in (SLAB_PERCPU_SHEAVES) array based caching
+ * layer in front of the cpu slab. A sheaf is an array of free objects;
+ * allocation and freeing on the local cpu are a pop/push on its main sheaf
+ * under a local_lock, without touching the cpu slab freelist. Sheaves are
+ * refilled from and flushed to slabs in bulk, and full or empty sheaves are
+ * exchanged through a per-node barn so that objects freed on one cpu can be
+ * reused by another cpu of the same node.
+ */
+struct slab_sheaf {
+	struct list_head barn_list;
+	unsigned int size;
+	void *objects[];
+};
+
+struct slub_percpu_sheaves {
+	local_lock_t lock;
+	struct slab_sheaf *main;	/* Never NULL when unlocked */
+	struct slab_sheaf *spare;	/* Empty or full, may be NULL */
+};
+
+struct node_barn {
+	spinlock_t lock;
+	struct list_head sheaves_full;
+	struct list_head sheaves_empty;
+	unsigned int nr_full;
+	unsigned int nr_empty;
+};
 #endif /* CONFIG_SLUB_TINY */
 
 static inline void stat(const struct kmem_cache *s, enum stat_item si)
@@ -431,6 +464,9 @@ struct kmem_cache_node {
 	atomic_long_t total_objects;
 	struct list_head full;
 #endif
+#ifndef CONFIG_SLUB_TINY
+	struct node_barn barn;
+#endif
 };
 
 static inline struct kmem_cache_node *get_node(struct kmem_cache *s, int node)
@@ -3080,6 +3116,417 @@ static inline void put_partials_cpu(struct kmem_cache *s,
 
 #endif	/* CONFIG_SLUB_CPU_PARTIAL */
 
+static int __kmem_cache_alloc_bulk(struct kmem_cache *s, gfp_t flags,
+				   size_t size, void **p);
+static void __kmem_cache_free_bulk(struct kmem_cache *s, size_t size,
+				   void **p);
+
+#define MAX_FULL_SHEAVES	10
+#define MAX_EMPTY_SHEAVES	10
+#define PCS_BATCH_MAX		32U
+
+static inline bool slab_has_sheaves(struct kmem_cache *s)
+{
+	return s->cpu_sheaves;
+}
+
+static unsigned int calc_sheaf_capacity(struct kmem_cache *s)
+{
+	if (s->size > PAGE_SIZE)
+		return 8;
+	if (s->size > 1024)
+		return 16;
+	if (s->size > 256)
+		return 32;
+	return 64;
+}
+
+static struct slab_sheaf *alloc_empty_sheaf(struct kmem_cache *s, gfp_t gfp)
+{
+	struct slab_sheaf *sheaf;
+
+	/* The sheaf itself is not accounted and must not come from DMA zones */
+	gfp &= ~(__GFP_ZERO | __GFP_ACCOUNT | __GFP_RECLAIMABLE | __GFP_NOFAIL |
+		 __GFP_DMA | __GFP_DMA32);
+	sheaf = kmalloc(struct_size(sheaf, objects, s->sheaf_capacity),
+			gfp | __GFP_NOWARN);
+	if (sheaf)
+		sheaf->size = 0;
+
+	return sheaf;
+}
+
+static int refill_sheaf(struct kmem_cache *s, struct slab_sheaf *sheaf,
+			gfp_t gfp)
+{
+	unsigned int to_fill = s->sheaf_capacity - sheaf->size;
+
+	if (!to_fill)
+		return 0;
+
+	/*
+	 * Objects in sheaves are handed out to any later caller, so don't take
+	 * them from pfmemalloc reserves.
+	 */
+	if (!__kmem_cache_alloc_bulk(s, gfp | __GFP_NOMEMALLOC, to_fill,
+				     &sheaf->objects[sheaf->size]))
+		return -ENOMEM;
+
+	sheaf->size = s->sheaf_capacity;
+	stat(s, SHEAF_REFILL);
+	return 0;
+}
+
+/* Return all objects of a detached sheaf to their slabs and free it */
+static void sheaf_discard(struct kmem_cache *s, struct slab_sheaf *sheaf)
+{
+	if (sheaf->size) {
+		__kmem_cache_free_bulk(s, sheaf->size, &sheaf->objects[0]);
+		stat(s, SHEAF_FLUSH);
+	}
+	kfree(sheaf);
+}
+
+static struct node_barn *get_barn(struct kmem_cache *s)
+{
+	struct kmem_cache_node *n = get_node(s, numa_mem_id());
+
+	return n ? &n->barn : NULL;
+}
+
+/* The barn lock is always taken with the percpu sheaves lock held */
+static struct slab_sheaf *barn_get(struct node_barn *barn, bool full)
+{
+	struct list_head *list = full ? &barn->sheaves_full : &barn->sheaves_empty;
+	unsigned int *nr = full ? &barn->nr_full : &barn->nr_empty;
+	struct slab_sheaf *sheaf = NULL;
+
+	if (!data_race(*nr))
+		return NULL;
+
+	spin_lock(&barn->lock);
+	if (*nr) {
+		sheaf = list_first_entry(list, struct slab_sheaf, barn_list);
+		list_del(&sheaf->barn_list);
+		(*nr)--;
+	}
+	spin_unlock(&barn->lock);
+
+	return sheaf;
+}
+
+static bool barn_put(struct node_barn *barn, struct slab_sheaf *sheaf)
+{
+	bool ret = false;
+
+	spin_lock(&barn->lock);
+	if (sheaf->size && barn->nr_full < MAX_FULL_SHEAVES) {
+		list_add(&sheaf->barn_list, &barn->sheaves_full);
+		barn->nr_full++;
+		ret = true;
+	} else if (!sheaf->size && barn->nr_empty < MAX_EMPTY_SHEAVES) {
+		list_add(&sheaf->barn_list, &barn->sheaves_empty);
+		barn->nr_empty++;
+		ret = true;
+	}
+	spin_unlock(&barn->lock);
+
+	return ret;
+}
+
+static void barn_shrink(struct kmem_cache *s, struct node_barn *barn)
+{
+	struct slab_sheaf *sheaf, *tmp;
+	unsigned long flags;
+	LIST_HEAD(list);
+
+	spin_lock_irqsave(&barn->lock, flags);
+	list_splice_init(&barn->sheaves_full, &list);
+	list_splice_init(&barn->sheaves_empty, &list);
+	barn->nr_full = 0;
+	barn->nr_empty = 0;
+	spin_unlock_irqrestore(&barn->lock, flags);
+
+	list_for_each_entry_safe(sheaf, tmp, &list, barn_list)
+		sheaf_discard(s, sheaf);
+}
+
+/*
+ * Park a sheaf that stopped being the main one, preferring the spare slot
+ * and then the barn. Returns the sheaf if there was no room for it, the
+ * caller has to discard it after dropping the lock.
+ */
+static struct slab_sheaf *pcs_stash_sheaf(struct kmem_cache *s,
+					  struct slub_percpu_sheaves *pcs,
+					  struct slab_sheaf *sheaf)
+{
+	struct node_barn *barn;
+
+	if (!pcs->spare) {
+		pcs->spare = sheaf;
+		return NULL;
+	}
+
+	barn = get_barn(s);
+	if (barn && barn_put(barn, sheaf))
+		return NULL;
+
+	return sheaf;
+}
+
+static void *alloc_from_pcs_refill(struct kmem_cache *s,
+				   struct slab_sheaf *sheaf, gfp_t gfp)
+{
+	struct slub_percpu_sheaves *pcs;
+	struct slab_sheaf *discard;
+	unsigned long flags;
+	void *object;
+
+	if (!sheaf) {
+		sheaf = alloc_empty_sheaf(s, gfp);
+		if (!sheaf)
+			return NULL;
+	}
+
+	if (refill_sheaf(s, sheaf, gfp)) {
+		kfree(sheaf);
+		return NULL;
+	}
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+
+	/* We might have been refilled or migrated meanwhile */
+	if (!pcs->main->size)
+		swap(pcs->main, sheaf);
+	discard = pcs_stash_sheaf(s, pcs, sheaf);
+
+	object = pcs->main->objects[--pcs->main->size];
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+	stat(s, ALLOC_PCS);
+	if (discard)
+		sheaf_discard(s, discard);
+
+	return object;
+}
+
+static void *alloc_from_pcs(struct kmem_cache *s, gfp_t gfp)
+{
+	struct slub_percpu_sheaves *pcs;
+	struct slab_sheaf *discard = NULL;
+	unsigned long flags;
+	void *object;
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+
+	if (unlikely(!pcs->main->size)) {
+		struct node_barn *barn = get_barn(s);
+		struct slab_sheaf *sheaf = NULL;
+
+		if (!pcs->spare || !pcs->spare->size)
+			sheaf = barn ? barn_get(barn, true) : NULL;
+
+		if (pcs->spare && pcs->spare->size) {
+			swap(pcs->main, pcs->spare);
+		} else if (sheaf) {
+			discard = pcs_stash_sheaf(s, pcs, pcs->main);
+			pcs->main = sheaf;
+		} else {
+			/* Refill an empty spare or barn sheaf outside the lock */
+			sheaf = pcs->spare;
+			pcs->spare = NULL;
+			if (!sheaf && barn)
+				sheaf = barn_get(barn, false);
+			local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+			return alloc_from_pcs_refill(s, sheaf, gfp);
+		}
+	}
+
+	object = pcs->main->objects[--pcs->main->size];
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+	stat(s, ALLOC_PCS);
+	if (unlikely(discard))
+		sheaf_discard(s, discard);
+
+	return object;
+}
+
+/* Flush the main sheaf of the current cpu in batches, outside of its lock */
+static void sheaf_flush_main(struct kmem_cache *s)
+{
+	struct slub_percpu_sheaves *pcs;
+	void *objects[PCS_BATCH_MAX];
+	unsigned int batch, remaining;
+	unsigned long flags;
+
+	do {
+		local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+		pcs = this_cpu_ptr(s->cpu_sheaves);
+
+		batch = min(PCS_BATCH_MAX, pcs->main->size);
+		pcs->main->size -= batch;
+		memcpy(objects, &pcs->main->objects[pcs->main->size],
+		       batch * sizeof(void *));
+		remaining = pcs->main->size;
+
+		local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+		if (batch) {
+			__kmem_cache_free_bulk(s, batch, objects);
+			stat(s, SHEAF_FLUSH);
+		}
+	} while (remaining);
+}
+
+static bool can_free_to_pcs(struct kmem_cache *s, struct slab *slab,
+			    void *object)
+{
+	return slab_has_sheaves(s) && likely(!is_kfence_address(object)) &&
+	       likely(slab_nid(slab) == numa_mem_id()) &&
+	       likely(!slab_test_pfmemalloc(slab));
+}
+
+static void free_to_pcs(struct kmem_cache *s, void *object)
+{
+	struct slub_percpu_sheaves *pcs;
+	struct slab_sheaf *discard = NULL;
+	unsigned long flags;
+
+retry:
+	local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+
+	if (unlikely(pcs->main->size == s->sheaf_capacity)) {
+		struct node_barn *barn = get_barn(s);
+		struct slab_sheaf *empty = NULL;
+
+		if (!pcs->spare || pcs->spare->size == s->sheaf_capacity)
+			empty = barn ? barn_get(barn, false) : NULL;
+
+		if (pcs->spare && pcs->spare->size < s->sheaf_capacity) {
+			swap(pcs->main, pcs->spare);
+		} else if (empty) {
+			discard = pcs_stash_sheaf(s, pcs, pcs->main);
+			pcs->main = empty;
+		} else {
+			/* Nowhere to park a full sheaf, send it back to slabs */
+			local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+			sheaf_flush_main(s);
+			goto retry;
+		}
+	}
+
+	pcs->main->objects[pcs->main->size++] = object;
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+	stat(s, FREE_PCS);
+	if (unlikely(discard))
+		sheaf_discard(s, discard);
+}
+
+/* Called from the cpu flush work, with migration disabled */
+static void pcs_flush_all(struct kmem_cache *s)
+{
+	struct slub_percpu_sheaves *pcs;
+	struct slab_sheaf *spare;
+	unsigned long flags;
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+	spare = pcs->spare;
+	pcs->spare = NULL;
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+	if (spare)
+		sheaf_discard(s, spare);
+	sheaf_flush_main(s);
+}
+
+/* The cpu is dead, nobody else can access its sheaves */
+static void __pcs_flush_all_cpu(struct kmem_cache *s, unsigned int cpu)
+{
+	struct slub_percpu_sheaves *pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+
+	if (pcs->spare) {
+		sheaf_discard(s, pcs->spare);
+		pcs->spare = NULL;
+	}
+	if (pcs->main->size) {
+		__kmem_cache_free_bulk(s, pcs->main->size, &pcs->main->objects[0]);
+		pcs->main->size = 0;
+		stat(s, SHEAF_FLUSH);
+	}
+}
+
+static bool pcs_has_objects(struct kmem_cache *s, int cpu)
+{
+	struct slub_percpu_sheaves *pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+
+	return pcs->main->size || pcs->spare;
+}
+
+static void barn_shrink_all(struct kmem_cache *s)
+{
+	struct kmem_cache_node *n;
+	int node;
+
+	for_each_kmem_cache_node(s, node, n)
+		barn_shrink(s, &n->barn);
+}
+
+static void free_percpu_sheaves(struct kmem_cache *s)
+{
+	int cpu;
+
+	if (!s->cpu_sheaves)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct slub_percpu_sheaves *pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+
+		kfree(pcs->main);
+		kfree(pcs->spare);
+	}
+	free_percpu(s->cpu_sheaves);
+	s->cpu_sheaves = NULL;
+}
+
+static int init_percpu_sheaves(struct kmem_cache *s)
+{
+	int cpu;
+
+	/*
+	 * Debugging needs every object to go through the slow paths, and
+	 * sheaves themselves are kmalloc'ed so they can't front the kmalloc
+	 * caches or caches created before slab is up.
+	 */
+	if (!(s->flags & SLAB_PERCPU_SHEAVES) || kmem_cache_debug(s) ||
+	    (s->flags & SLAB_KMALLOC) || slab_state < UP) {
+		s->flags &= ~SLAB_PERCPU_SHEAVES;
+		return 1;
+	}
+
+	s->sheaf_capacity = calc_sheaf_capacity(s);
+	s->cpu_sheaves = alloc_percpu(struct slub_percpu_sheaves);
+	if (!s->cpu_sheaves)
+		return 0;
+
+	for_each_possible_cpu(cpu) {
+		struct slub_percpu_sheaves *pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+
+		local_lock_init(&pcs->lock);
+		pcs->main = alloc_empty_sheaf(s, GFP_KERNEL);
+		if (!pcs->main)
+			return 0;
+	}
+
+	return 1;
+}
+
 static inline void flush_slab(struct kmem_cache *s, struct kmem_cache_cpu *c)
 {
 	unsigned long flags;
@@ -3119,6 +3566,9 @@ static inline void __flush_cpu_slab(struct kmem_cache *s, int cpu)
 	}
 
 	put_partials_cpu(s, c);
+
+	if (slab_has_sheaves(s))
+		__pcs_flush_all_cpu(s, cpu);
 }
 
 struct slub_flush_work {
@@ -3147,12 +3597,18 @@ static void flush_cpu_slab(struct work_struct *w)
 		flush_slab(s, c);
 
 	put_partials(s);
+
+	if (slab_has_sheaves(s))
+		pcs_flush_all(s);
 }
 
 static bool has_cpu_slab(int cpu, struct kmem_cache *s)
 {
 	struct kmem_cache_cpu *c = per_cpu_ptr(s->cpu_slab, cpu);
 
+	if (slab_has_sheaves(s) && pcs_has_objects(s, cpu))
+		return true;
+
 	return c->slab || slub_percpu_partial(c);
 }
 
@@ -3186,6 +3642,9 @@ static void flush_all_cpus_locked(struct kmem_cache *s)
 		flush_work(&sfw->work);
 	}
 
+	if (slab_has_sheaves(s))
+		barn_shrink_all(s);
+
 	mutex_unlock(&flush_lock);
 }
 
@@ -3212,6 +3671,13 @@ static int slub_cpu_dead(unsigned int cpu)
 }
 
 #else /* CONFIG_SLUB_TINY */
+static inline bool slab_has_sheaves(struct kmem_cache *s) { return false; }
+static inline void *alloc_from_pcs(struct kmem_cache *s, gfp_t gfp) { return NULL; }
+static inline bool can_free_to_pcs(struct kmem_cache *s, struct slab *slab,
+				   void *object) { return false; }
+static inline void free_to_pcs(struct kmem_cache *s, void *object) { }
+static inline void free_percpu_sheaves(struct kmem_cache *s) { }
+static inline int init_percpu_sheaves(struct kmem_cache *s) { return 1; }
 static inline void flush_all_cpus_locked(struct kmem_cache *s) { }
 static inline void flush_all(struct kmem_cache *s) { }
 static inline void __flush_cpu_slab(struct kmem_cache *s, int cpu) { }
@@ -3987,7 +4453,11 @@ static __fastpath_inline void *slab_alloc_node(struct kmem_cache *s, struct list
 	if (unlikely(object))
 		goto out;
 
-	object = __slab_alloc_node(s, gfpflags, node, addr, orig_size);
+	if (slab_has_sheaves(s) && node == NUMA_NO_NODE)
+		object = alloc_from_pcs(s, gfpflags);
+
+	if (!object)
+		object = __slab_alloc_node(s, gfpflags, node, addr, orig_size);
 
 	maybe_wipe_obj_freeptr(s, object);
 	init = slab_want_init_on_alloc(gfpflags, s);
@@ -4435,8 +4905,15 @@ void slab_free(struct kmem_cache *s, struct slab *slab, void *object,
 	memcg_slab_free_hook(s, slab, &object, 1);
 	alloc_tagging_slab_free_hook(s, slab, &object, 1);
 
-	if (likely(slab_free_hook(s, object, slab_want_init_on_free(s))))
-		do_slab_free(s, slab, object, object, 1, addr);
+	if (unlikely(!slab_free_hook(s, object, slab_want_init_on_free(s))))
+		return;
+
+	if (can_free_to_pcs(s, slab, object)) {
+		free_to_pcs(s, object);
+		return;
+	}
+
+	do_slab_free(s, slab, object, object, 1, addr);
 }
 
 #ifdef CONFIG_MEMCG_KMEM
@@ -4953,6 +5430,13 @@ init_kmem_cache_node(struct kmem_cache_node *n)
 	atomic_long_set(&n->total_objects, 0);
 	INIT_LIST_HEAD(&n->full);
 #endif
+#ifndef CONFIG_SLUB_TINY
+	spin_lock_init(&n->barn.lock);
+	INIT_LIST_HEAD(&n->barn.sheaves_full);
+	INIT_LIST_HEAD(&n->barn.sheaves_empty);
+	n->barn.nr_full = 0;
+	n->barn.nr_empty = 0;
+#endif
 }
 
 #ifndef CONFIG_SLUB_TINY
@@ -5043,6 +5527,7 @@ void __kmem_cache_release(struct kmem_cache *s)
 {
 	cache_random_seq_destroy(s);
 #ifndef CONFIG_SLUB_TINY
+	free_percpu_sheaves(s);
 	free_percpu(s->cpu_slab);
 #endif
 	free_kmem_cache_nodes(s);
@@ -5296,7 +5781,7 @@ static int kmem_cache_open(struct kmem_cache *s, slab_flags_t flags)
 	if (!init_kmem_cache_nodes(s))
 		goto error;
 
-	if (alloc_kmem_cache_cpus(s))
+	if (alloc_kmem_cache_cpus(s) && init_percpu_sheaves(s))
 		return 0;
 
 error:
@@ -6684,6 +7169,10 @@ STAT_ATTR(CPU_PARTIAL_ALLOC, cpu_partial_alloc);
 STAT_ATTR(CPU_PARTIAL_FREE, cpu_partial_free);
 STAT_ATTR(CPU_PARTIAL_NODE, cpu_partial_node);
 STAT_ATTR(CPU_PARTIAL_DRAIN, cpu_partial_drain);
+STAT_ATTR(ALLOC_PCS, alloc_cpu_sheaf);
+STAT_ATTR(FREE_PCS, free_cpu_sheaf);
+STAT_ATTR(SHEAF_REFILL, sheaf_refill);
+STAT_ATTR(SHEAF_FLUSH, sheaf_flush);
 #endif	/* CONFIG_SLUB_STATS */
 
 #ifdef CONFIG_KFENCE
@@ -6771,6 +7260,10 @@ static struct attribute *slab_attrs[] = {
 	&cpu_partial_free_attr.attr,
 	&cpu_partial_node_attr.attr,
 	&cpu_partial_drain_attr.attr,
+	&alloc_cpu_sheaf_attr.attr,
+	&free_cpu_sheaf_attr.attr,
+	&sheaf_refill_attr.attr,
+	&sheaf_flush_attr.attr,
 #endif
 #ifdef CONFIG_FAILSLAB
 	&failslab_attr.attr,
@@ -289,6 +289,7 @@ static void discard_swap_cluster(struct swap_info_struct *si,
 #define swap_entry_order(order)	0
 #endif
 #define LATENCY_LIMIT		256
+#define FRAG_SCAN_CLUSTERS	64
 
 static inline void cluster_set_flag(struct swap_cluster_info *info,
 	unsigned int flag)
@@ -638,6 +639,50 @@ static inline bool swap_range_empty(char *swap_map, unsigned int start,
 	return true;
 }
 
+/*
+ * With no free cluster left, look for a naturally aligned free range of the
+ * requested order in partially used clusters, so that large folios aren't
+ * split just because the free space is spread over partial clusters. The scan
+ * resumes where the previous one stopped and looks at a bounded number of
+ * candidate clusters, as it runs under si->lock.
+ */
+static unsigned int scan_swap_map_frag_cluster(struct swap_info_struct *si,
+					       int order)
+{
+	unsigned long nr_clusters = DIV_ROUND_UP(si->max, SWAPFILE_CLUSTER);
+	unsigned int nr_pages = 1 << order;
+	unsigned long idx = si->frag_cluster_next;
+	unsigned long scanned, candidates = 0;
+	struct swap_cluster_info *ci;
+	unsigned int offset, end;
+
+	for (scanned = 0; scanned < nr_clusters; scanned++, idx++) {
+		if (idx >= nr_clusters)
+			idx = 0;
+		/* racy, rechecked under the cluster lock below */
+		if (cluster_count(&si->cluster_info[idx]) + nr_pages >
+		    SWAPFILE_CLUSTER)
+			continue;
+		if (++candidates > FRAG_SCAN_CLUSTERS)
+			break;
+
+		offset = idx * SWAPFILE_CLUSTER;
+		end = min_t(unsigned long, si->max, offset + SWAPFILE_CLUSTER);
+		ci = lock_cluster(si, offset);
+		for (; offset + nr_pages <= end; offset += nr_pages) {
+			if (swap_range_empty(si->swap_map, offset, nr_pages)) {
+				unlock_cluster(ci);
+				si->frag_cluster_next = idx;
+				return offset;
+			}
+		}
+		unlock_cluster(ci);
+	}
+
+	si->frag_cluster_next = idx < nr_clusters ? idx : 0;
+	return SWAP_NEXT_INVALID;
+}
+
 /*
  * Try to get swap entries with specified order from current cpu's swap entry
  * pool (a cluster). This might involve allocating a new cluster for current CPU
@@ -668,6 +713,10 @@ static bool scan_swap_map_try_ssd_cluster(struct swap_info_struct *si,
 			*scan_base = this_cpu_read(*si->cluster_next_cpu);
 			*offset = *scan_base;
 			goto new_cluster;
+		} else if (order > 0) {
+			tmp = scan_swap_map_frag_cluster(si, order);
+			if (tmp == SWAP_NEXT_INVALID)
+				return false;
 		} else
 			return false;
 	}
@@ -764,6 +813,7 @@ static void swap_range_free(struct swap_info_struct *si, unsigned long offset,
 		swap_slot_free_notify = NULL;
 	while (offset <= end) {
 		arch_swap_invalidate_page(si->type, offset);
+		zswap_invalidate(swp_entry(si->type, offset));
 		if (swap_slot_free_notify)
 			swap_slot_free_notify(si->bdev, offset);
 		offset++;
@@ -882,12 +882,14 @@ static struct vmap_node {
 	/* Bookkeeping data of this node. */
 	struct rb_list busy;
 	struct rb_list lazy;
+	unsigned long nr_lazy;
 
 	/*
 	 * Ready-to-free areas.
 	 */
 	struct list_head purge_list;
 	struct work_struct purge_work;
+	unsigned long nr_purge_pages;
 	unsigned long nr_purged;
 } single;
 
@@ -2194,9 +2196,9 @@ static void purge_vmap_node(struct work_struct *work)
 	LIST_HEAD(local_list);
 
 	vn->nr_purged = 0;
+	atomic_long_sub(vn->nr_purge_pages, &vmap_lazy_nr);
 
 	list_for_each_entry_safe(va, n_va, &vn->purge_list, list) {
-		unsigned long nr = (va->va_end - va->va_start) >> PAGE_SHIFT;
 		unsigned long orig_start = va->va_start;
 		unsigned long orig_end = va->va_end;
 		unsigned int vn_id = decode_vn_id(va->flags);
@@ -2207,7 +2209,6 @@ static void purge_vmap_node(struct work_struct *work)
 			kasan_release_vmalloc(orig_start, orig_end,
 					      va->va_start, va->va_end);
 
-		atomic_long_sub(nr, &vmap_lazy_nr);
 		vn->nr_purged++;
 
 		if (is_vn_id_valid(vn_id) && !vn->skip_populate)
@@ -2228,10 +2229,11 @@ static bool __purge_vmap_area_lazy(unsigned long start, unsigned long end,
 		bool full_pool_decay)
 {
 	unsigned long nr_purged_areas = 0;
-	unsigned int nr_purge_helpers;
+	unsigned long purge_threshold;
+	unsigned long max_purge_pages;
 	unsigned int nr_purge_nodes;
 	struct vmap_node *vn;
-	int i;
+	int i, inline_node;
 
 	lockdep_assert_held(&vmap_purge_lock);
 
@@ -2239,6 +2241,8 @@ static bool __purge_vmap_area_lazy(unsigned long start, unsigned long end,
 	 * Use cpumask to mark which node has to be processed.
 	 */
 	purge_nodes = CPU_MASK_NONE;
+	max_purge_pages = 0;
+	inline_node = 0;
 
 	for (i = 0; i < nr_vmap_nodes; i++) {
 		vn = &vmap_nodes[i];
@@ -2253,8 +2257,15 @@ static bool __purge_vmap_area_lazy(unsigned long start, unsigned long end,
 		spin_lock(&vn->lazy.lock);
 		WRITE_ONCE(vn->lazy.root.rb_node, NULL);
 		list_replace_init(&vn->lazy.head, &vn->purge_list);
+		vn->nr_purge_pages = vn->nr_lazy;
+		vn->nr_lazy = 0;
 		spin_unlock(&vn->lazy.lock);
 
+		if (vn->nr_purge_pages > max_purge_pages) {
+			max_purge_pages = vn->nr_purge_pages;
+			inline_node = i;
+		}
+
 		start = min(start, list_first_entry(&vn->purge_list,
 			struct vmap_area, list)->va_start);
 
@@ -2268,24 +2279,35 @@ static bool __purge_vmap_area_lazy(unsigned long start, unsigned long end,
 	if (nr_purge_nodes > 0) {
 		flush_tlb_kernel_range(start, end);
 
-		/* One extra worker is per a lazy_max_pages() full set minus one. */
-		nr_purge_helpers = atomic_long_read(&vmap_lazy_nr) / lazy_max_pages();
-		nr_purge_helpers = clamp(nr_purge_helpers, 1U, nr_purge_nodes) - 1;
+		/*
+		 * A node gets its own worker once it holds at least its fair
+		 * share of lazy_max_pages(), so that a few busy nodes are not
+		 * drained serially by the caller. The busiest node and nodes
+		 * with only a handful of areas are processed inline.
+		 */
+		purge_threshold = lazy_max_pages() / nr_vmap_nodes;
 
 		for_each_cpu(i, &purge_nodes) {
 			vn = &vmap_nodes[i];
 
-			if (nr_purge_helpers > 0) {
+			if (i != inline_node &&
+					vn->nr_purge_pages >= purge_threshold) {
 				INIT_WORK(&vn->purge_work, purge_vmap_node);
 
 				if (cpumask_test_cpu(i, cpu_online_mask))
 					schedule_work_on(i, &vn->purge_work);
 				else
 					schedule_work(&vn->purge_work);
-
-				nr_purge_helpers--;
 			} else {
 				vn->purge_work.func = NULL;
+			}
+		}
+
+		/* All workers are queued, now drain the others meanwhile */
+		for_each_cpu(i, &purge_nodes) {
+			vn = &vmap_nodes[i];
+
+			if (!vn->purge_work.func) {
 				purge_vmap_node(&vn->purge_work);
 				nr_purged_areas += vn->nr_purged;
 			}
@@ -2333,6 +2355,7 @@ static void free_vmap_area_noflush(struct vmap_area *va)
 {
 	unsigned long nr_lazy_max = lazy_max_pages();
 	unsigned long va_start = va->va_start;
+	unsigned long nr = (va->va_end - va->va_start) >> PAGE_SHIFT;
 	unsigned int vn_id = decode_vn_id(va->flags);
 	struct vmap_node *vn;
 	unsigned long nr_lazy;
@@ -2340,8 +2363,7 @@ static void free_vmap_area_noflush(struct vmap_area *va)
 	if (WARN_ON_ONCE(!list_empty(&va->list)))
 		return;
 
-	nr_lazy = atomic_long_add_return((va->va_end - va->va_start) >>
-				PAGE_SHIFT, &vmap_lazy_nr);
+	nr_lazy = atomic_long_add_return(nr, &vmap_lazy_nr);
 
 	/*
 	 * If it was request by a certain node we would like to
@@ -2352,6 +2374,7 @@ static void free_vmap_area_noflush(struct vmap_area *va)
 
 	spin_lock(&vn->lazy.lock);
 	insert_vmap_area(va, &vn->lazy.root, &vn->lazy.head);
+	vn->nr_lazy += nr;
 	spin_unlock(&vn->lazy.lock);
 
 	trace_free_vmap_area_noflush(va_start, nr_lazy, nr_lazy_max);
@@ -5053,6 +5076,7 @@ static void vmap_init_nodes(void)
 		vn->lazy.root = RB_ROOT;
 		INIT_LIST_HEAD(&vn->lazy.head);
 		spin_lock_init(&vn->lazy.lock);
+		vn->nr_lazy = 0;
 
 		for (i = 0; i < MAX_VA_SIZE_PAGES; i++) {
 			INIT_LIST_HEAD(&vn->pool[i].head);
@@ -5099,6 +5099,114 @@ static void lru_gen_change_state(bool enabled)
 	cgroup_unlock();
 }
 
+/******************************************************************************
+ *                          proactive reclaim
+ ******************************************************************************/
+
+/* the period of proactive aging and reclaim in jiffies, 0 means disabled */
+static unsigned long lru_gen_proactive_period __read_mostly;
+/* the refaults per second at which a memcg is no longer proactively reclaimed */
+static unsigned long lru_gen_proactive_refaults __read_mostly;
+
+static void lru_gen_proactive_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(lru_gen_proactive_work, lru_gen_proactive_fn);
+
+static void lru_gen_proactive_lruvec(struct lruvec *lruvec, struct scan_control *sc,
+				     unsigned long period, unsigned long target)
+{
+	int gen;
+	unsigned long seq, refaults, rate;
+	int swappiness = get_swappiness(lruvec, sc);
+	struct lru_gen_folio *lrugen = &lruvec->lrugen;
+	DEFINE_MAX_SEQ(lruvec);
+	DEFINE_MIN_SEQ(lruvec);
+
+	/* keep the youngest generation no older than one period */
+	gen = lru_gen_from_seq(max_seq);
+	if (min_seq[!swappiness] + MAX_NR_GENS - 1 > max_seq &&
+	    time_is_before_jiffies(READ_ONCE(lrugen->timestamps[gen]) + period))
+		try_to_inc_max_seq(lruvec, max_seq, swappiness, false);
+
+	refaults = lruvec_page_state(lruvec, WORKINGSET_REFAULT_ANON) +
+		   lruvec_page_state(lruvec, WORKINGSET_REFAULT_FILE);
+	rate = (refaults - lrugen->proactive_refaults) * HZ / period;
+	lrugen->proactive_refaults = refaults;
+
+	/* the working set is already under pressure, leave it to reclaim */
+	if (rate >= target)
+		return;
+
+	/* only evict generations that have been through a full round of aging */
+	seq = READ_ONCE(lrugen->min_seq[!swappiness]);
+	if (seq + MIN_NR_GENS > READ_ONCE(lrugen->max_seq))
+		return;
+
+	sc->nr_reclaimed = 0;
+
+	while (sc->nr_reclaimed < sc->nr_to_reclaim &&
+	       READ_ONCE(lrugen->min_seq[!swappiness]) == seq) {
+		if (!evict_folios(lruvec, sc, swappiness))
+			break;
+
+		cond_resched();
+	}
+}
+
+static void lru_gen_proactive_fn(struct work_struct *work)
+{
+	int nid;
+	unsigned int flags;
+	struct blk_plug plug;
+	unsigned long period = READ_ONCE(lru_gen_proactive_period);
+	unsigned long target = READ_ONCE(lru_gen_proactive_refaults);
+	struct scan_control sc = {
+		.nr_to_reclaim = MAX_LRU_BATCH,
+		.may_writepage = true,
+		.may_unmap = true,
+		.may_swap = true,
+		.proactive = true,
+		.priority = DEF_PRIORITY,
+		.reclaim_idx = MAX_NR_ZONES - 1,
+		.gfp_mask = GFP_KERNEL,
+	};
+
+	if (!period)
+		return;
+
+	if (!lru_gen_enabled())
+		goto requeue;
+
+	mem_cgroup_flush_stats_ratelimited(NULL);
+
+	set_task_reclaim_state(current, &sc.reclaim_state);
+	flags = memalloc_noreclaim_save();
+	blk_start_plug(&plug);
+	set_mm_walk(NULL, true);
+
+	for_each_node_state(nid, N_MEMORY) {
+		struct mem_cgroup *memcg = mem_cgroup_iter(NULL, NULL, NULL);
+
+		do {
+			struct lruvec *lruvec = get_lruvec(memcg, nid);
+
+			mem_cgroup_calculate_protection(NULL, memcg);
+
+			if (!mem_cgroup_below_min(NULL, memcg) &&
+			    !mem_cgroup_below_low(NULL, memcg))
+				lru_gen_proactive_lruvec(lruvec, &sc, period, target);
+
+			cond_resched();
+		} while ((memcg = mem_cgroup_iter(NULL, memcg, NULL)));
+	}
+
+	clear_mm_walk();
+	blk_finish_plug(&plug);
+	memalloc_noreclaim_restore(flags);
+	set_task_reclaim_state(current, NULL);
+requeue:
+	queue_delayed_work(system_unbound_wq, &lru_gen_proactive_work, period);
+}
+
 /******************************************************************************
  *                          sysfs interface
  ******************************************************************************/
@@ -5124,6 +5232,64 @@ static ssize_t min_ttl_ms_store(struct kobject *kobj, struct kobj_attribute *att
 
 static struct kobj_attribute lru_gen_min_ttl_attr = __ATTR_RW(min_ttl_ms);
 
+static ssize_t proactive_ms_show(struct kobject *kobj, struct kobj_attribute *attr,
+				 char *buf)
+{
+	return sysfs_emit(buf, "%u\n",
+			  jiffies_to_msecs(READ_ONCE(lru_gen_proactive_period)));
+}
+
+/*
+ * proactive_ms: every this many milliseconds, age each memcg so that its
+ * youngest generation is no older than the period, and evict its oldest
+ * generation unless it refaults at proactive_refaults or more. 0 disables.
+ */
+static ssize_t proactive_ms_store(struct kobject *kobj, struct kobj_attribute *attr,
+				  const char *buf, size_t len)
+{
+	unsigned int msecs;
+	unsigned long period;
+
+	if (kstrtouint(buf, 0, &msecs))
+		return -EINVAL;
+
+	period = msecs_to_jiffies(msecs);
+	WRITE_ONCE(lru_gen_proactive_period, period);
+	if (period)
+		mod_delayed_work(system_unbound_wq, &lru_gen_proactive_work, period);
+
+	return len;
+}
+
+static struct kobj_attribute lru_gen_proactive_ms_attr = __ATTR_RW(proactive_ms);
+
+static ssize_t proactive_refaults_show(struct kobject *kobj,
+				       struct kobj_attribute *attr, char *buf)
+{
+	return sysfs_emit(buf, "%lu\n", READ_ONCE(lru_gen_proactive_refaults));
+}
+
+/*
+ * proactive_refaults: the refaults per second at or above which a memcg is
+ * considered under pressure and left alone by proactive reclaim.
+ */
+static ssize_t proactive_refaults_store(struct kobject *kobj,
+					struct kobj_attribute *attr,
+					const char *buf, size_t len)
+{
+	unsigned long refaults;
+
+	if (kstrtoul(buf, 0, &refaults))
+		return -EINVAL;
+
+	WRITE_ONCE(lru_gen_proactive_refaults, refaults);
+
+	return len;
+}
+
+static struct kobj_attribute lru_gen_proactive_refaults_attr =
+	__ATTR_RW(proactive_refaults);
+
 static ssize_t enabled_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
 {
 	unsigned int caps = 0;
@@ -5172,6 +5338,8 @@ static struct kobj_attribute lru_gen_enabled_attr = __ATTR_RW(enabled);
 
 static struct attribute *lru_gen_attrs[] = {
 	&lru_gen_min_ttl_attr.attr,
+	&lru_gen_proactive_ms_attr.attr,
+	&lru_gen_proactive_refaults_attr.attr,
 	&lru_gen_enabled_attr.attr,
 	NULL
 };
@@ -1377,6 +1377,10 @@ const char * const vmstat_text[] = {
 	"thp_swpout",
 	"thp_swpout_fallback",
 #endif
+#ifdef CONFIG_PAGE_REPORTING
+	"page_reported",
+	"page_reported_reused",
+#endif
 #ifdef CONFIG_MEMORY_BALLOON
 	"balloon_inflate",
 	"balloon_deflate",
@@ -1415,6 +1419,8 @@ const char * const vmstat_text[] = {
 	"vma_lock_abort",
 	"vma_lock_retry",
 	"vma_lock_miss",
+	"vma_lock_madvise",
+	"vma_lock_madvise_fallback",
 #endif
 #endif /* CONFIG_VM_EVENT_COUNTERS || CONFIG_MEMCG */
 };
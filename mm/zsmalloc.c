@@ -1950,15 +1950,19 @@ static unsigned long __zs_compact(struct zs_pool *pool,
 		}
 		src_zspage = NULL;
 
-		if (get_fullness_group(class, dst_zspage) == ZS_INUSE_RATIO_100
-		    || spin_is_contended(&pool->lock)) {
-			putback_zspage(class, dst_zspage);
-			dst_zspage = NULL;
-
-			spin_unlock(&pool->lock);
-			cond_resched();
-			spin_lock(&pool->lock);
-		}
+		/*
+		 * Don't hold pool->lock across more than one source zspage,
+		 * zs_malloc() and zs_free() on every class wait for it. The
+		 * destination goes back on its fullness list before the lock
+		 * is dropped, and the fullest zspage is picked again the next
+		 * time around.
+		 */
+		putback_zspage(class, dst_zspage);
+		dst_zspage = NULL;
+
+		spin_unlock(&pool->lock);
+		cond_resched();
+		spin_lock(&pool->lock);
 	}
 
 	if (src_zspage)
@@ -1991,6 +1995,9 @@ unsigned long zs_compact(struct zs_pool *pool)
 		class = pool->size_class[i];
 		if (class->index != i)
 			continue;
+		/* racy, but avoids taking pool->lock for classes with no waste */
+		if (!zs_can_compact(class))
+			continue;
 		pages_freed += __zs_compact(pool, class);
 	}
 	atomic_long_add(pages_freed, &pool->stats.pages_compacted);
@@ -899,9 +899,10 @@ static int zswap_cpu_comp_dead(unsigned int cpu, struct hlist_node *node)
 	return 0;
 }
 
-static bool zswap_compress(struct folio *folio, struct zswap_entry *entry)
+/* Called with acomp_ctx->mutex held */
+static bool zswap_compress(struct page *page, struct zswap_entry *entry,
+			   struct crypto_acomp_ctx *acomp_ctx)
 {
-	struct crypto_acomp_ctx *acomp_ctx;
 	struct scatterlist input, output;
 	int comp_ret = 0, alloc_ret = 0;
 	unsigned int dlen = PAGE_SIZE;
@@ -911,13 +912,9 @@ static bool zswap_compress(struct folio *folio, struct zswap_entry *entry)
 	gfp_t gfp;
 	u8 *dst;
 
-	acomp_ctx = raw_cpu_ptr(entry->pool->acomp_ctx);
-
-	mutex_lock(&acomp_ctx->mutex);
-
 	dst = acomp_ctx->buffer;
 	sg_init_table(&input, 1);
-	sg_set_page(&input, &folio->page, PAGE_SIZE, 0);
+	sg_set_page(&input, page, PAGE_SIZE, 0);
 
 	/*
 	 * We need PAGE_SIZE * 2 here since there maybe over-compression case,
@@ -938,6 +935,8 @@ static bool zswap_compress(struct folio *folio, struct zswap_entry *entry)
 	 * in one thread doing zwap.
 	 * but in different threads running on different cpu, we have different
 	 * acomp instance, so multiple threads can do (de)compression in parallel.
+	 * Large folios are compressed in batches under a single acquisition of
+	 * the acomp context, see zswap_store_pages().
 	 */
 	comp_ret = crypto_wait_req(crypto_acomp_compress(acomp_ctx->req), &acomp_ctx->wait);
 	dlen = acomp_ctx->req->dlen;
@@ -967,7 +966,6 @@ static bool zswap_compress(struct folio *folio, struct zswap_entry *entry)
 	else if (alloc_ret)
 		zswap_reject_alloc_fail++;
 
-	mutex_unlock(&acomp_ctx->mutex);
 	return comp_ret == 0 && alloc_ret == 0;
 }
 
@@ -1373,14 +1371,14 @@ static void shrink_worker(struct work_struct *w)
 /*********************************
 * same-filled functions
 **********************************/
-static bool zswap_is_folio_same_filled(struct folio *folio, unsigned long *value)
+static bool zswap_is_page_same_filled(struct page *src, unsigned long *value)
 {
 	unsigned long *page;
 	unsigned long val;
 	unsigned int pos, last_pos = PAGE_SIZE / sizeof(*page) - 1;
 	bool ret = false;
 
-	page = kmap_local_folio(folio, 0);
+	page = kmap_local_page(src);
 	val = page[0];
 
 	if (val != page[last_pos])
@@ -1409,23 +1407,151 @@ static void zswap_fill_page(void *ptr, unsigned long value)
 /*********************************
 * main API
 **********************************/
+/* Number of pages compressed under one acquisition of the acomp context */
+#define ZSWAP_STORE_BATCH	8
+
+/* Free an entry that never made it into the tree */
+static void zswap_entry_discard(struct zswap_entry *entry)
+{
+	if (entry->length) {
+		zpool_free(zswap_find_zpool(entry), entry->handle);
+		zswap_pool_put(entry->pool);
+	}
+	zswap_entry_cache_free(entry);
+}
+
+/*
+ * Store pages [start, end) of @folio. The entries are allocated first, then
+ * all pages are compressed back to back while holding the acomp context, and
+ * only then published in the tree, so the per-cpu context isn't held across
+ * the xarray and entry allocations. On failure the entries already stored
+ * are left for the caller to erase.
+ */
+static bool zswap_store_pages(struct folio *folio, long start, long end,
+			      struct obj_cgroup *objcg, struct zswap_pool *pool)
+{
+	struct zswap_entry *entries[ZSWAP_STORE_BATCH];
+	struct crypto_acomp_ctx *acomp_ctx;
+	swp_entry_t swp = folio->swap;
+	long i, nr = end - start;
+	unsigned long value;
+	bool ret = true;
+
+	for (i = 0; i < nr; i++) {
+		entries[i] = zswap_entry_cache_alloc(GFP_KERNEL, folio_nid(folio));
+		if (!entries[i]) {
+			zswap_reject_kmemcache_fail++;
+			nr = i;
+			i = 0;
+			ret = false;
+			goto discard;
+		}
+		entries[i]->pool = pool;
+		entries[i]->length = 0;
+	}
+
+	acomp_ctx = raw_cpu_ptr(pool->acomp_ctx);
+	mutex_lock(&acomp_ctx->mutex);
+	for (i = 0; i < nr; i++) {
+		struct page *page = folio_page(folio, start + i);
+
+		if (zswap_is_page_same_filled(page, &value)) {
+			entries[i]->value = value;
+			continue;
+		}
+
+		if (!zswap_compress(page, entries[i], acomp_ctx)) {
+			i = 0;
+			ret = false;
+			break;
+		}
+
+		/*
+		 * The caller's reference keeps the pool alive; if the entry is
+		 * successfully added, it keeps this one.
+		 */
+		percpu_ref_get(&pool->ref);
+	}
+	mutex_unlock(&acomp_ctx->mutex);
+
+	if (!ret)
+		goto discard;
+
+	for (i = 0; i < nr; i++) {
+		struct zswap_entry *entry = entries[i], *old;
+		pgoff_t offset = swp_offset(swp) + start + i;
+
+		entry->swpentry = swp_entry(swp_type(swp), offset);
+		entry->objcg = objcg;
+
+		old = xa_store(swap_zswap_tree(entry->swpentry), offset, entry,
+			       GFP_KERNEL);
+		if (xa_is_err(old)) {
+			int err = xa_err(old);
+
+			WARN_ONCE(err != -ENOMEM, "unexpected xarray error: %d\n", err);
+			zswap_reject_alloc_fail++;
+			ret = false;
+			goto discard;
+		}
+
+		/*
+		 * We may have had an existing entry that became stale when
+		 * the folio was redirtied and now the new version is being
+		 * swapped out. Get rid of the old.
+		 */
+		if (old)
+			zswap_entry_free(old);
+
+		if (objcg) {
+			obj_cgroup_get(objcg);
+			obj_cgroup_charge_zswap(objcg, entry->length);
+			count_objcg_event(objcg, ZSWPOUT);
+		}
+
+		/*
+		 * We finish initializing the entry while it's already in xarray.
+		 * This is safe because:
+		 *
+		 * 1. Concurrent stores and invalidations are excluded by folio lock.
+		 *
+		 * 2. Writeback is excluded by the entry not being on the LRU yet.
+		 *    The publishing order matters to prevent writeback from seeing
+		 *    an incoherent entry.
+		 */
+		if (entry->length) {
+			INIT_LIST_HEAD(&entry->lru);
+			zswap_lru_add(&zswap_list_lru, entry);
+		} else {
+			atomic_inc(&zswap_same_filled_pages);
+		}
+
+		/* update stats */
+		atomic_inc(&zswap_stored_pages);
+		count_vm_event(ZSWPOUT);
+	}
+
+	return true;
+
+discard:
+	for (; i < nr; i++)
+		zswap_entry_discard(entries[i]);
+	return ret;
+}
+
 bool zswap_store(struct folio *folio)
 {
+	long nr_pages = folio_nr_pages(folio);
 	swp_entry_t swp = folio->swap;
-	pgoff_t offset = swp_offset(swp);
-	struct xarray *tree = swap_zswap_tree(swp);
-	struct zswap_entry *entry, *old;
 	struct obj_cgroup *objcg = NULL;
 	struct mem_cgroup *memcg = NULL;
-	unsigned long value;
+	struct zswap_pool *pool;
+	struct zswap_entry *entry;
+	long index;
 
 	VM_WARN_ON_ONCE(!folio_test_locked(folio));
 	VM_WARN_ON_ONCE(!folio_test_swapcache(folio));
 
-	/* Large folios aren't supported */
-	if (folio_test_large(folio))
-		return false;
-
 	if (!zswap_enabled)
 		goto check_old;
 
@@ -1443,24 +1569,9 @@ bool zswap_store(struct folio *folio)
 	if (zswap_check_limits())
 		goto reject;
 
-	/* allocate entry */
-	entry = zswap_entry_cache_alloc(GFP_KERNEL, folio_nid(folio));
-	if (!entry) {
-		zswap_reject_kmemcache_fail++;
+	pool = zswap_pool_current_get();
+	if (!pool)
 		goto reject;
-	}
-
-	if (zswap_is_folio_same_filled(folio, &value)) {
-		entry->length = 0;
-		entry->value = value;
-		atomic_inc(&zswap_same_filled_pages);
-		goto store_entry;
-	}
-
-	/* if entry is successfully added, it keeps the reference */
-	entry->pool = zswap_pool_current_get();
-	if (!entry->pool)
-		goto freepage;
 
 	if (objcg) {
 		memcg = get_mem_cgroup_from_objcg(objcg);
@@ -1471,66 +1582,19 @@ bool zswap_store(struct folio *folio)
 		mem_cgroup_put(memcg);
 	}
 
-	if (!zswap_compress(folio, entry))
-		goto put_pool;
-
-store_entry:
-	entry->swpentry = swp;
-	entry->objcg = objcg;
-
-	old = xa_store(tree, offset, entry, GFP_KERNEL);
-	if (xa_is_err(old)) {
-		int err = xa_err(old);
-
-		WARN_ONCE(err != -ENOMEM, "unexpected xarray error: %d\n", err);
-		zswap_reject_alloc_fail++;
-		goto store_failed;
-	}
-
-	/*
-	 * We may have had an existing entry that became stale when
-	 * the folio was redirtied and now the new version is being
-	 * swapped out. Get rid of the old.
-	 */
-	if (old)
-		zswap_entry_free(old);
+	for (index = 0; index < nr_pages; index += ZSWAP_STORE_BATCH) {
+		long end = min(index + ZSWAP_STORE_BATCH, nr_pages);
 
-	if (objcg) {
-		obj_cgroup_charge_zswap(objcg, entry->length);
-		count_objcg_event(objcg, ZSWPOUT);
-	}
-
-	/*
-	 * We finish initializing the entry while it's already in xarray.
-	 * This is safe because:
-	 *
-	 * 1. Concurrent stores and invalidations are excluded by folio lock.
-	 *
-	 * 2. Writeback is excluded by the entry not being on the LRU yet.
-	 *    The publishing order matters to prevent writeback from seeing
-	 *    an incoherent entry.
-	 */
-	if (entry->length) {
-		INIT_LIST_HEAD(&entry->lru);
-		zswap_lru_add(&zswap_list_lru, entry);
+		if (!zswap_store_pages(folio, index, end, objcg, pool))
+			goto put_pool;
 	}
 
-	/* update stats */
-	atomic_inc(&zswap_stored_pages);
-	count_vm_event(ZSWPOUT);
-
+	zswap_pool_put(pool);
+	obj_cgroup_put(objcg);
 	return true;
 
-store_failed:
-	if (!entry->length)
-		atomic_dec(&zswap_same_filled_pages);
-	else {
-		zpool_free(zswap_find_zpool(entry), entry->handle);
 put_pool:
-		zswap_pool_put(entry->pool);
-	}
-freepage:
-	zswap_entry_cache_free(entry);
+	zswap_pool_put(pool);
 reject:
 	obj_cgroup_put(objcg);
 	if (zswap_pool_reached_full)
@@ -1538,12 +1602,18 @@ bool zswap_store(struct folio *folio)
 check_old:
 	/*
 	 * If the zswap store fails or zswap is disabled, we must invalidate the
-	 * possibly stale entry which was previously stored at this offset.
+	 * possibly stale entries which were previously stored at the folio's
+	 * offsets, as well as those stored for the folio before the failure.
 	 * Otherwise, writeback could overwrite the new data in the swapfile.
 	 */
-	entry = xa_erase(tree, offset);
-	if (entry)
-		zswap_entry_free(entry);
+	for (index = 0; index < nr_pages; index++) {
+		pgoff_t offset = swp_offset(swp) + index;
+
+		entry = xa_erase(swap_zswap_tree(swp_entry(swp_type(swp), offset)),
+				 offset);
+		if (entry)
+			zswap_entry_free(entry);
+	}
 	return false;
 }
 
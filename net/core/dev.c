@@ -3780,9 +3780,11 @@ static inline int __dev_xmit_skb(struct sk_buff *skb, struct Qdisc *q,
 				 struct net_device *dev,
 				 struct netdev_queue *txq)
 {
+	struct sk_buff *next, *to_free = NULL;
 	spinlock_t *root_lock = qdisc_lock(q);
-	struct sk_buff *to_free = NULL;
-	bool contended;
+	struct llist_node *ll_list, *first_n;
+	unsigned long defer_count = 0;
+	unsigned int limit;
 	int rc;
 
 	qdisc_calculate_pkt_len(skb, q);
@@ -3826,63 +3828,92 @@ static inline int __dev_xmit_skb(struct sk_buff *skb, struct Qdisc *q,
 		kfree_skb_reason(skb, SKB_DROP_REASON_TC_RECLASSIFY_LOOP);
 		return NET_XMIT_DROP;
 	}
+
 	/*
-	 * Heuristic to force contended enqueues to serialize on a
-	 * separate lock before trying to get qdisc main lock.
-	 * This permits qdisc->running owner to get the lock more
-	 * often and dequeue packets faster.
-	 * On PREEMPT_RT it is possible to preempt the qdisc owner during xmit
-	 * and then other tasks will only enqueue packets. The packets will be
-	 * sent after the qdisc owner is scheduled again. To prevent this
-	 * scenario the task always serialize on the lock.
+	 * Instead of having every producer spin on the qdisc lock, queue
+	 * the skb on a lockless list. Only the producer which finds the
+	 * list empty takes the lock, and enqueues everything that has been
+	 * queued meanwhile in one go. The others return immediately, so
+	 * that the qdisc->running owner gets the lock more often and
+	 * dequeues packets faster.
 	 */
-	contended = qdisc_is_running(q) || IS_ENABLED(CONFIG_PREEMPT_RT);
-	if (unlikely(contended))
-		spin_lock(&q->busylock);
+	first_n = READ_ONCE(q->defer_list.first);
+	do {
+		if (first_n && !defer_count) {
+			/* Not all qdiscs maintain sch->limit, bound the
+			 * list by the device queue length for those.
+			 */
+			limit = READ_ONCE(q->limit) ?:
+				max(READ_ONCE(dev->tx_queue_len), 1U);
+			defer_count = atomic_long_inc_return(&q->defer_count);
+			if (unlikely(defer_count > limit)) {
+				kfree_skb_reason(skb, SKB_DROP_REASON_QDISC_DROP);
+				return NET_XMIT_DROP;
+			}
+		}
+		skb->ll_node.next = first_n;
+	} while (!try_cmpxchg(&q->defer_list.first, &first_n, &skb->ll_node));
+
+	/* If the list was not empty, its owner will enqueue our skb */
+	if (first_n)
+		return NET_XMIT_SUCCESS;
 
 	spin_lock(root_lock);
+
+	ll_list = llist_del_all(&q->defer_list);
+	/* There is a small race because we clear defer_count not atomically
+	 * with the prior llist_del_all(). This means defer_list could grow
+	 * over its limit.
+	 */
+	atomic_long_set(&q->defer_count, 0);
+
+	ll_list = llist_reverse_order(ll_list);
+
 	if (unlikely(test_bit(__QDISC_STATE_DEACTIVATED, &q->state))) {
-		__qdisc_drop(skb, &to_free);
+		llist_for_each_entry_safe(skb, next, ll_list, ll_node)
+			__qdisc_drop(skb, &to_free);
 		rc = NET_XMIT_DROP;
-	} else if ((q->flags & TCQ_F_CAN_BYPASS) && !qdisc_qlen(q) &&
-		   qdisc_run_begin(q)) {
+		goto unlock;
+	}
+	if ((q->flags & TCQ_F_CAN_BYPASS) && !qdisc_qlen(q) &&
+	    !llist_next(ll_list) && qdisc_run_begin(q)) {
 		/*
 		 * This is a work-conserving queue; there are no old skbs
 		 * waiting to be sent out; and the qdisc is not running -
 		 * xmit the skb directly.
 		 */
 
+		DEBUG_NET_WARN_ON_ONCE(skb != llist_entry(ll_list,
+							   struct sk_buff,
+							   ll_node));
 		qdisc_bstats_update(q, skb);
-
-		if (sch_direct_xmit(skb, q, dev, txq, root_lock, true)) {
-			if (unlikely(contended)) {
-				spin_unlock(&q->busylock);
-				contended = false;
-			}
+		if (sch_direct_xmit(skb, q, dev, txq, root_lock, true))
 			__qdisc_run(q);
-		}
-
 		qdisc_run_end(q);
 		rc = NET_XMIT_SUCCESS;
 	} else {
+		int count = 0;
+
 		WRITE_ONCE(q->owner, smp_processor_id());
-		rc = dev_qdisc_enqueue(skb, q, &to_free, txq);
-		WRITE_ONCE(q->owner, -1);
-		if (qdisc_run_begin(q)) {
-			if (unlikely(contended)) {
-				spin_unlock(&q->busylock);
-				contended = false;
-			}
-			__qdisc_run(q);
-			qdisc_run_end(q);
+		llist_for_each_entry_safe(skb, next, ll_list, ll_node) {
+			prefetch(next);
+			skb_mark_not_on_list(skb);
+			rc = dev_qdisc_enqueue(skb, q, &to_free, txq);
+			count++;
 		}
+		WRITE_ONCE(q->owner, -1);
+		qdisc_run(q);
+		/* Only report the enqueue result of a lone skb, the other
+		 * producers have been told NET_XMIT_SUCCESS already.
+		 */
+		if (count != 1)
+			rc = NET_XMIT_SUCCESS;
 	}
+unlock:
 	spin_unlock(root_lock);
 	if (unlikely(to_free))
 		kfree_skb_list_reason(to_free,
 				      tcf_get_drop_reason(to_free));
-	if (unlikely(contended))
-		spin_unlock(&q->busylock);
 	return rc;
 }
 
@@ -4459,6 +4490,91 @@ int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id)
 }
 EXPORT_SYMBOL(__dev_direct_xmit);
 
+/**
+ * __dev_direct_xmit_list - transmit a list of skbs bypassing the qdisc
+ * @skb: skbs linked through skb->next, all for the same device
+ * @queue_id: tx queue to use
+ * @ret: NET_XMIT_DROP if any skb was dropped, otherwise the driver status
+ *	 of the last skb handed over
+ *
+ * Like __dev_direct_xmit(), but takes the tx lock once for the whole list
+ * and sets xmit_more, so that the driver can defer its doorbell to the
+ * last skb.
+ *
+ * Return: the skbs not sent because the queue was busy, still linked, or
+ * NULL.
+ */
+struct sk_buff *__dev_direct_xmit_list(struct sk_buff *skb, u16 queue_id,
+				       int *ret)
+{
+	struct net_device *dev = skb->dev;
+	struct sk_buff *next, *orig_skb, *head = NULL, **tail = &head;
+	struct netdev_queue *txq;
+	bool again = false;
+	int rc = NETDEV_TX_OK;
+
+	*ret = NETDEV_TX_OK;
+	if (unlikely(!netif_running(dev) ||
+		     !netif_carrier_ok(dev))) {
+		for (; skb; skb = next) {
+			next = skb->next;
+			dev_core_stats_tx_dropped_inc(dev);
+			kfree_skb(skb);
+		}
+		*ret = NET_XMIT_DROP;
+		return NULL;
+	}
+
+	for (; skb; skb = next) {
+		next = skb->next;
+		skb_mark_not_on_list(skb);
+		orig_skb = skb;
+		skb = validate_xmit_skb_list(skb, dev, &again);
+		if (skb != orig_skb) {
+			dev_core_stats_tx_dropped_inc(dev);
+			kfree_skb_list(skb);
+			*ret = NET_XMIT_DROP;
+			continue;
+		}
+		skb_set_queue_mapping(skb, queue_id);
+		*tail = skb;
+		tail = &skb->next;
+	}
+	if (!head)
+		return NULL;
+
+	skb = head;
+	txq = skb_get_tx_queue(dev, skb);
+
+	local_bh_disable();
+
+	dev_xmit_recursion_inc();
+	HARD_TX_LOCK(dev, txq, smp_processor_id());
+	while (skb) {
+		if (netif_xmit_frozen_or_drv_stopped(txq)) {
+			rc = NETDEV_TX_BUSY;
+			break;
+		}
+		next = skb->next;
+		skb_mark_not_on_list(skb);
+		rc = netdev_start_xmit(skb, dev, txq, next != NULL);
+		if (unlikely(!dev_xmit_complete(rc))) {
+			skb->next = next;
+			break;
+		}
+		skb = next;
+	}
+	HARD_TX_UNLOCK(dev, txq);
+	dev_xmit_recursion_dec();
+
+	local_bh_enable();
+
+	if (*ret != NET_XMIT_DROP || !dev_xmit_complete(rc))
+		*ret = rc;
+	return skb;
+}
+EXPORT_SYMBOL(__dev_direct_xmit_list);
+
 /*************************************************************************
  *			Receiver routines
  *************************************************************************/
@@ -4511,6 +4627,18 @@ EXPORT_SYMBOL(rps_needed);
 struct static_key_false rfs_needed __read_mostly;
 EXPORT_SYMBOL(rfs_needed);
 
+#ifdef CONFIG_RFS_ACCEL
+/* Packets were enqueued recently using this flow table entry */
+static bool rps_flow_is_active(struct rps_dev_flow *rflow,
+			       struct rps_dev_flow_table *flow_table,
+			       unsigned int cpu)
+{
+	return cpu < nr_cpu_ids &&
+	       ((int)(READ_ONCE(per_cpu(softnet_data, cpu).input_queue_head) -
+		      READ_ONCE(rflow->last_qtail)) < (int)(10 * flow_table->mask));
+}
+#endif
+
 static struct rps_dev_flow *
 set_rps_cpu(struct net_device *dev, struct sk_buff *skb,
 	    struct rps_dev_flow *rflow, u16 next_cpu)
@@ -4520,9 +4648,9 @@ set_rps_cpu(struct net_device *dev, struct sk_buff *skb,
 #ifdef CONFIG_RFS_ACCEL
 		struct netdev_rx_queue *rxqueue;
 		struct rps_dev_flow_table *flow_table;
-		struct rps_dev_flow *old_rflow;
+		struct rps_dev_flow *old_rflow, *tmp_rflow;
 		u16 rxq_index;
-		u32 flow_id;
+		u32 flow_id, hash;
 		int rc;
 
 		/* Should we steer this flow to a different hardware queue? */
@@ -4537,14 +4665,27 @@ set_rps_cpu(struct net_device *dev, struct sk_buff *skb,
 		flow_table = rcu_dereference(rxqueue->rps_flow_table);
 		if (!flow_table)
 			goto out;
-		flow_id = skb_get_hash(skb) & flow_table->mask;
+		hash = skb_get_hash(skb);
+		flow_id = hash & flow_table->mask;
+		tmp_rflow = &flow_table->flows[flow_id];
+
+		/* Don't take over the filter of another active flow which
+		 * collides with this one in the table of the target queue.
+		 */
+		if (READ_ONCE(tmp_rflow->filter) != RPS_NO_FILTER &&
+		    READ_ONCE(tmp_rflow->hash) != hash &&
+		    rps_flow_is_active(tmp_rflow, flow_table,
+				       READ_ONCE(tmp_rflow->cpu)))
+			goto out;
+
 		rc = dev->netdev_ops->ndo_rx_flow_steer(dev, skb,
 							rxq_index, flow_id);
 		if (rc < 0)
 			goto out;
 		old_rflow = rflow;
-		rflow = &flow_table->flows[flow_id];
+		rflow = tmp_rflow;
 		WRITE_ONCE(rflow->filter, rc);
+		WRITE_ONCE(rflow->hash, hash);
 		if (old_rflow->filter == rc)
 			WRITE_ONCE(old_rflow->filter, RPS_NO_FILTER);
 	out:
@@ -4686,10 +4827,8 @@ bool rps_may_expire_flow(struct net_device *dev, u16 rxq_index,
 	if (flow_table && flow_id <= flow_table->mask) {
 		rflow = &flow_table->flows[flow_id];
 		cpu = READ_ONCE(rflow->cpu);
-		if (READ_ONCE(rflow->filter) == filter_id && cpu < nr_cpu_ids &&
-		    ((int)(READ_ONCE(per_cpu(softnet_data, cpu).input_queue_head) -
-			   READ_ONCE(rflow->last_qtail)) <
-		     (int)(10 * flow_table->mask)))
+		if (READ_ONCE(rflow->filter) == filter_id &&
+		    rps_flow_is_active(rflow, flow_table, cpu))
 			expire = false;
 	}
 	rcu_read_unlock();
@@ -479,6 +479,12 @@ static enum gro_result dev_gro_receive(struct napi_struct *napi, struct sk_buff
 	if (netif_elide_gro(skb->dev))
 		goto normal;
 
+	/* Complete flows held since an earlier jiffy, as napi_gro_flush()
+	 * would, before they push out the ones still being merged.
+	 */
+	if (gro_list->count)
+		__napi_gro_flush_chain(napi, bucket, true);
+
 	gro_list_prepare(&gro_list->list, skb);
 
 	rcu_read_lock();
@@ -328,6 +328,23 @@ struct page_pool *page_pool_create(const struct page_pool_params *params)
 EXPORT_SYMBOL(page_pool_create);
 
 static void page_pool_return_page(struct page_pool *pool, struct page *page);
+static bool page_pool_napi_local(const struct page_pool *pool);
+
+/* A pool bound to a NAPI instance follows the node of the CPU the NAPI
+ * runs on, so that it does not keep serving remote memory after the IRQ
+ * affinity changed. Pages from the ring which are on the old node get
+ * released by the refill below.
+ */
+static void page_pool_follow_napi_nid(struct page_pool *pool)
+{
+#ifdef CONFIG_NUMA
+	int nid = numa_mem_id();
+
+	if (unlikely(pool->p.nid != nid) && pool->p.nid != NUMA_NO_NODE &&
+	    READ_ONCE(pool->p.napi) && page_pool_napi_local(pool))
+		page_pool_update_nid(pool, nid);
+#endif
+}
 
 noinline
 static struct page *page_pool_refill_alloc_cache(struct page_pool *pool)
@@ -336,6 +353,8 @@ static struct page *page_pool_refill_alloc_cache(struct page_pool *pool)
 	struct page *page;
 	int pref_nid; /* preferred NUMA node */
 
+	page_pool_follow_napi_nid(pool);
+
 	/* Quicker fallback, avoid locks when ring is empty */
 	if (__ptr_ring_empty(r)) {
 		alloc_stat_inc(pool, empty);
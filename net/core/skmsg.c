@@ -512,7 +512,8 @@ static struct sk_msg *alloc_sk_msg(gfp_t gfp)
 }
 
 static struct sk_msg *sk_psock_create_ingress_msg(struct sock *sk,
-						  struct sk_buff *skb)
+						  struct sk_buff *skb,
+						  gfp_t gfp)
 {
 	if (atomic_read(&sk->sk_rmem_alloc) > sk->sk_rcvbuf)
 		return NULL;
@@ -520,7 +521,7 @@ static struct sk_msg *sk_psock_create_ingress_msg(struct sock *sk,
 	if (!sk_rmem_schedule(sk, skb, skb->truesize))
 		return NULL;
 
-	return alloc_sk_msg(GFP_KERNEL);
+	return alloc_sk_msg(gfp);
 }
 
 static int sk_psock_skb_ingress_enqueue(struct sk_buff *skb,
@@ -573,7 +574,7 @@ static int sk_psock_skb_ingress(struct sk_psock *psock, struct sk_buff *skb,
 	 */
 	if (unlikely(skb->sk == sk))
 		return sk_psock_skb_ingress_self(psock, skb, off, len);
-	msg = sk_psock_create_ingress_msg(sk, skb);
+	msg = sk_psock_create_ingress_msg(sk, skb, GFP_KERNEL);
 	if (!msg)
 		return -EAGAIN;
 
@@ -901,6 +902,62 @@ int sk_psock_msg_verdict(struct sock *sk, struct sk_psock *psock,
 }
 EXPORT_SYMBOL_GPL(sk_psock_msg_verdict);
 
+/* Deliver an ingress redirect from the verdict context instead of bouncing
+ * it through sk_psock_backlog(). This is only done while nothing is queued
+ * on the backlog, so data from one source socket stays in order, and while
+ * the receiving socket is neither owned by user space nor locked by another
+ * CPU, as its memory accounting is updated. The socket lock is only tried,
+ * two sockets redirecting to each other would deadlock otherwise. If the
+ * data can't be delivered right away, the caller falls back to the backlog,
+ * which retries once memory is available.
+ */
+static bool sk_psock_skb_ingress_direct(struct sk_psock *psock,
+					struct sk_buff *skb)
+{
+	unsigned long sk_redir = skb->_sk_redir;
+	struct sock *sk = psock->sk;
+	u32 off = 0, len = skb->len;
+	struct sk_msg *msg;
+	bool done = false;
+
+	if (!sk_psock_test_state(psock, SK_PSOCK_TX_ENABLED) ||
+	    !skb_queue_empty_lockless(&psock->ingress_skb) ||
+	    READ_ONCE(psock->work_state.len))
+		return false;
+
+	if (skb_bpf_strparser(skb)) {
+		struct strp_msg *stm = strp_msg(skb);
+
+		off = stm->offset;
+		len = stm->full_len;
+	}
+
+	local_bh_disable();
+	if (!spin_trylock(&sk->sk_lock.slock))
+		goto out;
+	if (sock_owned_by_user_nocheck(sk) || skb->sk == sk)
+		goto unlock;
+
+	msg = sk_psock_create_ingress_msg(sk, skb, GFP_ATOMIC);
+	if (!msg)
+		goto unlock;
+
+	skb_bpf_redirect_clear(skb);
+	skb_set_owner_r(skb, sk);
+	if (sk_psock_skb_ingress_enqueue(skb, off, len, psock, sk, msg) < 0) {
+		/* the backlog takes the skb as one of its socket's own */
+		skb->_sk_redir = sk_redir;
+		kfree(msg);
+		goto unlock;
+	}
+	done = true;
+unlock:
+	spin_unlock(&sk->sk_lock.slock);
+out:
+	local_bh_enable();
+	return done;
+}
+
 static int sk_psock_skb_redirect(struct sk_psock *from, struct sk_buff *skb)
 {
 	struct sk_psock *psock_other;
@@ -925,6 +982,9 @@ static int sk_psock_skb_redirect(struct sk_psock *from, struct sk_buff *skb)
 		sock_drop(from->sk, skb);
 		return -EIO;
 	}
+	if (skb_bpf_ingress(skb) && sk_psock_skb_ingress_direct(psock_other, skb))
+		return 0;
+
 	spin_lock_bh(&psock_other->ingress_lock);
 	if (!sk_psock_test_state(psock_other, SK_PSOCK_TX_ENABLED)) {
 		spin_unlock_bh(&psock_other->ingress_lock);
@@ -1944,6 +1944,7 @@ static int __init inet_init(void)
 
 	net_hotdata.udp_protocol = (struct net_protocol) {
 		.handler =	udp_rcv,
+		.list_handler =	udp_rcv_list,
 		.err_handler =	udp_err,
 		.no_policy =	1,
 	};
@@ -56,6 +56,7 @@
 #include <linux/skbuff.h>
 #include <linux/netlink.h>
 #include <linux/init.h>
+#include <linux/jhash.h>
 #include <linux/list.h>
 #include <linux/slab.h>
 #include <linux/export.h>
@@ -1334,6 +1335,7 @@ int fib_table_insert(struct net *net, struct fib_table *tb,
 			rtmsg_fib(RTM_NEWROUTE, htonl(key), new_fa, plen,
 				  tb->tb_id, &cfg->fc_nlinfo, nlflags);
 
+			fib_lookup_cache_invalidate();
 			alias_free_mem_rcu(fa);
 
 			fib_release_info(fi_drop);
@@ -1441,6 +1443,122 @@ bool fib_lookup_good_nhc(const struct fib_nh_common *nhc, int fib_flags,
 	return true;
 }
 
+#ifdef CONFIG_IP_FIB_LOOKUP_CACHE
+/* A direct mapped cache of recent fib_table_lookup() results per CPU,
+ * used from softirq context only, i.e. for received and forwarded packets.
+ * All entries are invalidated at once by bumping the generation. This is
+ * done by rt_cache_flush() for everything that changes lookup results
+ * without freeing anything, e.g. a nexthop going down, and whenever an
+ * alias or table is unlinked from a trie, before it is freed. A reader
+ * that sees the old generation therefore holds the RCU read lock since
+ * before the free was queued.
+ */
+#define FIB_LOOKUP_CACHE_SIZE	256
+
+struct fib_lookup_cache_entry {
+	unsigned int		genid;
+	struct fib_table	*tb;
+	__be32			daddr;
+	int			oif;
+	u8			tos;
+	u8			scope;
+	u8			flags;
+	u8			fib_flags;
+	int			err;
+	struct fib_result	res;
+};
+
+static DEFINE_PER_CPU(struct fib_lookup_cache_entry [FIB_LOOKUP_CACHE_SIZE],
+		      fib_lookup_cache);
+static atomic_t fib_lookup_cache_genid;
+
+void fib_lookup_cache_invalidate(void)
+{
+	/* order the unlinking of entries before the new generation */
+	smp_mb__before_atomic();
+	atomic_inc(&fib_lookup_cache_genid);
+}
+
+static struct fib_lookup_cache_entry *
+fib_lookup_cache_slot(const struct fib_table *tb, const struct flowi4 *flp,
+		      unsigned int *genid)
+{
+	u32 hash;
+
+	if (!in_serving_softirq())
+		return NULL;
+
+	/* pairs with the barrier in fib_lookup_cache_invalidate() */
+	*genid = atomic_read_acquire(&fib_lookup_cache_genid);
+	hash = jhash_3words((__force u32)flp->daddr, flp->flowi4_oif,
+			    tb->tb_id, 0);
+	return this_cpu_ptr(&fib_lookup_cache[hash % FIB_LOOKUP_CACHE_SIZE]);
+}
+
+static bool fib_lookup_cache_hit(const struct fib_lookup_cache_entry *fce,
+				 const struct fib_table *tb,
+				 const struct flowi4 *flp, int fib_flags,
+				 unsigned int genid, struct fib_result *res,
+				 int *err)
+{
+	if (fce->genid != genid || fce->tb != tb ||
+	    fce->daddr != flp->daddr || fce->oif != flp->flowi4_oif ||
+	    fce->tos != flp->flowi4_tos ||
+	    fce->scope != flp->flowi4_scope ||
+	    fce->flags != flp->flowi4_flags ||
+	    fce->fib_flags != (fib_flags & ~FIB_LOOKUP_NOREF))
+		return false;
+
+	*res = fce->res;
+	*err = fce->err;
+	return true;
+}
+
+static void fib_lookup_cache_fill(struct fib_lookup_cache_entry *fce,
+				  struct fib_table *tb,
+				  const struct flowi4 *flp, int fib_flags,
+				  unsigned int genid,
+				  const struct fib_result *res, int err)
+{
+	fce->genid = genid;
+	fce->tb = tb;
+	fce->daddr = flp->daddr;
+	fce->oif = flp->flowi4_oif;
+	fce->tos = flp->flowi4_tos;
+	fce->scope = flp->flowi4_scope;
+	fce->flags = flp->flowi4_flags;
+	fce->fib_flags = fib_flags & ~FIB_LOOKUP_NOREF;
+	fce->err = err;
+	fce->res = *res;
+}
+#else
+struct fib_lookup_cache_entry;
+
+static struct fib_lookup_cache_entry *
+fib_lookup_cache_slot(const struct fib_table *tb, const struct flowi4 *flp,
+		      unsigned int *genid)
+{
+	return NULL;
+}
+
+static bool fib_lookup_cache_hit(const struct fib_lookup_cache_entry *fce,
+				 const struct fib_table *tb,
+				 const struct flowi4 *flp, int fib_flags,
+				 unsigned int genid, struct fib_result *res,
+				 int *err)
+{
+	return false;
+}
+
+static void fib_lookup_cache_fill(struct fib_lookup_cache_entry *fce,
+				  struct fib_table *tb,
+				  const struct flowi4 *flp, int fib_flags,
+				  unsigned int genid,
+				  const struct fib_result *res, int err)
+{
+}
+#endif
+
 /* should be called with rcu_read_lock */
 int fib_table_lookup(struct fib_table *tb, const struct flowi4 *flp,
 		     struct fib_result *res, int fib_flags)
@@ -1450,10 +1568,22 @@ int fib_table_lookup(struct fib_table *tb, const struct flowi4 *flp,
 	struct trie_use_stats __percpu *stats = t->stats;
 #endif
 	const t_key key = ntohl(flp->daddr);
+	struct fib_lookup_cache_entry *fce;
 	struct key_vector *n, *pn;
+	unsigned int genid = 0;
 	struct fib_alias *fa;
 	unsigned long index;
 	t_key cindex;
+	int cached_err;
+
+	fce = fib_lookup_cache_slot(tb, flp, &genid);
+	if (fce && fib_lookup_cache_hit(fce, tb, flp, fib_flags, genid, res,
+					&cached_err)) {
+		if (!(fib_flags & FIB_LOOKUP_NOREF))
+			refcount_inc(&res->fi->fib_clntref);
+		trace_fib_table_lookup(tb->tb_id, flp, res->nhc, cached_err);
+		return cached_err;
+	}
 
 	pn = t->kv;
 	cindex = 0;
@@ -1632,6 +1762,9 @@ int fib_table_lookup(struct fib_table *tb, const struct flowi4 *flp,
 			res->fi = fi;
 			res->table = tb;
 			res->fa_head = &n->leaf;
+			if (fce)
+				fib_lookup_cache_fill(fce, tb, flp, fib_flags,
+						      genid, res, err);
 #ifdef CONFIG_IP_FIB_TRIE_STATS
 			this_cpu_inc(stats->semantic_match_passed);
 #endif
@@ -1657,6 +1790,7 @@ static void fib_remove_alias(struct trie *t, struct key_vector *tp,
 
 	/* remove the fib_alias from the list */
 	hlist_del_rcu(&old->fa_list);
+	fib_lookup_cache_invalidate();
 
 	/* if we emptied the list this leaf will be freed and we can sort
 	 * out parent suffix lengths as a part of trie_rebalance
@@ -2006,6 +2140,7 @@ void fib_table_flush_external(struct fib_table *tb)
 			 */
 			if (tb->tb_id != fa->tb_id) {
 				hlist_del_rcu(&fa->fa_list);
+				fib_lookup_cache_invalidate();
 				alias_free_mem_rcu(fa);
 				continue;
 			}
@@ -2095,6 +2230,7 @@ int fib_table_flush(struct net *net, struct fib_table *tb, bool flush_all)
 				rtmsg_fib(RTM_DELROUTE, htonl(n->key), fa,
 					  KEYLENGTH - fa->fa_slen, tb->tb_id, &info, 0);
 			hlist_del_rcu(&fa->fa_list);
+			fib_lookup_cache_invalidate();
 			fib_release_info(fa->fa_info);
 			alias_free_mem_rcu(fa);
 			found++;
@@ -2263,6 +2399,7 @@ static void __trie_free_rcu(struct rcu_head *head)
 
 void fib_free_table(struct fib_table *tb)
 {
+	fib_lookup_cache_invalidate();
 	call_rcu(&tb->rcu, __trie_free_rcu);
 }
 
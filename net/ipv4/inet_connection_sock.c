@@ -632,7 +632,11 @@ static int inet_csk_wait_for_connect(struct sock *sk, long timeo)
 	 * beginning of the wait-queue. As such, it's ok to "drop"
 	 * our exclusiveness temporarily when we get woken up without
 	 * having to remove and re-insert us on the wait queue.
+	 *
+	 * Any acceptor can take the connection, so let the waker prefer
+	 * one that last ran in its LLC over the oldest one.
 	 */
+	wait.flags |= WQ_FLAG_AFFINE;
 	for (;;) {
 		prepare_to_wait_exclusive(sk_sleep(sk), &wait,
 					  TASK_INTERRUPTIBLE);
@@ -257,6 +257,98 @@ int ip_local_deliver(struct sk_buff *skb)
 }
 EXPORT_SYMBOL(ip_local_deliver);
 
+static void ip_list_deliver_proto(struct list_head *head,
+				  const struct net_protocol *ipprot)
+{
+	if (!list_empty(head)) {
+		ipprot->list_handler(head);
+		INIT_LIST_HEAD(head);
+	}
+}
+
+static void ip_local_deliver_list_finish(struct net *net,
+					 struct list_head *head)
+{
+	const struct net_protocol *ipprot, *curr_prot = NULL;
+	struct sk_buff *skb, *next;
+	struct list_head sublist;
+	int protocol;
+
+	INIT_LIST_HEAD(&sublist);
+	rcu_read_lock();
+	list_for_each_entry_safe(skb, next, head, list) {
+		skb_list_del_init(skb);
+		skb_clear_delivery_time(skb);
+		__skb_pull(skb, skb_network_header_len(skb));
+
+		protocol = ip_hdr(skb)->protocol;
+		ipprot = rcu_dereference(inet_protos[protocol]);
+		if (ipprot != curr_prot) {
+			/* keep the order between packets of different protocols */
+			if (curr_prot)
+				ip_list_deliver_proto(&sublist, curr_prot);
+			curr_prot = ipprot && ipprot->list_handler ? ipprot : NULL;
+		}
+		if (!curr_prot) {
+			ip_protocol_deliver_rcu(net, skb, protocol);
+			continue;
+		}
+
+		raw_local_deliver(skb, protocol);
+		if (!ipprot->no_policy) {
+			if (!xfrm4_policy_check(NULL, XFRM_POLICY_IN, skb)) {
+				kfree_skb_reason(skb,
+						 SKB_DROP_REASON_XFRM_POLICY);
+				continue;
+			}
+			nf_reset_ct(skb);
+		}
+		list_add_tail(&skb->list, &sublist);
+	}
+	if (curr_prot)
+		ip_list_deliver_proto(&sublist, curr_prot);
+	rcu_read_unlock();
+}
+
+static void ip_local_deliver_sublist(struct list_head *head,
+				     struct net_device *dev)
+{
+	struct net *net = dev_net(dev);
+
+	NF_HOOK_LIST(NFPROTO_IPV4, NF_INET_LOCAL_IN, net, NULL,
+		     head, dev, NULL, ip_local_deliver_finish);
+	ip_local_deliver_list_finish(net, head);
+}
+
+/* Deliver a list of IP packets sharing one local route */
+static void ip_local_deliver_list(struct list_head *head)
+{
+	struct net_device *curr_dev = NULL;
+	struct sk_buff *skb, *next;
+	struct list_head sublist;
+
+	INIT_LIST_HEAD(&sublist);
+	list_for_each_entry_safe(skb, next, head, list) {
+		skb_list_del_init(skb);
+		if (ip_is_fragment(ip_hdr(skb)) &&
+		    ip_defrag(dev_net(skb->dev), skb, IP_DEFRAG_LOCAL_DELIVER))
+			continue;
+
+		if (curr_dev != skb->dev) {
+			/* dispatch old sublist */
+			if (!list_empty(&sublist))
+				ip_local_deliver_sublist(&sublist, curr_dev);
+			/* start new sublist */
+			INIT_LIST_HEAD(&sublist);
+			curr_dev = skb->dev;
+		}
+		list_add_tail(&skb->list, &sublist);
+	}
+	/* dispatch final sublist */
+	if (!list_empty(&sublist))
+		ip_local_deliver_sublist(&sublist, curr_dev);
+}
+
 static inline bool ip_rcv_options(struct sk_buff *skb, struct net_device *dev)
 {
 	struct ip_options *opt;
@@ -575,6 +667,13 @@ static void ip_sublist_rcv_finish(struct list_head *head)
 {
 	struct sk_buff *skb, *next;
 
+	/* all packets of the sublist share the same dst */
+	skb = list_first_entry_or_null(head, struct sk_buff, list);
+	if (skb && skb_dst(skb)->input == ip_local_deliver) {
+		ip_local_deliver_list(head);
+		return;
+	}
+
 	list_for_each_entry_safe(skb, next, head, list) {
 		skb_list_del_init(skb);
 		dst_input(skb);
@@ -1826,17 +1826,26 @@ static void tcp_zerocopy_set_hint_for_skb(struct sock *sk,
 					  struct tcp_zerocopy_receive *zc,
 					  struct sk_buff *skb, u32 offset)
 {
-	u32 frag_offset, partial_frag_remainder = 0;
+	u32 frag_offset, partial_frag_remainder = 0, linear_remainder = 0;
 	int mappable_offset;
 	skb_frag_t *frag;
 
 	/* worst case: skip to next skb. try to improve on this case below */
 	zc->recv_skip_hint = skb->len - offset;
 
+	/* Headers split from the payload by the NIC end up in the linear
+	 * part, the rest of it must be read before the frags.
+	 */
+	if (offset < skb_headlen(skb) && skb_shinfo(skb)->nr_frags) {
+		linear_remainder = skb_headlen(skb) - offset;
+		offset = skb_headlen(skb);
+	}
+
 	/* Find the frag containing this offset (and how far into that frag) */
 	frag = skb_advance_to_frag(skb, offset, &frag_offset);
 	if (!frag)
 		return;
+	zc->recv_skip_hint -= linear_remainder;
 
 	if (frag_offset) {
 		struct skb_shared_info *info = skb_shinfo(skb);
@@ -1856,7 +1865,8 @@ static void tcp_zerocopy_set_hint_for_skb(struct sock *sk,
 	 * in partial_frag_remainder.
 	 */
 	mappable_offset = find_next_mappable_frag(frag, zc->recv_skip_hint);
-	zc->recv_skip_hint = mappable_offset + partial_frag_remainder;
+	zc->recv_skip_hint = mappable_offset + partial_frag_remainder +
+			     linear_remainder;
 }
 
 static int tcp_recvmsg_locked(struct sock *sk, struct msghdr *msg, size_t len,
@@ -2161,10 +2171,14 @@ static int tcp_zerocopy_receive(struct sock *sk,
 				tcp_update_recv_tstamps(skb, tss);
 				zc->msg_flags |= TCP_CMSG_TS;
 			}
-			zc->recv_skip_hint = skb->len - offset;
 			frags = skb_advance_to_frag(skb, offset, &offset_frag);
-			if (!frags || offset_frag)
+			if (!frags || offset_frag) {
+				/* Only copy up to the next mappable frag */
+				tcp_zerocopy_set_hint_for_skb(sk, zc, skb,
+							      offset);
 				break;
+			}
+			zc->recv_skip_hint = skb->len - offset;
 		}
 
 		mappable_offset = find_next_mappable_frag(frags,
@@ -5690,7 +5690,17 @@ void tcp_check_space(struct sock *sk)
 
 static inline void tcp_data_snd_check(struct sock *sk)
 {
-	tcp_push_pending_frames(sk);
+	/* If we are running from __release_sock() in user context, transmit
+	 * once from tcp_release_cb() for all the acks found in the backlog.
+	 */
+	if (sock_owned_by_user_nocheck(sk) &&
+	    READ_ONCE(sock_net(sk)->ipv4.sysctl_tcp_backlog_ack_defer)) {
+		if (test_and_set_bit(TCP_XMIT_DEFERRED, &sk->sk_tsq_flags))
+			NET_INC_STATS(sock_net(sk),
+				      LINUX_MIB_TCPBACKLOGXMITDEFER);
+	} else {
+		tcp_push_pending_frames(sk);
+	}
 	tcp_check_space(sk);
 }
 
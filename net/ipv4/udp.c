@@ -1473,31 +1473,6 @@ static void udp_skb_dtor_locked(struct sock *sk, struct sk_buff *skb)
 	udp_rmem_release(sk, udp_skb_truesize(skb), 1, true);
 }
 
-/* Idea of busylocks is to let producers grab an extra spinlock
- * to relieve pressure on the receive_queue spinlock shared by consumer.
- * Under flood, this means that only one producer can be in line
- * trying to acquire the receive_queue spinlock.
- * These busylock can be allocated on a per cpu manner, instead of a
- * per socket one (that would consume a cache line per socket)
- */
-static int udp_busylocks_log __read_mostly;
-static spinlock_t *udp_busylocks __read_mostly;
-
-static spinlock_t *busylock_acquire(void *ptr)
-{
-	spinlock_t *busy;
-
-	busy = udp_busylocks + hash_ptr(ptr, udp_busylocks_log);
-	spin_lock(busy);
-	return busy;
-}
-
-static void busylock_release(spinlock_t *busy)
-{
-	if (busy)
-		spin_unlock(busy);
-}
-
 static int udp_rmem_schedule(struct sock *sk, int size)
 {
 	int delta;
@@ -1509,18 +1484,29 @@ static int udp_rmem_schedule(struct sock *sk, int size)
 	return 0;
 }
 
+/* Producers add skbs to a lockless list per NUMA node. Only the producer
+ * which finds its list empty takes the receive_queue spinlock, and moves
+ * all the skbs queued on the list in the meantime by other producers, so
+ * that under flood the spinlock is taken once per batch instead of once
+ * per skb, and the skbs of one node get moved together.
+ */
 int __udp_enqueue_schedule_skb(struct sock *sk, struct sk_buff *skb)
 {
 	struct sk_buff_head *list = &sk->sk_receive_queue;
-	int rmem, err = -ENOMEM;
-	spinlock_t *busy = NULL;
+	struct udp_prod_queue *udp_prod_queue;
+	struct sk_buff *next, *to_drop = NULL;
+	int rmem, total_size = 0, q_size = 0;
+	struct llist_node *ll_list;
 	bool becomes_readable;
 	int size, rcvbuf;
 
+	udp_prod_queue = &udp_sk(sk)->udp_prod_queue[numa_node_id()];
+
 	/* Immediately drop when the receive queue is full.
 	 * Always allow at least one packet.
 	 */
-	rmem = atomic_read(&sk->sk_rmem_alloc);
+	rmem = atomic_read(&sk->sk_rmem_alloc) +
+	       atomic_read(&udp_prod_queue->rmem_alloc);
 	rcvbuf = READ_ONCE(sk->sk_rcvbuf);
 	if (rmem > rcvbuf)
 		goto drop;
@@ -1531,35 +1517,47 @@ int __udp_enqueue_schedule_skb(struct sock *sk, struct sk_buff *skb)
 	 * - Less cache line misses at copyout() time
 	 * - Less work at consume_skb() (less alien page frag freeing)
 	 */
-	if (rmem > (rcvbuf >> 1)) {
+	if (rmem > (rcvbuf >> 1))
 		skb_condense(skb);
-
-		busy = busylock_acquire(sk);
-	}
-	size = skb->truesize;
 	udp_set_dev_scratch(skb);
 
-	atomic_add(size, &sk->sk_rmem_alloc);
+	atomic_add(skb->truesize, &udp_prod_queue->rmem_alloc);
+
+	if (!llist_add(&skb->ll_node, &udp_prod_queue->ll_root))
+		return 0;
 
 	spin_lock(&list->lock);
-	err = udp_rmem_schedule(sk, size);
-	if (err) {
-		spin_unlock(&list->lock);
-		goto uncharge_drop;
-	}
 
-	sk_forward_alloc_add(sk, -size);
+	ll_list = llist_reverse_order(llist_del_all(&udp_prod_queue->ll_root));
+	becomes_readable = skb_queue_empty(list);
 
-	/* no need to setup a destructor, we will explicitly release the
-	 * forward allocated memory on dequeue
-	 */
-	sock_skb_set_dropcount(sk, skb);
+	llist_for_each_entry_safe(skb, next, ll_list, ll_node) {
+		size = udp_skb_truesize(skb);
+		total_size += size;
+		if (unlikely(udp_rmem_schedule(sk, size))) {
+			/* free the skbs outside of the locked section */
+			skb->next = to_drop;
+			to_drop = skb;
+			continue;
+		}
+
+		q_size += size;
+		sk_forward_alloc_add(sk, -size);
+
+		/* no need to setup a destructor, we will explicitly release the
+		 * forward allocated memory on dequeue
+		 */
+		sock_skb_set_dropcount(sk, skb);
+
+		__skb_queue_tail(list, skb);
+	}
+	atomic_add(q_size, &sk->sk_rmem_alloc);
 
-	becomes_readable = skb_queue_empty(list);
-	__skb_queue_tail(list, skb);
 	spin_unlock(&list->lock);
 
-	if (!sock_flag(sk, SOCK_DEAD)) {
+	atomic_sub(total_size, &udp_prod_queue->rmem_alloc);
+
+	if (q_size && !sock_flag(sk, SOCK_DEAD)) {
 		if (becomes_readable ||
 		    sk->sk_data_ready != sock_def_readable ||
 		    READ_ONCE(sk->sk_peek_off) >= 0)
@@ -1568,16 +1566,29 @@ int __udp_enqueue_schedule_skb(struct sock *sk, struct sk_buff *skb)
 		else
 			sk_wake_async_rcu(sk, SOCK_WAKE_WAITD, POLL_IN);
 	}
-	busylock_release(busy);
-	return 0;
 
-uncharge_drop:
-	atomic_sub(skb->truesize, &sk->sk_rmem_alloc);
+	if (unlikely(to_drop)) {
+		int nb = 0;
+
+		while (to_drop) {
+			skb = to_drop;
+			to_drop = skb->next;
+			skb_mark_not_on_list(skb);
+			kfree_skb_reason(skb, SKB_DROP_REASON_PROTO_MEM);
+			nb++;
+		}
+		/* the caller only accounts skbs it gets an error for */
+		atomic_add(nb, &sk->sk_drops);
+		SNMP_ADD_STATS(__UDPX_MIB(sk, sk->sk_family == AF_INET),
+			       UDP_MIB_RCVBUFERRORS, nb);
+		SNMP_ADD_STATS(__UDPX_MIB(sk, sk->sk_family == AF_INET),
+			       UDP_MIB_INERRORS, nb);
+	}
+	return 0;
 
 drop:
 	atomic_inc(&sk->sk_drops);
-	busylock_release(busy);
-	return err;
+	return -ENOMEM;
 }
 EXPORT_SYMBOL_GPL(__udp_enqueue_schedule_skb);
 
@@ -1594,6 +1605,7 @@ void udp_destruct_common(struct sock *sk)
 		kfree_skb(skb);
 	}
 	udp_rmem_release(sk, total, 0, true);
+	kfree(up->udp_prod_queue);
 }
 EXPORT_SYMBOL_GPL(udp_destruct_common);
 
@@ -1605,7 +1617,11 @@ static void udp_destruct_sock(struct sock *sk)
 
 int udp_init_sock(struct sock *sk)
 {
-	udp_lib_init_sock(sk);
+	int err;
+
+	err = udp_lib_init_sock(sk);
+	if (err)
+		return err;
 	sk->sk_destruct = udp_destruct_sock;
 	set_bit(SOCK_SUPPORT_ZC, &sk->sk_socket->flags);
 	return 0;
@@ -1613,6 +1629,8 @@ int udp_init_sock(struct sock *sk)
 
 void skb_consume_udp(struct sock *sk, struct sk_buff *skb, int len)
 {
+	bool shared = skb_shared(skb);
+
 	if (unlikely(READ_ONCE(udp_sk(sk)->peeking_with_offset)))
 		sk_peek_offset_bwd(sk, len);
 
@@ -1624,7 +1642,14 @@ void skb_consume_udp(struct sock *sk, struct sk_buff *skb, int len)
 	 */
 	if (unlikely(udp_skb_has_head_state(skb)))
 		skb_release_head_state(skb);
-	__consume_stateless_skb(skb);
+
+	/* Give the skb back to the per cpu cache of the cpu which allocated
+	 * it, unless skb_unref() dropped the last reference of a peeker.
+	 */
+	if (unlikely(shared))
+		__consume_stateless_skb(skb);
+	else
+		skb_attempt_defer_free(skb);
 }
 EXPORT_SYMBOL_GPL(skb_consume_udp);
 
@@ -2382,8 +2407,56 @@ static int udp_unicast_rcv_skb(struct sock *sk, struct sk_buff *skb,
  *	All we need to do is get the socket, and then do a checksum.
  */
 
-int __udp4_lib_rcv(struct sk_buff *skb, struct udp_table *udptable,
-		   int proto)
+/* Socket found by the last full lookup of a batch of received packets */
+struct udp_rcv_hint {
+	struct sock	*sk;
+	__be32		saddr;
+	__be32		daddr;
+	__be16		sport;
+	__be16		dport;
+	int		dif;
+	int		sdif;
+};
+
+/*
+ * Packets of one flow usually arrive back to back. The lookup only depends on
+ * the addresses, the ports and the ingress device, unless a reuseport group
+ * or a BPF sk_lookup program may pick a different socket for each packet.
+ */
+static struct sock *udp4_lib_lookup_hint(struct sk_buff *skb,
+					 const struct udphdr *uh,
+					 struct udp_table *udptable,
+					 struct udp_rcv_hint *hint)
+{
+	const struct iphdr *iph = ip_hdr(skb);
+	int dif = inet_iif(skb), sdif = inet_sdif(skb);
+	struct sock *sk;
+
+	if (hint->sk && hint->saddr == iph->saddr &&
+	    hint->daddr == iph->daddr && hint->sport == uh->source &&
+	    hint->dport == uh->dest && hint->dif == dif && hint->sdif == sdif)
+		return hint->sk;
+
+	sk = __udp4_lib_lookup(dev_net(skb->dev), iph->saddr, uh->source,
+			       iph->daddr, uh->dest, dif, sdif, udptable, skb);
+	if (!sk || rcu_access_pointer(sk->sk_reuseport_cb) ||
+	    static_branch_unlikely(&bpf_sk_lookup_enabled)) {
+		hint->sk = NULL;
+		return sk;
+	}
+
+	hint->sk = sk;
+	hint->saddr = iph->saddr;
+	hint->daddr = iph->daddr;
+	hint->sport = uh->source;
+	hint->dport = uh->dest;
+	hint->dif = dif;
+	hint->sdif = sdif;
+	return sk;
+}
+
+static int udp4_lib_rcv(struct sk_buff *skb, struct udp_table *udptable,
+			int proto, struct udp_rcv_hint *hint)
 {
 	struct sock *sk;
 	struct udphdr *uh;
@@ -2442,7 +2515,10 @@ int __udp4_lib_rcv(struct sk_buff *skb, struct udp_table *udptable,
 		return __udp4_lib_mcast_deliver(net, skb, uh,
 						saddr, daddr, udptable, proto);
 
-	sk = __udp4_lib_lookup_skb(skb, uh->source, uh->dest, udptable);
+	if (hint)
+		sk = udp4_lib_lookup_hint(skb, uh, udptable, hint);
+	else
+		sk = __udp4_lib_lookup_skb(skb, uh->source, uh->dest, udptable);
 	if (sk)
 		return udp_unicast_rcv_skb(sk, skb, uh);
 no_sk:
@@ -2491,6 +2567,12 @@ int __udp4_lib_rcv(struct sk_buff *skb, struct udp_table *udptable,
 	return 0;
 }
 
+int __udp4_lib_rcv(struct sk_buff *skb, struct udp_table *udptable,
+		   int proto)
+{
+	return udp4_lib_rcv(skb, udptable, proto, NULL);
+}
+
 /* We can only early demux multicast if there is a single matching socket.
  * If more than one socket found returns NULL
  */
@@ -2630,6 +2712,29 @@ int udp_rcv(struct sk_buff *skb)
 	return __udp4_lib_rcv(skb, dev_net(skb->dev)->ipv4.udp_table, IPPROTO_UDP);
 }
 
+/*
+ * Called under rcu_read_lock() with a list of packets for local delivery,
+ * which already passed the LOCAL_IN hook and the raw sockets. The socket
+ * lookup is shared by consecutive packets of the same flow.
+ */
+void udp_rcv_list(struct list_head *head)
+{
+	struct udp_rcv_hint hint = {};
+	struct sk_buff *skb, *next;
+	struct net *net;
+	int ret;
+
+	list_for_each_entry_safe(skb, next, head, list) {
+		skb_list_del_init(skb);
+		net = dev_net(skb->dev);
+		ret = udp4_lib_rcv(skb, net->ipv4.udp_table, IPPROTO_UDP, &hint);
+		if (ret < 0)
+			ip_protocol_deliver_rcu(net, skb, -ret);
+		else
+			__IP_INC_STATS(net, IPSTATS_MIB_INDELIVERS);
+	}
+}
+
 void udp_destroy_sock(struct sock *sk)
 {
 	struct udp_sock *up = udp_sk(sk);
@@ -3644,7 +3749,6 @@ static void __init bpf_iter_register(void)
 void __init udp_init(void)
 {
 	unsigned long limit;
-	unsigned int i;
 
 	udp_table_init(&udp_table, "UDP");
 	limit = nr_free_buffer_pages() / 8;
@@ -3653,15 +3757,6 @@ void __init udp_init(void)
 	sysctl_udp_mem[1] = limit;
 	sysctl_udp_mem[2] = sysctl_udp_mem[0] * 2;
 
-	/* 16 spinlocks per cpu */
-	udp_busylocks_log = ilog2(nr_cpu_ids) + 4;
-	udp_busylocks = kmalloc(sizeof(spinlock_t) << udp_busylocks_log,
-				GFP_KERNEL);
-	if (!udp_busylocks)
-		panic("UDP: failed to alloc udp_busylocks\n");
-	for (i = 0; i < (1U << udp_busylocks_log); i++)
-		spin_lock_init(udp_busylocks + i);
-
 	if (register_pernet_subsys(&udp_sysctl_ops))
 		panic("UDP: failed to init sysctl parameters.\n");
 
@@ -603,6 +603,19 @@ static struct sock *udp4_gro_lookup_skb(struct sk_buff *skb, __be16 sport,
 				 sdif, net->ipv4.udp_table, NULL);
 }
 
+/* A router with NETIF_F_GRO_FRAGLIST also running a UDP tunnel on the same
+ * port would otherwise merge the forwarded traffic through the tunnel's GRO
+ * handler, which then has to be segmented again on egress.
+ */
+static bool udp4_gro_forwarding(struct sk_buff *skb)
+{
+	const struct iphdr *iph = skb_gro_network_header(skb);
+
+	return (skb->dev->features & NETIF_F_GRO_FRAGLIST) &&
+	       inet_addr_type_dev_table(dev_net(skb->dev), skb->dev,
+					iph->daddr) == RTN_UNICAST;
+}
+
 INDIRECT_CALLABLE_SCOPE
 struct sk_buff *udp4_gro_receive(struct list_head *head, struct sk_buff *skb)
 {
@@ -626,8 +639,11 @@ struct sk_buff *udp4_gro_receive(struct list_head *head, struct sk_buff *skb)
 skip:
 	NAPI_GRO_CB(skb)->is_ipv6 = 0;
 
-	if (static_branch_unlikely(&udp_encap_needed_key))
+	if (static_branch_unlikely(&udp_encap_needed_key)) {
 		sk = udp4_gro_lookup_skb(skb, uh->source, uh->dest);
+		if (sk && udp_sk(sk)->gro_receive && udp4_gro_forwarding(skb))
+			sk = NULL;
+	}
 
 	pp = udp_gro_receive(head, skb, uh, sk);
 	return pp;
@@ -262,7 +262,8 @@ EXPORT_SYMBOL_GPL(inet6_lookup);
 
 static int __inet6_check_established(struct inet_timewait_death_row *death_row,
 				     struct sock *sk, const __u16 lport,
-				     struct inet_timewait_sock **twp)
+				     struct inet_timewait_sock **twp,
+				     bool rcu_lookup)
 {
 	struct inet_hashinfo *hinfo = death_row->hashinfo;
 	struct inet_sock *inet = inet_sk(sk);
@@ -280,6 +281,17 @@ static int __inet6_check_established(struct inet_timewait_death_row *death_row,
 	const struct hlist_nulls_node *node;
 	struct inet_timewait_sock *tw = NULL;
 
+	if (rcu_lookup) {
+		sk_nulls_for_each_rcu(sk2, node, &head->chain) {
+			if (sk2->sk_hash == hash &&
+			    sk2->sk_state != TCP_TIME_WAIT &&
+			    inet6_match(net, sk2, saddr, daddr, ports,
+					dif, sdif))
+				return -EADDRNOTAVAIL;
+		}
+		return 0;
+	}
+
 	spin_lock(lock);
 
 	sk_nulls_for_each(sk2, node, &head->chain) {
@@ -127,6 +127,16 @@ static struct sock *udp6_gro_lookup_skb(struct sk_buff *skb, __be16 sport,
 				 sdif, net->ipv4.udp_table, NULL);
 }
 
+/* See udp4_gro_forwarding() */
+static bool udp6_gro_forwarding(struct sk_buff *skb)
+{
+	const struct ipv6hdr *iph = skb_gro_network_header(skb);
+
+	return (skb->dev->features & NETIF_F_GRO_FRAGLIST) &&
+	       !ipv6_addr_is_multicast(&iph->daddr) &&
+	       !ipv6_chk_addr(dev_net(skb->dev), &iph->daddr, NULL, 0);
+}
+
 INDIRECT_CALLABLE_SCOPE
 struct sk_buff *udp6_gro_receive(struct list_head *head, struct sk_buff *skb)
 {
@@ -151,8 +161,11 @@ struct sk_buff *udp6_gro_receive(struct list_head *head, struct sk_buff *skb)
 skip:
 	NAPI_GRO_CB(skb)->is_ipv6 = 1;
 
-	if (static_branch_unlikely(&udpv6_encap_needed_key))
+	if (static_branch_unlikely(&udpv6_encap_needed_key)) {
 		sk = udp6_gro_lookup_skb(skb, uh->source, uh->dest);
+		if (sk && udp_sk(sk)->gro_receive && udp6_gro_forwarding(skb))
+			sk = NULL;
+	}
 
 	pp = udp_gro_receive(head, skb, uh, sk);
 	return pp;
@@ -67,11 +67,12 @@ static atomic_t ip_vs_conn_no_cport_cnt = ATOMIC_INIT(0);
 static unsigned int ip_vs_conn_rnd __read_mostly;
 
 /*
- *  Fine locking granularity for big connection hash table
+ *  Fine locking granularity for big connection hash table: at least
+ *  CT_LOCKS_MIN locks, and CT_LOCKS_PER_CPU per possible CPU, so that
+ *  connection setup on many CPUs does not serialize on a few locks.
  */
-#define CT_LOCKARRAY_BITS  5
-#define CT_LOCKARRAY_SIZE  (1<<CT_LOCKARRAY_BITS)
-#define CT_LOCKARRAY_MASK  (CT_LOCKARRAY_SIZE-1)
+#define CT_LOCKS_MIN		32
+#define CT_LOCKS_PER_CPU	16
 
 /* We need an addrstrlen that works with or without v6 */
 #ifdef CONFIG_IP_VS_IPV6
@@ -80,23 +81,18 @@ static unsigned int ip_vs_conn_rnd __read_mostly;
 #define IP_VS_ADDRSTRLEN (8+1)
 #endif
 
-struct ip_vs_aligned_lock
-{
-	spinlock_t	l;
-} __attribute__((__aligned__(SMP_CACHE_BYTES)));
-
 /* lock array for conn table */
-static struct ip_vs_aligned_lock
-__ip_vs_conntbl_lock_array[CT_LOCKARRAY_SIZE] __cacheline_aligned;
+static spinlock_t *ip_vs_conntbl_locks __read_mostly;
+static unsigned int ip_vs_conntbl_locks_mask __read_mostly;
 
 static inline void ct_write_lock_bh(unsigned int key)
 {
-	spin_lock_bh(&__ip_vs_conntbl_lock_array[key&CT_LOCKARRAY_MASK].l);
+	spin_lock_bh(&ip_vs_conntbl_locks[key & ip_vs_conntbl_locks_mask]);
 }
 
 static inline void ct_write_unlock_bh(unsigned int key)
 {
-	spin_unlock_bh(&__ip_vs_conntbl_lock_array[key&CT_LOCKARRAY_MASK].l);
+	spin_unlock_bh(&ip_vs_conntbl_locks[key & ip_vs_conntbl_locks_mask]);
 }
 
 static void ip_vs_conn_expire(struct timer_list *t);
@@ -1481,6 +1477,7 @@ void __net_exit ip_vs_conn_net_cleanup(struct netns_ipvs *ipvs)
 
 int __init ip_vs_conn_init(void)
 {
+	unsigned int nlocks;
 	size_t tab_array_size;
 	int max_avail;
 #if BITS_PER_LONG > 32
@@ -1510,9 +1507,23 @@ int __init ip_vs_conn_init(void)
 	if (!ip_vs_conn_tab)
 		return -ENOMEM;
 
+	/* No point in having more locks than hash rows */
+	nlocks = roundup_pow_of_two(num_possible_cpus() * CT_LOCKS_PER_CPU);
+	nlocks = clamp_t(unsigned int, nlocks, CT_LOCKS_MIN,
+			 ip_vs_conn_tab_size);
+	ip_vs_conntbl_locks = kvmalloc_array(nlocks,
+					     sizeof(*ip_vs_conntbl_locks),
+					     GFP_KERNEL);
+	if (!ip_vs_conntbl_locks) {
+		kvfree(ip_vs_conn_tab);
+		return -ENOMEM;
+	}
+	ip_vs_conntbl_locks_mask = nlocks - 1;
+
 	/* Allocate ip_vs_conn slab cache */
 	ip_vs_conn_cachep = KMEM_CACHE(ip_vs_conn, SLAB_HWCACHE_ALIGN);
 	if (!ip_vs_conn_cachep) {
+		kvfree(ip_vs_conntbl_locks);
 		kvfree(ip_vs_conn_tab);
 		return -ENOMEM;
 	}
@@ -1525,9 +1536,8 @@ int __init ip_vs_conn_init(void)
 	for (idx = 0; idx < ip_vs_conn_tab_size; idx++)
 		INIT_HLIST_HEAD(&ip_vs_conn_tab[idx]);
 
-	for (idx = 0; idx < CT_LOCKARRAY_SIZE; idx++)  {
-		spin_lock_init(&__ip_vs_conntbl_lock_array[idx].l);
-	}
+	for (idx = 0; idx < nlocks; idx++)
+		spin_lock_init(&ip_vs_conntbl_locks[idx]);
 
 	/* calculate the random value for connection hash */
 	get_random_bytes(&ip_vs_conn_rnd, sizeof(ip_vs_conn_rnd));
@@ -1541,5 +1551,6 @@ void ip_vs_conn_cleanup(void)
 	rcu_barrier();
 	/* Release the empty cache */
 	kmem_cache_destroy(ip_vs_conn_cachep);
+	kvfree(ip_vs_conntbl_locks);
 	kvfree(ip_vs_conn_tab);
 }
@@ -3,6 +3,7 @@
 #include <linux/module.h>
 #include <linux/netfilter.h>
 #include <linux/rhashtable.h>
+#include <linux/llist.h>
 #include <linux/netdevice.h>
 #include <linux/tc_act/tc_csum.h>
 #include <net/flow_offload.h>
@@ -18,13 +19,29 @@ static struct workqueue_struct *nf_flow_offload_del_wq;
 static struct workqueue_struct *nf_flow_offload_stats_wq;
 
 struct flow_offload_work {
-	struct list_head	list;
+	struct llist_node	llnode;
 	enum flow_cls_command	cmd;
 	struct nf_flowtable	*flowtable;
 	struct flow_offload	*flow;
 	struct work_struct	work;
 };
 
+/*
+ * Flow additions are collected per CPU and installed by one work item. A
+ * batch holds at most NF_FLOW_OFFLOAD_BATCH_MAX additions, anything beyond
+ * gets a work item of its own so that bursts still spread over the workers
+ * of the unbound workqueue.
+ */
+#define NF_FLOW_OFFLOAD_BATCH_MAX	64
+
+struct flow_offload_batch {
+	struct llist_head	list;
+	atomic_t		count;
+	struct work_struct	work;
+};
+
+static DEFINE_PER_CPU(struct flow_offload_batch, nf_flow_offload_add_batch);
+
 #define NF_FLOW_DISSECTOR(__match, __type, __field)	\
 	(__match)->dissector.offset[__type] =		\
 		offsetof(struct nf_flow_key, __field)
@@ -996,13 +1013,40 @@ static void flow_offload_work_handler(struct work_struct *work)
 	kfree(offload);
 }
 
+static void flow_offload_batch_handler(struct work_struct *work)
+{
+	struct flow_offload_batch *batch;
+	struct flow_offload_work *offload, *next;
+	struct llist_node *list;
+	int n = 0;
+
+	batch = container_of(work, struct flow_offload_batch, work);
+	list = llist_reverse_order(llist_del_all(&batch->list));
+	llist_for_each_entry_safe(offload, next, list, llnode) {
+		flow_offload_work_handler(&offload->work);
+		n++;
+		cond_resched();
+	}
+	/* Additions that raced with llist_del_all() are counted next time */
+	atomic_sub(n, &batch->count);
+}
+
 static void flow_offload_queue_work(struct flow_offload_work *offload)
 {
 	struct net *net = read_pnet(&offload->flowtable->net);
 
 	if (offload->cmd == FLOW_CLS_REPLACE) {
+		/* Any CPU's list will do, this one is likely cache hot */
+		struct flow_offload_batch *batch =
+			raw_cpu_ptr(&nf_flow_offload_add_batch);
+
 		NF_FLOW_TABLE_STAT_INC_ATOMIC(net, count_wq_add);
-		queue_work(nf_flow_offload_add_wq, &offload->work);
+		if (atomic_inc_return(&batch->count) > NF_FLOW_OFFLOAD_BATCH_MAX) {
+			atomic_dec(&batch->count);
+			queue_work(nf_flow_offload_add_wq, &offload->work);
+		} else if (llist_add(&offload->llnode, &batch->list)) {
+			queue_work(nf_flow_offload_add_wq, &batch->work);
+		}
 	} else if (offload->cmd == FLOW_CLS_DESTROY) {
 		NF_FLOW_TABLE_STAT_INC_ATOMIC(net, count_wq_del);
 		queue_work(nf_flow_offload_del_wq, &offload->work);
@@ -1209,6 +1253,17 @@ EXPORT_SYMBOL_GPL(nf_flow_table_offload_setup);
 
 int nf_flow_table_offload_init(void)
 {
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct flow_offload_batch *batch;
+
+		batch = per_cpu_ptr(&nf_flow_offload_add_batch, cpu);
+		init_llist_head(&batch->list);
+		atomic_set(&batch->count, 0);
+		INIT_WORK(&batch->work, flow_offload_batch_handler);
+	}
+
 	nf_flow_offload_add_wq  = alloc_workqueue("nf_ft_offload_add",
 						  WQ_UNBOUND | WQ_SYSFS, 0);
 	if (!nf_flow_offload_add_wq)
@@ -438,17 +438,26 @@ bool nft_pipapo_lookup(const struct net *net, const struct nft_set *set,
 
 	nft_pipapo_for_each_field(f, i, m) {
 		bool last = i == m->field_count - 1;
+		bool match;
 		int b;
 
 		/* For each bit group: select lookup table bucket depending on
 		 * packet bytes value, then AND bucket value
 		 */
 		if (likely(f->bb == 8))
-			pipapo_and_field_buckets_8bit(f, res_map, rp);
+			match = pipapo_and_field_buckets_8bit(f, res_map, rp);
 		else
-			pipapo_and_field_buckets_4bit(f, res_map, rp);
+			match = pipapo_and_field_buckets_4bit(f, res_map, rp);
 		NFT_PIPAPO_GROUP_BITS_ARE_8_OR_4;
 
+		/* No rule left: res_map is already clear, fill_map untouched */
+		if (!match) {
+			scratch->map_index = map_index;
+			local_bh_enable();
+
+			return false;
+		}
+
 		rp += f->groups / NFT_PIPAPO_GROUPS_PER_BYTE(f);
 
 		/* Now populate the bitmap for the next field, unless this is
@@ -546,18 +555,22 @@ static struct nft_pipapo_elem *pipapo_get(const struct net *net,
 
 	nft_pipapo_for_each_field(f, i, m) {
 		bool last = i == m->field_count - 1;
+		bool match;
 		int b;
 
 		/* For each bit group: select lookup table bucket depending on
 		 * packet bytes value, then AND bucket value
 		 */
 		if (f->bb == 8)
-			pipapo_and_field_buckets_8bit(f, res_map, data);
+			match = pipapo_and_field_buckets_8bit(f, res_map, data);
 		else if (f->bb == 4)
-			pipapo_and_field_buckets_4bit(f, res_map, data);
+			match = pipapo_and_field_buckets_4bit(f, res_map, data);
 		else
 			BUG();
 
+		if (!match)
+			goto out;
+
 		data += f->groups / NFT_PIPAPO_GROUPS_PER_BYTE(f);
 
 		/* Now populate the bitmap for the next field, unless this is
@@ -185,8 +185,13 @@ int pipapo_refill(unsigned long *map, unsigned int len, unsigned int rules,
  * @f:		Field including lookup table
  * @dst:	Area to store result
  * @data:	Input data selecting table buckets
+ *
+ * Stop as soon as no bits are left in @dst: further intersections can't set
+ * them again, and the remaining lookup table rows don't need to be loaded.
+ *
+ * Return: false if @dst is empty, true otherwise.
  */
-static inline void pipapo_and_field_buckets_4bit(const struct nft_pipapo_field *f,
+static inline bool pipapo_and_field_buckets_4bit(const struct nft_pipapo_field *f,
 						 unsigned long *dst,
 						 const u8 *data)
 {
@@ -197,15 +202,19 @@ static inline void pipapo_and_field_buckets_4bit(const struct nft_pipapo_field *
 		u8 v;
 
 		v = *data >> 4;
-		__bitmap_and(dst, dst, lt + v * f->bsize,
-			     f->bsize * BITS_PER_LONG);
+		if (!__bitmap_and(dst, dst, lt + v * f->bsize,
+				  f->bsize * BITS_PER_LONG))
+			return false;
 		lt += f->bsize * NFT_PIPAPO_BUCKETS(4);
 
 		v = *data & 0x0f;
-		__bitmap_and(dst, dst, lt + v * f->bsize,
-			     f->bsize * BITS_PER_LONG);
+		if (!__bitmap_and(dst, dst, lt + v * f->bsize,
+				  f->bsize * BITS_PER_LONG))
+			return false;
 		lt += f->bsize * NFT_PIPAPO_BUCKETS(4);
 	}
+
+	return true;
 }
 
 /**
@@ -213,8 +222,12 @@ static inline void pipapo_and_field_buckets_4bit(const struct nft_pipapo_field *
  * @f:		Field including lookup table
  * @dst:	Area to store result
  * @data:	Input data selecting table buckets
+ *
+ * Like pipapo_and_field_buckets_4bit(), stop once @dst is empty.
+ *
+ * Return: false if @dst is empty, true otherwise.
  */
-static inline void pipapo_and_field_buckets_8bit(const struct nft_pipapo_field *f,
+static inline bool pipapo_and_field_buckets_8bit(const struct nft_pipapo_field *f,
 						 unsigned long *dst,
 						 const u8 *data)
 {
@@ -222,10 +235,13 @@ static inline void pipapo_and_field_buckets_8bit(const struct nft_pipapo_field *
 	int group;
 
 	for (group = 0; group < f->groups; group++, data++) {
-		__bitmap_and(dst, dst, lt + *data * f->bsize,
-			     f->bsize * BITS_PER_LONG);
+		if (!__bitmap_and(dst, dst, lt + *data * f->bsize,
+				  f->bsize * BITS_PER_LONG))
+			return false;
 		lt += f->bsize * NFT_PIPAPO_BUCKETS(8);
 	}
+
+	return true;
 }
 
 /**
@@ -311,18 +311,38 @@ static u16 fl_ct_info_to_flower_map[] = {
 					TCA_FLOWER_KEY_CT_FLAGS_NEW,
 };
 
+/* The key dissected for @prev can be looked up in @mask too if both use
+ * the same dissector keys, and the range cleared before dissecting for
+ * @prev covers the range of @mask.
+ */
+static bool fl_mask_dissect_reusable(const struct fl_flow_mask *mask,
+				     const struct fl_flow_mask *prev)
+{
+	return prev &&
+	       prev->dissector.used_keys == mask->dissector.used_keys &&
+	       prev->range.start <= mask->range.start &&
+	       prev->range.end >= mask->range.end;
+}
+
 TC_INDIRECT_SCOPE int fl_classify(struct sk_buff *skb,
 				  const struct tcf_proto *tp,
 				  struct tcf_result *res)
 {
 	struct cls_fl_head *head = rcu_dereference_bh(tp->root);
 	bool post_ct = tc_skb_cb(skb)->post_ct;
+	struct fl_flow_mask *mask, *prev = NULL;
 	u16 zone = tc_skb_cb(skb)->zone;
 	struct fl_flow_key skb_key;
-	struct fl_flow_mask *mask;
 	struct cls_fl_filter *f;
 
 	list_for_each_entry_rcu(mask, &head->masks, list) {
+		/* Masks which only differ in the bits they match on, like
+		 * prefix lengths, share the dissection of the packet.
+		 */
+		if (fl_mask_dissect_reusable(mask, prev))
+			goto lookup;
+		prev = mask;
+
 		flow_dissector_init_keys(&skb_key.control, &skb_key.basic);
 		fl_clear_masked_range(&skb_key, mask);
 
@@ -339,7 +359,7 @@ TC_INDIRECT_SCOPE int fl_classify(struct sk_buff *skb,
 		skb_flow_dissect_hash(skb, &mask->dissector, &skb_key);
 		skb_flow_dissect(skb, &mask->dissector, &skb_key,
 				 FLOW_DISSECTOR_F_STOP_BEFORE_ENCAP);
-
+lookup:
 		f = fl_mask_lookup(mask, &skb_key);
 		if (f && !tc_skip_sw(f->flags)) {
 			*res = f->res;
@@ -25,6 +25,11 @@
  *   - Use a special fifo for high prio packets
  *
  *  dequeue() : serves flows in Round Robin
+ *  Rate limited (throttled) flows wait in a RB tree ordered by the time of
+ *  their next packet. Optionally, flows due within the next few milliseconds
+ *  can be kept in a timer wheel instead, which makes throttling a flow O(1)
+ *  at the cost of releasing it up to one wheel slot late.
+ *
  *  Note : When a flow becomes empty, we do not immediately remove it from
  *  rb trees, for performance reasons (its expected to send additional packets,
  *  or SLAB cache will reuse socket for another flow)
@@ -41,6 +46,7 @@
 #include <linux/skbuff.h>
 #include <linux/slab.h>
 #include <linux/rbtree.h>
+#include <linux/bitmap.h>
 #include <linux/hash.h>
 #include <linux/prefetch.h>
 #include <linux/vmalloc.h>
@@ -90,10 +96,32 @@ struct fq_flow {
 	int		band;
 	struct fq_flow *next;		/* next pointer in RR lists */
 
-	struct rb_node  rate_node;	/* anchor in q->delayed tree */
+	union {
+		struct rb_node	  rate_node;	/* anchor in q->delayed tree */
+		struct hlist_node wheel_node;	/* anchor in q->wheel slot */
+	};
 	u64		time_next_packet;
 };
 
+/*
+ * Timer wheel for throttled flows. Slot N holds the flows whose
+ * time_next_packet, rounded up to the slot granularity, is N. It covers
+ * FQ_WHEEL_SLOTS slots from q->wheel_cursor, flows further away are put
+ * in the q->delayed tree.
+ */
+#define FQ_WHEEL_SLOTS_LOG	12
+#define FQ_WHEEL_SLOTS		(1U << FQ_WHEEL_SLOTS_LOG)
+#define FQ_WHEEL_MASK		(FQ_WHEEL_SLOTS - 1)
+
+/* Limits of the slot granularity in ns */
+#define FQ_WHEEL_MIN_GRANULARITY	(1U << 10)
+#define FQ_WHEEL_MAX_GRANULARITY	(1U << 24)
+
+struct fq_wheel {
+	unsigned long	  map[BITS_TO_LONGS(FQ_WHEEL_SLOTS)]; /* non empty slots */
+	struct hlist_head slots[FQ_WHEEL_SLOTS];
+};
+
 struct fq_flow_head {
 	struct fq_flow *first;
 	struct fq_flow *last;
@@ -124,6 +152,7 @@ struct fq_sched_data {
 	u8		rate_enable;
 	u8		fq_trees_log;
 	u8		horizon_drop;
+	u8		wheel_shift; /* log2(wheel slot granularity), 0 if no wheel */
 	u8		prio2band[FQ_PRIO2BAND_CRUMB_SIZE];
 	u32		timer_slack; /* hrtimer slack in ns */
 
@@ -135,6 +164,9 @@ struct fq_sched_data {
 
 	struct fq_flow	internal;	/* fastpath queue. */
 	struct rb_root	delayed;	/* for rate limited flows */
+	struct fq_wheel	*wheel;		/* for rate limited flows due soon */
+	u64		wheel_cursor;	/* first wheel slot not yet expired */
+	u32		wheel_flows;
 	u64		time_next_delayed_flow;
 	unsigned long	unthrottle_latency_ns;
 
@@ -180,12 +212,13 @@ static bool fq_flow_is_detached(const struct fq_flow *f)
 	return !!(f->age & 1UL);
 }
 
-/* special value to mark a throttled flow (not on old/new list) */
+/* special values to mark a throttled flow (not on old/new list) */
 static struct fq_flow throttled;
+static struct fq_flow throttled_wheel;
 
 static bool fq_flow_is_throttled(const struct fq_flow *f)
 {
-	return f->next == &throttled;
+	return f->next == &throttled || f->next == &throttled_wheel;
 }
 
 enum new_flow {
@@ -209,14 +242,66 @@ static void fq_flow_add_tail(struct fq_sched_data *q, struct fq_flow *flow,
 	flow->next = NULL;
 }
 
+static u64 fq_wheel_slot(const struct fq_sched_data *q, const struct fq_flow *f)
+{
+	return (f->time_next_packet + (1ULL << q->wheel_shift) - 1) >> q->wheel_shift;
+}
+
+/* Return the first non empty slot, the wheel must not be empty */
+static u64 fq_wheel_next(const struct fq_sched_data *q)
+{
+	unsigned int start = q->wheel_cursor & FQ_WHEEL_MASK;
+	unsigned int idx;
+
+	idx = find_next_bit(q->wheel->map, FQ_WHEEL_SLOTS, start);
+	if (idx >= FQ_WHEEL_SLOTS)
+		idx = find_first_bit(q->wheel->map, start);
+	return q->wheel_cursor + ((idx - start) & FQ_WHEEL_MASK);
+}
+
+static bool fq_wheel_insert(struct fq_sched_data *q, struct fq_flow *f,
+			    u64 now)
+{
+	u64 slot = fq_wheel_slot(q, f);
+	unsigned int idx;
+
+	/* An empty wheel restarts at the current slot, not at this flow's */
+	if (!q->wheel_flows)
+		q->wheel_cursor = now >> q->wheel_shift;
+	slot = max(slot, q->wheel_cursor);
+	if (slot - q->wheel_cursor >= FQ_WHEEL_SLOTS)
+		return false;
+
+	idx = slot & FQ_WHEEL_MASK;
+	hlist_add_head(&f->wheel_node, &q->wheel->slots[idx]);
+	__set_bit(idx, q->wheel->map);
+	q->wheel_flows++;
+	f->next = &throttled_wheel;
+	return true;
+}
+
+static void fq_wheel_unlink(struct fq_sched_data *q, struct fq_flow *f)
+{
+	unsigned int idx;
+
+	hlist_del(&f->wheel_node);
+	idx = max(fq_wheel_slot(q, f), q->wheel_cursor) & FQ_WHEEL_MASK;
+	if (hlist_empty(&q->wheel->slots[idx]))
+		__clear_bit(idx, q->wheel->map);
+	q->wheel_flows--;
+}
+
 static void fq_flow_unset_throttled(struct fq_sched_data *q, struct fq_flow *f)
 {
-	rb_erase(&f->rate_node, &q->delayed);
+	if (f->next == &throttled_wheel)
+		fq_wheel_unlink(q, f);
+	else
+		rb_erase(&f->rate_node, &q->delayed);
 	q->throttled_flows--;
 	fq_flow_add_tail(q, f, OLD_FLOW);
 }
 
-static void fq_flow_set_throttled(struct fq_sched_data *q, struct fq_flow *f)
+static void fq_delayed_insert(struct fq_sched_data *q, struct fq_flow *f)
 {
 	struct rb_node **p = &q->delayed.rb_node, *parent = NULL;
 
@@ -232,12 +317,39 @@ static void fq_flow_set_throttled(struct fq_sched_data *q, struct fq_flow *f)
 	}
 	rb_link_node(&f->rate_node, parent, p);
 	rb_insert_color(&f->rate_node, &q->delayed);
+	f->next = &throttled;
+}
+
+static void fq_flow_set_throttled(struct fq_sched_data *q, struct fq_flow *f,
+				  u64 now)
+{
+	u64 time_next = f->time_next_packet;
+
+	if (q->wheel && fq_wheel_insert(q, f, now))
+		time_next = max(fq_wheel_slot(q, f), q->wheel_cursor) << q->wheel_shift;
+	else
+		fq_delayed_insert(q, f);
 	q->throttled_flows++;
 	q->stat_throttled++;
 
-	f->next = &throttled;
-	if (q->time_next_delayed_flow > f->time_next_packet)
-		q->time_next_delayed_flow = f->time_next_packet;
+	if (q->time_next_delayed_flow > time_next)
+		q->time_next_delayed_flow = time_next;
+}
+
+/* Move all flows of the wheel to the q->delayed tree */
+static void fq_wheel_flush(struct fq_sched_data *q)
+{
+	struct hlist_node *tmp;
+	struct fq_flow *f;
+	unsigned int idx;
+
+	for_each_set_bit(idx, q->wheel->map, FQ_WHEEL_SLOTS) {
+		hlist_for_each_entry_safe(f, tmp, &q->wheel->slots[idx], wheel_node)
+			fq_delayed_insert(q, f);
+		INIT_HLIST_HEAD(&q->wheel->slots[idx]);
+	}
+	bitmap_zero(q->wheel->map, FQ_WHEEL_SLOTS);
+	q->wheel_flows = 0;
 }
 
 
@@ -590,6 +702,34 @@ static int fq_enqueue(struct sk_buff *skb, struct Qdisc *sch,
 	return NET_XMIT_SUCCESS;
 }
 
+/* Release the flows of all wheel slots which started before @now */
+static void fq_wheel_expire(struct fq_sched_data *q, u64 now)
+{
+	u64 slot, now_slot = now >> q->wheel_shift;
+	struct hlist_node *tmp;
+	struct fq_flow *f;
+	unsigned int idx;
+
+	while (q->wheel_flows) {
+		slot = fq_wheel_next(q);
+		if (slot > now_slot) {
+			q->time_next_delayed_flow = slot << q->wheel_shift;
+			break;
+		}
+		idx = slot & FQ_WHEEL_MASK;
+		hlist_for_each_entry_safe(f, tmp, &q->wheel->slots[idx], wheel_node) {
+			q->wheel_flows--;
+			q->throttled_flows--;
+			fq_flow_add_tail(q, f, OLD_FLOW);
+		}
+		INIT_HLIST_HEAD(&q->wheel->slots[idx]);
+		__clear_bit(idx, q->wheel->map);
+		q->wheel_cursor = slot + 1;
+	}
+	/* all remaining flows are due after now_slot */
+	q->wheel_cursor = max(q->wheel_cursor, now_slot + 1);
+}
+
 static void fq_check_throttled(struct fq_sched_data *q, u64 now)
 {
 	unsigned long sample;
@@ -606,11 +746,14 @@ static void fq_check_throttled(struct fq_sched_data *q, u64 now)
 	q->unthrottle_latency_ns += sample >> 3;
 
 	q->time_next_delayed_flow = ~0ULL;
+	if (q->wheel)
+		fq_wheel_expire(q, now);
 	while ((p = rb_first(&q->delayed)) != NULL) {
 		struct fq_flow *f = rb_entry(p, struct fq_flow, rate_node);
 
 		if (f->time_next_packet > now) {
-			q->time_next_delayed_flow = f->time_next_packet;
+			q->time_next_delayed_flow = min(q->time_next_delayed_flow,
+							f->time_next_packet);
 			break;
 		}
 		fq_flow_unset_throttled(q, f);
@@ -688,7 +831,7 @@ static struct sk_buff *fq_dequeue(struct Qdisc *sch)
 		if (now < time_next_packet) {
 			head->first = f->next;
 			f->time_next_packet = time_next_packet;
-			fq_flow_set_throttled(q, f);
+			fq_flow_set_throttled(q, f, now);
 			goto begin;
 		}
 		prefetch(&skb->end);
@@ -809,6 +952,9 @@ static void fq_reset(struct Qdisc *sch)
 		q->band_flows[idx].old_flows.first = NULL;
 	}
 	q->delayed		= RB_ROOT;
+	if (q->wheel)
+		memset(q->wheel, 0, sizeof(*q->wheel));
+	q->wheel_flows		= 0;
 	q->flows		= 0;
 	q->inactive_flows	= 0;
 	q->throttled_flows	= 0;
@@ -923,6 +1069,7 @@ static const struct nla_policy fq_policy[TCA_FQ_MAX + 1] = {
 	[TCA_FQ_HORIZON_DROP]		= { .type = NLA_U8 },
 	[TCA_FQ_PRIOMAP]		= NLA_POLICY_EXACT_LEN(sizeof(struct tc_prio_qopt)),
 	[TCA_FQ_WEIGHTS]		= NLA_POLICY_EXACT_LEN(FQ_BANDS * sizeof(s32)),
+	[TCA_FQ_WHEEL_GRANULARITY]	= NLA_POLICY_MAX(NLA_U32, FQ_WHEEL_MAX_GRANULARITY),
 };
 
 /* compress a u8 array with all elems <= 3 to an array of 2-bit fields */
@@ -995,8 +1142,10 @@ static int fq_change(struct Qdisc *sch, struct nlattr *opt,
 {
 	struct fq_sched_data *q = qdisc_priv(sch);
 	struct nlattr *tb[TCA_FQ_MAX + 1];
+	struct fq_wheel *wheel = NULL;
 	int err, drop_count = 0;
 	unsigned drop_len = 0;
+	u32 granularity = 0;
 	u32 fq_log;
 
 	err = nla_parse_nested_deprecated(tb, TCA_FQ_MAX, opt, fq_policy,
@@ -1004,6 +1153,20 @@ static int fq_change(struct Qdisc *sch, struct nlattr *opt,
 	if (err < 0)
 		return err;
 
+	if (tb[TCA_FQ_WHEEL_GRANULARITY]) {
+		granularity = nla_get_u32(tb[TCA_FQ_WHEEL_GRANULARITY]);
+		if (granularity && granularity < FQ_WHEEL_MIN_GRANULARITY) {
+			NL_SET_ERR_MSG_MOD(extack, "timer wheel granularity too small");
+			return -EINVAL;
+		}
+		if (granularity && !q->wheel) {
+			wheel = kvzalloc_node(sizeof(*wheel), GFP_KERNEL,
+					      netdev_queue_numa_node_read(sch->dev_queue));
+			if (!wheel)
+				return -ENOMEM;
+		}
+	}
+
 	sch_tree_lock(sch);
 
 	fq_log = q->fq_trees_log;
@@ -1098,6 +1261,16 @@ static int fq_change(struct Qdisc *sch, struct nlattr *opt,
 		WRITE_ONCE(q->horizon_drop,
 			   nla_get_u8(tb[TCA_FQ_HORIZON_DROP]));
 
+	if (tb[TCA_FQ_WHEEL_GRANULARITY]) {
+		/* slots change meaning, park the flows in the tree */
+		if (q->wheel)
+			fq_wheel_flush(q);
+		/* swap in the new wheel, or out the one to be freed */
+		if (!granularity || !q->wheel)
+			swap(wheel, q->wheel);
+		WRITE_ONCE(q->wheel_shift, granularity ? ilog2(granularity) : 0);
+	}
+
 	if (!err) {
 
 		sch_tree_unlock(sch);
@@ -1116,6 +1289,7 @@ static int fq_change(struct Qdisc *sch, struct nlattr *opt,
 	qdisc_tree_reduce_backlog(sch, drop_count, drop_len);
 
 	sch_tree_unlock(sch);
+	kvfree(wheel);
 	return err;
 }
 
@@ -1125,6 +1299,7 @@ static void fq_destroy(struct Qdisc *sch)
 
 	fq_reset(sch);
 	fq_free(q->fq_root);
+	kvfree(q->wheel);
 	qdisc_watchdog_cancel(&q->watchdog);
 }
 
@@ -1183,6 +1358,7 @@ static int fq_dump(struct Qdisc *sch, struct sk_buff *skb)
 	struct nlattr *opts;
 	u64 ce_threshold;
 	s32 weights[3];
+	u8 wheel_shift;
 	u64 horizon;
 
 	opts = nla_nest_start_noflag(skb, TCA_OPTIONS);
@@ -1226,6 +1402,11 @@ static int fq_dump(struct Qdisc *sch, struct sk_buff *skb)
 		       READ_ONCE(q->horizon_drop)))
 		goto nla_put_failure;
 
+	wheel_shift = READ_ONCE(q->wheel_shift);
+	if (nla_put_u32(skb, TCA_FQ_WHEEL_GRANULARITY,
+			wheel_shift ? 1U << wheel_shift : 0))
+		goto nla_put_failure;
+
 	fq_prio2band_decompress_crumb(q->prio2band, prio.priomap);
 	if (nla_put(skb, TCA_FQ_PRIOMAP, sizeof(prio), &prio))
 		goto nla_put_failure;
@@ -571,6 +571,8 @@ static void unix_sock_destructor(struct sock *sk)
 	struct unix_sock *u = unix_sk(sk);
 
 	skb_queue_purge(&sk->sk_receive_queue);
+	/* unread MSG_ZEROCOPY completions */
+	skb_queue_purge(&sk->sk_error_queue);
 
 	DEBUG_NET_WARN_ON_ONCE(refcount_read(&sk->sk_wmem_alloc));
 	DEBUG_NET_WARN_ON_ONCE(!sk_unhashed(sk));
@@ -2195,6 +2197,7 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 			       size_t len)
 {
 	struct sock *sk = sock->sk;
+	struct ubuf_info *uarg = NULL;
 	struct sock *other = NULL;
 	int err, size;
 	struct sk_buff *skb;
@@ -2232,10 +2235,30 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 	if (READ_ONCE(sk->sk_shutdown) & SEND_SHUTDOWN)
 		goto pipe_err;
 
+	/* The receiver reads straight from the pinned pages of the sender,
+	 * which is notified on its error queue once they are consumed.
+	 */
+	if ((msg->msg_flags & MSG_ZEROCOPY) && len &&
+	    !(msg->msg_flags & MSG_SPLICE_PAGES) &&
+	    sock_flag(sk, SOCK_ZEROCOPY)) {
+		uarg = msg_zerocopy_realloc(sk, len, NULL);
+		if (!uarg) {
+			err = -ENOBUFS;
+			goto out_err;
+		}
+	}
+
 	while (sent < len) {
 		size = len - sent;
 
 		if (unlikely(msg->msg_flags & MSG_SPLICE_PAGES)) {
+			skb = sock_alloc_send_pskb(sk, 0, 0,
+						   msg->msg_flags & MSG_DONTWAIT,
+						   &err, 0);
+		} else if (uarg) {
+			/* Keep two messages in the pipe so it schedules better */
+			size = min_t(int, size, (READ_ONCE(sk->sk_sndbuf) >> 1) - 64);
+
 			skb = sock_alloc_send_pskb(sk, 0, 0,
 						   msg->msg_flags & MSG_DONTWAIT,
 						   &err, 0);
@@ -2274,6 +2297,18 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 			}
 			size = err;
 			refcount_add(size, &sk->sk_wmem_alloc);
+		} else if (uarg) {
+			/* Takes what fits in the frags, the rest goes in the
+			 * next skb.
+			 */
+			err = __zerocopy_sg_from_iter(msg, NULL, skb,
+						      &msg->msg_iter, size);
+			if (err == -EFAULT || (err == -EMSGSIZE && !skb->len)) {
+				kfree_skb(skb);
+				goto out_err;
+			}
+			size = skb->len;
+			skb_zcopy_set(skb, uarg, NULL);
 		} else {
 			skb_put(skb, size - data_len);
 			skb->data_len = data_len;
@@ -2309,6 +2344,7 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 #endif
 
 	scm_destroy(&scm);
+	net_zcopy_put(uarg);
 
 	return sent;
 
@@ -2320,6 +2356,7 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 		send_sig(SIGPIPE, current, 0);
 	err = -EPIPE;
 out_err:
+	net_zcopy_put_abort(uarg, true);
 	scm_destroy(&scm);
 	return sent ? : err;
 }
@@ -2502,6 +2539,12 @@ static int unix_read_skb(struct sock *sk, skb_read_actor_t recv_actor)
 	if (!skb)
 		return err;
 
+	/* The actor may pass the skb on, don't let the sender's pages go */
+	if (skb_orphan_frags_rx(skb, GFP_KERNEL)) {
+		kfree_skb(skb);
+		return -ENOMEM;
+	}
+
 	return recv_actor(sk, skb);
 }
 
@@ -2926,11 +2969,16 @@ static int unix_stream_recvmsg(struct socket *sock, struct msghdr *msg,
 		.size = size,
 		.flags = flags
 	};
-
-#ifdef CONFIG_BPF_SYSCALL
 	struct sock *sk = sock->sk;
+#ifdef CONFIG_BPF_SYSCALL
 	const struct proto *prot = READ_ONCE(sk->sk_prot);
+#endif
 
+	if (unlikely(flags & MSG_ERRQUEUE))
+		return sock_recv_errqueue(sk, msg, size, SOL_UNIX,
+					  UNIX_RECVERR);
+
+#ifdef CONFIG_BPF_SYSCALL
 	if (prot != &unix_stream_proto)
 		return prot->recvmsg(sk, msg, size, flags, NULL);
 #endif
@@ -2941,6 +2989,13 @@ static int unix_stream_splice_actor(struct sk_buff *skb,
 				    int skip, int chunk,
 				    struct unix_stream_read_state *state)
 {
+	/* Pages in a pipe outlive the skb, never hand out the pinned
+	 * pages of a MSG_ZEROCOPY sender. Their ubuf is SKBFL_DONT_ORPHAN,
+	 * so only the rx variant copies them.
+	 */
+	if (skb_orphan_frags_rx(skb, GFP_KERNEL))
+		return -ENOMEM;
+
 	return skb_splice_bits(skb, state->socket->sk,
 			       UNIXCB(skb).consumed + skip,
 			       state->pipe, chunk, state->splice_flags);
@@ -3155,7 +3210,8 @@ static __poll_t unix_poll(struct file *file, struct socket *sock, poll_table *wa
 	state = READ_ONCE(sk->sk_state);
 
 	/* exceptional events? */
-	if (READ_ONCE(sk->sk_err))
+	if (READ_ONCE(sk->sk_err) ||
+	    !skb_queue_empty_lockless(&sk->sk_error_queue))
 		mask |= EPOLLERR;
 	if (shutdown == SHUTDOWN_MASK)
 		mask |= EPOLLHUP;
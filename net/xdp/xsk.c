@@ -782,9 +782,40 @@ static struct sk_buff *xsk_build_skb(struct xdp_sock *xs,
 	return ERR_PTR(err);
 }
 
+/* Hand the complete packets collected by __xsk_generic_xmit() to the driver */
+static int xsk_xmit_list(struct xdp_sock *xs, struct sk_buff *list)
+{
+	struct sk_buff *skb, *next;
+	u32 descs = 0;
+	int ret;
+
+	skb = __dev_direct_xmit_list(list, xs->queue_id, &ret);
+	if (ret == NETDEV_TX_BUSY) {
+		/* The unsent packets own the last descriptors consumed, hand
+		 * them back and tell user-space to retry the send.
+		 */
+		for (; skb; skb = next) {
+			next = skb->next;
+			skb_mark_not_on_list(skb);
+			descs += xsk_get_num_desc(skb);
+			xsk_consume_skb(skb);
+		}
+		xskq_cons_cancel_n(xs->tx, descs);
+		return -EAGAIN;
+	}
+
+	/* Ignore NET_XMIT_CN as packet might have been sent */
+	if (ret == NET_XMIT_DROP)
+		/* SKB completed but not sent */
+		return -EBUSY;
+
+	return 0;
+}
+
 static int __xsk_generic_xmit(struct sock *sk)
 {
 	struct xdp_sock *xs = xdp_sk(sk);
+	struct sk_buff *list = NULL, **tail = &list;
 	u32 max_batch = TX_BATCH_SIZE;
 	bool sent_frame = false;
 	struct xdp_desc desc;
@@ -802,10 +833,40 @@ static int __xsk_generic_xmit(struct sock *sk)
 	if (xs->queue_id >= xs->dev->real_num_tx_queues)
 		goto out;
 
-	while (xskq_cons_peek_desc(xs->tx, &desc, xs->pool)) {
+	for (;;) {
+		/* Peeking past the cached entries publishes the consumer
+		 * index, after which the descriptors of the batch can no
+		 * longer be handed back when the queue is busy. Send the
+		 * batch first.
+		 */
+		if (list && !xskq_has_descs(xs->tx)) {
+			err = xsk_xmit_list(xs, list);
+			list = NULL;
+			tail = &list;
+			sent_frame = true;
+			if (err)
+				goto out;
+		}
+
+		if (!xskq_cons_peek_desc(xs->tx, &desc, xs->pool))
+			break;
+
 		if (max_batch-- == 0) {
 			err = -EAGAIN;
-			goto out;
+			goto xmit;
+		}
+
+		/* Multi-buffer packets may release descriptors before they
+		 * are complete, send what we have first so that a busy
+		 * queue can still give the last descriptors back.
+		 */
+		if (list && xp_mb_desc(&desc) && !xs->skb) {
+			err = xsk_xmit_list(xs, list);
+			list = NULL;
+			tail = &list;
+			sent_frame = true;
+			if (err)
+				goto out;
 		}
 
 		/* This is the backpressure mechanism for the Tx path.
@@ -814,13 +875,13 @@ static int __xsk_generic_xmit(struct sock *sk)
 		 * any buffering in the Tx path.
 		 */
 		if (xsk_cq_reserve_addr_locked(xs, desc.addr))
-			goto out;
+			goto xmit;
 
 		skb = xsk_build_skb(xs, &desc);
 		if (IS_ERR(skb)) {
 			err = PTR_ERR(skb);
 			if (err != -EOVERFLOW)
-				goto out;
+				goto xmit;
 			err = 0;
 			continue;
 		}
@@ -832,25 +893,18 @@ static int __xsk_generic_xmit(struct sock *sk)
 			continue;
 		}
 
-		err = __dev_direct_xmit(skb, xs->queue_id);
-		if  (err == NETDEV_TX_BUSY) {
-			/* Tell user-space to retry the send */
-			xskq_cons_cancel_n(xs->tx, xsk_get_num_desc(skb));
-			xsk_consume_skb(skb);
-			err = -EAGAIN;
-			goto out;
-		}
-
-		/* Ignore NET_XMIT_CN as packet might have been sent */
-		if (err == NET_XMIT_DROP) {
-			/* SKB completed but not sent */
-			err = -EBUSY;
-			xs->skb = NULL;
-			goto out;
-		}
+		/* Queue the complete packet, it is sent with the batch */
+		xs->skb = NULL;
+		*tail = skb;
+		tail = &skb->next;
+	}
 
+	if (list) {
+		err = xsk_xmit_list(xs, list);
+		list = NULL;
 		sent_frame = true;
-		xs->skb = NULL;
+		if (err)
+			goto out;
 	}
 
 	if (xskq_has_descs(xs->tx)) {
@@ -858,7 +912,16 @@ static int __xsk_generic_xmit(struct sock *sk)
 			xsk_drop_skb(xs->skb);
 		xskq_cons_release(xs->tx);
 	}
+	goto out;
+
+xmit:
+	if (list) {
+		int ret = xsk_xmit_list(xs, list);
 
+		sent_frame = true;
+		if (ret)
+			err = ret;
+	}
 out:
 	if (sent_frame)
 		if (xsk_tx_writeable(xs))
@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: GPL-2.0
+/* BPF_F_CLOCK_LRU eviction of LRU hash maps */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <bpf/bpf.h>
+#include <bpf/libbpf.h>
+
+#include <test_maps.h>
+
+#define PCPU_ENTRIES	8
+
+static void pin_to_cpu(int cpu)
+{
+	cpu_set_t cpuset;
+
+	CPU_ZERO(&cpuset);
+	CPU_SET(cpu, &cpuset);
+	CHECK(sched_setaffinity(0, sizeof(cpuset), &cpuset), "sched_setaffinity",
+	      "error: %s\n", strerror(errno));
+}
+
+static int count_entries(int fd)
+{
+	__u32 key, next;
+	int n = 0, err;
+
+	for (err = bpf_map_get_next_key(fd, NULL, &next); !err;
+	     err = bpf_map_get_next_key(fd, &key, &next)) {
+		key = next;
+		n++;
+	}
+	CHECK(errno != ENOENT, "bpf_map_get_next_key", "error: %s\n",
+	      strerror(errno));
+	return n;
+}
+
+static void test_flags(void)
+{
+	LIBBPF_OPTS(bpf_map_create_opts, opts);
+	int fd;
+
+	opts.map_flags = BPF_F_CLOCK_LRU;
+	fd = bpf_map_create(BPF_MAP_TYPE_HASH, NULL, sizeof(__u32),
+			    sizeof(__u64), 64, &opts);
+	CHECK(fd >= 0 || errno != EINVAL, "clock_lru_non_lru",
+	      "fd %d errno %d\n", fd, errno);
+
+	opts.map_flags = BPF_F_CLOCK_LRU | BPF_F_NO_COMMON_LRU;
+	fd = bpf_map_create(BPF_MAP_TYPE_LRU_HASH, NULL, sizeof(__u32),
+			    sizeof(__u64), 64, &opts);
+	CHECK(fd >= 0 || errno != EINVAL, "clock_lru_no_common_lru",
+	      "fd %d errno %d\n", fd, errno);
+
+	opts.map_flags = BPF_F_CLOCK_LRU | BPF_F_NO_PREALLOC;
+	fd = bpf_map_create(BPF_MAP_TYPE_LRU_HASH, NULL, sizeof(__u32),
+			    sizeof(__u64), 64, &opts);
+	CHECK(fd >= 0 || errno != EINVAL, "clock_lru_no_prealloc",
+	      "fd %d errno %d\n", fd, errno);
+}
+
+/*
+ * Updates from one CPU only evict from that CPU's slice: once it is full,
+ * every update still succeeds and the map holds exactly one slice worth of
+ * elements, the latest of which is always present.
+ */
+static void test_evict(enum bpf_map_type type, int nr_cpus, int cpu)
+{
+	LIBBPF_OPTS(bpf_map_create_opts, opts, .map_flags = BPF_F_CLOCK_LRU);
+	/* large enough for the per-CPU values as well */
+	__u64 value[nr_cpus];
+	__u32 key;
+	int fd, err;
+
+	memset(value, 0, sizeof(value));
+
+	fd = bpf_map_create(type, NULL, sizeof(key), sizeof(__u64),
+			    PCPU_ENTRIES * nr_cpus, &opts);
+	CHECK(fd < 0, "bpf_map_create", "error: %s\n", strerror(errno));
+
+	pin_to_cpu(cpu);
+
+	for (key = 0; key < 4 * PCPU_ENTRIES; key++) {
+		value[0] = key;
+		err = bpf_map_update_elem(fd, &key, value, BPF_NOEXIST);
+		CHECK(err, "bpf_map_update_elem", "key %u error: %s\n", key,
+		      strerror(errno));
+
+		err = bpf_map_lookup_elem(fd, &key, value);
+		CHECK(err || value[0] != key, "bpf_map_lookup_elem",
+		      "key %u err %d value %llu\n", key, err, value[0]);
+	}
+	CHECK(count_entries(fd) != PCPU_ENTRIES, "count_full",
+	      "%d entries\n", count_entries(fd));
+
+	/* Deleted nodes are reclaimed by the clock hand */
+	for (key = 0; key < 4 * PCPU_ENTRIES; key++)
+		bpf_map_delete_elem(fd, &key);
+	CHECK(count_entries(fd), "count_empty", "%d entries\n",
+	      count_entries(fd));
+
+	for (key = 0; key < PCPU_ENTRIES; key++) {
+		err = bpf_map_update_elem(fd, &key, value, BPF_NOEXIST);
+		CHECK(err, "bpf_map_update_elem", "key %u error: %s\n", key,
+		      strerror(errno));
+	}
+	CHECK(count_entries(fd) != PCPU_ENTRIES, "count_refill",
+	      "%d entries\n", count_entries(fd));
+
+	close(fd);
+}
+
+void test_lru_clock_map(void)
+{
+	int nr_cpus = libbpf_num_possible_cpus();
+	cpu_set_t old;
+	int cpu;
+
+	CHECK(nr_cpus < 0, "libbpf_num_possible_cpus", "error %d\n", nr_cpus);
+	CHECK(sched_getaffinity(0, sizeof(old), &old), "sched_getaffinity",
+	      "error: %s\n", strerror(errno));
+	for (cpu = 0; !CPU_ISSET(cpu, &old); cpu++)
+		;
+
+	test_flags();
+	test_evict(BPF_MAP_TYPE_LRU_HASH, nr_cpus, cpu);
+	test_evict(BPF_MAP_TYPE_LRU_PERCPU_HASH, nr_cpus, cpu);
+
+	sched_setaffinity(0, sizeof(old), &old);
+	printf("%s:PASS\n", __func__);
+}
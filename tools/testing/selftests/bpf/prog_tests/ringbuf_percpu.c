@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: GPL-2.0
+#define _GNU_SOURCE
+#include <test_progs.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "test_ringbuf_percpu.skel.h"
+
+struct sample {
+	int cpu;
+	int pid;
+	long seq;
+};
+
+static int page_size;
+
+/*
+ * Consume the ring of one CPU through the layout of a BPF_F_RINGBUF_PERCPU
+ * map: the ring of CPU n is mapped at page offset n * stride, with the
+ * consumer page, the producer page and the double-mapped data of a single
+ * ring buffer. Returns the number of records, which must all be from @cpu.
+ */
+static int consume_ring(int map_fd, int cpu, size_t stride, size_t ring_sz)
+{
+	unsigned long *consumer, *producer, cons, prod;
+	off_t off = (off_t)cpu * stride * page_size;
+	void *data;
+	int n = 0;
+
+	consumer = mmap(NULL, page_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+			map_fd, off);
+	if (!ASSERT_OK_PTR(consumer, "mmap_consumer"))
+		return -1;
+	producer = mmap(NULL, page_size + 2 * ring_sz, PROT_READ, MAP_SHARED,
+			map_fd, off + page_size);
+	if (!ASSERT_OK_PTR(producer, "mmap_producer")) {
+		munmap(consumer, page_size);
+		return -1;
+	}
+	data = (void *)producer + page_size;
+
+	cons = *consumer;
+	prod = __atomic_load_n(producer, __ATOMIC_ACQUIRE);
+	while (cons < prod) {
+		__u32 *hdr = data + (cons & (ring_sz - 1));
+		__u32 len = __atomic_load_n(hdr, __ATOMIC_ACQUIRE);
+		struct sample *s = (void *)hdr + BPF_RINGBUF_HDR_SZ;
+
+		if (!ASSERT_FALSE(len & BPF_RINGBUF_BUSY_BIT, "record_busy"))
+			break;
+		ASSERT_EQ(len, sizeof(*s), "record_len");
+		ASSERT_EQ(s->cpu, cpu, "record_cpu");
+		ASSERT_EQ(s->pid, getpid(), "record_pid");
+
+		cons += (len + BPF_RINGBUF_HDR_SZ + 7) & ~7UL;
+		n++;
+	}
+	__atomic_store_n(consumer, cons, __ATOMIC_RELEASE);
+
+	munmap(producer, page_size + 2 * ring_sz);
+	munmap(consumer, page_size);
+	return n;
+}
+
+void test_ringbuf_percpu(void)
+{
+	struct epoll_event ev = { .events = EPOLLIN };
+	struct test_ringbuf_percpu *skel;
+	int nr_cpus, cpu, map_fd, efd = -1, err, fed = 0;
+	size_t ring_sz, stride;
+	cpu_set_t old, cpuset, fed_cpus;
+	void *ptr;
+
+	page_size = getpagesize();
+	ring_sz = page_size;
+	/* position pages plus the double-mapped data, in pages */
+	stride = 2 + 2 * ring_sz / page_size;
+
+	nr_cpus = libbpf_num_possible_cpus();
+	if (!ASSERT_GT(nr_cpus, 0, "nr_cpus"))
+		return;
+	if (!ASSERT_OK(sched_getaffinity(0, sizeof(old), &old), "getaffinity"))
+		return;
+
+	skel = test_ringbuf_percpu__open();
+	if (!ASSERT_OK_PTR(skel, "skel_open"))
+		return;
+	err = bpf_map__set_max_entries(skel->maps.ringbuf, ring_sz);
+	if (!ASSERT_OK(err, "set_max_entries"))
+		goto cleanup;
+	err = test_ringbuf_percpu__load(skel);
+	if (!ASSERT_OK(err, "skel_load"))
+		goto cleanup;
+	map_fd = bpf_map__fd(skel->maps.ringbuf);
+
+	/* there is no ring past the last possible CPU */
+	ptr = mmap(NULL, page_size, PROT_READ, MAP_SHARED, map_fd,
+		   (off_t)nr_cpus * stride * page_size);
+	ASSERT_ERR_PTR(ptr, "mmap_past_last_cpu");
+	if (ptr != MAP_FAILED)
+		munmap(ptr, page_size);
+
+	efd = epoll_create1(EPOLL_CLOEXEC);
+	if (!ASSERT_GE(efd, 0, "epoll_create"))
+		goto cleanup;
+	err = epoll_ctl(efd, EPOLL_CTL_ADD, map_fd, &ev);
+	if (!ASSERT_OK(err, "epoll_ctl"))
+		goto cleanup;
+	ASSERT_EQ(epoll_wait(efd, &ev, 1, 0), 0, "epoll_empty");
+
+	skel->bss->pid = getpid();
+	err = test_ringbuf_percpu__attach(skel);
+	if (!ASSERT_OK(err, "skel_attach"))
+		goto cleanup;
+
+	/* one record from every CPU we may run on, each into its own ring */
+	CPU_ZERO(&fed_cpus);
+	for (cpu = 0; cpu < nr_cpus; cpu++) {
+		if (!CPU_ISSET(cpu, &old))
+			continue;
+		CPU_ZERO(&cpuset);
+		CPU_SET(cpu, &cpuset);
+		if (sched_setaffinity(0, sizeof(cpuset), &cpuset))
+			continue;
+		syscall(__NR_getpgid);
+		CPU_SET(cpu, &fed_cpus);
+		fed++;
+	}
+	sched_setaffinity(0, sizeof(old), &old);
+	test_ringbuf_percpu__detach(skel);
+
+	ASSERT_EQ(skel->bss->seq, fed, "records_written");
+	ASSERT_EQ(skel->bss->dropped, 0, "records_dropped");
+
+	/* one fd covers all the rings */
+	ASSERT_EQ(epoll_wait(efd, &ev, 1, 1000), 1, "epoll_data");
+
+	for (cpu = 0; cpu < nr_cpus; cpu++)
+		ASSERT_EQ(consume_ring(map_fd, cpu, stride, ring_sz),
+			  CPU_ISSET(cpu, &fed_cpus) ? 1 : 0, "records_per_cpu");
+
+	ASSERT_EQ(epoll_wait(efd, &ev, 1, 0), 0, "epoll_drained");
+
+cleanup:
+	if (efd >= 0)
+		close(efd);
+	test_ringbuf_percpu__destroy(skel);
+}
@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: GPL-2.0
+
+#include <linux/bpf.h>
+#include <bpf/bpf_helpers.h>
+
+char _license[] SEC("license") = "GPL";
+
+struct sample {
+	int cpu;
+	int pid;
+	long seq;
+};
+
+struct {
+	__uint(type, BPF_MAP_TYPE_RINGBUF);
+	__uint(map_flags, BPF_F_RINGBUF_PERCPU);
+} ringbuf SEC(".maps");
+
+/* inputs */
+int pid = 0;
+
+/* outputs */
+long seq = 0;
+long dropped = 0;
+
+SEC("tp/syscalls/sys_enter_getpgid")
+int test_ringbuf_percpu(void *ctx)
+{
+	struct sample s;
+
+	if ((bpf_get_current_pid_tgid() >> 32) != pid)
+		return 0;
+
+	s.cpu = bpf_get_smp_processor_id();
+	s.pid = pid;
+	s.seq = __sync_fetch_and_add(&seq, 1);
+
+	if (bpf_ringbuf_output(&ringbuf, &s, sizeof(s), 0))
+		__sync_fetch_and_add(&dropped, 1);
+	return 0;
+}
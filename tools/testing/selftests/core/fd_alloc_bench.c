@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Strictly speaking, this is not a test. It measures the accept()/close()
+ * rate of several threads sharing one file table that already holds a
+ * large number of descriptors, which stresses fd allocation.
+ *
+ * Usage: fd_alloc_bench [nr_fds [nr_threads [seconds]]]
+ */
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "../kselftest.h"
+
+static struct sockaddr_un addr;
+static socklen_t addrlen;
+static int listen_fd;
+static volatile bool stop;
+
+static void *bench_thread(void *arg)
+{
+	unsigned long long *ops = arg;
+	int c, a;
+
+	while (!stop) {
+		c = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (c < 0)
+			err(1, "socket");
+		if (connect(c, (struct sockaddr *)&addr, addrlen))
+			err(1, "connect");
+		a = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+		if (a < 0)
+			err(1, "accept4");
+		close(a);
+		close(c);
+		(*ops)++;
+	}
+	return NULL;
+}
+
+static unsigned long nr_open(void)
+{
+	unsigned long val = 1024 * 1024;
+	FILE *f = fopen("/proc/sys/fs/nr_open", "r");
+
+	if (f) {
+		if (fscanf(f, "%lu", &val) != 1)
+			val = 1024 * 1024;
+		fclose(f);
+	}
+	return val;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long nr_fds = argc > 1 ? strtoul(argv[1], NULL, 0) : 1024 * 1024;
+	int nr_threads = argc > 2 ? atoi(argv[2]) : sysconf(_SC_NPROCESSORS_ONLN);
+	int seconds = argc > 3 ? atoi(argv[3]) : 5;
+	unsigned long long *ops, total = 0;
+	struct rlimit rlim;
+	pthread_t *threads;
+	unsigned long i;
+	int fd;
+
+	ksft_print_header();
+	ksft_set_plan(1);
+
+	if (nr_threads < 1)
+		nr_threads = 1;
+	if (seconds < 1)
+		seconds = 1;
+	/* room for the prefilled table plus two sockets per thread */
+	rlim.rlim_cur = rlim.rlim_max = nr_fds + 2 * nr_threads + 64;
+	if (rlim.rlim_max > nr_open() || setrlimit(RLIMIT_NOFILE, &rlim))
+		ksft_exit_skip("cannot raise RLIMIT_NOFILE to %lu: %s\n",
+			       (unsigned long)rlim.rlim_max, strerror(errno));
+
+	listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (listen_fd < 0)
+		ksft_exit_fail_msg("socket: %s\n", strerror(errno));
+	addr.sun_family = AF_UNIX;
+	snprintf(addr.sun_path + 1, sizeof(addr.sun_path) - 1,
+		 "fd_alloc_bench-%d", getpid());
+	addrlen = offsetof(struct sockaddr_un, sun_path) + 1 +
+		  strlen(addr.sun_path + 1);
+	if (bind(listen_fd, (struct sockaddr *)&addr, addrlen) ||
+	    listen(listen_fd, 4096))
+		ksft_exit_fail_msg("bind/listen: %s\n", strerror(errno));
+
+	/* fill the table so that allocations happen at high fd numbers */
+	for (i = 0; i < nr_fds; i++) {
+		fd = dup(listen_fd);
+		if (fd < 0)
+			ksft_exit_fail_msg("dup #%lu: %s\n", i, strerror(errno));
+	}
+
+	ops = calloc(nr_threads, sizeof(*ops) * 8);
+	threads = calloc(nr_threads, sizeof(*threads));
+	if (!ops || !threads)
+		ksft_exit_fail_msg("out of memory\n");
+
+	for (i = 0; i < nr_threads; i++) {
+		/* keep the counters on separate cache lines */
+		if (pthread_create(&threads[i], NULL, bench_thread, &ops[i * 8]))
+			ksft_exit_fail_msg("pthread_create failed\n");
+	}
+	sleep(seconds);
+	stop = true;
+	for (i = 0; i < nr_threads; i++) {
+		pthread_join(threads[i], NULL);
+		total += ops[i * 8];
+	}
+
+	ksft_print_msg("%lu fds, %d threads: %llu accept/close per second\n",
+		       nr_fds, nr_threads, total / seconds);
+	ksft_test_result_pass("accept/close with %lu open fds\n", nr_fds);
+	ksft_finished();
+}
@@ -0,0 +1,214 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Concurrent open/dup/dup2/close on one file table. Every descriptor a
+ * thread gets must be free before and refer to the file it asked for, and
+ * the table must keep handing out the lowest free descriptor.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+#include "../kselftest_harness.h"
+
+#define NR_THREADS	8
+#define NR_ITERS	50000
+/* descriptors held per thread, enough to make the table grow a few times */
+#define NR_HELD		128
+#define MAX_FD		4096
+
+/* thread id + 1 of the owner of each descriptor, 0 if free */
+static int owner[MAX_FD];
+
+struct worker {
+	pthread_t thread;
+	int id;
+	int pipe[2];
+	ino_t ino;
+	int held[NR_HELD];
+	int nr_held;
+	const char *error;
+	int error_fd;
+};
+
+static bool same_file(int fd, ino_t ino)
+{
+	struct stat st;
+
+	return !fstat(fd, &st) && st.st_ino == ino;
+}
+
+static bool fail(struct worker *w, const char *error, int fd)
+{
+	w->error = error;
+	w->error_fd = fd;
+	return false;
+}
+
+/* Record the new descriptor @fd as ours, it must not be in use */
+static bool claim(struct worker *w, int fd)
+{
+	if (fd < 0)
+		return fail(w, "allocation failed", errno);
+	if (fd >= MAX_FD)
+		return fail(w, "descriptor out of range", fd);
+	if (__atomic_exchange_n(&owner[fd], w->id + 1, __ATOMIC_SEQ_CST))
+		return fail(w, "descriptor handed out twice", fd);
+	if (!same_file(fd, w->ino))
+		return fail(w, "descriptor refers to another file", fd);
+	w->held[w->nr_held++] = fd;
+	return true;
+}
+
+static bool release(struct worker *w, int i)
+{
+	int fd = w->held[i];
+
+	if (!same_file(fd, w->ino))
+		return fail(w, "held descriptor changed", fd);
+	w->held[i] = w->held[--w->nr_held];
+	__atomic_store_n(&owner[fd], 0, __ATOMIC_SEQ_CST);
+	if (close(fd))
+		return fail(w, "close failed", fd);
+	return true;
+}
+
+static void *worker_fn(void *arg)
+{
+	struct worker *w = arg;
+	unsigned int seed = w->id;
+	int i, fd;
+
+	for (i = 0; i < NR_ITERS; i++) {
+		int op = rand_r(&seed) % 5;
+
+		/* keep the table between half and fully used */
+		if (w->nr_held == NR_HELD ||
+		    (w->nr_held > NR_HELD / 2 && op == 4)) {
+			if (!release(w, rand_r(&seed) % w->nr_held))
+				return NULL;
+			continue;
+		}
+
+		switch (op) {
+		case 0:
+			if (!claim(w, dup(w->pipe[0])))
+				return NULL;
+			break;
+		case 1:
+			fd = fcntl(w->pipe[0], F_DUPFD_CLOEXEC, 0);
+			if (!claim(w, fd))
+				return NULL;
+			if (fcntl(fd, F_GETFD) != FD_CLOEXEC) {
+				fail(w, "F_DUPFD_CLOEXEC lost close-on-exec", fd);
+				return NULL;
+			}
+			break;
+		case 2:
+			/* a racing allocation must not be able to take it */
+			fd = fcntl(w->pipe[0], F_DUPFD, rand_r(&seed) % MAX_FD / 2);
+			if (!claim(w, fd))
+				return NULL;
+			break;
+		case 3:
+			if (!w->nr_held) {
+				if (!claim(w, dup(w->pipe[0])))
+					return NULL;
+				break;
+			}
+			/* replacing a descriptor we own keeps it ours */
+			fd = w->held[rand_r(&seed) % w->nr_held];
+			if (dup2(w->pipe[1], fd) != fd) {
+				fail(w, "dup2 over an open descriptor failed", fd);
+				return NULL;
+			}
+			if (dup2(w->pipe[0], fd) != fd || !same_file(fd, w->ino)) {
+				fail(w, "dup2 back failed", fd);
+				return NULL;
+			}
+			break;
+		case 4:
+			if (w->nr_held && !release(w, rand_r(&seed) % w->nr_held))
+				return NULL;
+			break;
+		}
+	}
+
+	while (w->nr_held)
+		if (!release(w, 0))
+			return NULL;
+	return NULL;
+}
+
+/* The lowest descriptor that is not open */
+static int lowest_free(void)
+{
+	int fd;
+
+	for (fd = 0; fcntl(fd, F_GETFD) >= 0; fd++)
+		;
+	return fd;
+}
+
+TEST(concurrent_alloc)
+{
+	struct worker workers[NR_THREADS];
+	struct rlimit rlim;
+	struct stat st;
+	int i, fd, first;
+
+	ASSERT_EQ(0, getrlimit(RLIMIT_NOFILE, &rlim));
+	if (rlim.rlim_max < MAX_FD)
+		SKIP(return, "RLIMIT_NOFILE hard limit below %d", MAX_FD);
+	rlim.rlim_cur = MAX_FD;
+	ASSERT_EQ(0, setrlimit(RLIMIT_NOFILE, &rlim));
+
+	memset(workers, 0, sizeof(workers));
+	for (i = 0; i < NR_THREADS; i++) {
+		struct worker *w = &workers[i];
+
+		w->id = i;
+		ASSERT_EQ(0, pipe(w->pipe));
+		ASSERT_EQ(0, fstat(w->pipe[0], &st));
+		w->ino = st.st_ino;
+	}
+
+	first = lowest_free();
+	for (i = 0; i < NR_THREADS; i++)
+		ASSERT_EQ(0, pthread_create(&workers[i].thread, NULL,
+					    worker_fn, &workers[i]));
+	for (i = 0; i < NR_THREADS; i++) {
+		struct worker *w = &workers[i];
+
+		ASSERT_EQ(0, pthread_join(w->thread, NULL));
+		if (w->error)
+			TH_LOG("thread %d: %s (%d)", i, w->error, w->error_fd);
+		EXPECT_EQ(NULL, w->error);
+	}
+
+	/* everything was closed again, so allocation starts over at the bottom */
+	EXPECT_EQ(first, lowest_free());
+	for (i = 0; i < 2 * NR_HELD; i++) {
+		fd = dup(workers[0].pipe[0]);
+		ASSERT_EQ(first + i, fd);
+	}
+	for (i = 1; i < 2 * NR_HELD; i += 2)
+		ASSERT_EQ(0, close(first + i));
+	for (i = 1; i < 2 * NR_HELD; i += 2)
+		ASSERT_EQ(first + i, dup(workers[0].pipe[0]));
+	for (i = 0; i < 2 * NR_HELD; i++)
+		close(first + i);
+
+	for (i = 0; i < NR_THREADS; i++) {
+		close(workers[i].pipe[0]);
+		close(workers[i].pipe[1]);
+	}
+}
+
+TEST_HARNESS_MAIN
@@ -0,0 +1,279 @@
+// SPDX-License-Identifier: GPL-2.0
+/* UFFDIO_COPY_VEC and UFFDIO_CONTINUE_VEC */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <linux/userfaultfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "../kselftest_harness.h"
+
+#define NR_PAGES	16
+
+static int uffd_open(__u64 features)
+{
+	struct uffdio_api api = {
+		.api = UFFD_API,
+		.features = features,
+	};
+	int fd;
+
+	fd = syscall(__NR_userfaultfd, O_CLOEXEC | O_NONBLOCK |
+		     UFFD_USER_MODE_ONLY);
+	if (fd < 0)
+		return -errno;
+
+	if (ioctl(fd, UFFDIO_API, &api)) {
+		close(fd);
+		return -errno;
+	}
+
+	return fd;
+}
+
+static int uffd_register(int fd, void *addr, size_t len, __u64 mode,
+			 __u64 *ioctls)
+{
+	struct uffdio_register reg = {
+		.range = {
+			.start = (unsigned long)addr,
+			.len = len,
+		},
+		.mode = mode,
+	};
+
+	if (ioctl(fd, UFFDIO_REGISTER, &reg))
+		return -errno;
+
+	*ioctls = reg.ioctls;
+	return 0;
+}
+
+FIXTURE(uffd_vec)
+{
+	size_t page_size;
+	char *src;
+	int uffd;
+};
+
+FIXTURE_SETUP(uffd_vec)
+{
+	int i;
+
+	self->page_size = getpagesize();
+
+	self->src = mmap(NULL, NR_PAGES * self->page_size,
+			 PROT_READ | PROT_WRITE,
+			 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	ASSERT_NE(MAP_FAILED, self->src);
+	for (i = 0; i < NR_PAGES; i++)
+		memset(self->src + i * self->page_size, 'a' + i,
+		       self->page_size);
+
+	self->uffd = -1;
+}
+
+FIXTURE_TEARDOWN(uffd_vec)
+{
+	if (self->uffd >= 0)
+		close(self->uffd);
+	munmap(self->src, NR_PAGES * self->page_size);
+}
+
+/* Resolve every other page of a MISSING range in a single call. */
+TEST_F(uffd_vec, copy)
+{
+	struct uffdio_copy copy[NR_PAGES / 2];
+	struct uffdio_vec vec;
+	__u64 ioctls;
+	char *dst;
+	int i;
+
+	self->uffd = uffd_open(0);
+	if (self->uffd < 0)
+		SKIP(return, "userfaultfd: %s", strerror(-self->uffd));
+
+	dst = mmap(NULL, NR_PAGES * self->page_size, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	ASSERT_NE(MAP_FAILED, dst);
+
+	ASSERT_EQ(0, uffd_register(self->uffd, dst,
+				   NR_PAGES * self->page_size,
+				   UFFDIO_REGISTER_MODE_MISSING, &ioctls));
+	ASSERT_TRUE(ioctls & ((__u64)1 << _UFFDIO_COPY_VEC));
+	ASSERT_FALSE(ioctls & ((__u64)1 << _UFFDIO_CONTINUE_VEC));
+
+	for (i = 0; i < NR_PAGES / 2; i++) {
+		copy[i] = (struct uffdio_copy) {
+			.dst = (unsigned long)dst + 2 * i * self->page_size,
+			.src = (unsigned long)self->src +
+			       2 * i * self->page_size,
+			.len = self->page_size,
+		};
+	}
+
+	vec = (struct uffdio_vec) {
+		.entries = (unsigned long)copy,
+		.nr = NR_PAGES / 2,
+	};
+	ASSERT_EQ(0, ioctl(self->uffd, UFFDIO_COPY_VEC, &vec));
+	ASSERT_EQ(NR_PAGES / 2, vec.done);
+
+	for (i = 0; i < NR_PAGES / 2; i++) {
+		ASSERT_EQ(self->page_size, copy[i].copy);
+		ASSERT_EQ(0, memcmp(dst + 2 * i * self->page_size,
+				    self->src + 2 * i * self->page_size,
+				    self->page_size));
+	}
+
+	munmap(dst, NR_PAGES * self->page_size);
+}
+
+/* The walk stops at the first entry that is not fully resolved. */
+TEST_F(uffd_vec, copy_partial)
+{
+	struct uffdio_copy copy[NR_PAGES];
+	struct uffdio_vec vec;
+	const int stop = NR_PAGES / 2;
+	__u64 ioctls;
+	char *dst;
+	int i;
+
+	self->uffd = uffd_open(0);
+	if (self->uffd < 0)
+		SKIP(return, "userfaultfd: %s", strerror(-self->uffd));
+
+	dst = mmap(NULL, NR_PAGES * self->page_size, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	ASSERT_NE(MAP_FAILED, dst);
+
+	ASSERT_EQ(0, uffd_register(self->uffd, dst,
+				   NR_PAGES * self->page_size,
+				   UFFDIO_REGISTER_MODE_MISSING, &ioctls));
+
+	for (i = 0; i < NR_PAGES; i++) {
+		copy[i] = (struct uffdio_copy) {
+			.dst = (unsigned long)dst + i * self->page_size,
+			.src = (unsigned long)self->src + i * self->page_size,
+			.len = self->page_size,
+		};
+	}
+
+	/* Populate one page up front so that its entry fails */
+	ASSERT_EQ(0, ioctl(self->uffd, UFFDIO_COPY, &copy[stop]));
+	copy[stop].copy = 0;
+
+	vec = (struct uffdio_vec) {
+		.entries = (unsigned long)copy,
+		.nr = NR_PAGES,
+	};
+	ASSERT_EQ(-1, ioctl(self->uffd, UFFDIO_COPY_VEC, &vec));
+	ASSERT_EQ(EEXIST, errno);
+	ASSERT_EQ(stop, vec.done);
+	ASSERT_EQ(-EEXIST, copy[stop].copy);
+
+	for (i = 0; i < stop; i++)
+		ASSERT_EQ(self->page_size, copy[i].copy);
+	for (i = stop + 1; i < NR_PAGES; i++)
+		ASSERT_EQ(0, copy[i].copy);
+
+	munmap(dst, NR_PAGES * self->page_size);
+}
+
+TEST_F(uffd_vec, empty)
+{
+	struct uffdio_vec vec = { .nr = 0, .done = -1 };
+	__u64 ioctls;
+	char *dst;
+
+	self->uffd = uffd_open(0);
+	if (self->uffd < 0)
+		SKIP(return, "userfaultfd: %s", strerror(-self->uffd));
+
+	dst = mmap(NULL, self->page_size, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	ASSERT_NE(MAP_FAILED, dst);
+	ASSERT_EQ(0, uffd_register(self->uffd, dst, self->page_size,
+				   UFFDIO_REGISTER_MODE_MISSING, &ioctls));
+
+	ASSERT_EQ(0, ioctl(self->uffd, UFFDIO_COPY_VEC, &vec));
+	ASSERT_EQ(0, vec.done);
+
+	/* An array whose size overflows is refused up front */
+	vec = (struct uffdio_vec) {
+		.entries = 0,
+		.nr = UINT64_MAX / 2,
+	};
+	ASSERT_EQ(-1, ioctl(self->uffd, UFFDIO_COPY_VEC, &vec));
+	ASSERT_EQ(EINVAL, errno);
+
+	munmap(dst, self->page_size);
+}
+
+/* Map pages already in the shmem page cache through a MINOR range. */
+TEST_F(uffd_vec, continue_minor)
+{
+	struct uffdio_continue cont[NR_PAGES];
+	struct uffdio_vec vec;
+	char *dst, *alias;
+	__u64 ioctls;
+	int memfd, i;
+
+	self->uffd = uffd_open(UFFD_FEATURE_MINOR_SHMEM);
+	if (self->uffd < 0)
+		SKIP(return, "UFFD_FEATURE_MINOR_SHMEM: %s",
+		     strerror(-self->uffd));
+
+	memfd = memfd_create("uffd-vec", MFD_CLOEXEC);
+	ASSERT_GE(memfd, 0);
+	ASSERT_EQ(0, ftruncate(memfd, NR_PAGES * self->page_size));
+
+	alias = mmap(NULL, NR_PAGES * self->page_size, PROT_READ | PROT_WRITE,
+		     MAP_SHARED, memfd, 0);
+	ASSERT_NE(MAP_FAILED, alias);
+	memcpy(alias, self->src, NR_PAGES * self->page_size);
+
+	dst = mmap(NULL, NR_PAGES * self->page_size, PROT_READ | PROT_WRITE,
+		   MAP_SHARED, memfd, 0);
+	ASSERT_NE(MAP_FAILED, dst);
+
+	ASSERT_EQ(0, uffd_register(self->uffd, dst,
+				   NR_PAGES * self->page_size,
+				   UFFDIO_REGISTER_MODE_MINOR, &ioctls));
+	ASSERT_TRUE(ioctls & ((__u64)1 << _UFFDIO_CONTINUE_VEC));
+
+	for (i = 0; i < NR_PAGES; i++) {
+		cont[i] = (struct uffdio_continue) {
+			.range = {
+				.start = (unsigned long)dst +
+					 i * self->page_size,
+				.len = self->page_size,
+			},
+		};
+	}
+
+	vec = (struct uffdio_vec) {
+		.entries = (unsigned long)cont,
+		.nr = NR_PAGES,
+	};
+	ASSERT_EQ(0, ioctl(self->uffd, UFFDIO_CONTINUE_VEC, &vec));
+	ASSERT_EQ(NR_PAGES, vec.done);
+
+	for (i = 0; i < NR_PAGES; i++)
+		ASSERT_EQ(self->page_size, cont[i].mapped);
+	ASSERT_EQ(0, memcmp(dst, self->src, NR_PAGES * self->page_size));
+
+	munmap(dst, NR_PAGES * self->page_size);
+	munmap(alias, NR_PAGES * self->page_size);
+	close(memfd);
+}
+
+TEST_HARNESS_MAIN
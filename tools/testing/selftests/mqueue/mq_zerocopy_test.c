@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Zero-copy hand-over of large POSIX mqueue messages to waiting
+ * receivers, enabled by fs/mqueue/zerocopy_min.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <mqueue.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../kselftest_harness.h"
+
+#define ZEROCOPY_MIN	"/proc/sys/fs/mqueue/zerocopy_min"
+#define MSG_SIZE	(64 * 1024)
+#define MSG_PRIO	7
+
+static int read_sysctl(unsigned int *val)
+{
+	FILE *f = fopen(ZEROCOPY_MIN, "r");
+	int ret;
+
+	if (!f)
+		return -1;
+	ret = fscanf(f, "%u", val) == 1 ? 0 : -1;
+	fclose(f);
+	return ret;
+}
+
+static int write_sysctl(const char *val)
+{
+	int fd = open(ZEROCOPY_MIN, O_WRONLY);
+	ssize_t ret;
+
+	if (fd < 0)
+		return -1;
+	ret = write(fd, val, strlen(val));
+	close(fd);
+	return ret < 0 ? -1 : 0;
+}
+
+struct receiver {
+	mqd_t mq;
+	char *buf;
+	ssize_t len;
+	unsigned int prio;
+};
+
+static void *receive(void *arg)
+{
+	struct receiver *r = arg;
+
+	r->len = mq_receive(r->mq, r->buf, MSG_SIZE, &r->prio);
+	return NULL;
+}
+
+FIXTURE(zerocopy)
+{
+	unsigned int old_min;
+	bool restore;
+	char name[32];
+	mqd_t mq;
+	char *buf;
+	char *out;
+};
+
+FIXTURE_SETUP(zerocopy)
+{
+	struct mq_attr attr = {
+		.mq_maxmsg = 1,
+		.mq_msgsize = MSG_SIZE,
+	};
+
+	if (read_sysctl(&self->old_min))
+		SKIP(return, "no " ZEROCOPY_MIN);
+	if (write_sysctl("4096"))
+		SKIP(return, "cannot write " ZEROCOPY_MIN);
+	self->restore = true;
+
+	snprintf(self->name, sizeof(self->name), "/mq_zc_%d", getpid());
+	self->mq = mq_open(self->name, O_RDWR | O_CREAT | O_EXCL, 0600, &attr);
+	ASSERT_NE((mqd_t)-1, self->mq);
+
+	self->buf = malloc(MSG_SIZE);
+	self->out = malloc(MSG_SIZE);
+	ASSERT_NE(NULL, self->buf);
+	ASSERT_NE(NULL, self->out);
+	memset(self->buf, 'a', MSG_SIZE);
+}
+
+FIXTURE_TEARDOWN(zerocopy)
+{
+	char val[16];
+
+	if (!self->restore)
+		return;
+	free(self->buf);
+	free(self->out);
+	if (self->mq != (mqd_t)-1) {
+		mq_close(self->mq);
+		mq_unlink(self->name);
+	}
+	snprintf(val, sizeof(val), "%u", self->old_min);
+	write_sysctl(val);
+}
+
+TEST_F(zerocopy, sysctl_bounds)
+{
+	unsigned int val;
+
+	EXPECT_EQ(0, write_sysctl("0"));
+	ASSERT_EQ(0, read_sysctl(&val));
+	EXPECT_EQ(0, val);
+
+	/* larger than any message can be */
+	EXPECT_EQ(-1, write_sysctl("16777217"));
+	EXPECT_EQ(EINVAL, errno);
+	EXPECT_EQ(-1, write_sysctl("-1"));
+	EXPECT_EQ(EINVAL, errno);
+}
+
+/* A large message handed to a waiting receiver arrives intact */
+TEST_F(zerocopy, waiting_receiver)
+{
+	struct receiver r = { .mq = self->mq, .buf = self->out };
+	pthread_t thread;
+
+	ASSERT_EQ(0, pthread_create(&thread, NULL, receive, &r));
+	/* give the receiver time to block on the empty queue */
+	usleep(100000);
+
+	ASSERT_EQ(0, mq_send(self->mq, self->buf, MSG_SIZE, MSG_PRIO));
+	/* the receiver is done with our buffer once mq_send() returned */
+	memset(self->buf, 'b', MSG_SIZE);
+
+	ASSERT_EQ(0, pthread_join(thread, NULL));
+	ASSERT_EQ(MSG_SIZE, r.len);
+	EXPECT_EQ(MSG_PRIO, r.prio);
+	memset(self->buf, 'a', MSG_SIZE);
+	EXPECT_EQ(0, memcmp(self->buf, self->out, MSG_SIZE));
+}
+
+/* Messages below zerocopy_min, and large ones from an unaligned buffer */
+TEST_F(zerocopy, small_unaligned)
+{
+	struct receiver r = { .mq = self->mq, .buf = self->out };
+	pthread_t thread;
+
+	ASSERT_EQ(0, pthread_create(&thread, NULL, receive, &r));
+	usleep(100000);
+
+	ASSERT_EQ(0, mq_send(self->mq, self->buf + 1, 4095, MSG_PRIO));
+	ASSERT_EQ(0, pthread_join(thread, NULL));
+	ASSERT_EQ(4095, r.len);
+	EXPECT_EQ(0, memcmp(self->buf, self->out, 4095));
+
+	ASSERT_EQ(0, pthread_create(&thread, NULL, receive, &r));
+	usleep(100000);
+
+	ASSERT_EQ(0, mq_send(self->mq, self->buf + 1, MSG_SIZE - 1, 0));
+	ASSERT_EQ(0, pthread_join(thread, NULL));
+	ASSERT_EQ(MSG_SIZE - 1, r.len);
+	EXPECT_EQ(0, memcmp(self->buf, self->out, MSG_SIZE - 1));
+}
+
+/* An invalid buffer fails with EFAULT and leaves the receiver waiting */
+TEST_F(zerocopy, bad_buffer)
+{
+	struct receiver r = { .mq = self->mq, .buf = self->out };
+	pthread_t thread;
+
+	ASSERT_EQ(0, pthread_create(&thread, NULL, receive, &r));
+	usleep(100000);
+
+	EXPECT_EQ(-1, mq_send(self->mq, NULL, MSG_SIZE, 0));
+	EXPECT_EQ(EFAULT, errno);
+
+	ASSERT_EQ(0, mq_send(self->mq, self->buf, MSG_SIZE, MSG_PRIO));
+	ASSERT_EQ(0, pthread_join(thread, NULL));
+	ASSERT_EQ(MSG_SIZE, r.len);
+	EXPECT_EQ(0, memcmp(self->buf, self->out, MSG_SIZE));
+}
+
+/* Without a waiting receiver the message is queued and copied as usual */
+TEST_F(zerocopy, queued)
+{
+	unsigned int prio;
+
+	ASSERT_EQ(0, mq_send(self->mq, self->buf, MSG_SIZE, MSG_PRIO));
+	memset(self->buf, 'b', MSG_SIZE);
+
+	ASSERT_EQ(MSG_SIZE, mq_receive(self->mq, self->out, MSG_SIZE, &prio));
+	EXPECT_EQ(MSG_PRIO, prio);
+	memset(self->buf, 'a', MSG_SIZE);
+	EXPECT_EQ(0, memcmp(self->buf, self->out, MSG_SIZE));
+}
+
+TEST_HARNESS_MAIN
@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: GPL-2.0
+/* MSG_ZEROCOPY on AF_UNIX stream sockets. */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <linux/errqueue.h>
+#include <linux/un.h>
+#include <sys/socket.h>
+
+#include "../../kselftest_harness.h"
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY	60
+#endif
+
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY	5
+#endif
+
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED	1
+#endif
+
+#define PAYLOAD_LEN	(64 * 1024)
+
+FIXTURE(msg_zerocopy)
+{
+	int fd[2];
+	char *buf;
+};
+
+FIXTURE_SETUP(msg_zerocopy)
+{
+	int one = 1;
+
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, self->fd));
+	ASSERT_EQ(0, setsockopt(self->fd[0], SOL_SOCKET, SO_ZEROCOPY,
+				&one, sizeof(one)));
+
+	self->buf = aligned_alloc(4096, PAYLOAD_LEN);
+	ASSERT_NE(NULL, self->buf);
+	memset(self->buf, 'a', PAYLOAD_LEN);
+}
+
+FIXTURE_TEARDOWN(msg_zerocopy)
+{
+	free(self->buf);
+	close(self->fd[0]);
+	close(self->fd[1]);
+}
+
+/* Wait for the completion of the single zerocopy send and return its code. */
+static int read_completion(struct __test_metadata *_metadata, int fd)
+{
+	char control[CMSG_SPACE(sizeof(struct sock_extended_err))];
+	struct sock_extended_err *serr;
+	struct msghdr msg = {
+		.msg_control = control,
+		.msg_controllen = sizeof(control),
+	};
+	struct cmsghdr *cmsg;
+	int i;
+
+	for (i = 0; i < 1000; i++) {
+		if (recvmsg(fd, &msg, MSG_ERRQUEUE) >= 0)
+			break;
+		ASSERT_EQ(EAGAIN, errno);
+		usleep(1000);
+	}
+	ASSERT_LT(i, 1000);
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	ASSERT_NE(NULL, cmsg);
+	ASSERT_EQ(SOL_UNIX, cmsg->cmsg_level);
+	ASSERT_EQ(UNIX_RECVERR, cmsg->cmsg_type);
+
+	serr = (struct sock_extended_err *)CMSG_DATA(cmsg);
+	ASSERT_EQ(SO_EE_ORIGIN_ZEROCOPY, serr->ee_origin);
+	ASSERT_EQ(0, serr->ee_info);
+	ASSERT_EQ(0, serr->ee_data);
+
+	return serr->ee_code;
+}
+
+TEST_F(msg_zerocopy, recv)
+{
+	char *out = malloc(PAYLOAD_LEN);
+	ssize_t ret, len = 0;
+
+	ASSERT_NE(NULL, out);
+	ASSERT_EQ(PAYLOAD_LEN, send(self->fd[0], self->buf, PAYLOAD_LEN,
+				    MSG_ZEROCOPY));
+
+	while (len < PAYLOAD_LEN) {
+		ret = recv(self->fd[1], out + len, PAYLOAD_LEN - len, 0);
+		ASSERT_GT(ret, 0);
+		len += ret;
+	}
+	ASSERT_EQ(0, memcmp(self->buf, out, PAYLOAD_LEN));
+
+	/* Received by copying straight out of the sender's pages */
+	ASSERT_EQ(0, read_completion(_metadata, self->fd[0]));
+	free(out);
+}
+
+TEST_F(msg_zerocopy, splice)
+{
+	char *out = malloc(PAYLOAD_LEN);
+	ssize_t ret, len = 0;
+	int pipefd[2];
+
+	ASSERT_NE(NULL, out);
+	ASSERT_EQ(0, pipe(pipefd));
+	ASSERT_GE(fcntl(pipefd[1], F_SETPIPE_SZ, PAYLOAD_LEN), PAYLOAD_LEN);
+
+	ASSERT_EQ(PAYLOAD_LEN, send(self->fd[0], self->buf, PAYLOAD_LEN,
+				    MSG_ZEROCOPY));
+
+	while (len < PAYLOAD_LEN) {
+		ret = splice(self->fd[1], NULL, pipefd[1], NULL,
+			     PAYLOAD_LEN - len, 0);
+		ASSERT_GT(ret, 0);
+		len += ret;
+	}
+
+	/*
+	 * The pipe must not refer to the sender's pages: once the
+	 * completion arrived, the sender may reuse its buffer.
+	 */
+	ASSERT_EQ(SO_EE_CODE_ZEROCOPY_COPIED,
+		  read_completion(_metadata, self->fd[0]));
+	memset(self->buf, 'b', PAYLOAD_LEN);
+
+	len = 0;
+	while (len < PAYLOAD_LEN) {
+		ret = read(pipefd[0], out + len, PAYLOAD_LEN - len);
+		ASSERT_GT(ret, 0);
+		len += ret;
+	}
+	memset(self->buf, 'a', PAYLOAD_LEN);
+	ASSERT_EQ(0, memcmp(self->buf, out, PAYLOAD_LEN));
+
+	close(pipefd[0]);
+	close(pipefd[1]);
+	free(out);
+}
+
+TEST_HARNESS_MAIN